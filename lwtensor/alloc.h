@@ -0,0 +1,629 @@
+/*
+  MIT License
+  
+  Copyright (c) 2025 Morcillo Sanz
+  
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+  
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+  
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  SOFTWARE.
+*/
+
+#pragma once
+
+#include <stdlib.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+#include <stdatomic.h>
+
+#define LWT_ALIGNMENT 64
+
+/*
+ * Default size of the blocks requested by a TensorArena.
+ */
+#ifndef LWT_ARENA_BLOCK_SIZE
+#define LWT_ARENA_BLOCK_SIZE (1 << 20)
+#endif
+
+/*
+ * Number of distinct buffer sizes cached by the pool of each thread, and the
+ * maximum number of bytes a thread keeps cached.
+ */
+#ifndef LWT_BUFPOOL_SLOTS
+#define LWT_BUFPOOL_SLOTS 64
+#endif
+
+#ifndef LWT_BUFPOOL_CAPACITY
+#define LWT_BUFPOOL_CAPACITY ((size_t) 256 << 20)
+#endif
+
+/*
+ * Maximum number of distinct operations tracked by the allocation statistics.
+ */
+#ifndef LWT_MAX_OP_STATS
+#define LWT_MAX_OP_STATS 64
+#endif
+
+#if defined(_MSC_VER)
+#define LWT_THREAD_LOCAL __declspec(thread)
+#else
+#define LWT_THREAD_LOCAL _Thread_local
+#endif
+
+/**
+ * Allocates a block of memory aligned to a given boundary.
+ *
+ * @param size      Number of bytes to allocate.
+ * @param alignment Alignment in bytes (power of two).
+ * @return          A pointer aligned to `alignment`, or NULL on failure.
+ *
+ * Note: The block must be released with `lwt_aligned_free`.
+ */
+void* lwt_aligned_malloc(size_t size, size_t alignment) {
+
+    void* base = malloc(size + alignment + sizeof(void*));
+    if(base == NULL)
+        return NULL;
+
+    uintptr_t address = (uintptr_t) base + sizeof(void*);
+    address = (address + alignment - 1) & ~(uintptr_t) (alignment - 1);
+
+    ((void**) address)[-1] = base;
+    return (void*) address;
+}
+
+/**
+ * Releases a block allocated with `lwt_aligned_malloc`.
+ *
+ * @param ptr The aligned pointer (may be NULL).
+ */
+void lwt_aligned_free(void* ptr) {
+    if(ptr != NULL)
+        free(((void**) ptr)[-1]);
+}
+
+/**
+ * Allocation callbacks used for every heap allocation of the library.
+ *
+ * `free` receives the size that was requested, so it works as a sized deallocation
+ * for memory coming from either `alloc` or `aligned_alloc`.
+ */
+typedef struct {
+    void* (*alloc)(void* context, size_t size);
+    void (*free)(void* context, void* ptr, size_t size);
+    void* (*aligned_alloc)(void* context, size_t size, size_t alignment);
+    void* context;
+} TensorAllocator;
+
+/**
+ * Global allocation counters.
+ */
+typedef struct {
+    size_t live_bytes;
+    size_t peak_bytes;
+    size_t allocations;
+    size_t frees;
+    size_t pool_hits;
+    size_t pooled_bytes;
+} TensorAllocStats;
+
+/**
+ * Allocation counters of one operation.
+ */
+typedef struct {
+    const char* name;
+    size_t allocations;
+    size_t bytes;
+} TensorOpStats;
+
+void* lwt_default_alloc(void* context, size_t size) {
+    (void) context;
+    return lwt_aligned_malloc(size, 2 * sizeof(void*));
+}
+
+void lwt_default_free(void* context, void* ptr, size_t size) {
+    (void) context;
+    (void) size;
+    lwt_aligned_free(ptr);
+}
+
+void* lwt_default_aligned_alloc(void* context, size_t size, size_t alignment) {
+    (void) context;
+    return lwt_aligned_malloc(size, alignment);
+}
+
+TensorAllocator lwt_allocator = { lwt_default_alloc, lwt_default_free, lwt_default_aligned_alloc, NULL };
+
+atomic_size_t lwt_stat_live_bytes;
+atomic_size_t lwt_stat_peak_bytes;
+atomic_size_t lwt_stat_allocations;
+atomic_size_t lwt_stat_frees;
+atomic_size_t lwt_stat_pool_hits;
+atomic_size_t lwt_stat_pooled_bytes;
+
+struct {
+    _Atomic(const char*) name;
+    atomic_size_t allocations;
+    atomic_size_t bytes;
+} lwt_op_stats[LWT_MAX_OP_STATS];
+
+/*
+ * Operation charged for the allocations of the calling thread. The outermost
+ * operation wins, so scratch tensors of inverse() are charged to "inverse".
+ */
+LWT_THREAD_LOCAL const char* lwt_current_op = NULL;
+
+#define LWT_OP_ENTER(name) const char* lwt_previous_op = lwt_op_enter(name)
+#define LWT_OP_LEAVE() (lwt_current_op = lwt_previous_op)
+
+const char* lwt_op_enter(const char* name) {
+
+    const char* previous = lwt_current_op;
+    if(previous == NULL)
+        lwt_current_op = name;
+
+    return previous;
+}
+
+/*
+ * Size-class pool of one thread: each slot caches freed aligned buffers of one exact size.
+ */
+typedef struct {
+    size_t size;
+    void* head;
+} TensorBufPoolSlot;
+
+LWT_THREAD_LOCAL TensorBufPoolSlot lwt_bufpool[LWT_BUFPOOL_SLOTS];
+LWT_THREAD_LOCAL size_t lwt_bufpool_cached = 0;
+
+atomic_int lwt_bufpool_enabled;
+
+/**
+ * Replaces the allocation callbacks of the library.
+ *
+ * @param alloc         Allocates `size` bytes.
+ * @param free          Releases a block, receiving the size it was requested with.
+ * @param aligned_alloc Allocates `size` bytes aligned to `alignment`.
+ * @param context       User pointer forwarded to every callback.
+ *
+ * Note: Pass NULL callbacks to restore the defaults. Call it before creating tensors:
+ * blocks are always released through the callbacks that are current at release time.
+ */
+void lwt_set_allocator(void* (*alloc)(void*, size_t), void (*free)(void*, void*, size_t),
+    void* (*aligned_alloc)(void*, size_t, size_t), void* context) {
+
+    lwt_allocator.alloc = alloc != NULL ? alloc : lwt_default_alloc;
+    lwt_allocator.free = free != NULL ? free : lwt_default_free;
+    lwt_allocator.aligned_alloc = aligned_alloc != NULL ? aligned_alloc : lwt_default_aligned_alloc;
+    lwt_allocator.context = context;
+}
+
+/**
+ * Records an allocation in the global and per-operation counters.
+ *
+ * @param size Number of bytes allocated.
+ */
+void lwt_stats_allocated(size_t size) {
+
+    atomic_fetch_add_explicit(&lwt_stat_allocations, 1, memory_order_relaxed);
+    size_t live = atomic_fetch_add_explicit(&lwt_stat_live_bytes, size, memory_order_relaxed) + size;
+
+    size_t peak = atomic_load_explicit(&lwt_stat_peak_bytes, memory_order_relaxed);
+    while(live > peak && !atomic_compare_exchange_weak_explicit(&lwt_stat_peak_bytes, &peak, live,
+        memory_order_relaxed, memory_order_relaxed));
+
+    const char* op = lwt_current_op != NULL ? lwt_current_op : "other";
+
+    for(int i = 0; i < LWT_MAX_OP_STATS; i ++) {
+
+        const char* name = atomic_load_explicit(&lwt_op_stats[i].name, memory_order_acquire);
+
+        if(name == NULL) {
+            const char* expected = NULL;
+            if(atomic_compare_exchange_strong(&lwt_op_stats[i].name, &expected, op))
+                name = op;
+            else
+                name = expected;
+        }
+
+        if(name == op || strcmp(name, op) == 0) {
+            atomic_fetch_add_explicit(&lwt_op_stats[i].allocations, 1, memory_order_relaxed);
+            atomic_fetch_add_explicit(&lwt_op_stats[i].bytes, size, memory_order_relaxed);
+            return;
+        }
+    }
+}
+
+/**
+ * Records a release in the global counters.
+ *
+ * @param size Number of bytes released.
+ */
+void lwt_stats_released(size_t size) {
+    atomic_fetch_add_explicit(&lwt_stat_frees, 1, memory_order_relaxed);
+    atomic_fetch_sub_explicit(&lwt_stat_live_bytes, size, memory_order_relaxed);
+}
+
+/**
+ * Allocates memory through the allocation callbacks.
+ *
+ * @param size Number of bytes.
+ * @return     A pointer to the memory, to be released with `lwt_free`.
+ */
+void* lwt_malloc(size_t size) {
+
+    void* ptr = lwt_allocator.alloc(lwt_allocator.context, size);
+    if(ptr != NULL)
+        lwt_stats_allocated(size);
+
+    return ptr;
+}
+
+/**
+ * Releases memory obtained from `lwt_malloc`.
+ *
+ * @param ptr  The pointer (may be NULL).
+ * @param size The size it was requested with.
+ */
+void lwt_free(void* ptr, size_t size) {
+
+    if(ptr == NULL)
+        return;
+
+    lwt_stats_released(size);
+    lwt_allocator.free(lwt_allocator.context, ptr, size);
+}
+
+/**
+ * Returns the pool slot caching buffers of a given size.
+ *
+ * @param size   Buffer size in bytes.
+ * @param create Whether to claim an empty slot when none matches.
+ * @return       The slot, or NULL.
+ */
+TensorBufPoolSlot* lwt_bufpool_slot(size_t size, int create) {
+
+    size_t first = (size / LWT_ALIGNMENT) % LWT_BUFPOOL_SLOTS;
+    TensorBufPoolSlot* reusable = NULL;
+
+    for(size_t probe = 0; probe < LWT_BUFPOOL_SLOTS; probe ++) {
+
+        TensorBufPoolSlot* slot = &lwt_bufpool[(first + probe) % LWT_BUFPOOL_SLOTS];
+
+        if(slot->size == size)
+            return slot;
+
+        if(reusable == NULL && slot->head == NULL)
+            reusable = slot;
+
+        // Slots are never emptied back to size 0, so an unused slot ends the probe sequence
+        if(slot->size == 0)
+            break;
+    }
+
+    if(create && reusable != NULL) {
+        reusable->size = size;
+        return reusable;
+    }
+
+    return NULL;
+}
+
+/**
+ * Allocates LWT_ALIGNMENT-aligned memory, reusing a pooled buffer of the same size when possible.
+ *
+ * @param size Number of bytes.
+ * @return     A pointer to the memory, to be released with `lwt_free_aligned`.
+ */
+void* lwt_malloc_aligned(size_t size) {
+
+    if(atomic_load_explicit(&lwt_bufpool_enabled, memory_order_relaxed)) {
+
+        TensorBufPoolSlot* slot = lwt_bufpool_slot(size, 0);
+
+        if(slot != NULL && slot->head != NULL) {
+
+            void* ptr = slot->head;
+            slot->head = *(void**) ptr;
+            lwt_bufpool_cached -= size;
+
+            atomic_fetch_add_explicit(&lwt_stat_pool_hits, 1, memory_order_relaxed);
+            atomic_fetch_sub_explicit(&lwt_stat_pooled_bytes, size, memory_order_relaxed);
+            lwt_stats_allocated(size);
+
+            return ptr;
+        }
+    }
+
+    void* ptr = lwt_allocator.aligned_alloc(lwt_allocator.context, size, LWT_ALIGNMENT);
+    if(ptr != NULL)
+        lwt_stats_allocated(size);
+
+    return ptr;
+}
+
+/**
+ * Releases memory obtained from `lwt_malloc_aligned`, caching it in the pool when enabled.
+ *
+ * @param ptr  The pointer (may be NULL).
+ * @param size The size it was requested with.
+ */
+void lwt_free_aligned(void* ptr, size_t size) {
+
+    if(ptr == NULL)
+        return;
+
+    lwt_stats_released(size);
+
+    if(atomic_load_explicit(&lwt_bufpool_enabled, memory_order_relaxed) &&
+        size >= sizeof(void*) && lwt_bufpool_cached + size <= LWT_BUFPOOL_CAPACITY) {
+
+        TensorBufPoolSlot* slot = lwt_bufpool_slot(size, 1);
+
+        if(slot != NULL) {
+
+            *(void**) ptr = slot->head;
+            slot->head = ptr;
+            lwt_bufpool_cached += size;
+
+            atomic_fetch_add_explicit(&lwt_stat_pooled_bytes, size, memory_order_relaxed);
+            return;
+        }
+    }
+
+    lwt_allocator.free(lwt_allocator.context, ptr, size);
+}
+
+/**
+ * Enables or disables the size-class pool of component buffers.
+ *
+ * @param enabled Non-zero to recycle freed buffers for later allocations of the same size.
+ *
+ * Note: Each thread keeps its own pool of at most LWT_BUFPOOL_CAPACITY bytes, so no locking
+ * is involved; a buffer freed on another thread is recycled by that thread.
+ */
+void lwt_bufpool_enable(int enabled) {
+    atomic_store(&lwt_bufpool_enabled, enabled);
+}
+
+/**
+ * Returns every buffer cached by the pool of the calling thread to the allocator.
+ */
+void lwt_bufpool_trim(void) {
+
+    for(int i = 0; i < LWT_BUFPOOL_SLOTS; i ++) {
+
+        TensorBufPoolSlot* slot = &lwt_bufpool[i];
+
+        while(slot->head != NULL) {
+
+            void* ptr = slot->head;
+            slot->head = *(void**) ptr;
+
+            atomic_fetch_sub_explicit(&lwt_stat_pooled_bytes, slot->size, memory_order_relaxed);
+            lwt_allocator.free(lwt_allocator.context, ptr, slot->size);
+        }
+    }
+
+    lwt_bufpool_cached = 0;
+}
+
+/**
+ * Returns a snapshot of the global allocation counters.
+ *
+ * @return The counters; `live_bytes` excludes buffers cached by the pools (see `pooled_bytes`).
+ */
+TensorAllocStats lwt_alloc_stats(void) {
+
+    TensorAllocStats stats;
+    stats.live_bytes = atomic_load(&lwt_stat_live_bytes);
+    stats.peak_bytes = atomic_load(&lwt_stat_peak_bytes);
+    stats.allocations = atomic_load(&lwt_stat_allocations);
+    stats.frees = atomic_load(&lwt_stat_frees);
+    stats.pool_hits = atomic_load(&lwt_stat_pool_hits);
+    stats.pooled_bytes = atomic_load(&lwt_stat_pooled_bytes);
+
+    return stats;
+}
+
+/**
+ * Copies the per-operation allocation counters.
+ *
+ * @param stats    Output array.
+ * @param capacity Number of entries available in `stats`.
+ * @return         Number of entries written.
+ */
+int lwt_alloc_op_stats(TensorOpStats* stats, int capacity) {
+
+    int count = 0;
+    for(int i = 0; i < LWT_MAX_OP_STATS && count < capacity; i ++) {
+
+        const char* name = atomic_load(&lwt_op_stats[i].name);
+        if(name == NULL)
+            break;
+
+        stats[count].name = name;
+        stats[count].allocations = atomic_load(&lwt_op_stats[i].allocations);
+        stats[count].bytes = atomic_load(&lwt_op_stats[i].bytes);
+        count ++;
+    }
+
+    return count;
+}
+
+/**
+ * Resets the allocation counters, except the live and pooled bytes which describe current state.
+ */
+void lwt_alloc_stats_reset(void) {
+
+    atomic_store(&lwt_stat_peak_bytes, atomic_load(&lwt_stat_live_bytes));
+    atomic_store(&lwt_stat_allocations, 0);
+    atomic_store(&lwt_stat_frees, 0);
+    atomic_store(&lwt_stat_pool_hits, 0);
+
+    for(int i = 0; i < LWT_MAX_OP_STATS; i ++) {
+        atomic_store(&lwt_op_stats[i].allocations, 0);
+        atomic_store(&lwt_op_stats[i].bytes, 0);
+    }
+}
+
+/**
+ * A block of memory owned by a TensorArena.
+ */
+struct TensorArenaBlock {
+    struct TensorArenaBlock* next;
+    unsigned char* data;
+    size_t size;
+    size_t used;
+};
+
+typedef struct TensorArenaBlock TensorArenaBlock;
+
+/**
+ * A bump allocator for short-lived tensors.
+ *
+ * Memory is handed out from large blocks in LWT_ALIGNMENT-aligned chunks and is
+ * only given back all at once by `tensor_arena_reset`, which keeps the blocks for
+ * the next round, or by `tensor_arena_destroy`.
+ */
+typedef struct {
+    TensorArenaBlock* head;
+    TensorArenaBlock* current;
+    size_t block_size;
+} TensorArena;
+
+/*
+ * Arena used by the tensor constructors of the calling thread, NULL for the heap.
+ */
+LWT_THREAD_LOCAL TensorArena* lwt_current_arena = NULL;
+
+/**
+ * Initializes an empty arena.
+ *
+ * @param arena      The arena to initialize.
+ * @param block_size Minimum size of the blocks it requests (0 for LWT_ARENA_BLOCK_SIZE).
+ */
+void tensor_arena_init(TensorArena* arena, size_t block_size) {
+    arena->head = NULL;
+    arena->current = NULL;
+    arena->block_size = block_size > 0 ? block_size : LWT_ARENA_BLOCK_SIZE;
+}
+
+/**
+ * Allocates memory from an arena.
+ *
+ * @param arena The arena.
+ * @param size  Number of bytes.
+ * @return      A pointer aligned to LWT_ALIGNMENT, or NULL if a new block could not be allocated.
+ *
+ * Note: The memory is valid until the arena is reset or destroyed.
+ */
+void* tensor_arena_alloc(TensorArena* arena, size_t size) {
+
+    size = (size + LWT_ALIGNMENT - 1) & ~(size_t) (LWT_ALIGNMENT - 1);
+
+    TensorArenaBlock* block = arena->current;
+    if(block != NULL && block->size - block->used >= size) {
+        void* ptr = block->data + block->used;
+        block->used += size;
+        return ptr;
+    }
+
+    // Reuse the blocks kept by the last reset before asking for a new one
+    while(block != NULL && block->next != NULL) {
+
+        block = block->next;
+        block->used = 0;
+
+        if(block->size >= size) {
+            arena->current = block;
+            block->used = size;
+            return block->data;
+        }
+    }
+
+    size_t block_size = size > arena->block_size ? size : arena->block_size;
+    TensorArenaBlock* fresh = (TensorArenaBlock*) lwt_malloc(sizeof(TensorArenaBlock) + block_size + LWT_ALIGNMENT);
+    if(fresh == NULL)
+        return NULL;
+
+    uintptr_t data = (uintptr_t) (fresh + 1);
+    fresh->data = (unsigned char*) ((data + LWT_ALIGNMENT - 1) & ~(uintptr_t) (LWT_ALIGNMENT - 1));
+    fresh->size = block_size;
+    fresh->used = size;
+
+    if(block == NULL) {
+        fresh->next = NULL;
+        arena->head = fresh;
+    }
+    else {
+        fresh->next = block->next;
+        block->next = fresh;
+    }
+
+    arena->current = fresh;
+    return fresh->data;
+}
+
+/**
+ * Releases every allocation of an arena at once, keeping its blocks for reuse.
+ *
+ * @param arena The arena.
+ *
+ * Note: O(1). Tensors created from the arena must not be used afterwards.
+ */
+void tensor_arena_reset(TensorArena* arena) {
+
+    arena->current = arena->head;
+    if(arena->head != NULL)
+        arena->head->used = 0;
+}
+
+/**
+ * Frees every block of an arena.
+ *
+ * @param arena The arena.
+ */
+void tensor_arena_destroy(TensorArena* arena) {
+
+    TensorArenaBlock* block = arena->head;
+    while(block != NULL) {
+        TensorArenaBlock* next = block->next;
+        lwt_free(block, sizeof(TensorArenaBlock) + block->size + LWT_ALIGNMENT);
+        block = next;
+    }
+
+    arena->head = NULL;
+    arena->current = NULL;
+}
+
+/**
+ * Makes an arena the allocation source of the tensor constructors on the calling thread.
+ *
+ * @param arena The arena to attach, or NULL to go back to the heap.
+ * @return      The previously attached arena (or NULL), so attachments can be nested.
+ *
+ * Note: Tensors created while an arena is attached own nothing; `destroy_tensor` leaves
+ * them alone and their memory is reclaimed by `tensor_arena_reset`.
+ */
+TensorArena* tensor_arena_attach(TensorArena* arena) {
+
+    TensorArena* previous = lwt_current_arena;
+    lwt_current_arena = arena;
+
+    return previous;
+}
\ No newline at end of file
@@ -0,0 +1,399 @@
+/*
+  MIT License
+  
+  Copyright (c) 2025 Morcillo Sanz
+  
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+  
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+  
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  SOFTWARE.
+*/
+
+#pragma once
+
+#include "tensor.h"
+
+/*
+ * Maximum number of nodes (tensors, scalars and operations) in an expression.
+ */
+#ifndef LWT_EXPR_MAX_NODES
+#define LWT_EXPR_MAX_NODES 32
+#endif
+
+/*
+ * Maximum number of distinct tensors read by an expression; the destination
+ * takes the remaining iterator operand.
+ */
+#define LWT_EXPR_MAX_INPUTS (LWT_MAX_OPERANDS - 1)
+
+/*
+ * Number of elements evaluated per node before moving to the next block. Every
+ * intermediate result of a block stays in a stack buffer that fits in L1.
+ */
+#ifndef LWT_EXPR_BLOCK
+#define LWT_EXPR_BLOCK 64
+#endif
+
+/**
+ * Node kinds of an expression. The arithmetic ones match the LWT_SIMD_* operations.
+ */
+typedef enum {
+    LWT_EXPR_ADD = LWT_SIMD_ADD,
+    LWT_EXPR_SUB = LWT_SIMD_SUB,
+    LWT_EXPR_MUL = LWT_SIMD_MUL,
+    LWT_EXPR_DIV = LWT_SIMD_DIV,
+    LWT_EXPR_TENSOR,
+    LWT_EXPR_SCALAR
+} TensorExprOp;
+
+typedef struct {
+    TensorExprOp op;
+    int lhs, rhs;
+    int input;
+    ttype value;
+} TensorExprNode;
+
+/**
+ * A recorded chain of element-wise operations over tensors and scalar constants.
+ *
+ * Nodes are appended in evaluation order, so every operation refers to earlier
+ * nodes and the last node is the result. The whole chain is evaluated in a single
+ * pass over memory, without full-size temporaries.
+ *
+ * Example: `a * s + b - c` is
+ *     TensorExpr e;
+ *     lwt_expr_init(&e);
+ *     lwt_expr_sub(&e, lwt_expr_add(&e, lwt_expr_mul(&e, lwt_expr_tensor(&e, a), lwt_expr_scalar(&e, s)),
+ *         lwt_expr_tensor(&e, b)), lwt_expr_tensor(&e, c));
+ *     lwt_expr_eval_into(&e, out);
+ */
+typedef struct {
+    TensorExprNode nodes[LWT_EXPR_MAX_NODES];
+    Tensor inputs[LWT_EXPR_MAX_INPUTS];
+    int node_count;
+    int input_count;
+    int overflow;
+} TensorExpr;
+
+/**
+ * Initializes an empty expression.
+ *
+ * @param expr The expression to initialize.
+ */
+void lwt_expr_init(TensorExpr* expr) {
+    expr->node_count = 0;
+    expr->input_count = 0;
+    expr->overflow = 0;
+}
+
+/**
+ * Appends a node to an expression.
+ *
+ * @param expr The expression.
+ * @param node The node to append.
+ * @return     Index of the node, or -1 if the expression is full.
+ */
+int lwt_expr_push(TensorExpr* expr, TensorExprNode node) {
+
+    if(expr->node_count == LWT_EXPR_MAX_NODES) {
+        expr->overflow = 1;
+        return -1;
+    }
+
+    expr->nodes[expr->node_count] = node;
+    return expr->node_count ++;
+}
+
+/**
+ * Adds a tensor operand to an expression.
+ *
+ * @param expr   The expression.
+ * @param tensor The tensor (or view) read by the expression; it must outlive the evaluation.
+ * @return       Index of the node, or -1 if the expression is full.
+ *
+ * Note: Adding the same tensor several times only reads it once per element.
+ */
+int lwt_expr_tensor(TensorExpr* expr, Tensor tensor) {
+
+    int input = 0;
+    while(input < expr->input_count) {
+
+        Tensor other = expr->inputs[input];
+
+        int same = other.components == tensor.components && other.rank == tensor.rank;
+        for(unsigned int i = 0; i < tensor.rank && same; i ++)
+            same = other.shape[i] == tensor.shape[i] && other.strides[i] == tensor.strides[i];
+
+        if(same)
+            break;
+        input ++;
+    }
+
+    if(input == expr->input_count) {
+
+        if(input == LWT_EXPR_MAX_INPUTS) {
+            expr->overflow = 1;
+            return -1;
+        }
+
+        expr->inputs[expr->input_count ++] = tensor;
+    }
+
+    TensorExprNode node = { LWT_EXPR_TENSOR, -1, -1, input, 0.0 };
+    return lwt_expr_push(expr, node);
+}
+
+/**
+ * Adds a scalar constant to an expression.
+ *
+ * @param expr  The expression.
+ * @param value The constant.
+ * @return      Index of the node, or -1 if the expression is full.
+ */
+int lwt_expr_scalar(TensorExpr* expr, ttype value) {
+    TensorExprNode node = { LWT_EXPR_SCALAR, -1, -1, -1, value };
+    return lwt_expr_push(expr, node);
+}
+
+/**
+ * Applies an arithmetic operation to one block of operands.
+ *
+ * @param op  One of LWT_EXPR_ADD, LWT_EXPR_SUB, LWT_EXPR_MUL or LWT_EXPR_DIV.
+ * @param n   Number of elements.
+ * @param out Contiguous destination.
+ * @param a   First operand.
+ * @param sa  Stride of `a` (0 for a scalar).
+ * @param b   Second operand.
+ * @param sb  Stride of `b` (0 for a scalar).
+ */
+void lwt_expr_apply(TensorExprOp op, size_t n, ttype* out,
+    const ttype* a, ptrdiff_t sa, const ttype* b, ptrdiff_t sb) {
+
+    if(sa == 1 && sb == 1 && lwt_simd_binary(op, n, out, a, b))
+        return;
+    if(sa == 1 && sb == 0 && lwt_simd_scalar(op, n, out, a, *b))
+        return;
+    if(sa == 0 && sb == 1 && (op == LWT_EXPR_ADD || op == LWT_EXPR_MUL) && lwt_simd_scalar(op, n, out, b, *a))
+        return;
+
+    switch(op) {
+        case LWT_EXPR_ADD: for(size_t i = 0; i < n; i ++) out[i] = a[i * sa] + b[i * sb]; break;
+        case LWT_EXPR_SUB: for(size_t i = 0; i < n; i ++) out[i] = a[i * sa] - b[i * sb]; break;
+        case LWT_EXPR_MUL: for(size_t i = 0; i < n; i ++) out[i] = a[i * sa] * b[i * sb]; break;
+        case LWT_EXPR_DIV: for(size_t i = 0; i < n; i ++) out[i] = a[i * sa] / b[i * sb]; break;
+        default: break;
+    }
+}
+
+/**
+ * Records an arithmetic operation between two nodes of an expression.
+ *
+ * @param expr The expression.
+ * @param op   One of LWT_EXPR_ADD, LWT_EXPR_SUB, LWT_EXPR_MUL or LWT_EXPR_DIV.
+ * @param lhs  Index of the first operand node.
+ * @param rhs  Index of the second operand node.
+ * @return     Index of the node, or -1 if the operation or an operand is invalid or the
+ *             expression is full.
+ *
+ * Note: Operations between two scalar constants are folded right away.
+ */
+int lwt_expr_binary(TensorExpr* expr, TensorExprOp op, int lhs, int rhs) {
+
+    if(op != LWT_EXPR_ADD && op != LWT_EXPR_SUB && op != LWT_EXPR_MUL && op != LWT_EXPR_DIV) {
+        expr->overflow = 1;
+        return -1;
+    }
+
+    if(lhs < 0 || rhs < 0 || lhs >= expr->node_count || rhs >= expr->node_count) {
+        expr->overflow = 1;
+        return -1;
+    }
+
+    if(expr->nodes[lhs].op == LWT_EXPR_SCALAR && expr->nodes[rhs].op == LWT_EXPR_SCALAR) {
+
+        ttype value;
+        lwt_expr_apply(op, 1, &value, &expr->nodes[lhs].value, 0, &expr->nodes[rhs].value, 0);
+        return lwt_expr_scalar(expr, value);
+    }
+
+    TensorExprNode node = { op, lhs, rhs, -1, 0.0 };
+    return lwt_expr_push(expr, node);
+}
+
+int lwt_expr_add(TensorExpr* expr, int lhs, int rhs) {
+    return lwt_expr_binary(expr, LWT_EXPR_ADD, lhs, rhs);
+}
+
+int lwt_expr_sub(TensorExpr* expr, int lhs, int rhs) {
+    return lwt_expr_binary(expr, LWT_EXPR_SUB, lhs, rhs);
+}
+
+int lwt_expr_mul(TensorExpr* expr, int lhs, int rhs) {
+    return lwt_expr_binary(expr, LWT_EXPR_MUL, lhs, rhs);
+}
+
+int lwt_expr_div(TensorExpr* expr, int lhs, int rhs) {
+    return lwt_expr_binary(expr, LWT_EXPR_DIV, lhs, rhs);
+}
+
+typedef struct {
+    const TensorExpr* expr;
+    Tensor operands[LWT_MAX_OPERANDS];
+    TensorIterator it;
+} LwtExprJob;
+
+void lwt_expr_task(void* context, size_t begin, size_t end, int thread) {
+
+    (void) thread;
+    LwtExprJob* job = (LwtExprJob*) context;
+    const TensorExpr* expr = job->expr;
+    TensorIterator it = job->it;
+
+    int root = expr->node_count - 1;
+
+    _Alignas(LWT_ALIGNMENT) ttype buffers[LWT_EXPR_MAX_NODES][LWT_EXPR_BLOCK];
+    const ttype* values[LWT_EXPR_MAX_NODES];
+    ptrdiff_t steps[LWT_EXPR_MAX_NODES];
+
+    while(begin < end) {
+
+        tensor_iterator_seek(&it, begin);
+
+        size_t n = it.shape[0] - it.index[0];
+        n = n < end - begin ? n : end - begin;
+
+        ttype* destination = job->operands[0].components + it.offsets[0];
+        ptrdiff_t so = it.strides[0][0];
+
+        for(size_t start = 0; start < n; start += LWT_EXPR_BLOCK) {
+
+            size_t length = n - start < LWT_EXPR_BLOCK ? n - start : LWT_EXPR_BLOCK;
+
+            for(int i = 0; i <= root; i ++) {
+
+                const TensorExprNode* node = &expr->nodes[i];
+
+                if(node->op == LWT_EXPR_TENSOR) {
+                    ptrdiff_t stride = it.strides[0][node->input + 1];
+                    values[i] = job->operands[node->input + 1].components + it.offsets[node->input + 1] + start * stride;
+                    steps[i] = stride;
+                }
+                else if(node->op == LWT_EXPR_SCALAR) {
+                    values[i] = &node->value;
+                    steps[i] = 0;
+                }
+                else {
+                    ttype* result = i == root && so == 1 ? destination + start : buffers[i];
+                    lwt_expr_apply(node->op, length, result,
+                        values[node->lhs], steps[node->lhs], values[node->rhs], steps[node->rhs]);
+
+                    values[i] = result;
+                    steps[i] = 1;
+                }
+            }
+
+            if(values[root] != destination + start) {
+                for(size_t j = 0; j < length; j ++)
+                    destination[(start + j) * so] = values[root][j * steps[root]];
+            }
+        }
+
+        begin += n;
+    }
+}
+
+/**
+ * Evaluates an expression into a preallocated tensor in one fused pass.
+ *
+ * @param expr The expression; its last node is the result.
+ * @param out  Output tensor (or view); every tensor operand is broadcast to its shape.
+ *             It may be one of the operands as long as it is the exact same view.
+ * @return     TENSOR_OK, TENSOR_ERROR_SHAPE if an operand does not broadcast to `out`,
+ *             TENSOR_ERROR_LIMIT if building the expression ran out of nodes or inputs,
+ *             TENSOR_ERROR_DTYPE if a tensor is not of type `ttype`.
+ *
+ * Note: The operands are walked block by block; intermediate results of a block
+ * stay in a small stack buffer, so memory is read and written only once. Large
+ * tensors are split over the current thread pool.
+ */
+TensorStatus lwt_expr_eval_into(const TensorExpr* expr, Tensor out) {
+
+    if(expr->overflow || expr->node_count == 0)
+        return TENSOR_ERROR_LIMIT;
+    if(out.dtype != TENSOR_NATIVE)
+        return TENSOR_ERROR_DTYPE;
+
+    LwtExprJob job;
+    job.expr = expr;
+    job.operands[0] = out;
+
+    for(int k = 0; k < expr->input_count; k ++) {
+        if(expr->inputs[k].dtype != TENSOR_NATIVE)
+            return TENSOR_ERROR_DTYPE;
+        if(lwt_broadcast_operand(expr->inputs[k], out, &job.operands[k + 1]) != TENSOR_OK)
+            return TENSOR_ERROR_SHAPE;
+    }
+
+    if(tensor_iterator_init(&job.it, expr->input_count + 1, job.operands))
+        lwt_parallel_for(get_length(out), LWT_PARALLEL_GRAIN, lwt_expr_task, &job);
+
+    return TENSOR_OK;
+}
+
+/**
+ * Evaluates an expression into a new tensor.
+ *
+ * @param expr The expression; it must read at least one tensor.
+ * @return     A new tensor with the broadcast shape of the tensor operands, or the
+ *             empty tensor if the expression is invalid.
+ */
+Tensor lwt_expr_eval(const TensorExpr* expr) {
+
+    if(expr->input_count == 0)
+        return lwt_empty_tensor();
+
+    LWT_OP_ENTER("expr");
+
+    int extents[LWT_MAX_RANK];
+    Tensor shape = expr->inputs[0];
+
+    for(int k = 1; k < expr->input_count && shape.shape != NULL; k ++) {
+
+        int broadcast[LWT_MAX_RANK];
+        if(lwt_broadcast_shape(shape, expr->inputs[k], &shape.rank, broadcast) != TENSOR_OK) {
+            shape.shape = NULL;
+            break;
+        }
+
+        memcpy(extents, broadcast, sizeof(int) * shape.rank);
+        shape.shape = extents;
+    }
+
+    Tensor tensor = lwt_empty_tensor();
+
+    if(shape.shape != NULL) {
+
+        tensor = lwt_create_shaped(shape.rank, shape.shape);
+
+        if(lwt_expr_eval_into(expr, tensor) != TENSOR_OK) {
+            destroy_tensor(tensor);
+            tensor = lwt_empty_tensor();
+        }
+    }
+
+    LWT_OP_LEAVE();
+    return tensor;
+}
\ No newline at end of file
@@ -0,0 +1,952 @@
+/*
+  MIT License
+  
+  Copyright (c) 2025 Morcillo Sanz
+  
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+  
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+  
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  SOFTWARE.
+*/
+
+#pragma once
+
+#include <stddef.h>
+
+#include "tensor.h"
+
+/*
+ * Blocking parameters of the GEMM engine.
+ *
+ * MR x NR is the register tile computed by the micro-kernel, KC x NR is the
+ * packed B micro-panel that should stay in L1, MC x KC is the packed A block
+ * that should stay in L2 and KC x NC is the packed B block that should stay in L3.
+ * MC must be a multiple of MR and NC a multiple of NR. On x86 the tile is the one of
+ * the SIMD tile kernels in simd.h (64 bytes of rows by LWT_SIMD_TILE_COLS columns);
+ * other sizes fall back to the portable micro-kernel.
+ */
+#ifndef LWT_GEMM_MR
+#if defined(LWT_SIMD_X86)
+#define LWT_GEMM_MR ((int) (64 / sizeof(ttype)))
+#else
+#define LWT_GEMM_MR 4
+#endif
+#endif
+
+#ifndef LWT_GEMM_NR
+#if defined(LWT_SIMD_X86)
+#define LWT_GEMM_NR LWT_SIMD_TILE_COLS
+#else
+#define LWT_GEMM_NR 4
+#endif
+#endif
+
+#ifndef LWT_GEMM_KC
+#define LWT_GEMM_KC 256
+#endif
+
+#ifndef LWT_GEMM_MC
+#define LWT_GEMM_MC (LWT_GEMM_MR * 16)
+#endif
+
+#ifndef LWT_GEMM_NC
+#define LWT_GEMM_NC (LWT_GEMM_NR * 170)
+#endif
+
+/**
+ * Packs an mc x kc block of A into MR-row micro-panels.
+ *
+ * @param mc     Number of rows of the block.
+ * @param kc     Number of columns of the block.
+ * @param A      Pointer to the first element of the block.
+ * @param rsa    Row stride of A.
+ * @param csa    Column stride of A.
+ * @param buffer Destination buffer of at least ceil(mc / MR) * MR * kc elements.
+ *
+ * Note: Rows past `mc` in the last micro-panel are zero padded.
+ */
+void lwt_gemm_pack_a(int mc, int kc, const ttype* A, ptrdiff_t rsa, ptrdiff_t csa, ttype* buffer) {
+
+    for(int i0 = 0; i0 < mc; i0 += LWT_GEMM_MR) {
+
+        int rows = mc - i0 < LWT_GEMM_MR ? mc - i0 : LWT_GEMM_MR;
+        const ttype* panel = A + i0 * rsa;
+
+        for(int p = 0; p < kc; p ++) {
+
+            const ttype* column = panel + p * csa;
+
+            for(int i = 0; i < rows; i ++)
+                buffer[i] = column[i * rsa];
+            for(int i = rows; i < LWT_GEMM_MR; i ++)
+                buffer[i] = 0.0;
+
+            buffer += LWT_GEMM_MR;
+        }
+    }
+}
+
+/**
+ * Packs a kc x nc block of B into NR-column micro-panels.
+ *
+ * @param kc     Number of rows of the block.
+ * @param nc     Number of columns of the block.
+ * @param B      Pointer to the first element of the block.
+ * @param rsb    Row stride of B.
+ * @param csb    Column stride of B.
+ * @param buffer Destination buffer of at least kc * ceil(nc / NR) * NR elements.
+ *
+ * Note: Columns past `nc` in the last micro-panel are zero padded.
+ */
+void lwt_gemm_pack_b(int kc, int nc, const ttype* B, ptrdiff_t rsb, ptrdiff_t csb, ttype* buffer) {
+
+    for(int j0 = 0; j0 < nc; j0 += LWT_GEMM_NR) {
+
+        int cols = nc - j0 < LWT_GEMM_NR ? nc - j0 : LWT_GEMM_NR;
+        const ttype* panel = B + j0 * csb;
+
+        for(int p = 0; p < kc; p ++) {
+
+            const ttype* row = panel + p * rsb;
+
+            for(int j = 0; j < cols; j ++)
+                buffer[j] = row[j * csb];
+            for(int j = cols; j < LWT_GEMM_NR; j ++)
+                buffer[j] = 0.0;
+
+            buffer += LWT_GEMM_NR;
+        }
+    }
+}
+
+/**
+ * Computes an MR x NR register tile from a packed A micro-panel and a packed B micro-panel.
+ *
+ * @param kc Depth of the product.
+ * @param a  Packed A micro-panel (kc groups of MR elements).
+ * @param b  Packed B micro-panel (kc groups of NR elements).
+ * @param ab Output tile of MR x NR elements, stored column by column.
+ *
+ * Note: Runs the FMA tile kernel of the current SIMD level when the tile matches it.
+ * Otherwise the loops have compile-time bounds so the compiler keeps the accumulators
+ * in registers and vectorizes along MR.
+ */
+void lwt_gemm_micro_kernel(int kc, const ttype* restrict a, const ttype* restrict b, ttype* restrict ab) {
+
+    int level = lwt_simd_level();
+
+    if(level != LWT_SIMD_SCALAR && LWT_GEMM_MR * sizeof(ttype) == 64 && LWT_GEMM_NR == LWT_SIMD_TILE_COLS) {
+
+        if(sizeof(ttype) == sizeof(double)) {
+            lwt_simd_tile_f64[level](kc, (const double*) a, (const double*) b, (double*) ab);
+            return;
+        }
+        if(sizeof(ttype) == sizeof(float)) {
+            lwt_simd_tile_f32[level](kc, (const float*) a, (const float*) b, (float*) ab);
+            return;
+        }
+    }
+
+    ttype acc[LWT_GEMM_MR * LWT_GEMM_NR];
+    for(int i = 0; i < LWT_GEMM_MR * LWT_GEMM_NR; i ++)
+        acc[i] = 0.0;
+
+    for(int p = 0; p < kc; p ++) {
+
+        for(int j = 0; j < LWT_GEMM_NR; j ++) {
+
+            ttype bj = b[j];
+            for(int i = 0; i < LWT_GEMM_MR; i ++)
+                acc[j * LWT_GEMM_MR + i] += a[i] * bj;
+        }
+
+        a += LWT_GEMM_MR;
+        b += LWT_GEMM_NR;
+    }
+
+    for(int i = 0; i < LWT_GEMM_MR * LWT_GEMM_NR; i ++)
+        ab[i] = acc[i];
+}
+
+/**
+ * Multiplies a packed A block by a packed B block and accumulates into C.
+ *
+ * @param mc    Rows of the block.
+ * @param nc    Columns of the block.
+ * @param kc    Depth of the block.
+ * @param alpha Scale applied to the product.
+ * @param a     Packed A block.
+ * @param b     Packed B block.
+ * @param beta  Scale applied to the existing contents of C (0 overwrites C).
+ * @param C     Pointer to the first element of the C block.
+ * @param rsc   Row stride of C.
+ * @param csc   Column stride of C.
+ */
+void lwt_gemm_macro_kernel(int mc, int nc, int kc, ttype alpha, const ttype* a, const ttype* b,
+    ttype beta, ttype* C, ptrdiff_t rsc, ptrdiff_t csc) {
+
+    ttype ab[LWT_GEMM_MR * LWT_GEMM_NR];
+
+    for(int jr = 0; jr < nc; jr += LWT_GEMM_NR) {
+
+        int cols = nc - jr < LWT_GEMM_NR ? nc - jr : LWT_GEMM_NR;
+        const ttype* b_panel = b + (size_t) jr * kc;
+
+        for(int ir = 0; ir < mc; ir += LWT_GEMM_MR) {
+
+            int rows = mc - ir < LWT_GEMM_MR ? mc - ir : LWT_GEMM_MR;
+            const ttype* a_panel = a + (size_t) ir * kc;
+
+            lwt_gemm_micro_kernel(kc, a_panel, b_panel, ab);
+
+            ttype* tile = C + ir * rsc + jr * csc;
+            for(int j = 0; j < cols; j ++) {
+                for(int i = 0; i < rows; i ++) {
+
+                    ttype* c = tile + i * rsc + j * csc;
+                    ttype value = alpha * ab[j * LWT_GEMM_MR + i];
+                    *c = beta == 0.0 ? value : value + beta * (*c);
+                }
+            }
+        }
+    }
+}
+
+/**
+ * Scales C by beta, the whole product when alpha or the depth is zero.
+ *
+ * @param m    Rows of C.
+ * @param n    Columns of C.
+ * @param beta Scale (0 overwrites C with zeros, NaNs included).
+ * @param C    Pointer to the first element of C.
+ * @param rsc  Row stride of C.
+ * @param csc  Column stride of C.
+ */
+void lwt_gemm_scale(int m, int n, ttype beta, ttype* C, ptrdiff_t rsc, ptrdiff_t csc) {
+
+    for(int j = 0; j < n; j ++) {
+        for(int i = 0; i < m; i ++) {
+            ttype* c = C + i * rsc + j * csc;
+            *c = beta == 0.0 ? 0.0 : beta * (*c);
+        }
+    }
+}
+
+/*
+ * Products with at most this many multiply-adds skip packing in `lwt_gemm` and `lwt_gemm_serial`:
+ * the operands of such a product already sit in L1, and padding them to whole
+ * register tiles would cost more than it saves.
+ */
+#ifndef LWT_GEMM_SMALL_MAX
+#define LWT_GEMM_SMALL_MAX 256
+#endif
+
+/**
+ * Size in elements of the packed B buffer `lwt_gemm_serial` needs for a given product.
+ *
+ * @param n Columns of B and C.
+ * @param k Columns of A and rows of B.
+ * @return  Number of elements.
+ */
+size_t lwt_gemm_b_pack_size(int n, int k) {
+
+    int kc = k < LWT_GEMM_KC ? k : LWT_GEMM_KC;
+    int nc = n < LWT_GEMM_NC ? n : LWT_GEMM_NC;
+
+    return (size_t) kc * ((nc + LWT_GEMM_NR - 1) / LWT_GEMM_NR * LWT_GEMM_NR);
+}
+
+/**
+ * Computes C = alpha * A * B + beta * C on the calling thread with caller-provided buffers.
+ *
+ * @param m      Rows of A and C.
+ * @param n      Columns of B and C.
+ * @param k      Columns of A and rows of B.
+ * @param alpha  Scale applied to the product.
+ * @param A      Pointer to the first element of A.
+ * @param rsa    Row stride of A.
+ * @param csa    Column stride of A.
+ * @param B      Pointer to the first element of B.
+ * @param rsb    Row stride of B.
+ * @param csb    Column stride of B.
+ * @param beta   Scale applied to the existing contents of C (0 overwrites C).
+ * @param C      Pointer to the first element of C.
+ * @param rsc    Row stride of C.
+ * @param csc    Column stride of C.
+ * @param a_pack Buffer of LWT_GEMM_MC * LWT_GEMM_KC elements.
+ * @param b_pack Buffer of `lwt_gemm_b_pack_size(n, k)` elements.
+ *
+ * Note: The building block of batched products, which run many of these side by side
+ * and so must neither allocate nor spawn work per product. Products of at most
+ * LWT_GEMM_SMALL_MAX multiply-adds are computed directly and leave the buffers untouched.
+ */
+void lwt_gemm_serial(int m, int n, int k, ttype alpha,
+    const ttype* A, ptrdiff_t rsa, ptrdiff_t csa,
+    const ttype* B, ptrdiff_t rsb, ptrdiff_t csb,
+    ttype beta, ttype* C, ptrdiff_t rsc, ptrdiff_t csc,
+    ttype* a_pack, ttype* b_pack) {
+
+    if(m <= 0 || n <= 0)
+        return;
+
+    if(alpha == 0.0 || k <= 0) {
+        lwt_gemm_scale(m, n, beta, C, rsc, csc);
+        return;
+    }
+
+    if((double) m * n * k <= LWT_GEMM_SMALL_MAX) {
+
+        for(int j = 0; j < n; j ++) {
+            for(int i = 0; i < m; i ++) {
+
+                ttype sum = 0.0;
+                for(int p = 0; p < k; p ++)
+                    sum += A[i * rsa + p * csa] * B[p * rsb + j * csb];
+
+                ttype* c = C + i * rsc + j * csc;
+                *c = beta == 0.0 ? alpha * sum : alpha * sum + beta * (*c);
+            }
+        }
+
+        return;
+    }
+
+    for(int jc = 0; jc < n; jc += LWT_GEMM_NC) {
+
+        int nc = n - jc < LWT_GEMM_NC ? n - jc : LWT_GEMM_NC;
+
+        for(int pc = 0; pc < k; pc += LWT_GEMM_KC) {
+
+            int kc = k - pc < LWT_GEMM_KC ? k - pc : LWT_GEMM_KC;
+            lwt_gemm_pack_b(kc, nc, B + pc * rsb + jc * csb, rsb, csb, b_pack);
+
+            for(int ic = 0; ic < m; ic += LWT_GEMM_MC) {
+
+                int mc = m - ic < LWT_GEMM_MC ? m - ic : LWT_GEMM_MC;
+                lwt_gemm_pack_a(mc, kc, A + ic * rsa + pc * csa, rsa, csa, a_pack);
+
+                lwt_gemm_macro_kernel(mc, nc, kc, alpha, a_pack, b_pack, pc == 0 ? beta : 1.0,
+                    C + ic * rsc + jc * csc, rsc, csc);
+            }
+        }
+    }
+}
+
+/*
+ * Number of products `lwt_gemm_lanes` computes side by side, and the largest product
+ * (in multiply-adds) it is used for; past that the packed kernel wins again.
+ */
+#ifndef LWT_GEMM_LANES
+#define LWT_GEMM_LANES 32
+#endif
+
+#ifndef LWT_GEMM_LANES_MAX
+#define LWT_GEMM_LANES_MAX 32768
+#endif
+
+/**
+ * Computes C = alpha * A * B + beta * C for LWT_GEMM_LANES interleaved products.
+ *
+ * Element (i, j) of product l is at `C + l + i * rsc + j * csc`, and likewise for A and
+ * B with a lane stride of 1, or 0 when one matrix is shared by every product. This is
+ * the layout of a contiguous tensor whose first axis indexes the batch, and the one
+ * that vectorizes best for small matrices: each multiply-add runs across the lanes.
+ *
+ * @param m     Rows of A and C.
+ * @param n     Columns of B and C.
+ * @param k     Columns of A and rows of B.
+ * @param alpha Scale applied to the products.
+ * @param A     Pointer to the first element of A in the first lane.
+ * @param lsa   Lane stride of A (0 or 1).
+ * @param rsa   Row stride of A.
+ * @param csa   Column stride of A.
+ * @param B     Pointer to the first element of B in the first lane.
+ * @param lsb   Lane stride of B (0 or 1).
+ * @param rsb   Row stride of B.
+ * @param csb   Column stride of B.
+ * @param beta  Scale applied to the existing contents of C (0 overwrites C).
+ * @param C     Pointer to the first element of C in the first lane.
+ * @param rsc   Row stride of C.
+ * @param csc   Column stride of C.
+ *
+ * Note: The lane loops have compile-time bounds, like the micro-kernel's, so the
+ * accumulators stay in registers.
+ */
+void lwt_gemm_lanes(int m, int n, int k, ttype alpha,
+    const ttype* A, ptrdiff_t lsa, ptrdiff_t rsa, ptrdiff_t csa,
+    const ttype* B, ptrdiff_t lsb, ptrdiff_t rsb, ptrdiff_t csb,
+    ttype beta, ttype* C, ptrdiff_t rsc, ptrdiff_t csc) {
+
+    ttype acc[LWT_GEMM_LANES];
+
+    for(int j = 0; j < n; j ++) {
+        for(int i = 0; i < m; i ++) {
+
+            for(int l = 0; l < LWT_GEMM_LANES; l ++)
+                acc[l] = 0.0;
+
+            const ttype* a = A + i * rsa;
+            const ttype* b = B + j * csb;
+
+            if(lsa != 0 && lsb != 0) {
+                for(int p = 0; p < k; p ++) {
+                    for(int l = 0; l < LWT_GEMM_LANES; l ++)
+                        acc[l] += a[p * csa + l] * b[p * rsb + l];
+                }
+            }
+            else if(lsa != 0) {
+                for(int p = 0; p < k; p ++) {
+                    ttype bp = b[p * rsb];
+                    for(int l = 0; l < LWT_GEMM_LANES; l ++)
+                        acc[l] += a[p * csa + l] * bp;
+                }
+            }
+            else if(lsb != 0) {
+                for(int p = 0; p < k; p ++) {
+                    ttype ap = a[p * csa];
+                    for(int l = 0; l < LWT_GEMM_LANES; l ++)
+                        acc[l] += ap * b[p * rsb + l];
+                }
+            }
+            else {
+                ttype sum = 0.0;
+                for(int p = 0; p < k; p ++)
+                    sum += a[p * csa] * b[p * rsb];
+                for(int l = 0; l < LWT_GEMM_LANES; l ++)
+                    acc[l] = sum;
+            }
+
+            ttype* c = C + i * rsc + j * csc;
+            for(int l = 0; l < LWT_GEMM_LANES; l ++)
+                c[l] = beta == 0.0 ? alpha * acc[l] : alpha * acc[l] + beta * c[l];
+        }
+    }
+}
+
+/*
+ * Products with fewer multiply-adds than this run on the calling thread only.
+ */
+#ifndef LWT_GEMM_PARALLEL_MIN
+#define LWT_GEMM_PARALLEL_MIN ((double) (1 << 21))
+#endif
+
+/*
+ * One packed B block shared by every thread; each task packs its own A block and
+ * updates a disjoint mc x (column group) tile of C.
+ */
+typedef struct {
+    int m, nc, kc, groups, group_width;
+    ttype alpha, beta;
+    const ttype* A;
+    ptrdiff_t rsa, csa;
+    const ttype* b_pack;
+    ttype* C;
+    ptrdiff_t rsc, csc;
+    ttype** a_packs;
+} LwtGemmJob;
+
+void lwt_gemm_task(void* context, size_t begin, size_t end, int thread) {
+
+    LwtGemmJob* job = (LwtGemmJob*) context;
+
+    if(job->a_packs[thread] == NULL)
+        job->a_packs[thread] = (ttype*) lwt_malloc_aligned(sizeof(ttype) * LWT_GEMM_MC * LWT_GEMM_KC);
+
+    ttype* a_pack = job->a_packs[thread];
+    int packed = -1;
+
+    for(size_t t = begin; t < end; t ++) {
+
+        int ic = (int) (t / job->groups) * LWT_GEMM_MC;
+        int jr = (int) (t % job->groups) * job->group_width;
+        if(jr >= job->nc)
+            continue;
+
+        int mc = job->m - ic < LWT_GEMM_MC ? job->m - ic : LWT_GEMM_MC;
+        int cols = job->nc - jr < job->group_width ? job->nc - jr : job->group_width;
+
+        if(packed != ic) {
+            lwt_gemm_pack_a(mc, job->kc, job->A + ic * job->rsa, job->rsa, job->csa, a_pack);
+            packed = ic;
+        }
+
+        lwt_gemm_macro_kernel(mc, cols, job->kc, job->alpha, a_pack, job->b_pack + (size_t) jr * job->kc,
+            job->beta, job->C + ic * job->rsc + jr * job->csc, job->rsc, job->csc);
+    }
+}
+
+/**
+ * Computes C = alpha * A * B + beta * C on general strided operands.
+ *
+ * @param m     Rows of A and C.
+ * @param n     Columns of B and C.
+ * @param k     Columns of A and rows of B.
+ * @param alpha Scale applied to the product.
+ * @param A     Pointer to the first element of A.
+ * @param rsa   Row stride of A.
+ * @param csa   Column stride of A.
+ * @param B     Pointer to the first element of B.
+ * @param rsb   Row stride of B.
+ * @param csb   Column stride of B.
+ * @param beta  Scale applied to the existing contents of C (0 overwrites C, NaNs included).
+ * @param C     Pointer to the first element of C.
+ * @param rsc   Row stride of C.
+ * @param csc   Column stride of C.
+ *
+ * Note: A and B are packed into cache-sized panels, so any stride combination
+ * runs at the same speed. C must not overlap A or B. Large products are split
+ * into row blocks (and column groups) over the current thread pool; products of
+ * at most LWT_GEMM_SMALL_MAX multiply-adds are computed directly, without packing.
+ */
+void lwt_gemm(int m, int n, int k, ttype alpha,
+    const ttype* A, ptrdiff_t rsa, ptrdiff_t csa,
+    const ttype* B, ptrdiff_t rsb, ptrdiff_t csb,
+    ttype beta, ttype* C, ptrdiff_t rsc, ptrdiff_t csc) {
+
+    if(m <= 0 || n <= 0)
+        return;
+
+    if(alpha == 0.0 || k <= 0) {
+        lwt_gemm_scale(m, n, beta, C, rsc, csc);
+        return;
+    }
+
+    if((double) m * n * k <= LWT_GEMM_SMALL_MAX) {
+        lwt_gemm_serial(m, n, k, alpha, A, rsa, csa, B, rsb, csb, beta, C, rsc, csc, NULL, NULL);
+        return;
+    }
+
+    LWT_OP_ENTER("gemm");
+
+    int threads = (double) m * n * k < LWT_GEMM_PARALLEL_MIN ? 1 : lwt_parallel_threads();
+
+    size_t b_bytes = sizeof(ttype) * lwt_gemm_b_pack_size(n, k);
+    ttype* b_pack = (ttype*) lwt_malloc_aligned(b_bytes);
+
+    ttype* a_packs[LWT_MAX_THREADS] = { NULL };
+
+    LwtGemmJob job;
+    job.m = m;
+    job.alpha = alpha;
+    job.rsa = rsa;
+    job.csa = csa;
+    job.b_pack = b_pack;
+    job.rsc = rsc;
+    job.csc = csc;
+    job.a_packs = a_packs;
+
+    int row_blocks = (m + LWT_GEMM_MC - 1) / LWT_GEMM_MC;
+
+    for(int jc = 0; jc < n; jc += LWT_GEMM_NC) {
+
+        int nc = n - jc < LWT_GEMM_NC ? n - jc : LWT_GEMM_NC;
+
+        /* Split the columns as well when there are too few row blocks to keep every thread busy. */
+        int panels = (nc + LWT_GEMM_NR - 1) / LWT_GEMM_NR;
+        int groups = 1;
+        while(row_blocks * groups < 2 * threads && panels / (groups * 2) >= 4)
+            groups *= 2;
+
+        job.nc = nc;
+        job.groups = groups;
+        job.group_width = (panels + groups - 1) / groups * LWT_GEMM_NR;
+
+        for(int pc = 0; pc < k; pc += LWT_GEMM_KC) {
+
+            int kc = k - pc < LWT_GEMM_KC ? k - pc : LWT_GEMM_KC;
+
+            lwt_gemm_pack_b(kc, nc, B + pc * rsb + jc * csb, rsb, csb, b_pack);
+
+            job.kc = kc;
+            job.beta = pc == 0 ? beta : 1.0;
+            job.A = A + pc * csa;
+            job.C = C + jc * csc;
+
+            size_t tasks = (size_t) row_blocks * groups;
+            if(threads == 1)
+                lwt_gemm_task(&job, 0, tasks, 0);
+            else
+                lwt_parallel_for(tasks, 1, lwt_gemm_task, &job);
+        }
+    }
+
+    for(int i = 0; i < LWT_MAX_THREADS; i ++) {
+        if(a_packs[i] != NULL)
+            lwt_free_aligned(a_packs[i], sizeof(ttype) * LWT_GEMM_MC * LWT_GEMM_KC);
+    }
+    lwt_free_aligned(b_pack, b_bytes);
+
+    LWT_OP_LEAVE();
+}
+
+/*
+ * Products with a long inner dimension and a small result, such as A^T * B for tall A
+ * and B, leave `lwt_gemm` too few row blocks to split. They are split along k instead:
+ * at most LWT_GEMM_SPLIT_MAX slices are multiplied on separate threads into partial
+ * results, which are then combined by a pairwise tree. The slices only depend on k.
+ */
+#ifndef LWT_GEMM_SPLIT_MAX
+#define LWT_GEMM_SPLIT_MAX 64
+#endif
+
+typedef struct {
+    int m, n, k, slice;
+    ttype alpha;
+    const ttype* A;
+    ptrdiff_t rsa, csa;
+    const ttype* B;
+    ptrdiff_t rsb, csb;
+    ttype* partials;
+    ttype** a_packs;
+    ttype** b_packs;
+} LwtGemmSplitJob;
+
+void lwt_gemm_split_task(void* context, size_t begin, size_t end, int thread) {
+
+    LwtGemmSplitJob* job = (LwtGemmSplitJob*) context;
+
+    if(job->a_packs[thread] == NULL) {
+        job->a_packs[thread] = (ttype*) lwt_malloc_aligned(sizeof(ttype) * LWT_GEMM_MC * LWT_GEMM_KC);
+        job->b_packs[thread] = (ttype*) lwt_malloc_aligned(sizeof(ttype) * lwt_gemm_b_pack_size(job->n, job->slice));
+    }
+
+    for(size_t t = begin; t < end; t ++) {
+
+        int p = (int) t * job->slice;
+        int kc = job->k - p < job->slice ? job->k - p : job->slice;
+
+        lwt_gemm_serial(job->m, job->n, kc, job->alpha,
+            job->A + p * job->csa, job->rsa, job->csa,
+            job->B + p * job->rsb, job->rsb, job->csb,
+            0.0, job->partials + t * job->m * job->n, 1, job->m,
+            job->a_packs[thread], job->b_packs[thread]);
+    }
+}
+
+/**
+ * Computes C = alpha * A * B + beta * C, splitting the inner dimension over the thread pool.
+ *
+ * @param m     Rows of A and C.
+ * @param n     Columns of B and C.
+ * @param k     Columns of A and rows of B.
+ * @param alpha Scale applied to the product.
+ * @param A     Pointer to the first element of A.
+ * @param rsa   Row stride of A.
+ * @param csa   Column stride of A.
+ * @param B     Pointer to the first element of B.
+ * @param rsb   Row stride of B.
+ * @param csb   Column stride of B.
+ * @param beta  Scale applied to the existing contents of C (0 overwrites C, NaNs included).
+ * @param C     Pointer to the first element of C.
+ * @param rsc   Row stride of C.
+ * @param csc   Column stride of C.
+ *
+ * Note: Falls back to `lwt_gemm` for small products and results large enough to be split
+ * by rows. Both the choice and the slices depend on the shape only, so the result is the
+ * same for any number of threads.
+ */
+void lwt_gemm_split_k(int m, int n, int k, ttype alpha,
+    const ttype* A, ptrdiff_t rsa, ptrdiff_t csa,
+    const ttype* B, ptrdiff_t rsb, ptrdiff_t csb,
+    ttype beta, ttype* C, ptrdiff_t rsc, ptrdiff_t csc) {
+
+    int slice = (k + LWT_GEMM_SPLIT_MAX - 1) / LWT_GEMM_SPLIT_MAX;
+    slice = (slice + LWT_GEMM_KC - 1) / LWT_GEMM_KC * LWT_GEMM_KC;
+
+    if((double) m * n * k < LWT_GEMM_PARALLEL_MIN || m > LWT_GEMM_MC || slice >= k) {
+        lwt_gemm(m, n, k, alpha, A, rsa, csa, B, rsb, csb, beta, C, rsc, csc);
+        return;
+    }
+
+    LWT_OP_ENTER("gemm");
+
+    int parts = (k + slice - 1) / slice;
+
+    size_t bytes = sizeof(ttype) * parts * m * n;
+    ttype* partials = (ttype*) lwt_malloc_aligned(bytes);
+    ttype* a_packs[LWT_MAX_THREADS] = { NULL };
+    ttype* b_packs[LWT_MAX_THREADS] = { NULL };
+
+    LwtGemmSplitJob job;
+    job.m = m;
+    job.n = n;
+    job.k = k;
+    job.slice = slice;
+    job.alpha = alpha;
+    job.A = A;
+    job.rsa = rsa;
+    job.csa = csa;
+    job.B = B;
+    job.rsb = rsb;
+    job.csb = csb;
+    job.partials = partials;
+    job.a_packs = a_packs;
+    job.b_packs = b_packs;
+
+    lwt_parallel_for((size_t) parts, 1, lwt_gemm_split_task, &job);
+
+    /* Pairwise tree over the partials, always in the same order. */
+    size_t size = (size_t) m * n;
+    for(int step = 1; step < parts; step *= 2) {
+        for(int t = 0; t + step < parts; t += 2 * step) {
+
+            ttype* target = partials + t * size;
+            const ttype* source = partials + (t + step) * size;
+
+            for(size_t i = 0; i < size; i ++)
+                target[i] += source[i];
+        }
+    }
+
+    lwt_gemm_scale(m, n, beta, C, rsc, csc);
+    for(int j = 0; j < n; j ++) {
+        for(int i = 0; i < m; i ++)
+            C[i * rsc + j * csc] += partials[i + (size_t) j * m];
+    }
+
+    for(int i = 0; i < LWT_MAX_THREADS; i ++) {
+        lwt_free_aligned(a_packs[i], sizeof(ttype) * LWT_GEMM_MC * LWT_GEMM_KC);
+        lwt_free_aligned(b_packs[i], sizeof(ttype) * lwt_gemm_b_pack_size(n, slice));
+    }
+    lwt_free_aligned(partials, bytes);
+
+    LWT_OP_LEAVE();
+}
+
+/*
+ * Matrix-vector products stream A once, so they are bound by memory bandwidth. The rows
+ * of y are split into blocks of LWT_GEMV_ROWS, which stay in L1 while every column of A
+ * is added to them; products with at least LWT_GEMV_PARALLEL_MIN elements of A spread
+ * the blocks over the thread pool.
+ */
+#ifndef LWT_GEMV_ROWS
+#define LWT_GEMV_ROWS 512
+#endif
+
+#ifndef LWT_GEMV_PARALLEL_MIN
+#define LWT_GEMV_PARALLEL_MIN ((double) (1 << 16))
+#endif
+
+/**
+ * Adds four scaled unit-stride columns to y with the SIMD kernels when available.
+ *
+ * @param n   Number of rows.
+ * @param y   Contiguous destination.
+ * @param a   First column; the next ones follow at `lda` elements.
+ * @param lda Distance between columns.
+ * @param s   The four scales.
+ */
+void lwt_gemv_axpy4(size_t n, ttype* y, const ttype* a, ptrdiff_t lda, const ttype* s) {
+
+    int level = lwt_simd_level();
+
+    if(level != LWT_SIMD_SCALAR && sizeof(ttype) == sizeof(double)) {
+        lwt_simd_axpy4_f64[level](n, (double*) y, (const double*) a, lda, (const double*) s);
+        return;
+    }
+    if(level != LWT_SIMD_SCALAR && sizeof(ttype) == sizeof(float)) {
+        lwt_simd_axpy4_f32[level](n, (float*) y, (const float*) a, lda, (const float*) s);
+        return;
+    }
+
+    for(size_t i = 0; i < n; i ++)
+        y[i] = y[i] + a[i] * s[0] + a[lda + i] * s[1] + a[2 * lda + i] * s[2] + a[3 * lda + i] * s[3];
+}
+
+/**
+ * Computes four dot products of unit-stride rows with x, with the SIMD kernels when available.
+ *
+ * @param n   Length of the rows.
+ * @param a   First row; the next ones follow at `lda` elements.
+ * @param lda Distance between rows.
+ * @param x   Contiguous vector.
+ * @param out Receives the four dot products.
+ */
+void lwt_gemv_dot4(size_t n, const ttype* a, ptrdiff_t lda, const ttype* x, ttype* out) {
+
+    int level = lwt_simd_level();
+
+    if(level != LWT_SIMD_SCALAR && sizeof(ttype) == sizeof(double)) {
+        lwt_simd_dot4_f64[level](n, (const double*) a, lda, (const double*) x, (double*) out);
+        return;
+    }
+    if(level != LWT_SIMD_SCALAR && sizeof(ttype) == sizeof(float)) {
+        lwt_simd_dot4_f32[level](n, (const float*) a, lda, (const float*) x, (float*) out);
+        return;
+    }
+
+    for(int r = 0; r < 4; r ++)
+        out[r] = lwt_sum_block(n, a + r * lda, 1, x, 1);
+}
+
+typedef struct {
+    int m, n;
+    ttype alpha, beta;
+    const ttype* A;
+    ptrdiff_t rsa, csa;
+    const ttype* x;
+    ptrdiff_t incx;
+    ttype* y;
+} LwtGemvJob;
+
+void lwt_gemv_task(void* context, size_t begin, size_t end, int thread) {
+
+    (void) thread;
+    LwtGemvJob* job = (LwtGemvJob*) context;
+
+    for(size_t block = begin; block < end; block ++) {
+
+        int i0 = (int) block * LWT_GEMV_ROWS;
+        int rows = job->m - i0 < LWT_GEMV_ROWS ? job->m - i0 : LWT_GEMV_ROWS;
+        ttype* y = job->y + i0;
+        const ttype* A = job->A + i0 * job->rsa;
+
+        if(job->rsa == 1) {
+
+            /* Unit-stride columns: y += (alpha * x[j]) * A[:, j], four columns at a time. */
+            for(int i = 0; i < rows; i ++)
+                y[i] = job->beta == 0.0 ? 0.0 : job->beta * y[i];
+
+            int j = 0;
+            for(; j + 4 <= job->n; j += 4) {
+
+                ttype s[4];
+                for(int q = 0; q < 4; q ++)
+                    s[q] = job->alpha * job->x[(j + q) * job->incx];
+
+                lwt_gemv_axpy4(rows, y, A + j * job->csa, job->csa, s);
+            }
+            for(; j < job->n; j ++) {
+
+                ttype s = job->alpha * job->x[j * job->incx];
+                const ttype* column = A + j * job->csa;
+
+                for(int i = 0; i < rows; i ++)
+                    y[i] += column[i] * s;
+            }
+        }
+        else {
+
+            /* Unit-stride rows (x is then contiguous) or a general layout: one dot product per row. */
+            int i = 0;
+            ttype dots[4];
+
+            if(job->csa == 1) {
+                for(; i + 4 <= rows; i += 4) {
+
+                    lwt_gemv_dot4(job->n, A + i * job->rsa, job->rsa, job->x, dots);
+
+                    for(int q = 0; q < 4; q ++)
+                        y[i + q] = job->beta == 0.0 ? job->alpha * dots[q] : job->alpha * dots[q] + job->beta * y[i + q];
+                }
+            }
+            for(; i < rows; i ++) {
+
+                ttype sum = lwt_sum_block(job->n, A + i * job->rsa, job->csa, job->x, job->incx);
+                y[i] = job->beta == 0.0 ? job->alpha * sum : job->alpha * sum + job->beta * y[i];
+            }
+        }
+    }
+}
+
+/**
+ * Computes y = alpha * A * x + beta * y on general strided operands.
+ *
+ * @param m     Rows of A and length of y.
+ * @param n     Columns of A and length of x.
+ * @param alpha Scale applied to the product.
+ * @param A     Pointer to the first element of A.
+ * @param rsa   Row stride of A.
+ * @param csa   Column stride of A.
+ * @param x     Pointer to the first element of x.
+ * @param incx  Stride of x.
+ * @param beta  Scale applied to the existing contents of y (0 overwrites y, NaNs included).
+ * @param y     Pointer to the first element of y.
+ * @param incy  Stride of y.
+ *
+ * Note: A is read exactly once. Unit-stride columns (the layout of a contiguous Matrix)
+ * are added to y four at a time; unit-stride rows (a transposed view) are dotted with x
+ * four at a time. Strided x and y go through contiguous copies. y must not overlap A or x.
+ */
+void lwt_gemv(int m, int n, ttype alpha,
+    const ttype* A, ptrdiff_t rsa, ptrdiff_t csa,
+    const ttype* x, ptrdiff_t incx,
+    ttype beta, ttype* y, ptrdiff_t incy) {
+
+    if(m <= 0)
+        return;
+
+    if(alpha == 0.0 || n <= 0) {
+        lwt_gemm_scale(m, 1, beta, y, incy, 0);
+        return;
+    }
+
+    LWT_OP_ENTER("gemv");
+
+    LwtGemvJob job;
+    job.m = m;
+    job.n = n;
+    job.alpha = alpha;
+    job.beta = beta;
+    job.A = A;
+    job.rsa = m == 1 ? 1 : rsa;
+    job.csa = n == 1 ? 1 : csa;
+    job.x = x;
+    job.incx = incx;
+    job.y = y;
+
+    /* The dot kernels want a contiguous x, every kernel a contiguous y. */
+    ttype* x_copy = NULL;
+    if(job.rsa != 1 && job.csa == 1 && incx != 1) {
+
+        x_copy = (ttype*) lwt_malloc(sizeof(ttype) * n);
+        for(int j = 0; j < n; j ++)
+            x_copy[j] = x[j * incx];
+
+        job.x = x_copy;
+        job.incx = 1;
+    }
+
+    ttype* y_copy = NULL;
+    if(incy != 1) {
+
+        y_copy = (ttype*) lwt_malloc(sizeof(ttype) * m);
+        for(int i = 0; i < m; i ++)
+            y_copy[i] = beta == 0.0 ? 0.0 : y[i * incy];
+
+        job.y = y_copy;
+    }
+
+    size_t blocks = (m + LWT_GEMV_ROWS - 1) / LWT_GEMV_ROWS;
+
+    if((double) m * n < LWT_GEMV_PARALLEL_MIN)
+        lwt_gemv_task(&job, 0, blocks, 0);
+    else
+        lwt_parallel_for(blocks, 1, lwt_gemv_task, &job);
+
+    if(y_copy != NULL) {
+
+        for(int i = 0; i < m; i ++)
+            y[i * incy] = y_copy[i];
+
+        lwt_free(y_copy, sizeof(ttype) * m);
+    }
+
+    if(x_copy != NULL)
+        lwt_free(x_copy, sizeof(ttype) * n);
+
+    LWT_OP_LEAVE();
+}
\ No newline at end of file
@@ -0,0 +1,493 @@
+/*
+  MIT License
+  
+  Copyright (c) 2025 Morcillo Sanz
+  
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+  
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+  
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  SOFTWARE.
+*/
+
+#pragma once
+
+#include "matrix.h"
+
+/*
+ * Fixed-size vectors and matrices for geometry: plain values that live on the stack,
+ * with no allocation and no rank loops. Matrices are stored like a contiguous Matrix,
+ * column by column: element (r, c) of a MatN is m[r + N * c].
+ *
+ * Every loop below has compile-time bounds, so the compiler can unroll it, and the Mat4
+ * products use SSE2 directly. The Tensor conversions at the end are the only functions
+ * that allocate.
+ */
+typedef union {
+    struct { ttype x, y; };
+    ttype v[2];
+} Vec2;
+
+typedef union {
+    struct { ttype x, y, z; };
+    ttype v[3];
+} Vec3;
+
+typedef union {
+    struct { ttype x, y, z, w; };
+    ttype v[4];
+} Vec4;
+
+typedef struct {
+    ttype m[4];
+} Mat2;
+
+typedef struct {
+    ttype m[9];
+} Mat3;
+
+typedef struct {
+    ttype m[16];
+} Mat4;
+
+Vec2 vec2(ttype x, ttype y) {
+    Vec2 r = { { x, y } };
+    return r;
+}
+
+Vec3 vec3(ttype x, ttype y, ttype z) {
+    Vec3 r = { { x, y, z } };
+    return r;
+}
+
+Vec4 vec4(ttype x, ttype y, ttype z, ttype w) {
+    Vec4 r = { { x, y, z, w } };
+    return r;
+}
+
+/*
+ * Element-wise vector arithmetic, dot product, length and normalization. Normalizing
+ * a zero vector gives NaNs, like `normalize`.
+ */
+#define LWT_DEFINE_VEC_OPS(V, N, prefix)                                         \
+V prefix##_add(V a, V b) {                                                        \
+    V r;                                                                          \
+    for(int i = 0; i < N; i ++)                                                   \
+        r.v[i] = a.v[i] + b.v[i];                                                 \
+    return r;                                                                     \
+}                                                                                 \
+V prefix##_sub(V a, V b) {                                                        \
+    V r;                                                                          \
+    for(int i = 0; i < N; i ++)                                                   \
+        r.v[i] = a.v[i] - b.v[i];                                                 \
+    return r;                                                                     \
+}                                                                                 \
+V prefix##_scale(V a, ttype s) {                                                  \
+    V r;                                                                          \
+    for(int i = 0; i < N; i ++)                                                   \
+        r.v[i] = a.v[i] * s;                                                      \
+    return r;                                                                     \
+}                                                                                 \
+ttype prefix##_dot(V a, V b) {                                                    \
+    ttype sum = 0.0;                                                              \
+    for(int i = 0; i < N; i ++)                                                   \
+        sum += a.v[i] * b.v[i];                                                   \
+    return sum;                                                                   \
+}                                                                                 \
+ttype prefix##_length(V a) {                                                      \
+    return sqrt(prefix##_dot(a, a));                                              \
+}                                                                                 \
+V prefix##_normalize(V a) {                                                       \
+    return prefix##_scale(a, 1.0 / prefix##_length(a));                           \
+}
+
+LWT_DEFINE_VEC_OPS(Vec2, 2, vec2)
+LWT_DEFINE_VEC_OPS(Vec3, 3, vec3)
+LWT_DEFINE_VEC_OPS(Vec4, 4, vec4)
+
+/**
+ * Computes the cross product of two 3D vectors.
+ *
+ * @param u First vector.
+ * @param v Second vector.
+ * @return  u × v.
+ */
+Vec3 vec3_cross(Vec3 u, Vec3 v) {
+    return vec3(u.y * v.z - u.z * v.y, u.z * v.x - u.x * v.z, u.x * v.y - u.y * v.x);
+}
+
+/*
+ * Identity and transpose.
+ */
+#define LWT_DEFINE_MAT_OPS(M, N, prefix)                                         \
+M prefix##_identity(void) {                                                       \
+    M r;                                                                          \
+    for(int i = 0; i < N * N; i ++)                                               \
+        r.m[i] = i % (N + 1) == 0 ? 1.0 : 0.0;                                    \
+    return r;                                                                     \
+}                                                                                 \
+M prefix##_transpose(M a) {                                                       \
+    M r;                                                                          \
+    for(int c = 0; c < N; c ++) {                                                 \
+        for(int i = 0; i < N; i ++)                                               \
+            r.m[i + N * c] = a.m[c + N * i];                                      \
+    }                                                                             \
+    return r;                                                                     \
+}
+
+/*
+ * Matrix product and matrix-vector product, one column of the result at a time.
+ */
+#define LWT_DEFINE_MAT_PRODUCTS(M, V, N, prefix)                                 \
+M prefix##_mul(M a, M b) {                                                        \
+    M r;                                                                          \
+    for(int c = 0; c < N; c ++) {                                                 \
+        for(int i = 0; i < N; i ++)                                               \
+            r.m[i + N * c] = a.m[i] * b.m[N * c];                                 \
+        for(int k = 1; k < N; k ++) {                                             \
+            for(int i = 0; i < N; i ++)                                           \
+                r.m[i + N * c] += a.m[i + N * k] * b.m[k + N * c];                \
+        }                                                                         \
+    }                                                                             \
+    return r;                                                                     \
+}                                                                                 \
+V prefix##_mul_vec(M a, V x) {                                                    \
+    V r;                                                                          \
+    for(int i = 0; i < N; i ++)                                                   \
+        r.v[i] = a.m[i] * x.v[0];                                                 \
+    for(int k = 1; k < N; k ++) {                                                 \
+        for(int i = 0; i < N; i ++)                                               \
+            r.v[i] += a.m[i + N * k] * x.v[k];                                    \
+    }                                                                             \
+    return r;                                                                     \
+}
+
+LWT_DEFINE_MAT_OPS(Mat2, 2, mat2)
+LWT_DEFINE_MAT_OPS(Mat3, 3, mat3)
+LWT_DEFINE_MAT_OPS(Mat4, 4, mat4)
+LWT_DEFINE_MAT_PRODUCTS(Mat2, Vec2, 2, mat2)
+LWT_DEFINE_MAT_PRODUCTS(Mat3, Vec3, 3, mat3)
+
+#if defined(LWT_SIMD_X86) && defined(__SSE2__)
+/*
+ * Mat4 columns of a * b with SSE2, which every x86-64 CPU has: no run-time dispatch,
+ * so the products stay inlinable. A column of doubles is two registers, one of floats
+ * a single register.
+ */
+void lwt_mat4_columns_f64(int count, double* r, const double* a, const double* b) {
+
+    __m128d a0l = _mm_loadu_pd(a), a0h = _mm_loadu_pd(a + 2);
+    __m128d a1l = _mm_loadu_pd(a + 4), a1h = _mm_loadu_pd(a + 6);
+    __m128d a2l = _mm_loadu_pd(a + 8), a2h = _mm_loadu_pd(a + 10);
+    __m128d a3l = _mm_loadu_pd(a + 12), a3h = _mm_loadu_pd(a + 14);
+
+    for(int c = 0; c < count; c ++) {
+
+        __m128d b0 = _mm_set1_pd(b[4 * c]), b1 = _mm_set1_pd(b[4 * c + 1]);
+        __m128d b2 = _mm_set1_pd(b[4 * c + 2]), b3 = _mm_set1_pd(b[4 * c + 3]);
+
+        __m128d lo = _mm_add_pd(_mm_add_pd(_mm_mul_pd(a0l, b0), _mm_mul_pd(a1l, b1)),
+                                _mm_add_pd(_mm_mul_pd(a2l, b2), _mm_mul_pd(a3l, b3)));
+        __m128d hi = _mm_add_pd(_mm_add_pd(_mm_mul_pd(a0h, b0), _mm_mul_pd(a1h, b1)),
+                                _mm_add_pd(_mm_mul_pd(a2h, b2), _mm_mul_pd(a3h, b3)));
+
+        _mm_storeu_pd(r + 4 * c, lo);
+        _mm_storeu_pd(r + 4 * c + 2, hi);
+    }
+}
+
+void lwt_mat4_columns_f32(int count, float* r, const float* a, const float* b) {
+
+    __m128 a0 = _mm_loadu_ps(a), a1 = _mm_loadu_ps(a + 4);
+    __m128 a2 = _mm_loadu_ps(a + 8), a3 = _mm_loadu_ps(a + 12);
+
+    for(int c = 0; c < count; c ++) {
+
+        __m128 s = _mm_add_ps(_mm_add_ps(_mm_mul_ps(a0, _mm_set1_ps(b[4 * c])), _mm_mul_ps(a1, _mm_set1_ps(b[4 * c + 1]))),
+                              _mm_add_ps(_mm_mul_ps(a2, _mm_set1_ps(b[4 * c + 2])), _mm_mul_ps(a3, _mm_set1_ps(b[4 * c + 3]))));
+        _mm_storeu_ps(r + 4 * c, s);
+    }
+}
+
+Mat4 mat4_mul(Mat4 a, Mat4 b) {
+
+    Mat4 r;
+    if(sizeof(ttype) == sizeof(double))
+        lwt_mat4_columns_f64(4, (double*) r.m, (const double*) a.m, (const double*) b.m);
+    else
+        lwt_mat4_columns_f32(4, (float*) r.m, (const float*) a.m, (const float*) b.m);
+
+    return r;
+}
+
+Vec4 mat4_mul_vec(Mat4 a, Vec4 x) {
+
+    Vec4 r;
+    if(sizeof(ttype) == sizeof(double))
+        lwt_mat4_columns_f64(1, (double*) r.v, (const double*) a.m, (const double*) x.v);
+    else
+        lwt_mat4_columns_f32(1, (float*) r.v, (const float*) a.m, (const float*) x.v);
+
+    return r;
+}
+#else
+LWT_DEFINE_MAT_PRODUCTS(Mat4, Vec4, 4, mat4)
+#endif
+
+/**
+ * Transforms a point by an affine 4x4 matrix (w = 1, no perspective divide).
+ *
+ * @param a The transformation.
+ * @param p The point.
+ * @return  The upper three components of a * (p, 1).
+ */
+Vec3 mat4_transform_point(Mat4 a, Vec3 p) {
+    Vec4 r = mat4_mul_vec(a, vec4(p.x, p.y, p.z, 1.0));
+    return vec3(r.x, r.y, r.z);
+}
+
+/**
+ * Transforms a direction by a 4x4 matrix (w = 0, so translations are ignored).
+ *
+ * @param a The transformation.
+ * @param d The direction.
+ * @return  The upper three components of a * (d, 0).
+ */
+Vec3 mat4_transform_direction(Mat4 a, Vec3 d) {
+    Vec4 r = mat4_mul_vec(a, vec4(d.x, d.y, d.z, 0.0));
+    return vec3(r.x, r.y, r.z);
+}
+
+ttype mat2_determinant(Mat2 a) {
+    return a.m[0] * a.m[3] - a.m[2] * a.m[1];
+}
+
+ttype mat3_determinant(Mat3 a) {
+    return a.m[0] * (a.m[4] * a.m[8] - a.m[7] * a.m[5])
+         - a.m[3] * (a.m[1] * a.m[8] - a.m[7] * a.m[2])
+         + a.m[6] * (a.m[1] * a.m[5] - a.m[4] * a.m[2]);
+}
+
+/*
+ * The 2x2 minors of the upper two rows (s) and of the lower two rows (t) of a Mat4,
+ * shared by its determinant and its inverse.
+ */
+void lwt_mat4_minors(const Mat4* a, ttype* s, ttype* t) {
+
+    const ttype* m = a->m;
+
+    s[0] = m[0] * m[5] - m[4] * m[1];
+    s[1] = m[0] * m[9] - m[8] * m[1];
+    s[2] = m[0] * m[13] - m[12] * m[1];
+    s[3] = m[4] * m[9] - m[8] * m[5];
+    s[4] = m[4] * m[13] - m[12] * m[5];
+    s[5] = m[8] * m[13] - m[12] * m[9];
+
+    t[0] = m[2] * m[7] - m[6] * m[3];
+    t[1] = m[2] * m[11] - m[10] * m[3];
+    t[2] = m[2] * m[15] - m[14] * m[3];
+    t[3] = m[6] * m[11] - m[10] * m[7];
+    t[4] = m[6] * m[15] - m[14] * m[7];
+    t[5] = m[10] * m[15] - m[14] * m[11];
+}
+
+ttype mat4_determinant(Mat4 a) {
+
+    ttype s[6], t[6];
+    lwt_mat4_minors(&a, s, t);
+
+    return s[0] * t[5] - s[1] * t[4] + s[2] * t[3] + s[3] * t[2] - s[4] * t[1] + s[5] * t[0];
+}
+
+/**
+ * Inverts a 2x2 matrix in closed form.
+ *
+ * @param a   The matrix.
+ * @param out Receives the inverse.
+ * @return    TENSOR_OK, or TENSOR_ERROR_SINGULAR if the determinant is zero or not finite
+ *            (`out` is then left unchanged).
+ */
+TensorStatus mat2_inverse(Mat2 a, Mat2* out) {
+
+    ttype det = mat2_determinant(a);
+    if(det == 0.0 || !isfinite(det))
+        return TENSOR_ERROR_SINGULAR;
+
+    ttype inv = 1.0 / det;
+    Mat2 r = { { a.m[3] * inv, -a.m[1] * inv, -a.m[2] * inv, a.m[0] * inv } };
+
+    *out = r;
+    return TENSOR_OK;
+}
+
+/**
+ * Inverts a 3x3 matrix in closed form (adjugate over determinant).
+ *
+ * @param a   The matrix.
+ * @param out Receives the inverse.
+ * @return    TENSOR_OK, or TENSOR_ERROR_SINGULAR if the determinant is zero or not finite
+ *            (`out` is then left unchanged).
+ */
+TensorStatus mat3_inverse(Mat3 a, Mat3* out) {
+
+    const ttype* m = a.m;
+    Mat3 r;
+
+    r.m[0] = m[4] * m[8] - m[7] * m[5];
+    r.m[1] = m[7] * m[2] - m[1] * m[8];
+    r.m[2] = m[1] * m[5] - m[4] * m[2];
+    r.m[3] = m[6] * m[5] - m[3] * m[8];
+    r.m[4] = m[0] * m[8] - m[6] * m[2];
+    r.m[5] = m[3] * m[2] - m[0] * m[5];
+    r.m[6] = m[3] * m[7] - m[6] * m[4];
+    r.m[7] = m[6] * m[1] - m[0] * m[7];
+    r.m[8] = m[0] * m[4] - m[3] * m[1];
+
+    ttype det = m[0] * r.m[0] + m[3] * r.m[1] + m[6] * r.m[2];
+    if(det == 0.0 || !isfinite(det))
+        return TENSOR_ERROR_SINGULAR;
+
+    ttype inv = 1.0 / det;
+    for(int i = 0; i < 9; i ++)
+        r.m[i] *= inv;
+
+    *out = r;
+    return TENSOR_OK;
+}
+
+/**
+ * Inverts a 4x4 matrix in closed form, from the 2x2 minors of its row pairs.
+ *
+ * @param a   The matrix.
+ * @param out Receives the inverse.
+ * @return    TENSOR_OK, or TENSOR_ERROR_SINGULAR if the determinant is zero or not finite
+ *            (`out` is then left unchanged).
+ *
+ * Note: About 3x fewer operations than Gaussian elimination and no pivoting, which is
+ * accurate for the well-conditioned transforms of geometry; use `inverse_into` when the
+ * conditioning matters.
+ */
+TensorStatus mat4_inverse(Mat4 a, Mat4* out) {
+
+    const ttype* m = a.m;
+    ttype s[6], t[6];
+    lwt_mat4_minors(&a, s, t);
+
+    ttype det = s[0] * t[5] - s[1] * t[4] + s[2] * t[3] + s[3] * t[2] - s[4] * t[1] + s[5] * t[0];
+    if(det == 0.0 || !isfinite(det))
+        return TENSOR_ERROR_SINGULAR;
+
+    ttype inv = 1.0 / det;
+    Mat4 r;
+
+    r.m[0] = (m[5] * t[5] - m[9] * t[4] + m[13] * t[3]) * inv;
+    r.m[4] = (-m[4] * t[5] + m[8] * t[4] - m[12] * t[3]) * inv;
+    r.m[8] = (m[7] * s[5] - m[11] * s[4] + m[15] * s[3]) * inv;
+    r.m[12] = (-m[6] * s[5] + m[10] * s[4] - m[14] * s[3]) * inv;
+
+    r.m[1] = (-m[1] * t[5] + m[9] * t[2] - m[13] * t[1]) * inv;
+    r.m[5] = (m[0] * t[5] - m[8] * t[2] + m[12] * t[1]) * inv;
+    r.m[9] = (-m[3] * s[5] + m[11] * s[2] - m[15] * s[1]) * inv;
+    r.m[13] = (m[2] * s[5] - m[10] * s[2] + m[14] * s[1]) * inv;
+
+    r.m[2] = (m[1] * t[4] - m[5] * t[2] + m[13] * t[0]) * inv;
+    r.m[6] = (-m[0] * t[4] + m[4] * t[2] - m[12] * t[0]) * inv;
+    r.m[10] = (m[3] * s[4] - m[7] * s[2] + m[15] * s[0]) * inv;
+    r.m[14] = (-m[2] * s[4] + m[6] * s[2] - m[14] * s[0]) * inv;
+
+    r.m[3] = (-m[1] * t[3] + m[5] * t[1] - m[9] * t[0]) * inv;
+    r.m[7] = (m[0] * t[3] - m[4] * t[1] + m[8] * t[0]) * inv;
+    r.m[11] = (-m[3] * s[3] + m[7] * s[1] - m[11] * s[0]) * inv;
+    r.m[15] = (m[2] * s[3] - m[6] * s[1] + m[10] * s[0]) * inv;
+
+    *out = r;
+    return TENSOR_OK;
+}
+
+/**
+ * Reads the first n elements of a vector, or the leading n x n block of a matrix, of any strides.
+ *
+ * @param tensor A rank-1 or rank-2 tensor (or view) of the native element type.
+ * @param n      Size of the fixed-size value.
+ * @param rank   1 for a vector, 2 for a matrix.
+ * @param values Receives the elements, column by column.
+ * @return       TENSOR_OK, TENSOR_ERROR_SHAPE if the tensor is too small, or TENSOR_ERROR_DTYPE.
+ */
+TensorStatus lwt_small_load(Tensor tensor, int n, unsigned int rank, ttype* values) {
+
+    if(tensor.dtype != TENSOR_NATIVE)
+        return TENSOR_ERROR_DTYPE;
+    if(tensor.rank != rank || tensor.shape[0] < n || (rank == 2 && tensor.shape[1] < n))
+        return TENSOR_ERROR_SHAPE;
+
+    int cols = rank == 2 ? n : 1;
+    for(int c = 0; c < cols; c ++) {
+        for(int r = 0; r < n; r ++)
+            values[r + n * c] = tensor.components[r * tensor.strides[0] + (rank == 2 ? c * tensor.strides[1] : 0)];
+    }
+
+    return TENSOR_OK;
+}
+
+/**
+ * Writes a fixed-size value into a vector or matrix (or view) of at least its size.
+ *
+ * @param tensor The destination.
+ * @param n      Size of the fixed-size value.
+ * @param rank   1 for a vector, 2 for a matrix.
+ * @param values The elements, column by column.
+ * @return       TENSOR_OK, TENSOR_ERROR_SHAPE if the tensor is too small, or TENSOR_ERROR_DTYPE.
+ */
+TensorStatus lwt_small_store(Tensor tensor, int n, unsigned int rank, const ttype* values) {
+
+    if(tensor.dtype != TENSOR_NATIVE)
+        return TENSOR_ERROR_DTYPE;
+    if(tensor.rank != rank || tensor.shape[0] < n || (rank == 2 && tensor.shape[1] < n))
+        return TENSOR_ERROR_SHAPE;
+
+    int cols = rank == 2 ? n : 1;
+    for(int c = 0; c < cols; c ++) {
+        for(int r = 0; r < n; r ++)
+            tensor.components[r * tensor.strides[0] + (rank == 2 ? c * tensor.strides[1] : 0)] = values[r + n * c];
+    }
+
+    return TENSOR_OK;
+}
+
+/*
+ * Conversions to and from Tensor: `<type>_load` reads the leading elements of a vector
+ * or matrix (or view) into `out`, `<type>_store` writes a value into one, both without
+ * allocating and returning the status of `lwt_small_load` / `lwt_small_store`;
+ * `<type>_to_tensor` creates a new Vector or Matrix.
+ */
+#define LWT_DEFINE_SMALL_TENSOR(T, N, rank, field, prefix)                       \
+TensorStatus prefix##_load(Tensor tensor, T* out) {                               \
+    return lwt_small_load(tensor, N, rank, out->field);                           \
+}                                                                                 \
+TensorStatus prefix##_store(Tensor tensor, T value) {                             \
+    return lwt_small_store(tensor, N, rank, value.field);                         \
+}                                                                                 \
+Tensor prefix##_to_tensor(T value) {                                              \
+    Tensor tensor = rank == 2 ? create_tensor(2, N, N) : create_tensor(1, N);     \
+    lwt_small_store(tensor, N, rank, value.field);                                \
+    return tensor;                                                                \
+}
+
+LWT_DEFINE_SMALL_TENSOR(Vec2, 2, 1, v, vec2)
+LWT_DEFINE_SMALL_TENSOR(Vec3, 3, 1, v, vec3)
+LWT_DEFINE_SMALL_TENSOR(Vec4, 4, 1, v, vec4)
+LWT_DEFINE_SMALL_TENSOR(Mat2, 2, 2, m, mat2)
+LWT_DEFINE_SMALL_TENSOR(Mat3, 3, 2, m, mat3)
+LWT_DEFINE_SMALL_TENSOR(Mat4, 4, 2, m, mat4)
\ No newline at end of file
@@ -0,0 +1,441 @@
+/*
+  MIT License
+  
+  Copyright (c) 2025 Morcillo Sanz
+  
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+  
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+  
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  SOFTWARE.
+*/
+
+#pragma once
+
+#include "tensor.h"
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+/*
+ * On-disk tensor container.
+ *
+ * A file starts with a 64-byte LwtFileHeader, followed by an index of `count`
+ * 256-byte LwtFileEntry records, followed by the payloads. Every payload starts
+ * at a multiple of LWT_FILE_ALIGNMENT from the start of the file, so a mapped
+ * file can be used in place. Integers are stored little-endian (the byte order
+ * of the hosts the library supports); payloads hold elements of the entry's
+ * dtype in the order given by its shape and strides.
+ */
+#define LWT_FILE_MAGIC "LWTENSOR"
+#define LWT_FILE_VERSION 1
+#define LWT_FILE_ALIGNMENT 64
+#define LWT_FILE_NAME_BYTES 64
+#define LWT_FILE_MAX_RANK 8
+
+typedef struct {
+    char magic[8];
+    uint32_t version;
+    uint32_t count;
+    uint64_t index_offset;
+    uint8_t reserved[40];
+} LwtFileHeader;
+
+typedef struct {
+    char name[LWT_FILE_NAME_BYTES];
+    uint32_t dtype;
+    uint32_t rank;
+    int64_t shape[LWT_FILE_MAX_RANK];
+    int64_t strides[LWT_FILE_MAX_RANK];
+    uint64_t offset;
+    uint64_t bytes;
+    uint8_t reserved[40];
+} LwtFileEntry;
+
+/**
+ * A container mapped read-only in memory.
+ *
+ * `tensors[i]` is named `names[i]`; its components point into the mapping, so pages
+ * are only read from disk when first touched. The tensors stay valid until
+ * `tensor_mmap_close`; writing to a mapped tensor is an access violation.
+ */
+typedef struct {
+    unsigned int count;
+    const char** names;
+    Tensor* tensors;
+    int* shapes;
+    char* strings;
+    size_t strings_size;
+    void* data;
+    size_t size;
+#ifdef _WIN32
+    HANDLE file;
+    HANDLE mapping;
+#endif
+} TensorFile;
+
+/**
+ * Rounds a file offset up to LWT_FILE_ALIGNMENT.
+ */
+uint64_t lwt_file_align(uint64_t offset) {
+    return (offset + LWT_FILE_ALIGNMENT - 1) / LWT_FILE_ALIGNMENT * LWT_FILE_ALIGNMENT;
+}
+
+/**
+ * Writes `bytes` zero bytes to a file.
+ */
+int lwt_file_pad(FILE* stream, uint64_t bytes) {
+
+    static const char zeros[LWT_FILE_ALIGNMENT] = { 0 };
+    return fwrite(zeros, 1, (size_t) bytes, stream) == bytes;
+}
+
+/**
+ * Saves tensors to a container file.
+ *
+ * @param path    Path of the file, created or truncated.
+ * @param count   Number of tensors.
+ * @param names   Name of each tensor, at most LWT_FILE_NAME_BYTES - 1 bytes and unique.
+ * @param tensors The tensors (or views), of any element type and rank up to LWT_FILE_MAX_RANK.
+ * @return        TENSOR_OK, TENSOR_ERROR_LIMIT for an over-long name or rank, or
+ *                TENSOR_ERROR_IO if the file cannot be written.
+ *
+ * Note: Each tensor is written contiguously (views are copied first) with canonical
+ * strides, its payload aligned to LWT_FILE_ALIGNMENT bytes.
+ */
+TensorStatus tensor_save(const char* path, unsigned int count, const char* const* names, const Tensor* tensors) {
+
+    for(unsigned int i = 0; i < count; i ++) {
+        if(strlen(names[i]) >= LWT_FILE_NAME_BYTES || tensors[i].rank > LWT_FILE_MAX_RANK)
+            return TENSOR_ERROR_LIMIT;
+    }
+
+    FILE* stream = fopen(path, "wb");
+    if(stream == NULL)
+        return TENSOR_ERROR_IO;
+
+    LWT_OP_ENTER("tensor_save");
+
+    LwtFileHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, LWT_FILE_MAGIC, sizeof(header.magic));
+    header.version = LWT_FILE_VERSION;
+    header.count = count;
+    header.index_offset = sizeof(LwtFileHeader);
+
+    int ok = fwrite(&header, sizeof(header), 1, stream) == 1;
+
+    uint64_t offset = lwt_file_align(sizeof(LwtFileHeader) + (uint64_t) count * sizeof(LwtFileEntry));
+
+    for(unsigned int i = 0; i < count && ok; i ++) {
+
+        LwtFileEntry entry;
+        memset(&entry, 0, sizeof(entry));
+        memcpy(entry.name, names[i], strlen(names[i]));
+        entry.dtype = tensors[i].dtype;
+        entry.rank = tensors[i].rank;
+
+        int64_t stride = 1;
+        for(unsigned int axis = 0; axis < tensors[i].rank; axis ++) {
+            entry.shape[axis] = tensors[i].shape[axis];
+            entry.strides[axis] = stride;
+            stride *= tensors[i].shape[axis];
+        }
+
+        entry.offset = offset;
+        entry.bytes = tensor_dtype_size(tensors[i].dtype) * get_length(tensors[i]);
+        offset = lwt_file_align(offset + entry.bytes);
+
+        ok = fwrite(&entry, sizeof(entry), 1, stream) == 1;
+    }
+
+    uint64_t position = sizeof(LwtFileHeader) + (uint64_t) count * sizeof(LwtFileEntry);
+
+    for(unsigned int i = 0; i < count && ok; i ++) {
+
+        Tensor tensor = tensor_contiguous(tensors[i]);
+        size_t bytes = tensor_dtype_size(tensor.dtype) * get_length(tensor);
+
+        ok = lwt_file_pad(stream, lwt_file_align(position) - position);
+        ok = ok && (bytes == 0 || fwrite(tensor.components, 1, bytes, stream) == bytes);
+        position = lwt_file_align(position) + bytes;
+
+        destroy_tensor(tensor);
+    }
+
+    ok = fclose(stream) == 0 && ok;
+
+    LWT_OP_LEAVE();
+    return ok ? TENSOR_OK : TENSOR_ERROR_IO;
+}
+
+/**
+ * Checks an index entry against the size of the file.
+ *
+ * @param entry The entry.
+ * @param size  Size of the file in bytes.
+ * @return      1 if the entry describes a tensor lying inside the file, 0 otherwise.
+ */
+int lwt_file_check_entry(const LwtFileEntry* entry, uint64_t size) {
+
+    if(memchr(entry->name, 0, LWT_FILE_NAME_BYTES) == NULL)
+        return 0;
+    if(entry->dtype >= TENSOR_DTYPES || entry->rank > LWT_FILE_MAX_RANK || entry->rank > LWT_MAX_RANK)
+        return 0;
+    if(entry->offset % LWT_FILE_ALIGNMENT != 0 || entry->offset > size || entry->bytes > size - entry->offset)
+        return 0;
+
+    int empty = 0;
+    for(uint32_t axis = 0; axis < entry->rank; axis ++) {
+
+        if(entry->shape[axis] < 0 || entry->shape[axis] > INT32_MAX || entry->strides[axis] < 0)
+            return 0;
+        if(entry->shape[axis] == 0)
+            empty = 1;
+    }
+
+    if(empty)
+        return 1;
+
+    /* The last element reached by the strides must lie inside the payload. */
+    uint64_t length = 1, last = 0;
+    for(uint32_t axis = 0; axis < entry->rank; axis ++) {
+
+        length *= (uint64_t) entry->shape[axis];
+        last += (uint64_t) (entry->shape[axis] - 1) * (uint64_t) entry->strides[axis];
+
+        if(length > size || last > size)
+            return 0;
+    }
+
+    return (last + 1) * tensor_dtype_size((TensorDType) entry->dtype) <= entry->bytes;
+}
+
+/**
+ * Releases the mapping and the index of a container.
+ *
+ * @param file A container opened with `tensor_mmap_open`; its tensors become invalid.
+ */
+void tensor_mmap_close(TensorFile* file) {
+
+    for(unsigned int i = 0; i < file->count; i ++)
+        destroy_tensor(file->tensors[i]);
+
+    lwt_free(file->strings, file->strings_size);
+    lwt_free(file->names, sizeof(const char*) * file->count);
+    lwt_free(file->tensors, sizeof(Tensor) * file->count);
+    lwt_free(file->shapes, sizeof(int) * LWT_MAX_RANK * file->count);
+
+#ifdef _WIN32
+    if(file->data != NULL)
+        UnmapViewOfFile(file->data);
+    if(file->mapping != NULL)
+        CloseHandle(file->mapping);
+    if(file->file != INVALID_HANDLE_VALUE)
+        CloseHandle(file->file);
+#else
+    if(file->data != NULL)
+        munmap(file->data, file->size);
+#endif
+
+    memset(file, 0, sizeof(*file));
+}
+
+/**
+ * Maps a whole file read-only into a container with no tensors yet.
+ *
+ * @param path Path of the file.
+ * @param file Receives the mapping.
+ * @param size Smallest acceptable file size in bytes.
+ * @return     TENSOR_OK, or TENSOR_ERROR_IO (`file` is then left empty).
+ */
+TensorStatus lwt_file_map(const char* path, TensorFile* file, size_t size) {
+
+    memset(file, 0, sizeof(*file));
+#ifdef _WIN32
+    file->file = INVALID_HANDLE_VALUE;
+#endif
+
+#ifdef _WIN32
+    file->file = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+    if(file->file == INVALID_HANDLE_VALUE)
+        return TENSOR_ERROR_IO;
+
+    LARGE_INTEGER extent;
+    if(!GetFileSizeEx(file->file, &extent) || extent.QuadPart < (LONGLONG) size || extent.QuadPart == 0) {
+        tensor_mmap_close(file);
+        return TENSOR_ERROR_IO;
+    }
+
+    file->size = (size_t) extent.QuadPart;
+    file->mapping = CreateFileMappingA(file->file, NULL, PAGE_READONLY, 0, 0, NULL);
+    file->data = file->mapping != NULL ? MapViewOfFile(file->mapping, FILE_MAP_READ, 0, 0, 0) : NULL;
+#else
+    int descriptor = open(path, O_RDONLY);
+    if(descriptor < 0)
+        return TENSOR_ERROR_IO;
+
+    struct stat status;
+    if(fstat(descriptor, &status) != 0 || status.st_size < (off_t) size || status.st_size == 0) {
+        close(descriptor);
+        return TENSOR_ERROR_IO;
+    }
+
+    file->size = (size_t) status.st_size;
+    file->data = mmap(NULL, file->size, PROT_READ, MAP_SHARED, descriptor, 0);
+    close(descriptor);
+
+    if(file->data == MAP_FAILED)
+        file->data = NULL;
+#endif
+
+    if(file->data == NULL) {
+        tensor_mmap_close(file);
+        return TENSOR_ERROR_IO;
+    }
+
+    return TENSOR_OK;
+}
+
+/**
+ * Allocates the index of a mapped container.
+ *
+ * @param file  The container, with no tensors yet.
+ * @param count Number of tensors; each starts out empty.
+ */
+void lwt_file_alloc_index(TensorFile* file, unsigned int count) {
+
+    file->names = (const char**) lwt_malloc(sizeof(const char*) * count);
+    file->tensors = (Tensor*) lwt_malloc(sizeof(Tensor) * count);
+    file->shapes = (int*) lwt_malloc(sizeof(int) * LWT_MAX_RANK * count);
+    file->count = count;
+
+    for(unsigned int i = 0; i < count; i ++) {
+        file->names[i] = "";
+        file->tensors[i] = lwt_empty_tensor();
+    }
+}
+
+/**
+ * Maps a container file read-only and describes its tensors.
+ *
+ * @param path Path of a file written by `tensor_save`.
+ * @param file Receives the container.
+ * @return     TENSOR_OK, or TENSOR_ERROR_IO if the file cannot be mapped or is not a
+ *             valid container (`file` is then left empty).
+ *
+ * Note: Nothing but the index is read here; the operating system pages the payloads
+ * in on first access and may drop them again under memory pressure.
+ */
+TensorStatus tensor_mmap_open(const char* path, TensorFile* file) {
+
+    TensorStatus status = lwt_file_map(path, file, sizeof(LwtFileHeader));
+    if(status != TENSOR_OK)
+        return status;
+
+    const char* bytes = (const char*) file->data;
+    LwtFileHeader header;
+    memcpy(&header, bytes, sizeof(header));
+
+    if(memcmp(header.magic, LWT_FILE_MAGIC, sizeof(header.magic)) != 0 || header.version != LWT_FILE_VERSION ||
+        header.index_offset > file->size || header.count > (file->size - header.index_offset) / sizeof(LwtFileEntry)) {
+        tensor_mmap_close(file);
+        return TENSOR_ERROR_IO;
+    }
+
+    unsigned int count = header.count;
+    lwt_file_alloc_index(file, count);
+
+    for(unsigned int i = 0; i < count; i ++) {
+
+        const char* record = bytes + header.index_offset + (size_t) i * sizeof(LwtFileEntry);
+
+        LwtFileEntry entry;
+        memcpy(&entry, record, sizeof(entry));
+
+        if(!lwt_file_check_entry(&entry, file->size)) {
+            tensor_mmap_close(file);
+            return TENSOR_ERROR_IO;
+        }
+
+        Tensor* tensor = &file->tensors[i];
+        tensor->rank = entry.rank;
+        tensor->shape = file->shapes + (size_t) i * LWT_MAX_RANK;
+        tensor->components = (ttype*) (bytes + entry.offset);
+        tensor->flags = 0;
+        tensor->dtype = (TensorDType) entry.dtype;
+
+        for(unsigned int axis = 0; axis < entry.rank; axis ++) {
+            tensor->shape[axis] = (int) entry.shape[axis];
+            tensor->strides[axis] = (ptrdiff_t) entry.strides[axis];
+        }
+
+        file->names[i] = record + offsetof(LwtFileEntry, name);
+    }
+
+    return TENSOR_OK;
+}
+
+/**
+ * Looks up a tensor of a mapped container by name.
+ *
+ * @param file The container.
+ * @param name Name of the tensor.
+ * @return     The mapped tensor (read-only, owning nothing), or the empty tensor if there is none.
+ */
+Tensor tensor_mmap_get(const TensorFile* file, const char* name) {
+
+    for(unsigned int i = 0; i < file->count; i ++) {
+        if(strcmp(file->names[i], name) == 0)
+            return file->tensors[i];
+    }
+
+    return lwt_empty_tensor();
+}
+
+/**
+ * Loads one tensor of a container file into memory.
+ *
+ * @param path   Path of a file written by `tensor_save`.
+ * @param name   Name of the tensor, or NULL for the first one.
+ * @param tensor Receives a new contiguous tensor of the stored element type.
+ * @return       TENSOR_OK, TENSOR_ERROR_IO if the file is unreadable or invalid, or
+ *               TENSOR_ERROR_SHAPE if it has no tensor of that name.
+ *
+ * Note: The payload is copied straight from the mapped file, with no parsing.
+ */
+TensorStatus tensor_load(const char* path, const char* name, Tensor* tensor) {
+
+    TensorFile file;
+    TensorStatus status = tensor_mmap_open(path, &file);
+    if(status != TENSOR_OK)
+        return status;
+
+    Tensor stored = name != NULL ? tensor_mmap_get(&file, name) : file.count > 0 ? file.tensors[0] : lwt_empty_tensor();
+
+    if(stored.shape != NULL)
+        *tensor = create_copy(stored);
+    else
+        status = TENSOR_ERROR_SHAPE;
+
+    tensor_mmap_close(&file);
+    return status;
+}
\ No newline at end of file
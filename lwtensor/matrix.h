@@ -24,14 +24,25 @@
 
 #pragma once
 
+#include <float.h>
+
 #include "tensor.h"
 #include "vector.h"
+#include "gemm.h"
 
 /**
  * A Matrix is a specialization of the Tensor structure with rank 2.
  */
 typedef struct Tensor Matrix;
 
+/*
+ * Panel width of the blocked LU and Cholesky factorizations. Columns inside a panel
+ * are factored with rank-1 updates, the trailing matrix is updated with GEMM.
+ */
+#ifndef LWT_LU_NB
+#define LWT_LU_NB 64
+#endif
+
 /**
  * Computes the determinant of a square matrix.
  *
@@ -62,67 +73,392 @@ Matrix create_indentity(unsigned int n) {
 
     Matrix matrix = create_matrix(n, n);
 
-    for(int c = 0; c < n; c++) {
-        for(int r = 0; r < n; r ++) {
-            if(c == r)
-                set_value(matrix, 1.0, c, r);
-        }
-    }
+    for(unsigned int i = 0; i < n; i ++)
+        *tensor_at2(matrix, i, i) = 1.0;
 
     return matrix;
 }
 
+/**
+ * Computes out = alpha * lhs * rhs + beta * out.
+ *
+ * @param out   Output matrix of shape (lhs rows, rhs cols).
+ * @param lhs   Left-hand side matrix.
+ * @param rhs   Right-hand side matrix.
+ * @param alpha Scale applied to the product.
+ * @param beta  Scale applied to the previous contents of `out` (0 overwrites them).
+ * @return      TENSOR_OK, TENSOR_ERROR_SHAPE if the operands are not matrices of matching
+ *              shapes, or TENSOR_ERROR_DTYPE for operands that are not of the native element type.
+ *
+ * Note: Uses the packed, cache-blocked GEMM engine in gemm.h. `out` must not alias `lhs` or `rhs`.
+ */
+TensorStatus matmul_into(Matrix out, Matrix lhs, Matrix rhs, ttype alpha, ttype beta) {
+
+    if(out.dtype != TENSOR_NATIVE || lhs.dtype != TENSOR_NATIVE || rhs.dtype != TENSOR_NATIVE)
+        return TENSOR_ERROR_DTYPE;
+
+    if(out.rank != 2 || lhs.rank != 2 || rhs.rank != 2)
+        return TENSOR_ERROR_SHAPE;
+
+    if(lhs.shape[1] != rhs.shape[0] || out.shape[0] != lhs.shape[0] || out.shape[1] != rhs.shape[1])
+        return TENSOR_ERROR_SHAPE;
+
+    lwt_gemm(lhs.shape[0], rhs.shape[1], lhs.shape[1], alpha,
+        lhs.components, lhs.strides[0], lhs.strides[1],
+        rhs.components, rhs.strides[0], rhs.strides[1],
+        beta, out.components, out.strides[0], out.strides[1]);
+
+    return TENSOR_OK;
+}
+
 /**
  * Performs matrix multiplication between two matrices.
  *
  * @param lhs Left-hand side matrix.
  * @param rhs Right-hand side matrix.
- * @return    A new matrix resulting from lhs * rhs.
+ * @return    A new matrix of shape (lhs rows, rhs cols) resulting from lhs * rhs, or the empty
+ *            tensor if the number of columns of `lhs` differs from the number of rows of `rhs`
+ *            or an operand is not of the native element type.
  */
 Matrix matmul(Matrix lhs, Matrix rhs) {
 
-    Matrix result = create_matrix(rhs.shape[1], lhs.shape[0]);
+    LWT_OP_ENTER("matmul");
+
+    Matrix result = create_matrix(lhs.shape[0], rhs.shape[1]);
+    if(matmul_into(result, lhs, rhs, 1.0, 0.0) != TENSOR_OK) {
+        destroy_tensor(result);
+        result = lwt_empty_tensor();
+    }
+
+    LWT_OP_LEAVE();
+    return result;
+}
+
+/*
+ * Batched products: the last two axes of each operand hold the matrices, the leading
+ * axes index the batch and broadcast against each other like element-wise operands.
+ * `batch` keeps the strides of the batch axes of each operand aligned on the axes of
+ * `out` (zero where an operand is broadcast); `m`, `n`, `k` and the matrix strides are
+ * shared by every product. When `blocks` is non-zero, the first batch axis is unit-stride
+ * and each task index covers LWT_GEMM_LANES products along it (`blocks` per line).
+ */
+typedef struct {
+    int m, n, k;
+    ttype alpha, beta;
+    unsigned int batch_rank;
+    int shape[LWT_MAX_RANK];
+    ptrdiff_t batch[3][LWT_MAX_RANK];
+    ptrdiff_t rsa, csa, rsb, csb, rsc, csc;
+    const ttype* A;
+    const ttype* B;
+    ttype* C;
+    ttype** a_packs;
+    ttype** b_packs;
+    size_t b_pack_size;
+    size_t blocks;
+} LwtBatchedGemmJob;
+
+/**
+ * Locates one product of a batch.
+ *
+ * @param job     The batched product.
+ * @param t       Index of the product; the first batch axis varies fastest.
+ * @param offsets Receives the offsets of the matrices of `out`, `lhs` and `rhs`.
+ */
+void lwt_batched_offsets(const LwtBatchedGemmJob* job, size_t t, ptrdiff_t* offsets) {
+
+    offsets[0] = offsets[1] = offsets[2] = 0;
+
+    for(unsigned int axis = 0; axis < job->batch_rank; axis ++) {
+
+        ptrdiff_t index = (ptrdiff_t) (t % job->shape[axis]);
+        t /= job->shape[axis];
+
+        for(int operand = 0; operand < 3; operand ++)
+            offsets[operand] += index * job->batch[operand][axis];
+    }
+}
+
+void lwt_batched_gemm_task(void* context, size_t begin, size_t end, int thread) {
+
+    LwtBatchedGemmJob* job = (LwtBatchedGemmJob*) context;
+
+    int packed = (double) job->m * job->n * job->k > LWT_GEMM_SMALL_MAX;
+    if(packed && job->a_packs[thread] == NULL) {
+        job->a_packs[thread] = (ttype*) lwt_malloc_aligned(sizeof(ttype) * LWT_GEMM_MC * LWT_GEMM_KC);
+        job->b_packs[thread] = (ttype*) lwt_malloc_aligned(sizeof(ttype) * job->b_pack_size);
+    }
+
+    for(size_t t = begin; t < end; t ++) {
+
+        size_t first = t, last = t + 1;
+        ptrdiff_t offsets[3];
+
+        if(job->blocks != 0) {
+
+            /* A block of LWT_GEMM_LANES products along the first batch axis; a partial last one goes product by product. */
+            first = t % job->blocks * LWT_GEMM_LANES + t / job->blocks * job->shape[0];
+            last = first - first % job->shape[0] + job->shape[0];
+
+            if(last - first >= LWT_GEMM_LANES) {
+
+                lwt_batched_offsets(job, first, offsets);
+                lwt_gemm_lanes(job->m, job->n, job->k, job->alpha,
+                    job->A + offsets[1], job->batch[1][0], job->rsa, job->csa,
+                    job->B + offsets[2], job->batch[2][0], job->rsb, job->csb,
+                    job->beta, job->C + offsets[0], job->rsc, job->csc);
+                continue;
+            }
+        }
+
+        for(size_t u = first; u < last; u ++) {
+
+            lwt_batched_offsets(job, u, offsets);
+            lwt_gemm_serial(job->m, job->n, job->k, job->alpha,
+                job->A + offsets[1], job->rsa, job->csa,
+                job->B + offsets[2], job->rsb, job->csb,
+                job->beta, job->C + offsets[0], job->rsc, job->csc,
+                job->a_packs[thread], job->b_packs[thread]);
+        }
+    }
+}
+
+/**
+ * Computes the shape of a batched product.
+ *
+ * @param lhs   Left-hand side, of shape (..., m, k).
+ * @param rhs   Right-hand side, of shape (..., k, n).
+ * @param rank  Receives the rank of the result.
+ * @param shape Receives the shape of the result, (broadcast batch shape..., m, n).
+ * @return      TENSOR_OK, or TENSOR_ERROR_SHAPE if an operand has rank below 2, the inner
+ *              extents differ or the batch axes do not broadcast.
+ */
+TensorStatus lwt_batched_shape(Tensor lhs, Tensor rhs, unsigned int* rank, int* shape) {
+
+    if(lhs.rank < 2 || rhs.rank < 2 || lhs.shape[lhs.rank - 1] != rhs.shape[rhs.rank - 2])
+        return TENSOR_ERROR_SHAPE;
+
+    Tensor lhs_batch = lhs, rhs_batch = rhs;
+    lhs_batch.rank -= 2;
+    rhs_batch.rank -= 2;
+
+    if(lwt_broadcast_shape(lhs_batch, rhs_batch, rank, shape) != TENSOR_OK || *rank + 2 > LWT_MAX_RANK)
+        return TENSOR_ERROR_SHAPE;
+
+    shape[*rank] = lhs.shape[lhs.rank - 2];
+    shape[*rank + 1] = rhs.shape[rhs.rank - 1];
+    *rank += 2;
+
+    return TENSOR_OK;
+}
+
+/**
+ * Computes out = alpha * lhs * rhs + beta * out for every matrix of a batch.
+ *
+ * @param out   Output tensor (or view) of shape (batch..., m, n).
+ * @param lhs   Left-hand side of shape (..., m, k).
+ * @param rhs   Right-hand side of shape (..., k, n).
+ * @param alpha Scale applied to the products.
+ * @param beta  Scale applied to the previous contents of `out` (0 overwrites them).
+ * @return      TENSOR_OK, TENSOR_ERROR_SHAPE if the shapes do not match (the batch axes of
+ *              `lhs` and `rhs` must broadcast to those of `out`), or TENSOR_ERROR_DTYPE for
+ *              operands that are not of the native element type.
+ *
+ * Note: The matrices are the last two axes and any strides work, so a rank-2 operand is
+ * shared by the whole batch. Batches of small products are spread over the thread pool,
+ * with packing buffers reused across the products of a thread; in the contiguous layout
+ * (first batch axis unit-stride) small products are also computed LWT_GEMM_LANES at a
+ * time, vectorized across the batch. Large products run one after another, each split
+ * over the pool. `out` must not alias `lhs` or `rhs`.
+ */
+TensorStatus batched_matmul_into(Tensor out, Tensor lhs, Tensor rhs, ttype alpha, ttype beta) {
+
+    if(out.dtype != TENSOR_NATIVE || lhs.dtype != TENSOR_NATIVE || rhs.dtype != TENSOR_NATIVE)
+        return TENSOR_ERROR_DTYPE;
+
+    unsigned int rank;
+    int shape[LWT_MAX_RANK];
+
+    if(lwt_batched_shape(lhs, rhs, &rank, shape) != TENSOR_OK || rank != out.rank)
+        return TENSOR_ERROR_SHAPE;
+
+    for(unsigned int axis = 0; axis < rank; axis ++) {
+        if(shape[axis] != out.shape[axis])
+            return TENSOR_ERROR_SHAPE;
+    }
+
+    LWT_OP_ENTER("batched_matmul");
+
+    LwtBatchedGemmJob job;
+    job.m = lhs.shape[lhs.rank - 2];
+    job.k = lhs.shape[lhs.rank - 1];
+    job.n = rhs.shape[rhs.rank - 1];
+    job.alpha = alpha;
+    job.beta = beta;
+    job.batch_rank = rank - 2;
+    job.rsa = lhs.strides[lhs.rank - 2];
+    job.csa = lhs.strides[lhs.rank - 1];
+    job.rsb = rhs.strides[rhs.rank - 2];
+    job.csb = rhs.strides[rhs.rank - 1];
+    job.rsc = out.strides[rank - 2];
+    job.csc = out.strides[rank - 1];
+    job.A = lhs.components;
+    job.B = rhs.components;
+    job.C = out.components;
+
+    /* Batch strides of each operand on the batch axes of `out`; broadcast axes get 0. */
+    size_t count = 1;
+    for(unsigned int axis = 0; axis < job.batch_rank; axis ++) {
+
+        const Tensor* operands[3] = { &out, &lhs, &rhs };
+        for(int operand = 0; operand < 3; operand ++) {
+
+            const Tensor* tensor = operands[operand];
+            unsigned int shift = rank - tensor->rank;
+
+            job.batch[operand][axis] = axis >= shift && tensor->shape[axis - shift] != 1 ? tensor->strides[axis - shift] : 0;
+        }
+
+        job.shape[axis] = out.shape[axis];
+        count *= out.shape[axis];
+    }
+
+    double work = (double) job.m * job.n * job.k;
+
+    if(count > 0 && work >= LWT_GEMM_PARALLEL_MIN) {
+
+        for(size_t t = 0; t < count; t ++) {
+
+            ptrdiff_t offsets[3];
+            lwt_batched_offsets(&job, t, offsets);
+
+            lwt_gemm(job.m, job.n, job.k, alpha,
+                job.A + offsets[1], job.rsa, job.csa,
+                job.B + offsets[2], job.rsb, job.csb,
+                beta, job.C + offsets[0], job.rsc, job.csc);
+        }
+    }
+    else if(count > 0) {
 
-    for(int r = 0; r < lhs.shape[0]; r ++) {
-        for(int c = 0; c < rhs.shape[1]; c ++) {
+        ttype* a_packs[LWT_MAX_THREADS] = { NULL };
+        ttype* b_packs[LWT_MAX_THREADS] = { NULL };
+        job.a_packs = a_packs;
+        job.b_packs = b_packs;
+        job.b_pack_size = lwt_gemm_b_pack_size(job.n, job.k);
+        job.blocks = 0;
 
-            ttype mir = 0.0;
-            for(int k = 0; k < lhs.shape[1]; k ++)
-                mir += get_value(rhs, k, r) * get_value(lhs, c, k);
+        /* Small matrices interleaved along a unit-stride first batch axis: vectorize across the batch. */
+        size_t tasks = count;
+        if(job.batch_rank > 0 && job.shape[0] >= LWT_GEMM_LANES && work <= LWT_GEMM_LANES_MAX && job.batch[0][0] == 1 &&
+            (job.batch[1][0] == 0 || job.batch[1][0] == 1) && (job.batch[2][0] == 0 || job.batch[2][0] == 1)) {
 
-            set_value(result, mir, r, c);
+            job.blocks = (job.shape[0] + LWT_GEMM_LANES - 1) / LWT_GEMM_LANES;
+            tasks = count / job.shape[0] * job.blocks;
+            work *= LWT_GEMM_LANES;
+        }
+
+        /* Enough products per task to amortize the scheduling. */
+        size_t grain = work > 0 ? (size_t) (LWT_GEMM_PARALLEL_MIN / 32 / work) : tasks;
+        grain = grain < 1 ? 1 : grain;
+
+        if(work * tasks < LWT_GEMM_PARALLEL_MIN || lwt_parallel_threads() == 1)
+            lwt_batched_gemm_task(&job, 0, tasks, 0);
+        else
+            lwt_parallel_for(tasks, grain, lwt_batched_gemm_task, &job);
+
+        for(int i = 0; i < LWT_MAX_THREADS; i ++) {
+            if(a_packs[i] != NULL) {
+                lwt_free_aligned(a_packs[i], sizeof(ttype) * LWT_GEMM_MC * LWT_GEMM_KC);
+                lwt_free_aligned(b_packs[i], sizeof(ttype) * job.b_pack_size);
+            }
         }
     }
 
+    LWT_OP_LEAVE();
+    return TENSOR_OK;
+}
+
+/**
+ * Multiplies every matrix of a batch.
+ *
+ * @param lhs Left-hand side of shape (..., m, k).
+ * @param rhs Right-hand side of shape (..., k, n).
+ * @return    A new tensor of shape (broadcast batch shape..., m, n), or the empty tensor
+ *            if the shapes do not match or an operand is not of the native element type.
+ */
+Tensor batched_matmul(Tensor lhs, Tensor rhs) {
+
+    unsigned int rank;
+    int shape[LWT_MAX_RANK];
+
+    if(lhs.dtype != TENSOR_NATIVE || rhs.dtype != TENSOR_NATIVE || lwt_batched_shape(lhs, rhs, &rank, shape) != TENSOR_OK)
+        return lwt_empty_tensor();
+
+    LWT_OP_ENTER("batched_matmul");
+
+    Tensor result = lwt_create_shaped(rank, shape);
+    batched_matmul_into(result, lhs, rhs, 1.0, 0.0);
+
+    LWT_OP_LEAVE();
     return result;
 }
 
+/**
+ * Computes y = alpha * op(A) * x + beta * y, where op(A) is A or its transpose.
+ *
+ * @param y     Output vector (or view) of length op(A) rows.
+ * @param A     The matrix (or view); any strides.
+ * @param x     Input vector (or view) of length op(A) columns.
+ * @param alpha Scale applied to the product.
+ * @param beta  Scale applied to the previous contents of `y` (0 overwrites them).
+ * @param trans Non-zero to multiply by the transpose of A.
+ * @return      TENSOR_OK, TENSOR_ERROR_SHAPE if the ranks or lengths do not match, or
+ *              TENSOR_ERROR_DTYPE for operands that are not of the native element type.
+ *
+ * Note: Uses the bandwidth-bound GEMV kernel in gemm.h, which reads A once with SIMD
+ * loads whichever of its strides is unit and splits the rows of y over the thread pool.
+ * `y` must not alias `A` or `x`.
+ */
+TensorStatus gemv_into(Vector y, Matrix A, Vector x, ttype alpha, ttype beta, int trans) {
+
+    if(y.dtype != TENSOR_NATIVE || A.dtype != TENSOR_NATIVE || x.dtype != TENSOR_NATIVE)
+        return TENSOR_ERROR_DTYPE;
+
+    if(y.rank != 1 || A.rank != 2 || x.rank != 1)
+        return TENSOR_ERROR_SHAPE;
+
+    int rows = trans ? 1 : 0;
+    if(A.shape[rows] != y.shape[0] || A.shape[1 - rows] != x.shape[0])
+        return TENSOR_ERROR_SHAPE;
+
+    lwt_gemv(A.shape[rows], A.shape[1 - rows], alpha,
+        A.components, A.strides[rows], A.strides[1 - rows],
+        x.components, x.strides[0],
+        beta, y.components, y.strides[0]);
+
+    return TENSOR_OK;
+}
+
 /**
  * Applies a matrix transformation to a vector.
  *
  * @param vec    The vector to be transformed.
  * @param matrix The transformation matrix.
- * @return       The resulting transformed vector.
+ * @return       The resulting transformed vector, of length `matrix` rows, or the empty tensor
+ *               if the number of columns of `matrix` differs from the length of `vec` or an
+ *               operand is not of the native element type.
  */
 Vector transform(Vector vec, Matrix matrix) {
 
-    Vector vector = create_vector(vec.shape[0]);
-
-    for(int r = 0; r < matrix.shape[0]; r ++) {
-
-        Vector row_vector = create_vector(matrix.shape[1]);
-
-        for(int c = 0; c < matrix.shape[1]; c ++) {
-            ttype value = get_value(matrix, r, c);
-            set_value(row_vector, value, c);
-        }
-        
-        ttype value = dot(row_vector, vec);
-        vector.components[r] = value;
+    LWT_OP_ENTER("transform");
 
-        destroy_tensor(row_vector);
+    Vector vector = create_vector(matrix.shape[0]);
+    if(gemv_into(vector, matrix, vec, 1.0, 0.0, 0) != TENSOR_OK) {
+        destroy_tensor(vector);
+        vector = lwt_empty_tensor();
     }
 
+    LWT_OP_LEAVE();
     return vector;
 }
 
@@ -134,15 +470,16 @@ Vector transform(Vector vec, Matrix matrix) {
  */
 Matrix transpose(Matrix matrix) {
 
+    LWT_OP_ENTER("transpose");
+
     Matrix matrix_transposed = create_matrix(matrix.shape[1], matrix.shape[0]);
 
     for(int r = 0; r < matrix.shape[0]; r ++) {
-        for(int c = 0; c < matrix.shape[1]; c ++) {
-            ttype value = get_value(matrix, r, c);
-            set_value(matrix_transposed, value, c, r);
-        }
+        for(int c = 0; c < matrix.shape[1]; c ++)
+            *tensor_at2(matrix_transposed, c, r) = *tensor_at2(matrix, r, c);
     }
 
+    LWT_OP_LEAVE();
     return matrix_transposed;
 }
 
@@ -156,15 +493,16 @@ Matrix transpose(Matrix matrix) {
  */
 ttype minor(Matrix matrix, unsigned int row, unsigned int col) {
 
+    LWT_OP_ENTER("minor");
+
     Matrix sub_matrix = create_matrix(matrix.shape[1] - 1, matrix.shape[1] - 1);
 
     int index = 0;
     for(int r = 0; r < matrix.shape[0]; r ++) {
         for(int c = 0; c < matrix.shape[1]; c ++) {
 
-            if(row != r && col != c) {
-                ttype value = get_value(matrix, r, c);
-                sub_matrix.components[index] = value;
+            if((int) row != r && (int) col != c) {
+                sub_matrix.components[index] = *tensor_at2(matrix, r, c);
                 index ++;
             }
         }
@@ -173,6 +511,7 @@ ttype minor(Matrix matrix, unsigned int row, unsigned int col) {
     ttype det = determinant(sub_matrix);
     destroy_tensor(sub_matrix);
 
+    LWT_OP_LEAVE();
     return det;
 }
 
@@ -204,7 +543,7 @@ Matrix cofactor_matrix(Matrix matrix) {
 
     for(int r = 0; r < matrix.shape[0]; r ++) {
         for(int c = 0; c < matrix.shape[1]; c ++)
-            set_value(cof_matrix, cofactor(matrix, r, c), r, c);
+            *tensor_at2(cof_matrix, r, c) = cofactor(matrix, r, c);
     }
 
     return cof_matrix;
@@ -224,46 +563,1499 @@ Matrix adjugate_matrix(Matrix matrix) {
     return cof_matrix_transposed;
 }
 
+/**
+ * Swaps two rows of a column-major block over a range of columns.
+ *
+ * @param a     Pointer to the first element, element (i, j) at a[i + j * lda].
+ * @param lda   Leading dimension of `a`.
+ * @param first First column to swap.
+ * @param last  One past the last column to swap.
+ * @param r0    First row.
+ * @param r1    Second row.
+ */
+void lwt_swap_rows(ttype* a, int lda, int first, int last, int r0, int r1) {
+
+    if(r0 == r1)
+        return;
+
+    for(int c = first; c < last; c ++) {
+        ttype* col = a + (size_t) c * lda;
+        ttype temp = col[r0];
+        col[r0] = col[r1];
+        col[r1] = temp;
+    }
+}
+
+/**
+ * Factors a column-major square block in place as P * A = L * U with partial pivoting.
+ *
+ * @param n   Order of the matrix.
+ * @param a   Pointer to the first element, element (i, j) at a[i + j * lda].
+ * @param lda Leading dimension of `a`.
+ * @param piv  Output array of n row interchanges: row k was swapped with row piv[k] at step k (may be NULL).
+ * @param b    Optional column-major block whose rows receive the same interchanges (may be NULL).
+ * @param ldb  Leading dimension of `b`.
+ * @param nrhs Number of columns of `b`.
+ * @return     TENSOR_OK, or TENSOR_ERROR_SINGULAR if an exactly zero pivot was met.
+ *
+ * Note: L is unit lower triangular and stored below the diagonal, U on and above it.
+ * Panels of LWT_LU_NB columns are factored unblocked and the trailing matrix is
+ * updated through lwt_gemm, so most of the work runs in the GEMM kernel.
+ * Passing a right-hand side in `b` leaves P * B in it, so callers that only solve
+ * do not need to keep the pivots around.
+ */
+TensorStatus lwt_lu_factor(int n, ttype* a, int lda, int* piv, ttype* b, int ldb, int nrhs) {
+
+    TensorStatus status = TENSOR_OK;
+    int panel_piv[LWT_LU_NB];
+
+    for(int j = 0; j < n; j += LWT_LU_NB) {
+
+        int jb = n - j < LWT_LU_NB ? n - j : LWT_LU_NB;
+
+        // Unblocked factorization of the panel a[j:n, j:j+jb]
+        for(int k = j; k < j + jb; k ++) {
+
+            ttype* column = a + (size_t) k * lda;
+
+            int p = k;
+            ttype max = fabs(column[k]);
+            for(int i = k + 1; i < n; i ++) {
+                if(fabs(column[i]) > max) {
+                    max = fabs(column[i]);
+                    p = i;
+                }
+            }
+
+            panel_piv[k - j] = p;
+
+            if(max == 0.0) {
+                status = TENSOR_ERROR_SINGULAR;
+                continue;
+            }
+
+            lwt_swap_rows(a, lda, j, j + jb, k, p);
+
+            ttype inv_pivot = 1.0 / column[k];
+            for(int i = k + 1; i < n; i ++)
+                column[i] *= inv_pivot;
+
+            for(int c = k + 1; c < j + jb; c ++) {
+
+                ttype* col = a + (size_t) c * lda;
+                ttype factor = col[k];
+
+                for(int i = k + 1; i < n; i ++)
+                    col[i] -= column[i] * factor;
+            }
+        }
+
+        // Apply the panel interchanges to the columns left and right of the panel
+        for(int k = j; k < j + jb; k ++) {
+
+            int p = panel_piv[k - j];
+
+            lwt_swap_rows(a, lda, 0, j, k, p);
+            lwt_swap_rows(a, lda, j + jb, n, k, p);
+
+            if(b != NULL)
+                lwt_swap_rows(b, ldb, 0, nrhs, k, p);
+            if(piv != NULL)
+                piv[k] = p;
+        }
+
+        if(j + jb >= n)
+            continue;
+
+        // A12 = L11^-1 * A12
+        for(int c = j + jb; c < n; c ++) {
+
+            ttype* col = a + (size_t) c * lda;
+
+            for(int k = j; k < j + jb; k ++) {
+
+                ttype x = col[k];
+                const ttype* l = a + (size_t) k * lda;
+
+                for(int i = k + 1; i < j + jb; i ++)
+                    col[i] -= l[i] * x;
+            }
+        }
+
+        // A22 = A22 - A21 * A12
+        int rest = n - j - jb;
+        lwt_gemm(rest, rest, jb, -1.0,
+            a + (j + jb) + (size_t) j * lda, 1, lda,
+            a + j + (size_t) (j + jb) * lda, 1, lda,
+            1.0, a + (j + jb) + (size_t) (j + jb) * lda, 1, lda);
+    }
+
+    return status;
+}
+
+/**
+ * Solves L * X = B in place for a unit lower triangular L.
+ *
+ * @param n    Order of L.
+ * @param nrhs Number of right-hand sides (columns of B).
+ * @param a    Column-major block holding L below its diagonal (the diagonal is taken as 1).
+ * @param lda  Leading dimension of `a`.
+ * @param b    Column-major right-hand sides, overwritten with X.
+ * @param ldb  Leading dimension of `b`.
+ *
+ * Note: Diagonal blocks of LWT_LU_NB rows are solved directly and the remaining
+ * rows are updated through lwt_gemm.
+ */
+void lwt_trsm_lower_unit(int n, int nrhs, const ttype* a, int lda, ttype* b, int ldb) {
+
+    for(int j = 0; j < n; j += LWT_LU_NB) {
+
+        int jb = n - j < LWT_LU_NB ? n - j : LWT_LU_NB;
+
+        for(int c = 0; c < nrhs; c ++) {
+
+            ttype* x = b + (size_t) c * ldb;
+
+            for(int k = j; k < j + jb; k ++) {
+
+                const ttype* l = a + (size_t) k * lda;
+                ttype value = x[k];
+
+                for(int i = k + 1; i < j + jb; i ++)
+                    x[i] -= l[i] * value;
+            }
+        }
+
+        if(j + jb < n)
+            lwt_gemm(n - j - jb, nrhs, jb, -1.0,
+                a + (j + jb) + (size_t) j * lda, 1, lda,
+                b + j, 1, ldb,
+                1.0, b + j + jb, 1, ldb);
+    }
+}
+
+/**
+ * Solves U * X = B in place for a non-unit upper triangular U.
+ *
+ * @param n    Order of U.
+ * @param nrhs Number of right-hand sides (columns of B).
+ * @param a    Column-major block holding U on and above its diagonal.
+ * @param lda  Leading dimension of `a`.
+ * @param b    Column-major right-hand sides, overwritten with X.
+ * @param ldb  Leading dimension of `b`.
+ *
+ * Note: Works bottom-up in blocks of LWT_LU_NB rows, updating the rows above through lwt_gemm.
+ */
+void lwt_trsm_upper(int n, int nrhs, const ttype* a, int lda, ttype* b, int ldb) {
+
+    for(int end = n; end > 0; end -= LWT_LU_NB) {
+
+        int j = end - LWT_LU_NB > 0 ? end - LWT_LU_NB : 0;
+        int jb = end - j;
+
+        for(int c = 0; c < nrhs; c ++) {
+
+            ttype* x = b + (size_t) c * ldb;
+
+            for(int k = end - 1; k >= j; k --) {
+
+                const ttype* u = a + (size_t) k * lda;
+                x[k] /= u[k];
+                ttype value = x[k];
+
+                for(int i = j; i < k; i ++)
+                    x[i] -= u[i] * value;
+            }
+        }
+
+        if(j > 0)
+            lwt_gemm(j, nrhs, jb, -1.0,
+                a + (size_t) j * lda, 1, lda,
+                b + j, 1, ldb,
+                1.0, b, 1, ldb);
+    }
+}
+
+/**
+ * Computes the LU factorization with partial pivoting of a square matrix.
+ *
+ * @param matrix Input square matrix.
+ * @param LU     Output n x n matrix receiving L (unit diagonal, below) and U (on and above the diagonal).
+ *               It may be `matrix` itself for an in-place factorization.
+ * @param piv    Output array of n row interchanges: row k was swapped with row piv[k] at step k.
+ * @return       TENSOR_OK, TENSOR_ERROR_SHAPE for non-square input, TENSOR_ERROR_DTYPE if `matrix`
+ *               or `LU` is not of the native element type, TENSOR_ERROR_LAYOUT if `LU` does not
+ *               have unit stride along its rows, or TENSOR_ERROR_SINGULAR if the matrix is exactly
+ *               singular (the factorization is still completed).
+ */
+TensorStatus lu_decompose(Matrix matrix, Matrix* LU, int* piv) {
+
+    if(matrix.dtype != TENSOR_NATIVE || LU->dtype != TENSOR_NATIVE)
+        return TENSOR_ERROR_DTYPE;
+
+    int n = matrix.shape[0];
+
+    if(matrix.shape[1] != n || LU->shape[0] != n || LU->shape[1] != n)
+        return TENSOR_ERROR_SHAPE;
+
+    if(LU->strides[0] != 1)
+        return TENSOR_ERROR_LAYOUT;
+
+    if(LU->components != matrix.components)
+        copy_into(*LU, matrix);
+
+    return lwt_lu_factor(n, LU->components, LU->strides[1], piv, NULL, 0, 0);
+}
+
 /**
  * Computes the determinant of a matrix.
  *
  * @param matrix Input matrix.
- * @return       The determinant value.
+ * @return       The determinant value, 0 for a non-square matrix, or NaN if `matrix` is not of
+ *               the native element type.
  *
- * Note: Only works for square matrices.
+ * Note: Only works for square matrices. Uses an LU factorization, O(n^3).
  */
 ttype determinant(Matrix matrix) {
 
+    if(matrix.dtype != TENSOR_NATIVE)
+        return NAN;
     if(matrix.shape[0] != matrix.shape[1])
         return 0.0;
 
-    if(matrix.shape[1] == 2)
-        return get_value(matrix, 0, 0) * get_value(matrix, 1, 1) - get_value(matrix, 1, 0) * get_value(matrix, 0, 1);
+    LWT_OP_ENTER("determinant");
+
+    int n = matrix.shape[0];
+    Matrix LU = create_matrix(n, n);
+    int* piv = (int*) lwt_malloc(sizeof(int) * n);
+
+    lu_decompose(matrix, &LU, piv);
+
+    ttype result = 1.0;
+    for(int k = 0; k < n; k ++) {
+        result *= LU.components[k + (size_t) k * n];
+        if(piv[k] != k)
+            result = -result;
+    }
+
+    lwt_free(piv, sizeof(int) * n);
+    destroy_tensor(LU);
+
+    LWT_OP_LEAVE();
+    return result;
+}
+
+/**
+ * Computes the 1-norm (maximum absolute column sum) of a column-major square block.
+ *
+ * @param n   Order of the block.
+ * @param a   Pointer to the first element.
+ * @param lda Leading dimension of `a`.
+ * @return    The 1-norm.
+ */
+ttype lwt_norm1(int n, const ttype* a, int lda) {
 
     ttype result = 0.0;
-    for(int r = 0; r < matrix.shape[0]; r ++) {
-        ttype cof = cofactor(matrix, r, 0);
-        result += get_value(matrix, r, 0) * cof; 
+    for(int c = 0; c < n; c ++) {
+
+        const ttype* col = a + (size_t) c * lda;
+
+        ttype sum = 0.0;
+        for(int i = 0; i < n; i ++)
+            sum += fabs(col[i]);
+
+        if(sum > result)
+            result = sum;
     }
 
     return result;
 }
 
+/**
+ * Computes the inverse of a matrix into preallocated storage.
+ *
+ * @param out       Output n x n matrix. It may be `in` itself.
+ * @param in        A square matrix (or view).
+ * @param workspace Scratch n x n matrix that receives the LU factors of `in`.
+ * @return          TENSOR_OK, TENSOR_ERROR_SHAPE if the shapes do not match, TENSOR_ERROR_DTYPE if
+ *                  an operand is not of the native element type,
+ *                  TENSOR_ERROR_LAYOUT if `out` or `workspace` lack unit stride along their rows,
+ *                  TENSOR_ERROR_SINGULAR if `in` is exactly singular (`out` is left undefined), or
+ *                  TENSOR_ERROR_ILL_CONDITIONED if the reciprocal 1-norm condition number is below
+ *                  the machine epsilon of `ttype` (`out` still holds the computed inverse).
+ *
+ * Note: Performs no allocation. P * A = L * U is factored in `workspace` while the
+ * interchanges are applied to the identity in `out`, which is then solved with L and U.
+ */
+TensorStatus inverse_into(Matrix out, Matrix in, Matrix workspace) {
+
+    if(out.dtype != TENSOR_NATIVE || in.dtype != TENSOR_NATIVE || workspace.dtype != TENSOR_NATIVE)
+        return TENSOR_ERROR_DTYPE;
+
+    int n = in.shape[0];
+
+    if(in.shape[1] != n || out.shape[0] != n || out.shape[1] != n ||
+        workspace.shape[0] != n || workspace.shape[1] != n)
+        return TENSOR_ERROR_SHAPE;
+
+    if(out.strides[0] != 1 || workspace.strides[0] != 1)
+        return TENSOR_ERROR_LAYOUT;
+
+    int ldw = workspace.strides[1], ldo = out.strides[1];
+
+    copy_into(workspace, in);
+    ttype in_norm = lwt_norm1(n, workspace.components, ldw);
+
+    for(int c = 0; c < n; c ++) {
+        for(int r = 0; r < n; r ++)
+            *tensor_at2(out, r, c) = r == c ? 1.0 : 0.0;
+    }
+
+    if(lwt_lu_factor(n, workspace.components, ldw, NULL, out.components, ldo, n) != TENSOR_OK)
+        return TENSOR_ERROR_SINGULAR;
+
+    lwt_trsm_lower_unit(n, n, workspace.components, ldw, out.components, ldo);
+    lwt_trsm_upper(n, n, workspace.components, ldw, out.components, ldo);
+
+    ttype epsilon = sizeof(ttype) == sizeof(float) ? FLT_EPSILON : DBL_EPSILON;
+    ttype rcond = 1.0 / (in_norm * lwt_norm1(n, out.components, ldo));
+
+    if(!(rcond >= epsilon))
+        return TENSOR_ERROR_ILL_CONDITIONED;
+
+    return TENSOR_OK;
+}
+
 /**
  * Computes the inverse of a matrix.
  *
  * @param matrix A square matrix.
- * @return       The inverse matrix.
+ * @return       The inverse matrix, or the empty tensor if `matrix` is not square or not of the
+ *               native element type.
  *
- * Note: Assumes the matrix is invertible. No zero-determinant check is enforced.
+ * Note: Singular or ill-conditioned input is not reported; use `inverse_into` to get a status.
  */
 Matrix inverse(Matrix matrix) {
 
-    ttype det = determinant(matrix);
+    LWT_OP_ENTER("inverse");
 
-    Matrix inv = adjugate_matrix(matrix);
-    ttype inv_determinant = 1 / det;
-    product_scalar(inv, inv_determinant);
+    int n = matrix.shape[0];
 
-    return inv;
+    Matrix inv = create_matrix(n, n);
+    Matrix workspace = create_matrix(n, n);
+
+    TensorStatus status = inverse_into(inv, matrix, workspace);
+    destroy_tensor(workspace);
+
+    if(status == TENSOR_ERROR_SHAPE || status == TENSOR_ERROR_DTYPE) {
+        destroy_tensor(inv);
+        inv = lwt_empty_tensor();
+    }
+
+    LWT_OP_LEAVE();
+    return inv;
+}
+
+/*
+ * One step of the trailing update of a blocked Cholesky factorization, A22 -= L21 * L21^T:
+ * task t updates the lower part of the t-th block column of A22, LWT_LU_NB columns wide,
+ * with its own packing buffers.
+ */
+typedef struct {
+    int n, first, k;
+    ttype* a;
+    int lda;
+    const ttype* panel;
+    ttype** a_packs;
+    ttype** b_packs;
+} LwtCholeskyJob;
+
+void lwt_cholesky_update_task(void* context, size_t begin, size_t end, int thread) {
+
+    LwtCholeskyJob* job = (LwtCholeskyJob*) context;
+
+    if(job->a_packs[thread] == NULL) {
+        job->a_packs[thread] = (ttype*) lwt_malloc_aligned(sizeof(ttype) * LWT_GEMM_MC * LWT_GEMM_KC);
+        job->b_packs[thread] = (ttype*) lwt_malloc_aligned(sizeof(ttype) * lwt_gemm_b_pack_size(LWT_LU_NB, LWT_LU_NB));
+    }
+
+    for(size_t t = begin; t < end; t ++) {
+
+        int c = job->first + (int) t * LWT_LU_NB;
+        int cb = job->n - c < LWT_LU_NB ? job->n - c : LWT_LU_NB;
+
+        // Rows c..n of the block column; the part above its diagonal is scratch
+        lwt_gemm_serial(job->n - c, cb, job->k, -1.0,
+            job->panel + c, 1, job->lda,
+            job->panel + c, job->lda, 1,
+            1.0, job->a + c + (size_t) c * job->lda, 1, job->lda,
+            job->a_packs[thread], job->b_packs[thread]);
+    }
+}
+
+/**
+ * Factors a column-major symmetric positive definite block in place as A = L * L^T.
+ *
+ * @param n   Order of the matrix.
+ * @param a   Pointer to the first element, element (i, j) at a[i + j * lda]. Only the lower
+ *            triangle is read; it receives L, and the strict upper triangle is overwritten.
+ * @param lda Leading dimension of `a`.
+ * @return    TENSOR_OK, or TENSOR_ERROR_SINGULAR if the matrix is not positive definite
+ *            (a pivot is not positive); the factorization then stops at that column.
+ *
+ * Note: Panels of LWT_LU_NB columns are factored unblocked; the trailing update runs one
+ * GEMM per block column, restricted to the rows on and below its diagonal, and large
+ * updates spread the block columns over the current thread pool.
+ */
+TensorStatus lwt_cholesky_factor(int n, ttype* a, int lda) {
+
+    ttype* a_packs[LWT_MAX_THREADS] = { NULL };
+    ttype* b_packs[LWT_MAX_THREADS] = { NULL };
+    TensorStatus status = TENSOR_OK;
+
+    LwtCholeskyJob job;
+    job.n = n;
+    job.a = a;
+    job.lda = lda;
+    job.a_packs = a_packs;
+    job.b_packs = b_packs;
+
+    for(int j = 0; j < n && status == TENSOR_OK; j += LWT_LU_NB) {
+
+        int jb = n - j < LWT_LU_NB ? n - j : LWT_LU_NB;
+
+        // Unblocked factorization of the panel a[j:n, j:j+jb]
+        for(int k = j; k < j + jb; k ++) {
+
+            ttype* column = a + (size_t) k * lda;
+
+            if(!(column[k] > 0.0)) {
+                status = TENSOR_ERROR_SINGULAR;
+                break;
+            }
+
+            column[k] = sqrt(column[k]);
+
+            ttype inv_pivot = 1.0 / column[k];
+            for(int i = k + 1; i < n; i ++)
+                column[i] *= inv_pivot;
+
+            for(int c = k + 1; c < j + jb; c ++) {
+
+                ttype* col = a + (size_t) c * lda;
+                ttype factor = column[c];
+
+                for(int i = c; i < n; i ++)
+                    col[i] -= column[i] * factor;
+            }
+        }
+
+        if(status != TENSOR_OK || j + jb >= n)
+            continue;
+
+        // A22 = A22 - L21 * L21^T
+        int rest = n - j - jb;
+        size_t tasks = (size_t) (rest + LWT_LU_NB - 1) / LWT_LU_NB;
+
+        job.first = j + jb;
+        job.k = jb;
+        job.panel = a + (size_t) j * lda;
+
+        if((double) rest * rest * jb < LWT_GEMM_PARALLEL_MIN)
+            lwt_cholesky_update_task(&job, 0, tasks, 0);
+        else
+            lwt_parallel_for(tasks, 1, lwt_cholesky_update_task, &job);
+    }
+
+    for(int t = 0; t < LWT_MAX_THREADS; t ++) {
+        lwt_free_aligned(a_packs[t], sizeof(ttype) * LWT_GEMM_MC * LWT_GEMM_KC);
+        lwt_free_aligned(b_packs[t], sizeof(ttype) * lwt_gemm_b_pack_size(LWT_LU_NB, LWT_LU_NB));
+    }
+
+    return status;
+}
+
+/**
+ * Solves L * X = B, or L^T * X = B, in place for a non-unit lower triangular L.
+ *
+ * @param n     Order of L.
+ * @param nrhs  Number of right-hand sides (columns of B).
+ * @param a     Column-major block holding L on and below its diagonal.
+ * @param lda   Leading dimension of `a`.
+ * @param trans Nonzero to solve with L^T.
+ * @param b     Column-major right-hand sides, overwritten with X.
+ * @param ldb   Leading dimension of `b`.
+ *
+ * Note: Diagonal blocks of LWT_LU_NB rows are solved directly (top-down for L, bottom-up
+ * for L^T) and the remaining rows are updated through lwt_gemm, which reads L^T through
+ * swapped strides.
+ */
+void lwt_trsm_lower(int n, int nrhs, const ttype* a, int lda, int trans, ttype* b, int ldb) {
+
+    for(int step = 0; step < n; step += LWT_LU_NB) {
+
+        int j = trans ? (n - step - LWT_LU_NB > 0 ? n - step - LWT_LU_NB : 0) : step;
+        int end = trans ? n - step : (j + LWT_LU_NB < n ? j + LWT_LU_NB : n);
+        int jb = end - j;
+
+        for(int c = 0; c < nrhs; c ++) {
+
+            ttype* x = b + (size_t) c * ldb;
+
+            if(trans) {
+                for(int k = end - 1; k >= j; k --) {
+
+                    const ttype* l = a + (size_t) k * lda;
+                    ttype value = x[k];
+
+                    for(int i = k + 1; i < end; i ++)
+                        value -= l[i] * x[i];
+
+                    x[k] = value / l[k];
+                }
+            }
+            else {
+                for(int k = j; k < end; k ++) {
+
+                    const ttype* l = a + (size_t) k * lda;
+                    x[k] /= l[k];
+                    ttype value = x[k];
+
+                    for(int i = k + 1; i < end; i ++)
+                        x[i] -= l[i] * value;
+                }
+            }
+        }
+
+        if(trans && j > 0)
+            lwt_gemm(j, nrhs, jb, -1.0,
+                a + j, lda, 1,
+                b + j, 1, ldb,
+                1.0, b, 1, ldb);
+        else if(!trans && end < n)
+            lwt_gemm(n - end, nrhs, jb, -1.0,
+                a + end + (size_t) j * lda, 1, lda,
+                b + j, 1, ldb,
+                1.0, b + end, 1, ldb);
+    }
+}
+
+/**
+ * Computes the Cholesky factorization A = L * L^T of a symmetric positive definite matrix.
+ *
+ * @param L Output n x n lower triangular factor (zero above the diagonal). It may be `A`
+ *          itself for an in-place factorization.
+ * @param A A symmetric positive definite matrix (or view); only its lower triangle is read.
+ * @return  TENSOR_OK, TENSOR_ERROR_SHAPE if the shapes do not match, TENSOR_ERROR_DTYPE if `L` is
+ *          not of the native element type, TENSOR_ERROR_LAYOUT if `L` does not have unit stride
+ *          along its rows, or TENSOR_ERROR_SINGULAR if `A` is not positive definite (`L` is then
+ *          left undefined).
+ *
+ * Note: Performs no allocation besides the GEMM packing buffers, and half the work of `lu_decompose`.
+ */
+TensorStatus cholesky_into(Matrix L, Matrix A) {
+
+    int n = A.shape[0];
+
+    if(A.rank != 2 || L.rank != 2 || A.shape[1] != n || L.shape[0] != n || L.shape[1] != n)
+        return TENSOR_ERROR_SHAPE;
+
+    if(L.dtype != TENSOR_NATIVE)
+        return TENSOR_ERROR_DTYPE;
+
+    if(L.strides[0] != 1)
+        return TENSOR_ERROR_LAYOUT;
+
+    LWT_OP_ENTER("cholesky");
+
+    if(L.components != A.components)
+        copy_into(L, A);
+
+    int ldl = L.strides[1];
+    TensorStatus status = lwt_cholesky_factor(n, L.components, ldl);
+
+    for(int c = 1; c < n && status == TENSOR_OK; c ++) {
+        for(int r = 0; r < c; r ++)
+            L.components[r + (size_t) c * ldl] = 0.0;
+    }
+
+    LWT_OP_LEAVE();
+    return status;
+}
+
+/**
+ * Solves A * X = B for a symmetric positive definite A given its Cholesky factor.
+ *
+ * @param X Output n x nrhs matrix (or n vector). It may be `B` itself.
+ * @param L The factor computed by `cholesky_into`.
+ * @param B Right-hand sides: an n x nrhs matrix, or an n vector.
+ * @return  TENSOR_OK, TENSOR_ERROR_SHAPE if the shapes do not match, TENSOR_ERROR_DTYPE if `L` or
+ *          `X` is not of the native element type, or TENSOR_ERROR_LAYOUT if `L` or `X` does not
+ *          have unit stride along its rows.
+ *
+ * Note: Runs a forward substitution with L and a back substitution with L^T on all the
+ * right-hand sides at once, O(n^2 * nrhs).
+ */
+TensorStatus cholesky_solve_into(Tensor X, Matrix L, Tensor B) {
+
+    int n = L.shape[0];
+
+    if(L.rank != 2 || L.shape[1] != n || B.rank < 1 || B.rank > 2 || X.rank != B.rank || B.shape[0] != n ||
+        X.shape[0] != n || (B.rank == 2 && X.shape[1] != B.shape[1]))
+        return TENSOR_ERROR_SHAPE;
+
+    if(L.dtype != TENSOR_NATIVE || X.dtype != TENSOR_NATIVE)
+        return TENSOR_ERROR_DTYPE;
+
+    if(L.strides[0] != 1 || X.strides[0] != 1)
+        return TENSOR_ERROR_LAYOUT;
+
+    LWT_OP_ENTER("cholesky_solve");
+
+    if(X.components != B.components)
+        copy_into(X, B);
+
+    int nrhs = X.rank == 2 ? X.shape[1] : 1;
+    int ldx = X.rank == 2 ? X.strides[1] : n;
+
+    lwt_trsm_lower(n, nrhs, L.components, L.strides[1], 0, X.components, ldx);
+    lwt_trsm_lower(n, nrhs, L.components, L.strides[1], 1, X.components, ldx);
+
+    LWT_OP_LEAVE();
+    return TENSOR_OK;
+}
+
+/**
+ * Solves A * X = B for a square A through an LU factorization with partial pivoting.
+ *
+ * @param X         Output n x nrhs matrix (or n vector). It may be `B` itself.
+ * @param A         A square matrix (or view).
+ * @param B         Right-hand sides: an n x nrhs matrix, or an n vector.
+ * @param workspace Scratch n x n matrix that receives the LU factors of `A`.
+ * @return          TENSOR_OK, TENSOR_ERROR_SHAPE if the shapes do not match, TENSOR_ERROR_DTYPE if
+ *                  `X` or `workspace` is not of the native element type, TENSOR_ERROR_LAYOUT if `X`
+ *                  or `workspace` lacks unit stride along its rows, or TENSOR_ERROR_SINGULAR if `A`
+ *                  is exactly singular (`X` is left undefined).
+ *
+ * Note: Performs no allocation besides the GEMM packing buffers. The row interchanges are
+ * applied to X while A is factored, and two triangular solves finish it: about a third of
+ * the work of `inverse_into` followed by a product, and more accurate.
+ */
+TensorStatus solve_into(Tensor X, Matrix A, Tensor B, Matrix workspace) {
+
+    int n = A.shape[0];
+
+    if(A.rank != 2 || A.shape[1] != n || B.rank < 1 || B.rank > 2 || X.rank != B.rank || B.shape[0] != n ||
+        X.shape[0] != n || (B.rank == 2 && X.shape[1] != B.shape[1]) ||
+        workspace.rank != 2 || workspace.shape[0] != n || workspace.shape[1] != n)
+        return TENSOR_ERROR_SHAPE;
+
+    if(X.dtype != TENSOR_NATIVE || workspace.dtype != TENSOR_NATIVE)
+        return TENSOR_ERROR_DTYPE;
+
+    if(X.strides[0] != 1 || workspace.strides[0] != 1)
+        return TENSOR_ERROR_LAYOUT;
+
+    LWT_OP_ENTER("solve");
+
+    copy_into(workspace, A);
+    if(X.components != B.components)
+        copy_into(X, B);
+
+    int nrhs = X.rank == 2 ? X.shape[1] : 1;
+    int ldx = X.rank == 2 ? X.strides[1] : n;
+    int ldw = workspace.strides[1];
+
+    TensorStatus status = lwt_lu_factor(n, workspace.components, ldw, NULL, X.components, ldx, nrhs);
+
+    if(status == TENSOR_OK) {
+        lwt_trsm_lower_unit(n, nrhs, workspace.components, ldw, X.components, ldx);
+        lwt_trsm_upper(n, nrhs, workspace.components, ldw, X.components, ldx);
+    }
+
+    LWT_OP_LEAVE();
+    return status;
+}
+
+/**
+ * Solves A * X = B for a square A.
+ *
+ * @param A A square matrix.
+ * @param B Right-hand sides: an n x nrhs matrix, or an n vector.
+ * @return  The solution, shaped like `B`.
+ *
+ * Note: Singular input is not reported; use `solve_into` to get a status.
+ */
+Tensor solve(Matrix A, Tensor B) {
+
+    int n = A.shape[0];
+
+    Tensor X = B.rank == 2 ? create_matrix(n, B.shape[1]) : create_vector(n);
+    Matrix workspace = create_matrix(n, n);
+
+    solve_into(X, A, B, workspace);
+    destroy_tensor(workspace);
+
+    return X;
+}
+
+/**
+ * Copies a rows x cols strided block to or from a column-major buffer.
+ *
+ * @param rows  Number of rows.
+ * @param cols  Number of columns.
+ * @param t     First element of the strided block.
+ * @param rs    Row stride of the block.
+ * @param cs    Column stride of the block.
+ * @param a     Column-major buffer.
+ * @param lda   Leading dimension of `a`.
+ * @param store Nonzero to copy the buffer into the block, zero for the other way round.
+ */
+void lwt_block_copy(int rows, int cols, ttype* t, ptrdiff_t rs, ptrdiff_t cs, ttype* a, int lda, int store) {
+
+    for(int c = 0; c < cols; c ++) {
+
+        ttype* col = a + (size_t) c * lda;
+
+        for(int r = 0; r < rows; r ++) {
+            if(store)
+                t[r * rs + c * cs] = col[r];
+            else
+                col[r] = t[r * rs + c * cs];
+        }
+    }
+}
+
+/*
+ * Column block of the blocked QR factorization: each panel is factored recursively,
+ * halving it down to LWT_QR_LEAF columns, and the trailing matrix is updated with the
+ * compact WY form of the panel, I - V * T * V^T, so most of the work runs in GEMM.
+ */
+#ifndef LWT_QR_NB
+#define LWT_QR_NB 64
+#endif
+
+#ifndef LWT_QR_LEAF
+#define LWT_QR_LEAF 8
+#endif
+
+/**
+ * Euclidean norm of a contiguous column, scaled by its largest magnitude as LAPACK's xNRM2.
+ *
+ * @param length Number of elements of the column.
+ * @param x      Pointer to the first element.
+ * @return       The norm, which does not overflow or underflow when it is representable.
+ */
+ttype lwt_column_norm(int length, const ttype* x) {
+
+    ttype largest = 0.0;
+    for(int i = 0; i < length; i ++)
+        largest = fabs(x[i]) > largest ? fabs(x[i]) : largest;
+
+    if(largest == 0.0)
+        return 0.0;
+
+    ttype sum = 0.0;
+    for(int i = 0; i < length; i ++) {
+        ttype scaled = x[i] / largest;
+        sum += scaled * scaled;
+    }
+
+    return largest * sqrt(sum);
+}
+
+/**
+ * Turns a column into a Householder reflector H = I - tau * v * v^T with H * x = (beta, 0, ..., 0).
+ *
+ * @param length Number of elements of the column.
+ * @param v      The column x, overwritten with beta followed by v[1:length] (v[0] = 1 is implicit).
+ * @return       tau, or 0 when the column is already zero below its first element.
+ *
+ * Note: Like LAPACK's xLARFG, the column is scaled by its largest magnitude before the
+ * squares are summed, so beta neither overflows nor underflows for columns whose norm
+ * is representable.
+ */
+ttype lwt_householder(int length, ttype* v) {
+
+    ttype largest = 0.0;
+    for(int i = 1; i < length; i ++)
+        largest = fabs(v[i]) > largest ? fabs(v[i]) : largest;
+
+    if(largest == 0.0)
+        return 0.0;
+
+    ttype norm_scale = fabs(v[0]) > largest ? fabs(v[0]) : largest;
+    for(int i = 1; i < length; i ++)
+        v[i] /= norm_scale;
+
+    /* Everything below is in units of norm_scale; only beta is scaled back. */
+    ttype alpha = v[0] / norm_scale;
+    ttype tail = lwt_sum_block(length - 1, v + 1, 1, v + 1, 1);
+
+    ttype beta = sqrt(alpha * alpha + tail);
+    beta = alpha >= 0.0 ? -beta : beta;
+
+    ttype scale = 1.0 / (alpha - beta);
+    for(int i = 1; i < length; i ++)
+        v[i] *= scale;
+    v[0] = beta * norm_scale;
+
+    return (beta - alpha) / beta;
+}
+
+/**
+ * Applies a Householder reflector to a column.
+ *
+ * @param length Number of elements of the column.
+ * @param v      The reflector, as left by `lwt_householder` (v[0] is taken as 1).
+ * @param tau    Its scale.
+ * @param col    The column, overwritten with H * col.
+ */
+void lwt_householder_apply(int length, const ttype* v, ttype tau, ttype* col) {
+
+    if(tau == 0.0)
+        return;
+
+    ttype w = tau * (col[0] + lwt_sum_block(length - 1, v + 1, 1, col + 1, 1));
+
+    col[0] -= w;
+    for(int i = 1; i < length; i ++)
+        col[i] -= w * v[i];
+}
+
+/**
+ * Factors a column-major m x n block in place as A = Q * R, one reflector at a time (m >= n).
+ *
+ * @param m   Number of rows.
+ * @param n   Number of columns.
+ * @param a   Pointer to the first element, element (i, j) at a[i + j * lda]. Receives R on and
+ *            above the diagonal and the reflectors below it.
+ * @param lda Leading dimension of `a`.
+ * @param tau Output array of the n reflector scales.
+ *
+ * Note: Reflector k is H_k = I - tau[k] * v * v^T with v[k] = 1, v[k+1:m] stored below the
+ * diagonal of column k and zeros above, and Q = H_0 * H_1 * ... * H_(n-1) (the LAPACK convention).
+ */
+void lwt_qr_factor(int m, int n, ttype* a, int lda, ttype* tau) {
+
+    for(int k = 0; k < n; k ++) {
+
+        ttype* v = a + k + (size_t) k * lda;
+        tau[k] = lwt_householder(m - k, v);
+
+        for(int c = k + 1; c < n; c ++)
+            lwt_householder_apply(m - k, v, tau[k], a + k + (size_t) c * lda);
+    }
+}
+
+/**
+ * Applies the orthogonal factor of `lwt_qr_factor` to a column-major block, one reflector at a time.
+ *
+ * @param m     Number of rows of the reflectors and of B.
+ * @param k     Number of reflectors.
+ * @param a     The reflectors, as left by `lwt_qr_factor`.
+ * @param lda   Leading dimension of `a`.
+ * @param tau   The reflector scales.
+ * @param trans Nonzero to apply Q^T, zero to apply Q.
+ * @param b     Column-major m x nrhs block, overwritten with Q^T * B or Q * B.
+ * @param ldb   Leading dimension of `b`.
+ * @param nrhs  Number of columns of `b`.
+ */
+void lwt_qr_apply(int m, int k, const ttype* a, int lda, const ttype* tau, int trans, ttype* b, int ldb, int nrhs) {
+
+    for(int step = 0; step < k; step ++) {
+
+        int j = trans ? step : k - 1 - step;
+        const ttype* v = a + j + (size_t) j * lda;
+
+        for(int c = 0; c < nrhs; c ++)
+            lwt_householder_apply(m - j, v, tau[j], b + j + (size_t) c * ldb);
+    }
+}
+
+/**
+ * Builds the triangular factor T of the compact WY form H_0 * ... * H_(k-1) = I - V * T * V^T.
+ *
+ * @param m   Number of rows of the reflectors.
+ * @param k   Number of reflectors.
+ * @param v   The reflectors, as left by `lwt_qr_factor` (unit lower trapezoidal).
+ * @param lda Leading dimension of `v`.
+ * @param tau The reflector scales.
+ * @param t   Output k x k upper triangular factor, zero below the diagonal.
+ * @param ldt Leading dimension of `t`.
+ *
+ * Note: V^T * V is formed first, its rows below the top k x k triangle through GEMM, and
+ * T follows from the recurrence T[0:i, i] = -tau[i] * T[0:i, 0:i] * (V^T * V)[0:i, i].
+ */
+void lwt_qr_form_t(int m, int k, const ttype* v, int lda, const ttype* tau, ttype* t, int ldt) {
+
+    if(m > k)
+        lwt_gemm_split_k(k, k, m - k, 1.0, v + k, lda, 1, v + k, 1, lda, 0.0, t, 1, ldt);
+    else
+        lwt_gemm_scale(k, k, 0.0, t, 1, ldt);
+
+    for(int i = 0; i < k; i ++) {
+        for(int p = 0; p < i; p ++) {
+
+            ttype g = v[i + (size_t) p * lda];
+            for(int r = i + 1; r < k; r ++)
+                g += v[r + (size_t) p * lda] * v[r + (size_t) i * lda];
+
+            t[p + (size_t) i * ldt] += g;
+        }
+    }
+
+    for(int i = 0; i < k; i ++) {
+
+        ttype* column = t + (size_t) i * ldt;
+
+        for(int p = 0; p < i; p ++) {
+
+            ttype sum = 0.0;
+            for(int q = p; q < i; q ++)
+                sum += t[p + (size_t) q * ldt] * column[q];
+
+            column[p] = -tau[i] * sum;
+        }
+
+        column[i] = tau[i];
+        for(int r = i + 1; r < k; r ++)
+            column[r] = 0.0;
+    }
+}
+
+/**
+ * Applies a block reflector I - V * T * V^T, or its transpose, to a column-major block.
+ *
+ * @param m     Number of rows of V and C.
+ * @param k     Number of reflectors.
+ * @param v     The reflectors, as left by `lwt_qr_factor` (unit lower trapezoidal).
+ * @param lda   Leading dimension of `v`.
+ * @param t     The factor built by `lwt_qr_form_t`.
+ * @param ldt   Leading dimension of `t`.
+ * @param trans Nonzero to apply I - V * T^T * V^T.
+ * @param c     Column-major m x ncols block, overwritten with the product. It must not overlap V.
+ * @param ldc   Leading dimension of `c`.
+ * @param ncols Number of columns of `c`.
+ * @param work  Scratch of 2 * k * ncols elements.
+ *
+ * Note: Three GEMMs (W = V^T * C, W = op(T) * W, C -= V * W); the unit triangle at the top
+ * of V is applied by hand.
+ */
+void lwt_qr_apply_block(int m, int k, const ttype* v, int lda, const ttype* t, int ldt, int trans,
+    ttype* c, int ldc, int ncols, ttype* work) {
+
+    ttype* w = work;
+    ttype* tw = w + (size_t) k * ncols;
+
+    // W = V^T * C
+    if(m > k)
+        lwt_gemm_split_k(k, ncols, m - k, 1.0, v + k, lda, 1, c + k, 1, ldc, 0.0, w, 1, k);
+    else
+        lwt_gemm_scale(k, ncols, 0.0, w, 1, k);
+
+    for(int j = 0; j < ncols; j ++) {
+
+        const ttype* col = c + (size_t) j * ldc;
+
+        for(int p = 0; p < k; p ++) {
+
+            ttype sum = col[p];
+            for(int r = p + 1; r < k; r ++)
+                sum += v[r + (size_t) p * lda] * col[r];
+
+            w[p + (size_t) j * k] += sum;
+        }
+    }
+
+    // W = op(T) * W
+    lwt_gemm(k, ncols, k, 1.0, t, trans ? ldt : 1, trans ? 1 : ldt, w, 1, k, 0.0, tw, 1, k);
+
+    // C = C - V * W
+    if(m > k)
+        lwt_gemm(m - k, ncols, k, -1.0, v + k, 1, lda, tw, 1, k, 1.0, c + k, 1, ldc);
+
+    for(int j = 0; j < ncols; j ++) {
+
+        ttype* col = c + (size_t) j * ldc;
+        const ttype* x = tw + (size_t) j * k;
+
+        for(int r = 0; r < k; r ++) {
+
+            ttype sum = x[r];
+            for(int p = 0; p < r; p ++)
+                sum += v[r + (size_t) p * lda] * x[p];
+
+            col[r] -= sum;
+        }
+    }
+}
+
+/**
+ * Factors a column-major m x n panel (m >= n) in place by recursive halving.
+ *
+ * @param m   Number of rows.
+ * @param n   Number of columns.
+ * @param a   Pointer to the first element of the panel.
+ * @param lda Leading dimension of `a`.
+ * @param tau Output array of the n reflector scales.
+ * @param t    Scratch for the n/2 x n/2 factor of the left half.
+ * @param ldt  Leading dimension of `t`.
+ * @param work Scratch of n * n / 2 elements for `lwt_qr_apply_block`.
+ */
+void lwt_qr_panel(int m, int n, ttype* a, int lda, ttype* tau, ttype* t, int ldt, ttype* work) {
+
+    if(n <= LWT_QR_LEAF) {
+        lwt_qr_factor(m, n, a, lda, tau);
+        return;
+    }
+
+    int n1 = n / 2, n2 = n - n1;
+
+    lwt_qr_panel(m, n1, a, lda, tau, t, ldt, work);
+    lwt_qr_form_t(m, n1, a, lda, tau, t, ldt);
+    lwt_qr_apply_block(m, n1, a, lda, t, ldt, 1, a + (size_t) n1 * lda, lda, n2, work);
+    lwt_qr_panel(m - n1, n2, a + n1 + (size_t) n1 * lda, lda, tau + n1, t, ldt, work);
+}
+
+/**
+ * Factors a column-major m x n block in place as A = Q * R with blocked Householder reflections.
+ *
+ * @param m   Number of rows.
+ * @param n   Number of columns.
+ * @param a   Pointer to the first element; receives the same compact form as `lwt_qr_factor`.
+ * @param lda Leading dimension of `a`.
+ * @param tau Output array of the min(m, n) reflector scales.
+ *
+ * Note: Allocates the T factor and the block-update scratch once, LWT_QR_NB * (LWT_QR_NB + 2 * n)
+ * elements in all.
+ */
+void lwt_qr_blocked(int m, int n, ttype* a, int lda, ttype* tau) {
+
+    int k = m < n ? m : n;
+
+    size_t bytes = sizeof(ttype) * LWT_QR_NB * (LWT_QR_NB + 2 * (size_t) n);
+    ttype* t = (ttype*) lwt_malloc_aligned(bytes);
+    ttype* work = t + LWT_QR_NB * LWT_QR_NB;
+
+    for(int j = 0; j < k; j += LWT_QR_NB) {
+
+        int jb = k - j < LWT_QR_NB ? k - j : LWT_QR_NB;
+        ttype* panel = a + j + (size_t) j * lda;
+
+        lwt_qr_panel(m - j, jb, panel, lda, tau + j, t, LWT_QR_NB, work);
+
+        // A22 = (I - V * T * V^T)^T * A22
+        if(j + jb < n) {
+            lwt_qr_form_t(m - j, jb, panel, lda, tau + j, t, LWT_QR_NB);
+            lwt_qr_apply_block(m - j, jb, panel, lda, t, LWT_QR_NB, 1, panel + (size_t) jb * lda, lda, n - j - jb, work);
+        }
+    }
+
+    lwt_free_aligned(t, bytes);
+}
+
+/**
+ * Applies the orthogonal factor of a QR factorization to a column-major block.
+ *
+ * @param m     Number of rows of the reflectors and of C.
+ * @param k     Number of reflectors.
+ * @param a     The reflectors, as left by `lwt_qr_blocked` or `lwt_qr_factor`.
+ * @param lda   Leading dimension of `a`.
+ * @param tau   The reflector scales.
+ * @param trans Nonzero to apply Q^T, zero to apply Q.
+ * @param c     Column-major m x ncols block, overwritten with Q^T * C or Q * C.
+ * @param ldc   Leading dimension of `c`.
+ * @param ncols Number of columns of `c`.
+ *
+ * Note: Blocks of LWT_QR_NB reflectors are applied in compact WY form, unless C has so
+ * few columns that building T would cost more than the reflectors one at a time.
+ */
+void lwt_qr_multiply(int m, int k, const ttype* a, int lda, const ttype* tau, int trans, ttype* c, int ldc, int ncols) {
+
+    if(ncols < LWT_QR_NB / 8) {
+        lwt_qr_apply(m, k, a, lda, tau, trans, c, ldc, ncols);
+        return;
+    }
+
+    size_t bytes = sizeof(ttype) * LWT_QR_NB * (LWT_QR_NB + 2 * (size_t) ncols);
+    ttype* t = (ttype*) lwt_malloc_aligned(bytes);
+    ttype* work = t + LWT_QR_NB * LWT_QR_NB;
+    int blocks = (k + LWT_QR_NB - 1) / LWT_QR_NB;
+
+    for(int step = 0; step < blocks; step ++) {
+
+        int j = (trans ? step : blocks - 1 - step) * LWT_QR_NB;
+        int jb = k - j < LWT_QR_NB ? k - j : LWT_QR_NB;
+        const ttype* panel = a + j + (size_t) j * lda;
+
+        lwt_qr_form_t(m - j, jb, panel, lda, tau + j, t, LWT_QR_NB);
+        lwt_qr_apply_block(m - j, jb, panel, lda, t, LWT_QR_NB, trans, c + j, ldc, ncols, work);
+    }
+
+    lwt_free_aligned(t, bytes);
+}
+
+/**
+ * Factors a column-major m x n block in place as A * P = Q * R with column pivoting.
+ *
+ * @param m    Number of rows.
+ * @param n    Number of columns.
+ * @param a    Pointer to the first element; receives the same compact form as `lwt_qr_factor`.
+ * @param lda  Leading dimension of `a`.
+ * @param tau  Output array of the min(m, n) reflector scales.
+ * @param perm Output array of n column indices: column j of A * P is column perm[j] of A.
+ *
+ * Note: Each step moves the remaining column of largest norm to the front, so the diagonal
+ * of R decreases in magnitude. The norms are downdated after every reflector and recomputed
+ * when cancellation makes the downdate unreliable (as LAPACK's xGEQP3). The choice depends on
+ * the whole trailing matrix, so this path is unblocked.
+ */
+void lwt_qr_pivoted(int m, int n, ttype* a, int lda, ttype* tau, int* perm) {
+
+    int k = m < n ? m : n;
+
+    size_t bytes = sizeof(ttype) * 2 * n;
+    ttype* norms = (ttype*) lwt_malloc(bytes);
+    ttype* reference = norms + n;
+
+    ttype epsilon = sizeof(ttype) == sizeof(float) ? FLT_EPSILON : DBL_EPSILON;
+    ttype tolerance = sqrt(epsilon);
+
+    for(int j = 0; j < n; j ++) {
+        const ttype* col = a + (size_t) j * lda;
+        perm[j] = j;
+        norms[j] = reference[j] = lwt_column_norm(m, col);
+    }
+
+    for(int i = 0; i < k; i ++) {
+
+        int p = i;
+        for(int j = i + 1; j < n; j ++) {
+            if(norms[j] > norms[p])
+                p = j;
+        }
+
+        if(p != i) {
+
+            ttype* x = a + (size_t) i * lda;
+            ttype* y = a + (size_t) p * lda;
+            for(int r = 0; r < m; r ++) {
+                ttype temp = x[r];
+                x[r] = y[r];
+                y[r] = temp;
+            }
+
+            int index = perm[i];
+            perm[i] = perm[p];
+            perm[p] = index;
+
+            norms[p] = norms[i];
+            reference[p] = reference[i];
+        }
+
+        ttype* v = a + i + (size_t) i * lda;
+        tau[i] = lwt_householder(m - i, v);
+
+        for(int j = i + 1; j < n; j ++) {
+
+            ttype* col = a + i + (size_t) j * lda;
+            lwt_householder_apply(m - i, v, tau[i], col);
+
+            if(norms[j] == 0.0)
+                continue;
+
+            ttype ratio = fabs(col[0]) / norms[j];
+            ttype remaining = 1.0 - ratio * ratio;
+            remaining = remaining > 0.0 ? remaining : 0.0;
+
+            ttype relative = norms[j] / reference[j];
+            if(remaining * relative * relative <= tolerance) {
+                norms[j] = lwt_column_norm(m - i - 1, col + 1);
+                reference[j] = norms[j];
+            }
+            else
+                norms[j] *= sqrt(remaining);
+        }
+    }
+
+    lwt_free(norms, bytes);
+}
+
+/**
+ * Computes the QR factorization of a matrix, optionally with column pivoting.
+ *
+ * @param matrix Input m x n matrix (or view).
+ * @param QR     Output m x n matrix receiving R on and above the diagonal and the Householder
+ *               vectors below it (LAPACK's compact form). It may be `matrix` itself.
+ * @param tau    Output array of the min(m, n) reflector scales.
+ * @param perm   NULL to factor A = Q * R, or an output array of n column indices to factor
+ *               A * P = Q * R with column pivoting: column j of A * P is column perm[j] of A.
+ * @return       TENSOR_OK, TENSOR_ERROR_SHAPE if the shapes do not match, TENSOR_ERROR_DTYPE if `QR`
+ *               is not of the native element type, or TENSOR_ERROR_LAYOUT if `QR` does not have
+ *               unit stride along its rows.
+ *
+ * Note: Without pivoting, panels of LWT_QR_NB columns are factored recursively and the trailing
+ * matrix is updated in compact WY form, so most of the work runs in the GEMM kernel and tall,
+ * skinny inputs split their long dimension over the thread pool. Pivoting reveals the rank
+ * (|R[i][i]| is non-increasing) but runs one reflector at a time. Use `qr_multiply`,
+ * `qr_form_q` and `qr_form_r` to work with the factors.
+ */
+TensorStatus qr_decompose(Matrix matrix, Matrix* QR, ttype* tau, int* perm) {
+
+    int m = matrix.shape[0], n = matrix.rank == 2 ? matrix.shape[1] : 0;
+
+    if(matrix.rank != 2 || QR->rank != 2 || QR->shape[0] != m || QR->shape[1] != n)
+        return TENSOR_ERROR_SHAPE;
+
+    if(QR->dtype != TENSOR_NATIVE)
+        return TENSOR_ERROR_DTYPE;
+
+    if(QR->strides[0] != 1)
+        return TENSOR_ERROR_LAYOUT;
+
+    LWT_OP_ENTER("qr_decompose");
+
+    if(QR->components != matrix.components)
+        copy_into(*QR, matrix);
+
+    if(perm != NULL)
+        lwt_qr_pivoted(m, n, QR->components, QR->strides[1], tau, perm);
+    else
+        lwt_qr_blocked(m, n, QR->components, QR->strides[1], tau);
+
+    LWT_OP_LEAVE();
+    return TENSOR_OK;
+}
+
+/**
+ * Multiplies a matrix by the orthogonal factor of a QR factorization, without forming it.
+ *
+ * @param C     An m x ncols matrix (or m vector), overwritten with Q * C or Q^T * C.
+ * @param QR    The compact factorization computed by `qr_decompose`.
+ * @param tau   The reflector scales computed by `qr_decompose`.
+ * @param trans Nonzero to apply Q^T, zero to apply Q.
+ * @return      TENSOR_OK, TENSOR_ERROR_SHAPE if the shapes do not match, TENSOR_ERROR_DTYPE if `C`
+ *              or `QR` is not of the native element type, or TENSOR_ERROR_LAYOUT if `C` or `QR`
+ *              does not have unit stride along its rows.
+ */
+TensorStatus qr_multiply(Tensor C, Matrix QR, const ttype* tau, int trans) {
+
+    int m = QR.shape[0], n = QR.shape[1];
+
+    if(QR.rank != 2 || C.rank < 1 || C.rank > 2 || C.shape[0] != m)
+        return TENSOR_ERROR_SHAPE;
+
+    if(C.dtype != TENSOR_NATIVE || QR.dtype != TENSOR_NATIVE)
+        return TENSOR_ERROR_DTYPE;
+
+    if(C.strides[0] != 1 || QR.strides[0] != 1)
+        return TENSOR_ERROR_LAYOUT;
+
+    LWT_OP_ENTER("qr_multiply");
+
+    int ncols = C.rank == 2 ? C.shape[1] : 1;
+    int ldc = C.rank == 2 ? C.strides[1] : m;
+
+    lwt_qr_multiply(m, m < n ? m : n, QR.components, QR.strides[1], tau, trans, C.components, ldc, ncols);
+
+    LWT_OP_LEAVE();
+    return TENSOR_OK;
+}
+
+/**
+ * Forms the orthogonal factor of a QR factorization explicitly.
+ *
+ * @param Q   Output m x min(m, n) matrix for the economy factor (orthonormal columns),
+ *            or m x m for the full one.
+ * @param QR  The compact factorization computed by `qr_decompose`.
+ * @param tau The reflector scales computed by `qr_decompose`.
+ * @return    TENSOR_OK, TENSOR_ERROR_SHAPE if the shapes do not match, TENSOR_ERROR_DTYPE if `Q`
+ *            or `QR` is not of the native element type, or TENSOR_ERROR_LAYOUT if `Q` or `QR`
+ *            does not have unit stride along its rows.
+ *
+ * Note: Applies Q to the leading columns of the identity, in compact WY blocks.
+ */
+TensorStatus qr_form_q(Matrix Q, Matrix QR, const ttype* tau) {
+
+    int m = QR.shape[0], n = QR.shape[1];
+    int k = m < n ? m : n;
+
+    if(QR.rank != 2 || Q.rank != 2 || Q.shape[0] != m || (Q.shape[1] != k && Q.shape[1] != m))
+        return TENSOR_ERROR_SHAPE;
+
+    if(Q.dtype != TENSOR_NATIVE || QR.dtype != TENSOR_NATIVE)
+        return TENSOR_ERROR_DTYPE;
+
+    if(Q.strides[0] != 1 || QR.strides[0] != 1)
+        return TENSOR_ERROR_LAYOUT;
+
+    LWT_OP_ENTER("qr_form_q");
+
+    int cols = Q.shape[1], ldq = Q.strides[1];
+
+    for(int c = 0; c < cols; c ++) {
+        for(int r = 0; r < m; r ++)
+            Q.components[r + (size_t) c * ldq] = r == c ? 1.0 : 0.0;
+    }
+
+    lwt_qr_multiply(m, k, QR.components, QR.strides[1], tau, 0, Q.components, ldq, cols);
+
+    LWT_OP_LEAVE();
+    return TENSOR_OK;
+}
+
+/**
+ * Extracts the upper triangular factor of a QR factorization.
+ *
+ * @param R  Output min(m, n) x n matrix for the economy factor, or m x n for the full one
+ *           (or a view of either); zero below the diagonal.
+ * @param QR The compact factorization computed by `qr_decompose`.
+ * @return   TENSOR_OK, TENSOR_ERROR_SHAPE if the shapes do not match, or TENSOR_ERROR_DTYPE if
+ *           `R` or `QR` is not of the native element type.
+ */
+TensorStatus qr_form_r(Matrix R, Matrix QR) {
+
+    int m = QR.shape[0], n = QR.shape[1];
+    int k = m < n ? m : n;
+
+    if(QR.rank != 2 || R.rank != 2 || R.shape[1] != n || (R.shape[0] != k && R.shape[0] != m))
+        return TENSOR_ERROR_SHAPE;
+
+    if(R.dtype != TENSOR_NATIVE || QR.dtype != TENSOR_NATIVE)
+        return TENSOR_ERROR_DTYPE;
+
+    for(int c = 0; c < n; c ++) {
+        for(int r = 0; r < R.shape[0]; r ++)
+            *tensor_at2(R, r, c) = r <= c ? *tensor_at2(QR, r, c) : 0.0;
+    }
+
+    return TENSOR_OK;
+}
+
+/**
+ * Computes the least-squares solution of A * X = B for an m x n matrix A of full rank.
+ *
+ * @param X         Output n x nrhs matrix (or n vector).
+ * @param A         An m x n matrix (or view).
+ * @param B         Right-hand sides: an m x nrhs matrix, or an m vector.
+ * @param workspace Scratch matrix of max(m, n) x (min(m, n) + nrhs + 1) elements: the
+ *                  Householder factors, the transformed right-hand sides and the reflector scales.
+ * @return          TENSOR_OK, TENSOR_ERROR_SHAPE if the shapes do not match, TENSOR_ERROR_DTYPE for
+ *                  operands that are not of the native element type, TENSOR_ERROR_LAYOUT if
+ *                  `workspace` lacks unit stride along its rows, TENSOR_ERROR_SINGULAR if A is exactly
+ *                  rank deficient (`X` is left undefined), or TENSOR_ERROR_ILL_CONDITIONED if the
+ *                  smallest diagonal element of R is below the machine epsilon relative to the largest
+ *                  (`X` still holds the computed solution).
+ *
+ * Note: Overdetermined systems (m >= n) minimize ||A * X - B|| through A = Q * R: X = R^-1 * (Q^T * B).
+ * Underdetermined ones (m < n) get the minimum-norm solution through A^T = Q * R:
+ * X = Q * [R^-T * B; 0]. The factorization is the blocked one of `qr_decompose`; performs no
+ * allocation besides its scratch and the GEMM packing buffers.
+ */
+TensorStatus lstsq_into(Tensor X, Matrix A, Tensor B, Matrix workspace) {
+
+    int m = A.shape[0], n = A.rank == 2 ? A.shape[1] : 0;
+    int nrhs = B.rank == 2 ? B.shape[1] : 1;
+    int rows = m > n ? m : n, k = m < n ? m : n;
+
+    if(A.rank != 2 || B.rank < 1 || B.rank > 2 || X.rank != B.rank || B.shape[0] != m || X.shape[0] != n ||
+        (B.rank == 2 && X.shape[1] != nrhs) ||
+        workspace.rank != 2 || workspace.shape[0] != rows || workspace.shape[1] != k + nrhs + 1)
+        return TENSOR_ERROR_SHAPE;
+
+    if(X.dtype != TENSOR_NATIVE || A.dtype != TENSOR_NATIVE || B.dtype != TENSOR_NATIVE || workspace.dtype != TENSOR_NATIVE)
+        return TENSOR_ERROR_DTYPE;
+
+    if(workspace.strides[0] != 1)
+        return TENSOR_ERROR_LAYOUT;
+
+    LWT_OP_ENTER("lstsq");
+
+    int ldw = workspace.strides[1];
+    ttype* qr = workspace.components;
+    ttype* c = qr + (size_t) k * ldw;
+    ttype* tau = c + (size_t) nrhs * ldw;
+
+    ptrdiff_t rsb = B.strides[0], csb = B.rank == 2 ? B.strides[1] : 0;
+    ptrdiff_t rsx = X.strides[0], csx = X.rank == 2 ? X.strides[1] : 0;
+
+    if(m >= n)
+        lwt_block_copy(m, n, A.components, A.strides[0], A.strides[1], qr, ldw, 0);
+    else
+        lwt_block_copy(n, m, A.components, A.strides[1], A.strides[0], qr, ldw, 0);
+
+    lwt_qr_blocked(rows, k, qr, ldw, tau);
+
+    TensorStatus status = TENSOR_OK;
+    ttype largest = 0.0, smallest = INFINITY;
+
+    for(int i = 0; i < k; i ++) {
+        ttype value = fabs(qr[i + (size_t) i * ldw]);
+        largest = value > largest ? value : largest;
+        smallest = value < smallest ? value : smallest;
+    }
+
+    ttype epsilon = sizeof(ttype) == sizeof(float) ? FLT_EPSILON : DBL_EPSILON;
+
+    if(k > 0 && smallest == 0.0)
+        status = TENSOR_ERROR_SINGULAR;
+    else if(k > 0 && !(smallest >= epsilon * largest))
+        status = TENSOR_ERROR_ILL_CONDITIONED;
+
+    if(status != TENSOR_ERROR_SINGULAR && m >= n) {
+
+        // X = R^-1 * (Q^T * B)[0:n]
+        lwt_block_copy(m, nrhs, B.components, rsb, csb, c, ldw, 0);
+        lwt_qr_multiply(m, k, qr, ldw, tau, 1, c, ldw, nrhs);
+        lwt_trsm_upper(n, nrhs, qr, ldw, c, ldw);
+        lwt_block_copy(n, nrhs, X.components, rsx, csx, c, ldw, 1);
+    }
+    else if(status != TENSOR_ERROR_SINGULAR) {
+
+        // X = Q * [R^-T * B; 0], solving with R^T by forward substitution
+        lwt_block_copy(m, nrhs, B.components, rsb, csb, c, ldw, 0);
+
+        for(int r = 0; r < nrhs; r ++) {
+
+            ttype* z = c + (size_t) r * ldw;
+
+            for(int i = 0; i < m; i ++) {
+                const ttype* column = qr + (size_t) i * ldw;
+                z[i] = (z[i] - lwt_sum_block(i, column, 1, z, 1)) / column[i];
+            }
+
+            for(int i = m; i < n; i ++)
+                z[i] = 0.0;
+        }
+
+        lwt_qr_multiply(n, k, qr, ldw, tau, 0, c, ldw, nrhs);
+        lwt_block_copy(n, nrhs, X.components, rsx, csx, c, ldw, 1);
+    }
+
+    LWT_OP_LEAVE();
+    return status;
+}
+
+/**
+ * Computes the least-squares (or, for underdetermined systems, minimum-norm) solution of A * X = B.
+ *
+ * @param A An m x n matrix of full rank.
+ * @param B Right-hand sides: an m x nrhs matrix, or an m vector.
+ * @return  The n x nrhs solution (an n vector for a vector B).
+ *
+ * Note: Rank-deficient input is not reported; use `lstsq_into` to get a status.
+ */
+Tensor lstsq(Matrix A, Tensor B) {
+
+    int m = A.shape[0], n = A.shape[1];
+    int nrhs = B.rank == 2 ? B.shape[1] : 1;
+
+    Tensor X = B.rank == 2 ? create_matrix(n, nrhs) : create_vector(n);
+    Matrix workspace = create_matrix(m > n ? m : n, (m < n ? m : n) + nrhs + 1);
+
+    lstsq_into(X, A, B, workspace);
+    destroy_tensor(workspace);
+
+    return X;
 }
\ No newline at end of file
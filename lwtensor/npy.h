@@ -0,0 +1,677 @@
+/*
+  MIT License
+  
+  Copyright (c) 2025 Morcillo Sanz
+  
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+  
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+  
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  SOFTWARE.
+*/
+
+#pragma once
+
+#include <limits.h>
+
+#include "io.h"
+
+/*
+ * NumPy .npy and .npz files.
+ *
+ * A .npy file is a magic string, a version, a little-endian header length and an ASCII
+ * Python dict giving 'descr', 'fortran_order' and 'shape', padded so that the data
+ * that follows starts at a multiple of LWT_NPY_ALIGNMENT. A .npz file is a zip archive
+ * of .npy members. Both map onto strided tensors without any reordering: Fortran order
+ * is the native layout here, and C order just reverses the strides.
+ */
+#define LWT_NPY_MAGIC "\x93NUMPY"
+#define LWT_NPY_ALIGNMENT 64
+#define LWT_NPY_MAX_HEADER 65536
+
+/** .npy type codes of the element types, without the byte-order character (NULL if none). */
+static const char* const lwt_npy_codes[TENSOR_DTYPES] = { "f8", "f4", "f2", NULL, "i4", "i1", "u1" };
+
+/**
+ * Reads and writes little-endian integers byte by byte, whatever their alignment.
+ */
+uint16_t lwt_get_u16(const unsigned char* bytes) {
+    return (uint16_t) (bytes[0] | bytes[1] << 8);
+}
+
+uint32_t lwt_get_u32(const unsigned char* bytes) {
+    return (uint32_t) lwt_get_u16(bytes) | (uint32_t) lwt_get_u16(bytes + 2) << 16;
+}
+
+uint64_t lwt_get_u64(const unsigned char* bytes) {
+    return (uint64_t) lwt_get_u32(bytes) | (uint64_t) lwt_get_u32(bytes + 4) << 32;
+}
+
+void lwt_put_u16(unsigned char* bytes, uint32_t value) {
+    bytes[0] = (unsigned char) value;
+    bytes[1] = (unsigned char) (value >> 8);
+}
+
+void lwt_put_u32(unsigned char* bytes, uint32_t value) {
+    lwt_put_u16(bytes, value);
+    lwt_put_u16(bytes + 2, value >> 16);
+}
+
+/**
+ * Updates a CRC-32 (the zip polynomial) with a block of bytes.
+ *
+ * @param crc  The CRC of the preceding bytes (0 to start).
+ * @param data The bytes.
+ * @param size Number of bytes.
+ * @return     The CRC of the preceding bytes followed by `data`.
+ */
+uint32_t lwt_crc32(uint32_t crc, const void* data, size_t size) {
+
+    uint32_t table[256];
+    for(uint32_t i = 0; i < 256; i ++) {
+        uint32_t entry = i;
+        for(int bit = 0; bit < 8; bit ++)
+            entry = entry & 1 ? 0xEDB88320u ^ entry >> 1 : entry >> 1;
+        table[i] = entry;
+    }
+
+    const unsigned char* bytes = (const unsigned char*) data;
+    crc = ~crc;
+
+    for(size_t i = 0; i < size; i ++)
+        crc = table[(crc ^ bytes[i]) & 0xFF] ^ crc >> 8;
+
+    return ~crc;
+}
+
+/**
+ * Formats the .npy preamble (magic, version, header length and header) of a tensor.
+ *
+ * @param buffer Receives the preamble; LWT_NPY_ALIGNMENT * 8 bytes are always enough.
+ * @param tensor The tensor, written in Fortran order.
+ * @return       Length of the preamble, a multiple of LWT_NPY_ALIGNMENT.
+ */
+size_t lwt_npy_preamble(char* buffer, Tensor tensor) {
+
+    char* header = buffer + 10;
+    int length = sprintf(header, "{'descr': '%c%s', 'fortran_order': True, 'shape': (",
+        tensor_dtype_size(tensor.dtype) == 1 ? '|' : '<', lwt_npy_codes[tensor.dtype]);
+
+    for(unsigned int i = 0; i < tensor.rank; i ++)
+        length += sprintf(header + length, i + 1 < tensor.rank ? "%d, " : "%d,", tensor.shape[i]);
+
+    length += sprintf(header + length, "), }");
+
+    size_t total = (10 + length + 1 + LWT_NPY_ALIGNMENT - 1) / LWT_NPY_ALIGNMENT * LWT_NPY_ALIGNMENT;
+    memset(header + length, ' ', total - 10 - length - 1);
+    buffer[total - 1] = '\n';
+
+    memcpy(buffer, LWT_NPY_MAGIC, 6);
+    buffer[6] = 1;
+    buffer[7] = 0;
+    lwt_put_u16((unsigned char*) buffer + 8, (uint32_t) (total - 10));
+
+    return total;
+}
+
+/**
+ * Finds the value of a key in a .npy header dict.
+ *
+ * @param header The NUL-terminated header.
+ * @param key    The key, without quotes.
+ * @return       The first character of the value, or NULL if the key is missing.
+ */
+const char* lwt_npy_field(const char* header, const char* key) {
+
+    size_t length = strlen(key);
+
+    for(const char* at = strstr(header, key); at != NULL; at = strstr(at + 1, key)) {
+
+        if(at == header || (at[-1] != '\'' && at[-1] != '"') || at[length] != at[-1])
+            continue;
+
+        at += length + 1;
+        while(*at == ' ')
+            at ++;
+        if(*at != ':')
+            return NULL;
+
+        at ++;
+        while(*at == ' ')
+            at ++;
+
+        return at;
+    }
+
+    return NULL;
+}
+
+/**
+ * Parses a .npy preamble into a tensor header.
+ *
+ * @param bytes  Start of the .npy data.
+ * @param size   Number of bytes available.
+ * @param tensor Receives rank, dtype and strides; `tensor->shape` must hold LWT_MAX_RANK entries.
+ * @param offset Receives the offset of the elements from `bytes`.
+ * @return       TENSOR_OK, TENSOR_ERROR_DTYPE for an element type with no Tensor equivalent,
+ *               TENSOR_ERROR_LIMIT for a rank above LWT_MAX_RANK, or TENSOR_ERROR_IO for
+ *               malformed data.
+ *
+ * Note: A 0-d array is described as a vector of one element.
+ */
+TensorStatus lwt_npy_parse(const unsigned char* bytes, size_t size, Tensor* tensor, size_t* offset) {
+
+    if(size < 10 || memcmp(bytes, LWT_NPY_MAGIC, 6) != 0 || bytes[6] < 1 || bytes[6] > 3)
+        return TENSOR_ERROR_IO;
+
+    size_t start = bytes[6] == 1 ? 10 : 12;
+    size_t length = size < 12 ? 0 : bytes[6] == 1 ? lwt_get_u16(bytes + 8) : lwt_get_u32(bytes + 8);
+
+    if(start + length > size || length == 0 || length >= LWT_NPY_MAX_HEADER)
+        return TENSOR_ERROR_IO;
+
+    char* header = (char*) lwt_malloc(length + 1);
+    memcpy(header, bytes + start, length);
+    header[length] = 0;
+
+    TensorStatus status = TENSOR_ERROR_IO;
+    const char* descr = lwt_npy_field(header, "descr");
+    const char* order = lwt_npy_field(header, "fortran_order");
+    const char* shape = lwt_npy_field(header, "shape");
+
+    if(descr == NULL || order == NULL || shape == NULL || (*descr != '\'' && *descr != '"') || *shape != '(')
+        goto done;
+
+    /* Type: a byte order we can read as is, then one of the known codes. */
+    status = TENSOR_ERROR_DTYPE;
+    int dtype = -1;
+    for(int d = 0; d < TENSOR_DTYPES; d ++) {
+
+        const char* code = lwt_npy_codes[d];
+        size_t width = code != NULL ? strlen(code) : 0;
+
+        if(code != NULL && strncmp(descr + 2, code, width) == 0 && descr[2 + width] == descr[0])
+            dtype = d;
+    }
+
+    if(dtype < 0 || !(descr[1] == '<' || descr[1] == '|' || descr[1] == '=' || (descr[1] == '>' && tensor_dtype_size((TensorDType) dtype) == 1)))
+        goto done;
+
+    status = TENSOR_ERROR_IO;
+    int fortran = strncmp(order, "True", 4) == 0;
+    if(!fortran && strncmp(order, "False", 5) != 0)
+        goto done;
+
+    /* Shape: "()", "(n,)" or "(n, m, ...)". */
+    unsigned int rank = 0;
+    const char* at = shape + 1;
+
+    while(1) {
+
+        while(*at == ' ')
+            at ++;
+        if(*at == ')')
+            break;
+
+        char* end;
+        long long extent = strtoll(at, &end, 10);
+        if(end == at || extent < 0) {
+            status = TENSOR_ERROR_IO;
+            goto done;
+        }
+        if(rank == LWT_MAX_RANK || extent > INT_MAX) {
+            status = TENSOR_ERROR_LIMIT;
+            goto done;
+        }
+
+        tensor->shape[rank ++] = (int) extent;
+        at = end;
+
+        if(*at == 'L')
+            at ++;
+        while(*at == ' ')
+            at ++;
+        if(*at == ',')
+            at ++;
+        else if(*at != ')')
+            goto done;
+    }
+
+    if(rank == 0)
+        tensor->shape[rank ++] = 1;
+
+    tensor->rank = rank;
+    tensor->dtype = (TensorDType) dtype;
+
+    /* Fortran order is the canonical layout; C order makes the last index the fastest. */
+    ptrdiff_t stride = 1;
+    for(unsigned int i = 0; i < rank; i ++) {
+        unsigned int axis = fortran ? i : rank - 1 - i;
+        tensor->strides[axis] = stride;
+        stride *= tensor->shape[axis];
+    }
+
+    *offset = start + length;
+    size_t bytes_needed = tensor_dtype_size(tensor->dtype);
+    for(unsigned int i = 0; i < rank && bytes_needed != 0; i ++) {
+        if(tensor->shape[i] != 0 && bytes_needed > (size - *offset) / tensor->shape[i])
+            goto done;
+        bytes_needed *= tensor->shape[i];
+    }
+
+    status = bytes_needed <= size - *offset ? TENSOR_OK : TENSOR_ERROR_IO;
+
+done:
+    lwt_free(header, length + 1);
+    return status;
+}
+
+/**
+ * Describes one .npy image of a mapped file as a tensor of the container.
+ *
+ * @param file  The container.
+ * @param index Index of the tensor to fill in.
+ * @param bytes Start of the .npy data inside the mapping.
+ * @param size  Number of bytes of the .npy data.
+ * @return      TENSOR_OK, or the status of `lwt_npy_parse`.
+ *
+ * Note: The tensor points into the mapping when its elements are aligned to their size,
+ * and is otherwise a copy (with the same strides) owned by the container.
+ */
+TensorStatus lwt_npy_describe(TensorFile* file, unsigned int index, const unsigned char* bytes, size_t size) {
+
+    Tensor tensor = lwt_empty_tensor();
+    tensor.shape = file->shapes + (size_t) index * LWT_MAX_RANK;
+
+    size_t offset;
+    TensorStatus status = lwt_npy_parse(bytes, size, &tensor, &offset);
+    if(status != TENSOR_OK)
+        return status;
+
+    const unsigned char* data = bytes + offset;
+    size_t element = tensor_dtype_size(tensor.dtype);
+
+    if((uintptr_t) data % element == 0)
+        tensor.components = (ttype*) data;
+    else {
+
+        Tensor copy = create_tensor_dtype(tensor.dtype, tensor.rank, tensor.shape);
+        memcpy(copy.components, data, element * get_length(tensor));
+
+        for(unsigned int i = 0; i < tensor.rank; i ++)
+            copy.strides[i] = tensor.strides[i];
+
+        tensor = copy;
+    }
+
+    file->tensors[index] = tensor;
+    return TENSOR_OK;
+}
+
+/**
+ * Finds the end of central directory of a zip archive.
+ *
+ * @param bytes   The archive.
+ * @param size    Size of the archive in bytes.
+ * @param count   Receives the number of entries.
+ * @param central Receives the offset of the central directory.
+ * @return        1 on success, 0 if the archive is malformed.
+ */
+int lwt_zip_directory(const unsigned char* bytes, size_t size, uint64_t* count, uint64_t* central) {
+
+    if(size < 22)
+        return 0;
+
+    /* The record ends the file, followed only by a comment of up to 65535 bytes. */
+    size_t end = size - 22;
+    size_t limit = end > 65535 ? end - 65535 : 0;
+
+    while(lwt_get_u32(bytes + end) != 0x06054b50) {
+        if(end == limit)
+            return 0;
+        end --;
+    }
+
+    *count = lwt_get_u16(bytes + end + 10);
+    *central = lwt_get_u32(bytes + end + 16);
+
+    /* Zip64: the locator just before the record points to the 64-bit record. */
+    if((*count == 0xFFFF || *central == 0xFFFFFFFF) && end >= 20 && lwt_get_u32(bytes + end - 20) == 0x07064b50) {
+
+        uint64_t record = lwt_get_u64(bytes + end - 12);
+        if(size < 56 || record > size - 56 || lwt_get_u32(bytes + record) != 0x06064b50)
+            return 0;
+
+        *count = lwt_get_u64(bytes + record + 32);
+        *central = lwt_get_u64(bytes + record + 48);
+    }
+
+    return *central <= size && *count <= (size - *central) / 46;
+}
+
+/**
+ * Describes the members of a mapped .npz archive as the tensors of a container.
+ *
+ * @param file The container, mapped with no tensors yet.
+ * @return     TENSOR_OK, or TENSOR_ERROR_IO if the archive is malformed or has compressed
+ *             members, or the status of `lwt_npy_parse` for an unreadable member.
+ */
+TensorStatus lwt_npz_describe(TensorFile* file) {
+
+    const unsigned char* bytes = (const unsigned char*) file->data;
+    uint64_t count, central;
+
+    if(!lwt_zip_directory(bytes, file->size, &count, &central) || count > UINT_MAX)
+        return TENSOR_ERROR_IO;
+
+    lwt_file_alloc_index(file, (unsigned int) count);
+
+    file->strings_size = (size_t) (file->size - central);
+    file->strings = (char*) lwt_malloc(file->strings_size);
+    size_t used = 0;
+
+    uint64_t position = central;
+    for(unsigned int i = 0; i < count; i ++) {
+
+        if(position > file->size - 46 || lwt_get_u32(bytes + position) != 0x02014b50)
+            return TENSOR_ERROR_IO;
+
+        const unsigned char* record = bytes + position;
+        unsigned int method = lwt_get_u16(record + 10);
+        uint64_t packed = lwt_get_u32(record + 20);
+        uint64_t unpacked = lwt_get_u32(record + 24);
+        size_t name_length = lwt_get_u16(record + 28);
+        size_t extra_length = lwt_get_u16(record + 30);
+        uint64_t local = lwt_get_u32(record + 42);
+
+        position += 46 + name_length + extra_length + lwt_get_u16(record + 32);
+        if(position > file->size)
+            return TENSOR_ERROR_IO;
+
+        /* Zip64 extra field: 64-bit values for the fields saturated at 0xFFFFFFFF, in order. */
+        const unsigned char* extra = record + 46 + name_length;
+        for(size_t at = 0; at + 4 <= extra_length; at += 4 + lwt_get_u16(extra + at + 2)) {
+
+            if(lwt_get_u16(extra + at) != 0x0001)
+                continue;
+
+            const unsigned char* field = extra + at + 4;
+            const unsigned char* field_end = field + lwt_get_u16(extra + at + 2);
+
+            if(unpacked == 0xFFFFFFFF && field + 8 <= field_end) {
+                unpacked = lwt_get_u64(field);
+                field += 8;
+            }
+            if(packed == 0xFFFFFFFF && field + 8 <= field_end) {
+                packed = lwt_get_u64(field);
+                field += 8;
+            }
+            if(local == 0xFFFFFFFF && field + 8 <= field_end)
+                local = lwt_get_u64(field);
+        }
+
+        if(method != 0 || packed != unpacked || local > file->size - 30 || lwt_get_u32(bytes + local) != 0x04034b50)
+            return TENSOR_ERROR_IO;
+
+        uint64_t data = local + 30 + lwt_get_u16(bytes + local + 26) + lwt_get_u16(bytes + local + 28);
+        if(data > file->size || packed > file->size - data)
+            return TENSOR_ERROR_IO;
+
+        /* Members are named "<name>.npy". */
+        const char* name = (const char*) record + 46;
+        size_t length = name_length >= 4 && memcmp(name + name_length - 4, ".npy", 4) == 0 ? name_length - 4 : name_length;
+
+        memcpy(file->strings + used, name, length);
+        file->strings[used + length] = 0;
+        file->names[i] = file->strings + used;
+        used += length + 1;
+
+        TensorStatus status = lwt_npy_describe(file, i, bytes + data, (size_t) packed);
+        if(status != TENSOR_OK)
+            return status;
+    }
+
+    return TENSOR_OK;
+}
+
+/**
+ * Maps a .npy or .npz file read-only and describes its arrays.
+ *
+ * @param path Path of the file.
+ * @param file Receives the container: a single tensor named "" for a .npy file, or one
+ *             tensor per member (named without the ".npy" suffix) for a .npz file.
+ * @return     TENSOR_OK, TENSOR_ERROR_DTYPE or TENSOR_ERROR_LIMIT for an array with no
+ *             Tensor equivalent, or TENSOR_ERROR_IO if the file cannot be mapped, is
+ *             malformed, or has compressed members (`file` is then left empty).
+ *
+ * Note: Arrays are used in place when their elements are aligned (always so for .npy
+ * files and for archives written by `npz_save`) and copied otherwise. C-order arrays
+ * become views with reversed strides; call `tensor_contiguous` for the canonical layout.
+ * Release with `tensor_mmap_close`.
+ */
+TensorStatus npy_mmap_open(const char* path, TensorFile* file) {
+
+    TensorStatus status = lwt_file_map(path, file, 4);
+    if(status != TENSOR_OK)
+        return status;
+
+    LWT_OP_ENTER("npy_mmap_open");
+
+    const unsigned char* bytes = (const unsigned char*) file->data;
+
+    if(lwt_get_u32(bytes) == 0x04034b50 || lwt_get_u32(bytes) == 0x06054b50)
+        status = lwt_npz_describe(file);
+    else {
+        lwt_file_alloc_index(file, 1);
+        status = lwt_npy_describe(file, 0, bytes, file->size);
+    }
+
+    if(status != TENSOR_OK)
+        tensor_mmap_close(file);
+
+    LWT_OP_LEAVE();
+    return status;
+}
+
+/**
+ * Loads an array of a .npy or .npz file into memory.
+ *
+ * @param path   Path of the file.
+ * @param name   Name of the .npz member (without ".npy"), or NULL for the first array.
+ * @param tensor Receives a new contiguous tensor of the stored element type.
+ * @return       TENSOR_OK, TENSOR_ERROR_SHAPE if there is no array of that name, or an
+ *               error of `npy_mmap_open`.
+ */
+TensorStatus npy_load(const char* path, const char* name, Tensor* tensor) {
+
+    TensorFile file;
+    TensorStatus status = npy_mmap_open(path, &file);
+    if(status != TENSOR_OK)
+        return status;
+
+    Tensor stored = name != NULL ? tensor_mmap_get(&file, name) : file.count > 0 ? file.tensors[0] : lwt_empty_tensor();
+
+    if(stored.shape != NULL)
+        *tensor = create_copy(stored);
+    else
+        status = TENSOR_ERROR_SHAPE;
+
+    tensor_mmap_close(&file);
+    return status;
+}
+
+/**
+ * Saves a tensor as a .npy file.
+ *
+ * @param path   Path of the file, created or truncated.
+ * @param tensor The tensor (or view).
+ * @return       TENSOR_OK, TENSOR_ERROR_DTYPE for an element type .npy cannot express
+ *               (TENSOR_BF16), or TENSOR_ERROR_IO if the file cannot be written.
+ *
+ * Note: The array is written in Fortran order, the layout of a contiguous tensor, so
+ * `numpy.load` gives back an array with the same shape and element (i, j, ...) values.
+ */
+TensorStatus npy_save(const char* path, Tensor tensor) {
+
+    if(lwt_npy_codes[tensor.dtype] == NULL)
+        return TENSOR_ERROR_DTYPE;
+
+    FILE* stream = fopen(path, "wb");
+    if(stream == NULL)
+        return TENSOR_ERROR_IO;
+
+    LWT_OP_ENTER("npy_save");
+
+    char preamble[LWT_NPY_ALIGNMENT * 8];
+    size_t length = lwt_npy_preamble(preamble, tensor);
+
+    Tensor contiguous = tensor_contiguous(tensor);
+    size_t bytes = tensor_dtype_size(tensor.dtype) * get_length(tensor);
+
+    int ok = fwrite(preamble, 1, length, stream) == length;
+    ok = ok && (bytes == 0 || fwrite(contiguous.components, 1, bytes, stream) == bytes);
+    ok = fclose(stream) == 0 && ok;
+
+    destroy_tensor(contiguous);
+
+    LWT_OP_LEAVE();
+    return ok ? TENSOR_OK : TENSOR_ERROR_IO;
+}
+
+/**
+ * Saves tensors as an uncompressed .npz archive.
+ *
+ * @param path    Path of the file, created or truncated.
+ * @param count   Number of tensors, at most 65535.
+ * @param names   Name of each tensor; the members are named "<name>.npy".
+ * @param tensors The tensors (or views).
+ * @return        TENSOR_OK, TENSOR_ERROR_DTYPE as for `npy_save`, TENSOR_ERROR_LIMIT if an
+ *                array or the archive would exceed 4 GiB (the plain zip format), or
+ *                TENSOR_ERROR_IO if the file cannot be written.
+ *
+ * Note: Each member's elements start at a multiple of LWT_NPY_ALIGNMENT bytes (padding
+ * goes into the local header's extra field), so `npy_mmap_open` maps them in place.
+ */
+TensorStatus npz_save(const char* path, unsigned int count, const char* const* names, const Tensor* tensors) {
+
+    uint64_t total = 0;
+    for(unsigned int i = 0; i < count; i ++) {
+
+        if(lwt_npy_codes[tensors[i].dtype] == NULL)
+            return TENSOR_ERROR_DTYPE;
+
+        total += 2 * (30 + strlen(names[i]) + 4 + LWT_NPY_ALIGNMENT) + LWT_NPY_ALIGNMENT * 8;
+        total += tensor_dtype_size(tensors[i].dtype) * get_length(tensors[i]);
+    }
+
+    if(count > 0xFFFF || total >= 0xFFFFFFFF)
+        return TENSOR_ERROR_LIMIT;
+
+    FILE* stream = fopen(path, "wb");
+    if(stream == NULL)
+        return TENSOR_ERROR_IO;
+
+    LWT_OP_ENTER("npz_save");
+
+    uint32_t* crcs = (uint32_t*) lwt_malloc(sizeof(uint32_t) * 3 * count + 1);
+    uint32_t* sizes = crcs + count;
+    uint32_t* offsets = sizes + count;
+
+    unsigned char record[46];
+    uint32_t position = 0;
+    int ok = 1;
+
+    for(unsigned int i = 0; i < count && ok; i ++) {
+
+        char preamble[LWT_NPY_ALIGNMENT * 8];
+        size_t length = lwt_npy_preamble(preamble, tensors[i]);
+
+        Tensor contiguous = tensor_contiguous(tensors[i]);
+        size_t bytes = tensor_dtype_size(contiguous.dtype) * get_length(contiguous);
+
+        uint32_t name_length = (uint32_t) strlen(names[i]) + 4;
+        uint32_t padding = (LWT_NPY_ALIGNMENT - (position + 30 + name_length) % LWT_NPY_ALIGNMENT) % LWT_NPY_ALIGNMENT;
+        if(padding > 0 && padding < 4)
+            padding += LWT_NPY_ALIGNMENT;
+
+        crcs[i] = lwt_crc32(lwt_crc32(0, preamble, length), contiguous.components, bytes);
+        sizes[i] = (uint32_t) (length + bytes);
+        offsets[i] = position;
+
+        memset(record, 0, sizeof(record));
+        lwt_put_u32(record, 0x04034b50);
+        lwt_put_u16(record + 4, 20);
+        lwt_put_u16(record + 12, 0x21);
+        lwt_put_u32(record + 14, crcs[i]);
+        lwt_put_u32(record + 18, sizes[i]);
+        lwt_put_u32(record + 22, sizes[i]);
+        lwt_put_u16(record + 26, name_length);
+        lwt_put_u16(record + 28, padding);
+
+        /* The padding is an extra field with an unassigned id, which readers skip. */
+        unsigned char extra[LWT_NPY_ALIGNMENT + 4] = { 0 };
+        lwt_put_u16(extra, 0x4c57);
+        lwt_put_u16(extra + 2, padding >= 4 ? padding - 4 : 0);
+
+        ok = fwrite(record, 1, 30, stream) == 30;
+        ok = ok && fwrite(names[i], 1, name_length - 4, stream) == name_length - 4;
+        ok = ok && fwrite(".npy", 1, 4, stream) == 4;
+        ok = ok && fwrite(extra, 1, padding, stream) == padding;
+        ok = ok && fwrite(preamble, 1, length, stream) == length;
+        ok = ok && (bytes == 0 || fwrite(contiguous.components, 1, bytes, stream) == bytes);
+
+        position += 30 + name_length + padding + sizes[i];
+        destroy_tensor(contiguous);
+    }
+
+    uint32_t central = position;
+
+    for(unsigned int i = 0; i < count && ok; i ++) {
+
+        uint32_t name_length = (uint32_t) strlen(names[i]) + 4;
+
+        memset(record, 0, sizeof(record));
+        lwt_put_u32(record, 0x02014b50);
+        lwt_put_u16(record + 4, 20);
+        lwt_put_u16(record + 6, 20);
+        lwt_put_u16(record + 14, 0x21);
+        lwt_put_u32(record + 16, crcs[i]);
+        lwt_put_u32(record + 20, sizes[i]);
+        lwt_put_u32(record + 24, sizes[i]);
+        lwt_put_u16(record + 28, name_length);
+        lwt_put_u32(record + 42, offsets[i]);
+
+        ok = fwrite(record, 1, 46, stream) == 46;
+        ok = ok && fwrite(names[i], 1, name_length - 4, stream) == name_length - 4;
+        ok = ok && fwrite(".npy", 1, 4, stream) == 4;
+
+        position += 46 + name_length;
+    }
+
+    memset(record, 0, sizeof(record));
+    lwt_put_u32(record, 0x06054b50);
+    lwt_put_u16(record + 8, count);
+    lwt_put_u16(record + 10, count);
+    lwt_put_u32(record + 12, position - central);
+    lwt_put_u32(record + 16, central);
+
+    ok = ok && fwrite(record, 1, 22, stream) == 22;
+    ok = fclose(stream) == 0 && ok;
+
+    lwt_free(crcs, sizeof(uint32_t) * 3 * count + 1);
+
+    LWT_OP_LEAVE();
+    return ok ? TENSOR_OK : TENSOR_ERROR_IO;
+}
\ No newline at end of file
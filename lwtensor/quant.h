@@ -0,0 +1,724 @@
+/*
+  MIT License
+  
+  Copyright (c) 2025 Morcillo Sanz
+  
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+  
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+  
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  SOFTWARE.
+*/
+
+#pragma once
+
+#include "tensor.h"
+#include "reduce.h"
+#include "matrix.h"
+
+/*
+ * Register tile of the quantized GEMM: MR rows by NR columns of int32 accumulators.
+ */
+#define LWT_QGEMM_MR 4
+#define LWT_QGEMM_NR 16
+
+/*
+ * Tiles handed to a thread at a time by the quantized GEMM.
+ */
+#ifndef LWT_QGEMM_GRAIN
+#define LWT_QGEMM_GRAIN 8
+#endif
+
+/*
+ * Largest inner dimension of the quantized GEMM: the int32 accumulators hold k
+ * products of at most 255 * 128 without overflowing.
+ */
+#define LWT_QGEMM_MAX_K 65536
+
+/**
+ * A tensor of 8-bit integers with an affine mapping to real values:
+ * real = scale * (value - zero_point).
+ *
+ * `values` is a TENSOR_I8 or TENSOR_U8 tensor. With `axis` = -1 a single scale and
+ * zero point cover the whole tensor; otherwise there is one of each per index along
+ * `axis` (per channel), e.g. axis 1 for the output columns of a weight matrix.
+ */
+typedef struct {
+    Tensor values;
+    ttype* scales;
+    int32_t* zero_points;
+    int axis;
+} QuantizedTensor;
+
+/**
+ * Returns the number of scales (and zero points) of a quantized tensor.
+ */
+size_t quantized_channels(QuantizedTensor q) {
+    return q.axis < 0 ? 1 : (size_t) q.values.shape[q.axis];
+}
+
+/**
+ * Creates a quantized tensor with zero values, unit scales and zero zero points.
+ *
+ * @param dtype TENSOR_I8 or TENSOR_U8.
+ * @param rank  Number of dimensions.
+ * @param shape Extent of each dimension; the array is copied.
+ * @param axis  Channel axis of the scales, or -1 for a single scale.
+ * @return      A new quantized tensor, released with `destroy_quantized`.
+ */
+QuantizedTensor create_quantized(TensorDType dtype, unsigned int rank, const int* shape, int axis) {
+
+    QuantizedTensor q;
+    q.values = create_tensor_dtype(dtype, rank, shape);
+    q.axis = axis < (int) rank ? axis : -1;
+
+    size_t channels = quantized_channels(q);
+    q.scales = (ttype*) lwt_malloc(sizeof(ttype) * channels);
+    q.zero_points = (int32_t*) lwt_malloc(sizeof(int32_t) * channels);
+
+    for(size_t c = 0; c < channels; c ++) {
+        q.scales[c] = 1.0;
+        q.zero_points[c] = 0;
+    }
+
+    return q;
+}
+
+/**
+ * Frees the values, scales and zero points of a quantized tensor.
+ */
+void destroy_quantized(QuantizedTensor q) {
+
+    size_t channels = quantized_channels(q);
+
+    lwt_free(q.scales, sizeof(ttype) * channels);
+    lwt_free(q.zero_points, sizeof(int32_t) * channels);
+    destroy_tensor(q.values);
+}
+
+typedef struct {
+    TensorIterator it;
+    QuantizedTensor q;
+    Tensor real, channel;
+    int quantize;
+} LwtQuantJob;
+
+void lwt_quant_task(void* context, size_t begin, size_t end, int thread) {
+
+    (void) thread;
+    LwtQuantJob* job = (LwtQuantJob*) context;
+    TensorIterator it = job->it;
+
+    int is_signed = job->q.values.dtype == TENSOR_I8;
+    double low = is_signed ? INT8_MIN : 0, high = is_signed ? INT8_MAX : UINT8_MAX;
+
+    while(begin < end) {
+
+        tensor_iterator_seek(&it, begin);
+
+        size_t n = it.shape[0] - it.index[0];
+        n = n < end - begin ? n : end - begin;
+
+        char* values = (char*) job->q.values.components + it.offsets[0];
+        ttype* real = job->real.components + it.offsets[1];
+        ptrdiff_t sv = it.strides[0][0], sr = it.strides[0][1];
+        ptrdiff_t channel = it.offsets[2], step = it.strides[0][2];
+
+        for(size_t i = 0; i < n; i ++) {
+
+            ttype scale = job->q.scales[channel + (ptrdiff_t) i * step];
+            int32_t zero_point = job->q.zero_points[channel + (ptrdiff_t) i * step];
+            char* value = values + (ptrdiff_t) i * sv;
+
+            if(job->quantize) {
+
+                double q = lwt_saturate(real[i * sr] / scale, -INFINITY, INFINITY) + zero_point;
+                q = q < low ? low : q > high ? high : q;
+
+                if(is_signed)
+                    *(int8_t*) value = (int8_t) q;
+                else
+                    *(uint8_t*) value = (uint8_t) q;
+            }
+            else {
+                int32_t q = is_signed ? *(const int8_t*) value : *(const uint8_t*) value;
+                real[i * sr] = scale * (ttype) (q - zero_point);
+            }
+        }
+
+        begin += n;
+    }
+}
+
+/**
+ * Converts between the values of a quantized tensor and real values.
+ */
+TensorStatus lwt_quant_apply(QuantizedTensor q, Tensor real, int quantize) {
+
+    if(q.values.dtype != TENSOR_I8 && q.values.dtype != TENSOR_U8)
+        return TENSOR_ERROR_DTYPE;
+    if(real.dtype != TENSOR_NATIVE)
+        return TENSOR_ERROR_DTYPE;
+    if(real.rank != q.values.rank)
+        return TENSOR_ERROR_SHAPE;
+
+    for(unsigned int i = 0; i < real.rank; i ++) {
+        if(real.shape[i] != q.values.shape[i])
+            return TENSOR_ERROR_SHAPE;
+    }
+
+    LwtQuantJob job;
+    job.q = q;
+    job.real = real;
+    job.quantize = quantize;
+
+    /* Operand whose offsets are the channel of each element. */
+    job.channel = real;
+    job.channel.components = NULL;
+    for(unsigned int i = 0; i < real.rank; i ++)
+        job.channel.strides[i] = (int) i == q.axis ? 1 : 0;
+
+    Tensor operands[3] = { q.values, real, job.channel };
+
+    if(tensor_iterator_init(&job.it, 3, operands))
+        lwt_parallel_for(get_length(real), LWT_PARALLEL_GRAIN, lwt_quant_task, &job);
+
+    return TENSOR_OK;
+}
+
+/**
+ * Quantizes a tensor with the scales and zero points of a quantized tensor.
+ *
+ * @param q      Destination; its values are overwritten, its scales and zero points are used.
+ * @param tensor The tensor (or view) to quantize, of the shape of `q.values`.
+ * @return       TENSOR_OK, TENSOR_ERROR_SHAPE if the shapes differ, or TENSOR_ERROR_DTYPE.
+ *
+ * Note: value = round(real / scale) + zero_point, rounding half away from zero and
+ * saturating to the range of the integer type.
+ */
+TensorStatus quantize_into(QuantizedTensor q, Tensor tensor) {
+    return lwt_quant_apply(q, tensor, 1);
+}
+
+/**
+ * Converts a quantized tensor back to real values.
+ *
+ * @param out Output tensor (or view) of type `ttype` and of the shape of `q.values`.
+ * @param q   The quantized tensor.
+ * @return    TENSOR_OK, TENSOR_ERROR_SHAPE if the shapes differ, or TENSOR_ERROR_DTYPE.
+ */
+TensorStatus dequantize_into(Tensor out, QuantizedTensor q) {
+    return lwt_quant_apply(q, out, 0);
+}
+
+/**
+ * Quantizes a tensor, choosing the scales and zero points from its range.
+ *
+ * @param tensor The tensor (or view) to quantize.
+ * @param dtype  TENSOR_I8 for a symmetric mapping (zero point 0, scale = max|x| / 127),
+ *               as used for weights; TENSOR_U8 for an asymmetric mapping of [min, max]
+ *               (extended to include 0) onto [0, 255], as used for activations.
+ * @param axis   Axis with one scale per index, or -1 for a single scale.
+ * @return       A new quantized tensor, or one with empty values if `dtype` is not an 8-bit type.
+ */
+QuantizedTensor quantize(Tensor tensor, TensorDType dtype, int axis) {
+
+    if(dtype != TENSOR_I8 && dtype != TENSOR_U8) {
+        QuantizedTensor q = { lwt_empty_tensor(), NULL, NULL, -1 };
+        return q;
+    }
+
+    LWT_OP_ENTER("quantize");
+
+    QuantizedTensor q = create_quantized(dtype, tensor.rank, tensor.shape, axis);
+
+    int channels = (int) quantized_channels(q);
+    unsigned int mask = q.axis < 0 ? TENSOR_AXES_ALL : TENSOR_AXES_ALL & ~(1u << q.axis);
+
+    Tensor low = lwt_create_shaped(q.axis < 0 ? 0 : 1, &channels);
+    Tensor high = lwt_create_shaped(q.axis < 0 ? 0 : 1, &channels);
+    tensor_reduce_into(low, tensor, mask, TENSOR_REDUCE_MIN);
+    tensor_reduce_into(high, tensor, mask, TENSOR_REDUCE_MAX);
+
+    for(int c = 0; c < channels; c ++) {
+
+        ttype lo = low.components[c] < 0.0 ? low.components[c] : 0.0;
+        ttype hi = high.components[c] > 0.0 ? high.components[c] : 0.0;
+        ttype scale;
+
+        if(dtype == TENSOR_I8) {
+            scale = (-lo > hi ? -lo : hi) / 127;
+            q.zero_points[c] = 0;
+        }
+        else {
+            scale = (hi - lo) / 255;
+            q.zero_points[c] = scale > 0.0 ? (int32_t) lwt_saturate(-lo / scale, 0, 255) : 0;
+        }
+
+        q.scales[c] = scale > 0.0 ? scale : 1.0;
+    }
+
+    destroy_tensor(low);
+    destroy_tensor(high);
+
+    quantize_into(q, tensor);
+
+    LWT_OP_LEAVE();
+    return q;
+}
+
+/**
+ * Converts a quantized tensor to a new tensor of real values.
+ *
+ * @param q The quantized tensor.
+ * @return  A new tensor of type `ttype`.
+ */
+Tensor dequantize(QuantizedTensor q) {
+
+    LWT_OP_ENTER("dequantize");
+
+    Tensor result = lwt_create_shaped(q.values.rank, q.values.shape);
+    dequantize_into(result, q);
+
+    LWT_OP_LEAVE();
+    return result;
+}
+
+/*
+ * Int8 GEMM micro-kernels. Both operands are packed in groups of G consecutive k:
+ * A in MR-row panels laid out [k / G][MR][G], B in NR-column panels laid out
+ * [k / G][NR][G]. The VNNI kernel uses G = 4 with unsigned A bytes and signed B
+ * bytes (VPDPBUSD); the others use G = 2 with both operands widened to int16
+ * (VPMADDWD), which is exact where VPMADDUBSW would saturate its int16 pair sums.
+ */
+
+void lwt_qgemm_kernel_scalar(int steps, const int16_t* a, const int16_t* b, int32_t* tile) {
+
+    for(int i = 0; i < LWT_QGEMM_MR * LWT_QGEMM_NR; i ++)
+        tile[i] = 0;
+
+    for(int s = 0; s < steps; s ++) {
+
+        const int16_t* as = a + s * LWT_QGEMM_MR * 2;
+        const int16_t* bs = b + s * LWT_QGEMM_NR * 2;
+
+        for(int r = 0; r < LWT_QGEMM_MR; r ++) {
+            for(int c = 0; c < LWT_QGEMM_NR; c ++)
+                tile[r * LWT_QGEMM_NR + c] += as[2 * r] * bs[2 * c] + as[2 * r + 1] * bs[2 * c + 1];
+        }
+    }
+}
+
+#ifdef LWT_SIMD_X86
+
+__attribute__((target("avx2")))
+void lwt_qgemm_kernel_avx2(int steps, const int16_t* a, const int16_t* b, int32_t* tile) {
+
+    __m256i c00 = _mm256_setzero_si256(), c01 = _mm256_setzero_si256();
+    __m256i c10 = _mm256_setzero_si256(), c11 = _mm256_setzero_si256();
+    __m256i c20 = _mm256_setzero_si256(), c21 = _mm256_setzero_si256();
+    __m256i c30 = _mm256_setzero_si256(), c31 = _mm256_setzero_si256();
+
+    for(int s = 0; s < steps; s ++) {
+
+        const int16_t* as = a + s * LWT_QGEMM_MR * 2;
+        __m256i b0 = _mm256_loadu_si256((const __m256i*) (b + s * LWT_QGEMM_NR * 2));
+        __m256i b1 = _mm256_loadu_si256((const __m256i*) (b + s * LWT_QGEMM_NR * 2 + 16));
+
+        int32_t pair;
+        __m256i x;
+
+        memcpy(&pair, as, sizeof(pair));
+        x = _mm256_set1_epi32(pair);
+        c00 = _mm256_add_epi32(c00, _mm256_madd_epi16(x, b0));
+        c01 = _mm256_add_epi32(c01, _mm256_madd_epi16(x, b1));
+
+        memcpy(&pair, as + 2, sizeof(pair));
+        x = _mm256_set1_epi32(pair);
+        c10 = _mm256_add_epi32(c10, _mm256_madd_epi16(x, b0));
+        c11 = _mm256_add_epi32(c11, _mm256_madd_epi16(x, b1));
+
+        memcpy(&pair, as + 4, sizeof(pair));
+        x = _mm256_set1_epi32(pair);
+        c20 = _mm256_add_epi32(c20, _mm256_madd_epi16(x, b0));
+        c21 = _mm256_add_epi32(c21, _mm256_madd_epi16(x, b1));
+
+        memcpy(&pair, as + 6, sizeof(pair));
+        x = _mm256_set1_epi32(pair);
+        c30 = _mm256_add_epi32(c30, _mm256_madd_epi16(x, b0));
+        c31 = _mm256_add_epi32(c31, _mm256_madd_epi16(x, b1));
+    }
+
+    _mm256_storeu_si256((__m256i*) (tile + 0), c00);
+    _mm256_storeu_si256((__m256i*) (tile + 8), c01);
+    _mm256_storeu_si256((__m256i*) (tile + 16), c10);
+    _mm256_storeu_si256((__m256i*) (tile + 24), c11);
+    _mm256_storeu_si256((__m256i*) (tile + 32), c20);
+    _mm256_storeu_si256((__m256i*) (tile + 40), c21);
+    _mm256_storeu_si256((__m256i*) (tile + 48), c30);
+    _mm256_storeu_si256((__m256i*) (tile + 56), c31);
+}
+
+__attribute__((target("avx512f,avx512vnni")))
+void lwt_qgemm_kernel_vnni(int steps, const uint8_t* a, const int8_t* b, int32_t* tile) {
+
+    __m512i c0 = _mm512_setzero_si512(), c1 = _mm512_setzero_si512();
+    __m512i c2 = _mm512_setzero_si512(), c3 = _mm512_setzero_si512();
+
+    for(int s = 0; s < steps; s ++) {
+
+        const uint8_t* as = a + s * LWT_QGEMM_MR * 4;
+        __m512i bv = _mm512_loadu_si512((const void*) (b + s * LWT_QGEMM_NR * 4));
+        int32_t quad[LWT_QGEMM_MR];
+        memcpy(quad, as, sizeof(quad));
+
+        c0 = _mm512_dpbusd_epi32(c0, _mm512_set1_epi32(quad[0]), bv);
+        c1 = _mm512_dpbusd_epi32(c1, _mm512_set1_epi32(quad[1]), bv);
+        c2 = _mm512_dpbusd_epi32(c2, _mm512_set1_epi32(quad[2]), bv);
+        c3 = _mm512_dpbusd_epi32(c3, _mm512_set1_epi32(quad[3]), bv);
+    }
+
+    _mm512_storeu_si512((void*) (tile + 0), c0);
+    _mm512_storeu_si512((void*) (tile + 16), c1);
+    _mm512_storeu_si512((void*) (tile + 32), c2);
+    _mm512_storeu_si512((void*) (tile + 48), c3);
+}
+
+#endif
+
+/**
+ * Returns the micro-kernel family of the quantized GEMM.
+ *
+ * @return 2 for AVX-512 VNNI, 1 for AVX2, 0 for the scalar kernel.
+ */
+int lwt_qgemm_isa(void) {
+
+#ifdef LWT_SIMD_X86
+    int level = lwt_simd_level();
+
+    if(level >= LWT_SIMD_AVX512 && __builtin_cpu_supports("avx512vnni"))
+        return 2;
+    if(level >= LWT_SIMD_AVX2)
+        return 1;
+#endif
+
+    return 0;
+}
+
+typedef struct {
+    int m, n, k, steps, isa;
+    int row_panels;
+    const void* a_pack;
+    const void* b_pack;
+    const int32_t* row_sums;
+    const int32_t* col_sums;
+    const ttype* a_scales;
+    const int32_t* a_zeros;
+    const ttype* b_scales;
+    const int32_t* b_zeros;
+    Tensor out;
+    const ttype* out_scales;
+    const int32_t* out_zeros;
+} LwtQgemmJob;
+
+void lwt_qgemm_task(void* context, size_t begin, size_t end, int thread) {
+
+    (void) thread;
+    LwtQgemmJob* job = (LwtQgemmJob*) context;
+    int group = job->isa == 2 ? 4 : 2;
+    size_t element = job->isa == 2 ? 1 : 2;
+
+    int32_t tile[LWT_QGEMM_MR * LWT_QGEMM_NR];
+
+    for(size_t t = begin; t < end; t ++) {
+
+        /* Consecutive tiles share the B panel. */
+        int rp = (int) (t % job->row_panels), cp = (int) (t / job->row_panels);
+        size_t a_offset = (size_t) rp * job->steps * LWT_QGEMM_MR * group * element;
+        size_t b_offset = (size_t) cp * job->steps * LWT_QGEMM_NR * group * element;
+
+        const char* a = (const char*) job->a_pack + a_offset;
+        const char* b = (const char*) job->b_pack + b_offset;
+
+#ifdef LWT_SIMD_X86
+        if(job->isa == 2)
+            lwt_qgemm_kernel_vnni(job->steps, (const uint8_t*) a, (const int8_t*) b, tile);
+        else if(job->isa == 1)
+            lwt_qgemm_kernel_avx2(job->steps, (const int16_t*) a, (const int16_t*) b, tile);
+        else
+#endif
+            lwt_qgemm_kernel_scalar(job->steps, (const int16_t*) a, (const int16_t*) b, tile);
+
+        /* real = sa * sb * sum((a - za) (b - zb)), expanded around the integer product. */
+        for(int r = 0; r < LWT_QGEMM_MR; r ++) {
+
+            int i = rp * LWT_QGEMM_MR + r;
+            if(i >= job->m)
+                break;
+
+            for(int c = 0; c < LWT_QGEMM_NR; c ++) {
+
+                int j = cp * LWT_QGEMM_NR + c;
+                if(j >= job->n)
+                    break;
+
+                int64_t za = job->a_zeros[i], zb = job->b_zeros[j];
+                int64_t acc = tile[r * LWT_QGEMM_NR + c] - za * job->col_sums[j] - zb * job->row_sums[i] + za * zb * job->k;
+                double real = (double) job->a_scales[i] * job->b_scales[j] * (double) acc;
+                ptrdiff_t offset = i * job->out.strides[0] + j * job->out.strides[1];
+
+                if(job->out_scales == NULL)
+                    job->out.components[offset] = (ttype) real;
+                else {
+                    double q = lwt_saturate(real / job->out_scales[j], -INFINITY, INFINITY) + job->out_zeros[j];
+                    lwt_dtype_store(job->out.dtype, job->out.components, offset, q);
+                }
+            }
+        }
+    }
+}
+
+/**
+ * Returns the scale and zero point of every row (or column) of a quantized matrix.
+ *
+ * @param q      The quantized matrix.
+ * @param axis   0 for rows, 1 for columns.
+ * @param scales Receives `q.values.shape[axis]` scales.
+ * @param zeros  Receives `q.values.shape[axis]` zero points, shifted by `shift`.
+ * @param shift  Offset added to the zero points.
+ * @return       0 if the scales of `q` vary along the other axis, 1 otherwise.
+ */
+int lwt_qgemm_channels(QuantizedTensor q, int axis, ttype* scales, int32_t* zeros, int32_t shift) {
+
+    if(q.axis >= 0 && q.axis != axis)
+        return 0;
+
+    for(int i = 0; i < q.values.shape[axis]; i ++) {
+        scales[i] = q.scales[q.axis < 0 ? 0 : i];
+        zeros[i] = q.zero_points[q.axis < 0 ? 0 : i] + shift;
+    }
+
+    return 1;
+}
+
+/**
+ * Multiplies two quantized matrices with int32 accumulation.
+ *
+ * @param out        Output matrix of shape (lhs rows, rhs cols): TENSOR_I8/TENSOR_U8 values
+ *                   (requantized with `out_scales`) or a `ttype` matrix (dequantized).
+ * @param out_scales Scales of the output (per tensor or per column), or NULL for a `ttype` output.
+ * @param out_zeros  Zero points of the output, or NULL for a `ttype` output.
+ * @param out_axis   -1 or 1, the axis of `out_scales`.
+ * @param lhs        Left-hand side, per tensor or per row (axis 0).
+ * @param rhs        Right-hand side, per tensor or per column (axis 1).
+ */
+TensorStatus lwt_qgemm(Tensor out, const ttype* out_scales, const int32_t* out_zeros, int out_axis,
+    QuantizedTensor lhs, QuantizedTensor rhs) {
+
+    Tensor a = lhs.values, b = rhs.values;
+
+    if(a.rank != 2 || b.rank != 2 || out.rank != 2)
+        return TENSOR_ERROR_SHAPE;
+
+    int m = a.shape[0], k = a.shape[1], n = b.shape[1];
+
+    if(b.shape[0] != k || out.shape[0] != m || out.shape[1] != n)
+        return TENSOR_ERROR_SHAPE;
+    if((a.dtype != TENSOR_I8 && a.dtype != TENSOR_U8) || (b.dtype != TENSOR_I8 && b.dtype != TENSOR_U8))
+        return TENSOR_ERROR_DTYPE;
+    if(out_scales == NULL ? out.dtype != TENSOR_NATIVE : (out.dtype != TENSOR_I8 && out.dtype != TENSOR_U8))
+        return TENSOR_ERROR_DTYPE;
+    if(k > LWT_QGEMM_MAX_K)
+        return TENSOR_ERROR_LIMIT;
+    if(m == 0 || n == 0)
+        return TENSOR_OK;
+
+    LWT_OP_ENTER("qgemm");
+
+    LwtQgemmJob job;
+    job.m = m;
+    job.n = n;
+    job.k = k;
+    job.isa = lwt_qgemm_isa();
+    job.out = out;
+    job.out_scales = NULL;
+    job.out_zeros = NULL;
+
+    int group = job.isa == 2 ? 4 : 2;
+    job.steps = (k + group - 1) / group;
+    job.row_panels = (m + LWT_QGEMM_MR - 1) / LWT_QGEMM_MR;
+    int col_panels = (n + LWT_QGEMM_NR - 1) / LWT_QGEMM_NR;
+
+    /* A is fed to the kernels as unsigned bytes and B as signed ones: shift the values and zero points. */
+    int32_t a_shift = a.dtype == TENSOR_I8 ? 128 : 0;
+    int32_t b_shift = b.dtype == TENSOR_U8 ? -128 : 0;
+
+    size_t element = job.isa == 2 ? 1 : 2;
+    size_t a_bytes = (size_t) job.row_panels * LWT_QGEMM_MR * job.steps * group * element;
+    size_t b_bytes = (size_t) col_panels * LWT_QGEMM_NR * job.steps * group * element;
+    size_t sum_bytes = sizeof(int32_t) * (m + n) * 2;
+    size_t scale_bytes = sizeof(ttype) * (m + 2 * n);
+
+    char* a_pack = (char*) lwt_malloc_aligned(a_bytes);
+    char* b_pack = (char*) lwt_malloc_aligned(b_bytes);
+    int32_t* sums = (int32_t*) lwt_malloc(sum_bytes);
+    ttype* scales = (ttype*) lwt_malloc(scale_bytes);
+
+    int32_t* row_sums = sums;
+    int32_t* col_sums = sums + m;
+    int32_t* a_zeros = sums + m + n;
+    int32_t* b_zeros = sums + 2 * m + n;
+    ttype* a_scales = scales;
+    ttype* b_scales = scales + m;
+
+    int32_t* column_zeros = NULL;
+    TensorStatus status = TENSOR_OK;
+
+    if(!lwt_qgemm_channels(lhs, 0, a_scales, a_zeros, a_shift) || !lwt_qgemm_channels(rhs, 1, b_scales, b_zeros, b_shift))
+        status = TENSOR_ERROR_LAYOUT;
+
+    if(out_scales != NULL && out_axis >= 0 && out_axis != 1)
+        status = TENSOR_ERROR_LAYOUT;
+
+    if(status == TENSOR_OK && out_scales != NULL) {
+
+        ttype* column_scales = scales + m + n;
+        column_zeros = (int32_t*) lwt_malloc(sizeof(int32_t) * n);
+
+        for(int j = 0; j < n; j ++) {
+            column_scales[j] = out_scales[out_axis < 0 ? 0 : j];
+            column_zeros[j] = out_zeros[out_axis < 0 ? 0 : j];
+        }
+
+        job.out_scales = column_scales;
+        job.out_zeros = column_zeros;
+    }
+
+    if(status == TENSOR_OK) {
+
+        /* Pack A into [k / G][MR][G] panels, zero padded, and sum its rows. */
+        for(int rp = 0; rp < job.row_panels; rp ++) {
+            for(int r = 0; r < LWT_QGEMM_MR; r ++) {
+
+                int i = rp * LWT_QGEMM_MR + r;
+                int32_t sum = 0;
+
+                for(int p = 0; p < job.steps * group; p ++) {
+
+                    int32_t value = 0;
+                    if(i < m && p < k) {
+                        ptrdiff_t offset = i * a.strides[0] + p * a.strides[1];
+                        value = (a.dtype == TENSOR_I8 ? ((const int8_t*) a.components)[offset] : ((const uint8_t*) a.components)[offset]) + a_shift;
+                        sum += value;
+                    }
+
+                    size_t index = ((size_t) (rp * job.steps + p / group) * LWT_QGEMM_MR + r) * group + p % group;
+                    if(job.isa == 2)
+                        ((uint8_t*) a_pack)[index] = (uint8_t) value;
+                    else
+                        ((int16_t*) a_pack)[index] = (int16_t) value;
+                }
+
+                if(i < m)
+                    row_sums[i] = sum;
+            }
+        }
+
+        /* Pack B into [k / G][NR][G] panels, zero padded, and sum its columns. */
+        for(int cp = 0; cp < col_panels; cp ++) {
+            for(int c = 0; c < LWT_QGEMM_NR; c ++) {
+
+                int j = cp * LWT_QGEMM_NR + c;
+                int32_t sum = 0;
+
+                for(int p = 0; p < job.steps * group; p ++) {
+
+                    int32_t value = 0;
+                    if(j < n && p < k) {
+                        ptrdiff_t offset = p * b.strides[0] + j * b.strides[1];
+                        value = (b.dtype == TENSOR_I8 ? ((const int8_t*) b.components)[offset] : ((const uint8_t*) b.components)[offset]) + b_shift;
+                        sum += value;
+                    }
+
+                    size_t index = ((size_t) (cp * job.steps + p / group) * LWT_QGEMM_NR + c) * group + p % group;
+                    if(job.isa == 2)
+                        ((int8_t*) b_pack)[index] = (int8_t) value;
+                    else
+                        ((int16_t*) b_pack)[index] = (int16_t) value;
+                }
+
+                if(j < n)
+                    col_sums[j] = sum;
+            }
+        }
+
+        job.a_pack = a_pack;
+        job.b_pack = b_pack;
+        job.row_sums = row_sums;
+        job.col_sums = col_sums;
+        job.a_scales = a_scales;
+        job.a_zeros = a_zeros;
+        job.b_scales = b_scales;
+        job.b_zeros = b_zeros;
+
+        size_t tiles = (size_t) job.row_panels * col_panels;
+        if((double) m * n * k < LWT_GEMM_PARALLEL_MIN)
+            lwt_qgemm_task(&job, 0, tiles, 0);
+        else
+            lwt_parallel_for(tiles, LWT_QGEMM_GRAIN, lwt_qgemm_task, &job);
+    }
+
+    if(column_zeros != NULL)
+        lwt_free(column_zeros, sizeof(int32_t) * n);
+
+    lwt_free_aligned(a_pack, a_bytes);
+    lwt_free_aligned(b_pack, b_bytes);
+    lwt_free(sums, sum_bytes);
+    lwt_free(scales, scale_bytes);
+
+    LWT_OP_LEAVE();
+    return status;
+}
+
+/**
+ * Multiplies two quantized matrices and requantizes the product.
+ *
+ * @param out Quantized output of shape (lhs rows, rhs cols), per tensor or per column
+ *            (axis 1); its scales and zero points define the requantization.
+ * @param lhs Left-hand side (e.g. activations), TENSOR_U8 or TENSOR_I8, per tensor or per row (axis 0).
+ * @param rhs Right-hand side (e.g. weights), TENSOR_I8 or TENSOR_U8, per tensor or per column (axis 1).
+ * @return    TENSOR_OK, TENSOR_ERROR_SHAPE for mismatched shapes, TENSOR_ERROR_DTYPE for
+ *            non 8-bit values, TENSOR_ERROR_LAYOUT for scales along another axis, or
+ *            TENSOR_ERROR_LIMIT if the inner dimension exceeds LWT_QGEMM_MAX_K.
+ *
+ * Note: The int8 x int8 products are accumulated exactly in int32 (VPDPBUSD on AVX-512 VNNI,
+ * VPMADDWD on AVX2), the zero points are folded in afterwards from row and column sums,
+ * and the result is scaled in double and rounded to the output type with saturation.
+ */
+TensorStatus qmatmul_into(QuantizedTensor out, QuantizedTensor lhs, QuantizedTensor rhs) {
+    return lwt_qgemm(out.values, out.scales, out.zero_points, out.axis, lhs, rhs);
+}
+
+/**
+ * Multiplies two quantized matrices into a matrix of real values.
+ *
+ * @param out Output matrix of type `ttype` and shape (lhs rows, rhs cols).
+ * @param lhs Left-hand side, per tensor or per row (axis 0).
+ * @param rhs Right-hand side, per tensor or per column (axis 1).
+ * @return    The status codes of `qmatmul_into`.
+ */
+TensorStatus qmatmul_dequantize_into(Matrix out, QuantizedTensor lhs, QuantizedTensor rhs) {
+    return lwt_qgemm(out, NULL, NULL, -1, lhs, rhs);
+}
\ No newline at end of file
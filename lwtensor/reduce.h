@@ -0,0 +1,565 @@
+/*
+  MIT License
+  
+  Copyright (c) 2025 Morcillo Sanz
+  
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+  
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+  
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  SOFTWARE.
+*/
+
+#pragma once
+
+#include "tensor.h"
+
+/*
+ * Maximum number of partial results of a reduction split along a reduced axis.
+ * It only depends on the shape, so results do not change with the thread count.
+ */
+#ifndef LWT_REDUCE_PARTS
+#define LWT_REDUCE_PARTS 32
+#endif
+
+/*
+ * Selects every axis in an axis mask.
+ */
+#define TENSOR_AXES_ALL (~0u)
+
+/**
+ * Reduction operations of `tensor_reduce`.
+ */
+typedef enum {
+    TENSOR_REDUCE_SUM = 0,
+    TENSOR_REDUCE_MEAN,
+    TENSOR_REDUCE_PROD,
+    TENSOR_REDUCE_MAX,
+    TENSOR_REDUCE_MIN,
+    TENSOR_REDUCE_ARGMAX,
+    TENSOR_REDUCE_ARGMIN,
+    TENSOR_REDUCE_VAR
+} TensorReduceOp;
+
+/*
+ * Internal passes: TENSOR_REDUCE_VAR runs a mean pass and then accumulates the
+ * squared deviations from it.
+ */
+#define LWT_REDUCE_SQUARED_DEVIATION (TENSOR_REDUCE_VAR + 1)
+
+/**
+ * Folds a contiguous run with an associative operation.
+ *
+ * @param op       One of LWT_SIMD_ADD, LWT_SIMD_MUL, LWT_SIMD_MAX or LWT_SIMD_MIN.
+ * @param n        Number of elements.
+ * @param a        The run.
+ * @param identity Identity element of the operation.
+ * @return         The folded value.
+ */
+ttype lwt_fold_contiguous(int op, size_t n, const ttype* a, ttype identity) {
+
+    int level = lwt_simd_level();
+
+    if(level != LWT_SIMD_SCALAR && sizeof(ttype) == sizeof(double))
+        return (ttype) lwt_simd_reduce_f64[level][op](n, (const double*) a);
+    if(level != LWT_SIMD_SCALAR && sizeof(ttype) == sizeof(float))
+        return (ttype) lwt_simd_reduce_f32[level][op](n, (const float*) a);
+
+    ttype result = identity;
+    for(size_t i = 0; i < n; i ++) {
+        switch(op) {
+            case LWT_SIMD_ADD: result += a[i]; break;
+            case LWT_SIMD_MUL: result *= a[i]; break;
+            case LWT_SIMD_MAX: result = result > a[i] ? result : a[i]; break;
+            default: result = result < a[i] ? result : a[i]; break;
+        }
+    }
+
+    return result;
+}
+
+/**
+ * Combines `n` strided values into strided accumulators: acc[i] = acc[i] op x[i].
+ *
+ * @param op  One of LWT_SIMD_ADD, LWT_SIMD_MUL, LWT_SIMD_MAX or LWT_SIMD_MIN.
+ * @param n   Number of elements.
+ * @param acc Accumulators.
+ * @param sa  Stride of `acc`.
+ * @param x   Values.
+ * @param sx  Stride of `x`.
+ */
+void lwt_fold_into(int op, size_t n, ttype* acc, ptrdiff_t sa, const ttype* x, ptrdiff_t sx) {
+
+    if(sa == 1 && sx == 1 && lwt_simd_binary(op, n, acc, acc, x))
+        return;
+
+    for(size_t i = 0; i < n; i ++) {
+
+        ttype* a = acc + i * sa;
+        ttype b = x[i * sx];
+
+        switch(op) {
+            case LWT_SIMD_ADD: *a += b; break;
+            case LWT_SIMD_MUL: *a *= b; break;
+            case LWT_SIMD_MAX: *a = *a > b ? *a : b; break;
+            default: *a = *a < b ? *a : b; break;
+        }
+    }
+}
+
+/**
+ * Returns the element-wise operation an accumulating reduction folds with.
+ */
+int lwt_reduce_fold_op(int op) {
+    switch(op) {
+        case TENSOR_REDUCE_PROD: return LWT_SIMD_MUL;
+        case TENSOR_REDUCE_MAX: return LWT_SIMD_MAX;
+        case TENSOR_REDUCE_MIN: return LWT_SIMD_MIN;
+        default: return LWT_SIMD_ADD;
+    }
+}
+
+/**
+ * Returns the value the accumulators of a reduction start from.
+ */
+ttype lwt_reduce_identity(int op) {
+    switch(op) {
+        case TENSOR_REDUCE_PROD: return 1.0;
+        case TENSOR_REDUCE_MAX: case TENSOR_REDUCE_ARGMAX: return -INFINITY;
+        case TENSOR_REDUCE_MIN: case TENSOR_REDUCE_ARGMIN: return INFINITY;
+        default: return 0.0;
+    }
+}
+
+/**
+ * Accumulates a tensor into accumulators laid out as a view with zero strides on the reduced axes.
+ *
+ * @param op            The reduction (TENSOR_REDUCE_MEAN accumulates like a sum).
+ * @param input         The tensor (or slab of it) to reduce.
+ * @param acc           Accumulators, viewed with the shape of `input`.
+ * @param aux           Best values of ARGMAX/ARGMIN or the means of the deviation pass, same view as `acc`.
+ * @param compensation  Correction terms of the accumulators, same view as `acc`, or NULL components
+ *                      when the sums are not compensated.
+ * @param index         Operand whose offsets give the position of an element along the reduced axes.
+ * @param index_base    Reduced position of the first element of `input`.
+ * @param mode          Accumulation mode of the sums.
+ *
+ * Note: The tensor is walked in its own memory order whatever the reduced axes are.
+ * Runs along a reduced axis are summed pairwise (or in `mode`) with SIMD kernels, runs
+ * along a kept contiguous axis are combined element-wise with SIMD kernels.
+ */
+void lwt_reduce_accumulate(int op, Tensor input, Tensor acc, Tensor aux, Tensor compensation, Tensor index, ptrdiff_t index_base, TensorSumMode mode) {
+
+    int compensated = compensation.components != NULL;
+    if(!compensated)
+        compensation = acc;
+
+    Tensor operands[5] = { input, acc, aux, index, compensation };
+    int fold = lwt_reduce_fold_op(op);
+    ttype identity = lwt_reduce_identity(op);
+
+    TensorIterator it;
+    for(int more = tensor_iterator_init(&it, 5, operands); more; more = tensor_iterator_next(&it)) {
+
+        size_t n = it.shape[0];
+        const ttype* x = input.components + it.offsets[0];
+        ttype* a = acc.components + it.offsets[1];
+        ttype* m = aux.components + it.offsets[2];
+        ttype* c = compensation.components + it.offsets[4];
+        ptrdiff_t sx = it.strides[0][0], sa = it.strides[0][1], sm = it.strides[0][2], sc = it.strides[0][4];
+        ptrdiff_t position = index_base + it.offsets[3], step = it.strides[0][3];
+
+        if(op == TENSOR_REDUCE_ARGMAX || op == TENSOR_REDUCE_ARGMIN) {
+
+            for(size_t i = 0; i < n; i ++) {
+
+                ttype value = x[i * sx];
+                ttype* best = m + i * sm;
+
+                if(op == TENSOR_REDUCE_ARGMAX ? value > *best : value < *best) {
+                    *best = value;
+                    a[i * sa] = (ttype) (position + (ptrdiff_t) i * step);
+                }
+            }
+        }
+        else if(op == LWT_REDUCE_SQUARED_DEVIATION) {
+
+            for(size_t i = 0; i < n; i ++) {
+
+                ttype deviation = x[i * sx] - m[i * sm];
+
+                if(compensated)
+                    lwt_sum_add_compensated(a + i * sa, c + i * sc, deviation * deviation);
+                else
+                    a[i * sa] += deviation * deviation;
+            }
+        }
+        else if(sa == 0 && fold == LWT_SIMD_ADD && compensated) {
+
+            TensorSum sum = { 0.0, 0.0 };
+            lwt_sum_run(mode, n, x, sx, NULL, 0, &sum);
+
+            ttype value = (ttype) sum.value;
+            lwt_sum_add_compensated(a, c, value);
+            *c += (ttype) ((sum.value - value) + sum.compensation);
+        }
+        else if(sa == 0 && fold == LWT_SIMD_ADD)
+            *a += lwt_sum_pairwise(n, x, sx, NULL, 0);
+        else if(sa == 0 && sx == 1) {
+
+            ttype value = lwt_fold_contiguous(fold, n, x, identity);
+            lwt_fold_into(fold, 1, a, 0, &value, 0);
+        }
+        else if(sa == 0) {
+
+            ttype value = identity;
+            lwt_fold_into(fold, n, &value, 0, x, sx);
+            lwt_fold_into(fold, 1, a, 0, &value, 0);
+        }
+        else if(compensated) {
+            for(size_t i = 0; i < n; i ++)
+                lwt_sum_add_compensated(a + i * sa, c + i * sc, x[i * sx]);
+        }
+        else
+            lwt_fold_into(fold, n, a, sa, x, sx);
+    }
+}
+
+typedef struct {
+    int op;
+    unsigned int axis;
+    int extent;
+    int parts;
+    size_t part_size;
+    Tensor input, acc, aux, compensation, index;
+    ptrdiff_t aux_part_size;
+    TensorSumMode mode;
+} LwtReduceJob;
+
+/*
+ * Restricts a tensor to [begin, end) along one axis, the shape going to `shape`.
+ */
+Tensor lwt_reduce_slab(Tensor tensor, int* shape, unsigned int axis, int begin, int end) {
+
+    for(unsigned int i = 0; i < tensor.rank; i ++)
+        shape[i] = tensor.shape[i];
+    shape[axis] = end - begin;
+
+    tensor.shape = shape;
+    if(tensor.components != NULL)
+        tensor.components += begin * tensor.strides[axis];
+
+    return tensor;
+}
+
+void lwt_reduce_task(void* context, size_t begin, size_t end, int thread) {
+
+    (void) thread;
+    LwtReduceJob* job = (LwtReduceJob*) context;
+
+    for(size_t part = begin; part < end; part ++) {
+
+        int first = (int) ((long long) job->extent * part / job->parts);
+        int last = (int) ((long long) job->extent * (part + 1) / job->parts);
+
+        int shape[LWT_MAX_RANK];
+        Tensor input = lwt_reduce_slab(job->input, shape, job->axis, first, last);
+        Tensor acc = lwt_reduce_slab(job->acc, shape, job->axis, first, last);
+        Tensor aux = lwt_reduce_slab(job->aux, shape, job->axis, first, last);
+        Tensor compensation = lwt_reduce_slab(job->compensation, shape, job->axis, first, last);
+
+        acc.components += part * job->part_size;
+        aux.components += part * job->aux_part_size;
+        if(compensation.components != NULL)
+            compensation.components += part * job->part_size;
+
+        lwt_reduce_accumulate(job->op, input, acc, aux, compensation, job->index,
+            first * job->index.strides[job->axis], job->mode);
+    }
+}
+
+/**
+ * Reduces a tensor along a set of axes into a contiguous buffer.
+ *
+ * @param op     The reduction, including the internal deviation pass.
+ * @param input  The tensor to reduce.
+ * @param mask   Reduced axes (bit i selects axis i), restricted to the rank of `input`.
+ * @param result Contiguous buffer of one element per kept position, kept axes in order.
+ * @param means  Means used by the deviation pass, laid out like `result` (NULL otherwise).
+ *
+ * Note: The work is split along one axis. If the outermost axis is kept (and long enough)
+ * every thread owns distinct results; otherwise the slabs of a reduced axis go to at most
+ * LWT_REDUCE_PARTS partial buffers combined pairwise in a fixed tree, so the result is the
+ * same for any number of threads. In the compensated and wide modes the sums keep a
+ * correction term per accumulator, folded into `result` at the end.
+ */
+void lwt_reduce_buffer(int op, Tensor input, unsigned int mask, ttype* result, const ttype* means) {
+
+    size_t length = get_length(input);
+    size_t count = 1;
+
+    LwtReduceJob job;
+    job.op = op;
+    job.mode = lwt_sum_mode;
+    job.input = input;
+    job.acc = input;
+    job.index = input;
+    job.index.components = NULL;
+
+    ptrdiff_t kept = 1, reduced = 1;
+    for(unsigned int axis = 0; axis < input.rank; axis ++) {
+
+        if(mask & (1u << axis)) {
+            job.acc.strides[axis] = 0;
+            job.index.strides[axis] = reduced;
+            reduced *= input.shape[axis];
+        }
+        else {
+            job.acc.strides[axis] = kept;
+            job.index.strides[axis] = 0;
+            kept *= input.shape[axis];
+            count *= input.shape[axis];
+        }
+    }
+
+    /* Pick the split axis: the outermost one if it is kept, else the outermost reduced one. */
+    int outer = -1, outer_reduced = -1;
+    for(unsigned int axis = 0; axis < input.rank; axis ++) {
+        if(input.shape[axis] > 1) {
+            outer = axis;
+            if(mask & (1u << axis))
+                outer_reduced = axis;
+        }
+    }
+
+    size_t chunks = length / LWT_PARALLEL_GRAIN;
+    int split_kept = outer >= 0 && !(mask & (1u << outer)) && (input.shape[outer] >= LWT_REDUCE_PARTS || outer_reduced < 0);
+
+    job.axis = split_kept ? outer : (outer_reduced >= 0 ? outer_reduced : 0);
+    job.extent = input.rank > 0 ? input.shape[job.axis] : 1;
+    job.parts = 1;
+    if(chunks > 1 && job.extent > 1) {
+        size_t limit = split_kept ? (size_t) job.extent : LWT_REDUCE_PARTS;
+        limit = limit < (size_t) job.extent ? limit : (size_t) job.extent;
+        job.parts = (int) (chunks < limit ? chunks : limit);
+    }
+
+    int partials = split_kept ? 1 : job.parts;
+    int with_best = op == TENSOR_REDUCE_ARGMAX || op == TENSOR_REDUCE_ARGMIN;
+    int compensated = job.mode != TENSOR_SUM_PAIRWISE && lwt_reduce_fold_op(op) == LWT_SIMD_ADD && !with_best;
+    ttype identity = lwt_reduce_identity(op);
+
+    /* Partial accumulators (when the split axis is reduced), then the best values of ARGMAX/ARGMIN
+       or the correction terms of compensated sums. */
+    size_t scratch_count = count * ((partials > 1 ? partials : 0) + (with_best || compensated ? partials : 0));
+    ttype* scratch = scratch_count > 0 ? (ttype*) lwt_malloc_aligned(sizeof(ttype) * scratch_count) : NULL;
+
+    ttype* acc = partials > 1 ? scratch : result;
+    ttype* best = with_best ? scratch + (partials > 1 ? partials * count : 0) : NULL;
+    ttype* corrections = compensated ? scratch + (partials > 1 ? partials * count : 0) : NULL;
+
+    for(size_t i = 0; i < count * partials; i ++)
+        acc[i] = with_best ? 0.0 : identity;
+    for(size_t i = 0; best != NULL && i < count * partials; i ++)
+        best[i] = identity;
+    for(size_t i = 0; corrections != NULL && i < count * partials; i ++)
+        corrections[i] = 0.0;
+
+    job.acc.components = acc;
+    job.part_size = partials > 1 ? count : 0;
+    job.aux = job.acc;
+    job.aux.components = with_best ? best : means != NULL ? (ttype*) means : acc;
+    job.aux_part_size = with_best ? (ptrdiff_t) job.part_size : 0;
+    job.compensation = job.acc;
+    job.compensation.components = corrections;
+
+    lwt_parallel_for(job.parts, 1, lwt_reduce_task, &job);
+
+    /* Pairwise tree over the partials, always in the same order. */
+    int fold = lwt_reduce_fold_op(op == LWT_REDUCE_SQUARED_DEVIATION ? TENSOR_REDUCE_SUM : op);
+
+    for(int step = 1; step < partials; step *= 2) {
+        for(int p = 0; p + step < partials; p += 2 * step) {
+
+            ttype* target = acc + p * count;
+            const ttype* source = acc + (p + step) * count;
+
+            if(with_best) {
+
+                ttype* target_best = best + p * count;
+                const ttype* source_best = best + (p + step) * count;
+
+                for(size_t i = 0; i < count; i ++) {
+                    if(op == TENSOR_REDUCE_ARGMAX ? source_best[i] > target_best[i] : source_best[i] < target_best[i]) {
+                        target_best[i] = source_best[i];
+                        target[i] = source[i];
+                    }
+                }
+            }
+            else if(compensated) {
+
+                ttype* target_correction = corrections + p * count;
+                const ttype* source_correction = corrections + (p + step) * count;
+
+                for(size_t i = 0; i < count; i ++) {
+                    lwt_sum_add_compensated(&target[i], &target_correction[i], source[i]);
+                    target_correction[i] += source_correction[i];
+                }
+            }
+            else
+                lwt_fold_into(fold, count, target, 1, source, 1);
+        }
+    }
+
+    if(acc != result)
+        memcpy(result, acc, sizeof(ttype) * count);
+    if(compensated)
+        lwt_fold_into(LWT_SIMD_ADD, count, result, 1, corrections, 1);
+
+    if(scratch != NULL)
+        lwt_free_aligned(scratch, sizeof(ttype) * scratch_count);
+}
+
+/**
+ * Reduces a tensor along a set of axes into a preallocated tensor.
+ *
+ * @param out      Output tensor (or view); its shape is the shape of `tensor` with the reduced
+ *                 axes either set to 1 (keepdims) or removed.
+ * @param tensor   The tensor (or view) to reduce.
+ * @param axis_mask Reduced axes, bit i selecting axis i; bits at or above the rank are
+ *                 ignored, so TENSOR_AXES_ALL reduces everything.
+ * @param op       The reduction. ARGMAX/ARGMIN store the first position of the extremum,
+ *                 flattened over the reduced axes with the first one varying fastest;
+ *                 VAR is the population variance.
+ * @return         TENSOR_OK, TENSOR_ERROR_SHAPE if `out` has the wrong shape, or
+ *                 TENSOR_ERROR_DTYPE if a tensor is not of type `ttype`.
+ *
+ * Note: Allocates only scratch buffers of the size of `out`. Any axis is reduced walking
+ * `tensor` in memory order, and large tensors are split over the current thread pool with
+ * a deterministic pairwise combine. SUM, MEAN and VAR accumulate in the mode set by
+ * `lwt_set_sum_mode`.
+ */
+TensorStatus tensor_reduce_into(Tensor out, Tensor tensor, unsigned int axis_mask, TensorReduceOp op) {
+
+    if(out.dtype != TENSOR_NATIVE || tensor.dtype != TENSOR_NATIVE)
+        return TENSOR_ERROR_DTYPE;
+
+    unsigned int mask = tensor.rank < 32 ? axis_mask & ((1u << tensor.rank) - 1) : axis_mask;
+
+    unsigned int kept_rank = 0;
+    for(unsigned int axis = 0; axis < tensor.rank; axis ++)
+        kept_rank += !(mask & (1u << axis));
+
+    int keepdims = out.rank == tensor.rank;
+    if(!keepdims && out.rank != kept_rank)
+        return TENSOR_ERROR_SHAPE;
+
+    size_t count = 1, reduced = 1;
+    for(unsigned int axis = 0, o = 0; axis < tensor.rank; axis ++) {
+
+        int selected = (mask & (1u << axis)) != 0;
+        int expected = selected ? 1 : tensor.shape[axis];
+
+        if(keepdims || !selected) {
+            if(out.shape[o ++] != expected)
+                return TENSOR_ERROR_SHAPE;
+        }
+
+        if(selected)
+            reduced *= tensor.shape[axis];
+        else
+            count *= tensor.shape[axis];
+    }
+
+    LWT_OP_ENTER("reduce");
+
+    int dense = tensor_is_contiguous(out);
+    ttype* result = dense ? out.components : (ttype*) lwt_malloc_aligned(sizeof(ttype) * count);
+
+    if(op == TENSOR_REDUCE_VAR) {
+
+        ttype* means = (ttype*) lwt_malloc_aligned(sizeof(ttype) * count);
+
+        lwt_reduce_buffer(TENSOR_REDUCE_SUM, tensor, mask, means, NULL);
+        for(size_t i = 0; i < count; i ++)
+            means[i] /= reduced;
+
+        lwt_reduce_buffer(LWT_REDUCE_SQUARED_DEVIATION, tensor, mask, result, means);
+        for(size_t i = 0; i < count; i ++)
+            result[i] /= reduced;
+
+        lwt_free_aligned(means, sizeof(ttype) * count);
+    }
+    else {
+
+        lwt_reduce_buffer(op, tensor, mask, result, NULL);
+
+        if(op == TENSOR_REDUCE_MEAN) {
+            for(size_t i = 0; i < count; i ++)
+                result[i] /= reduced;
+        }
+    }
+
+    if(!dense) {
+
+        Tensor source = out;
+        source.components = result;
+        compute_strides(&source);
+        copy_into(out, source);
+
+        lwt_free_aligned(result, sizeof(ttype) * count);
+    }
+
+    LWT_OP_LEAVE();
+    return TENSOR_OK;
+}
+
+/**
+ * Reduces a tensor along a set of axes.
+ *
+ * @param tensor    The tensor (or view) to reduce.
+ * @param axis_mask Reduced axes, bit i selecting axis i (TENSOR_AXES_ALL for every axis).
+ * @param op        The reduction (see `tensor_reduce_into`).
+ * @param keepdims  Nonzero to keep the reduced axes with extent 1, zero to remove them.
+ * @return          A new tensor holding the reduction, or the empty tensor if `tensor` is not
+ *                  of the native element type.
+ *
+ * Example: the column means of a matrix are `tensor_reduce(m, 1u << 0, TENSOR_REDUCE_MEAN, 0)`.
+ */
+Tensor tensor_reduce(Tensor tensor, unsigned int axis_mask, TensorReduceOp op, int keepdims) {
+
+    LWT_OP_ENTER("reduce");
+
+    int shape[LWT_MAX_RANK];
+    unsigned int rank = 0;
+
+    for(unsigned int axis = 0; axis < tensor.rank; axis ++) {
+        if(axis < 32 && (axis_mask & (1u << axis))) {
+            if(keepdims)
+                shape[rank ++] = 1;
+        }
+        else
+            shape[rank ++] = tensor.shape[axis];
+    }
+
+    Tensor result = lwt_create_shaped(rank, shape);
+    if(tensor_reduce_into(result, tensor, axis_mask, op) != TENSOR_OK) {
+        destroy_tensor(result);
+        result = lwt_empty_tensor();
+    }
+
+    LWT_OP_LEAVE();
+    return result;
+}
\ No newline at end of file
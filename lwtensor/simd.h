@@ -0,0 +1,486 @@
+/*
+  MIT License
+  
+  Copyright (c) 2025 Morcillo Sanz
+  
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+  
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+  
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  SOFTWARE.
+*/
+
+#pragma once
+
+#include <stddef.h>
+#include <math.h>
+#include <stdatomic.h>
+
+/*
+ * Explicit SSE2 / AVX2 / AVX-512 kernels for the contiguous element-wise loops,
+ * chosen at run time from the features reported by cpuid. They are compiled with
+ * per-function target attributes, so no -m flags are needed. Define LWT_NO_SIMD
+ * to keep only the scalar loops.
+ */
+#if !defined(LWT_NO_SIMD) && (defined(__x86_64__) || defined(__i386__)) && (defined(__GNUC__) || defined(__clang__))
+#define LWT_SIMD_X86 1
+#include <immintrin.h>
+#endif
+
+/**
+ * Instruction set levels, from the scalar fallback to AVX-512.
+ */
+enum {
+    LWT_SIMD_SCALAR = 0,
+    LWT_SIMD_SSE2,
+    LWT_SIMD_AVX2,
+    LWT_SIMD_AVX512,
+    LWT_SIMD_LEVELS
+};
+
+/**
+ * Element-wise operations with a SIMD kernel.
+ */
+enum {
+    LWT_SIMD_ADD = 0,
+    LWT_SIMD_SUB,
+    LWT_SIMD_MUL,
+    LWT_SIMD_DIV,
+    LWT_SIMD_MAX,
+    LWT_SIMD_MIN,
+    LWT_SIMD_OPS
+};
+
+typedef void (*LwtBinaryF64)(size_t n, double* out, const double* a, const double* b);
+typedef void (*LwtBinaryF32)(size_t n, float* out, const float* a, const float* b);
+typedef void (*LwtScalarF64)(size_t n, double* out, const double* a, double s);
+typedef void (*LwtScalarF32)(size_t n, float* out, const float* a, float s);
+typedef double (*LwtDotF64)(size_t n, const double* a, const double* b);
+typedef float (*LwtDotF32)(size_t n, const float* a, const float* b);
+typedef double (*LwtReduceF64)(size_t n, const double* a);
+typedef float (*LwtReduceF32)(size_t n, const float* a);
+typedef void (*LwtAxpy4F64)(size_t n, double* y, const double* a, ptrdiff_t lda, const double* s);
+typedef void (*LwtAxpy4F32)(size_t n, float* y, const float* a, ptrdiff_t lda, const float* s);
+typedef void (*LwtDot4F64)(size_t n, const double* a, ptrdiff_t lda, const double* x, double* out);
+typedef void (*LwtDot4F32)(size_t n, const float* a, ptrdiff_t lda, const float* x, float* out);
+typedef void (*LwtDotsF64)(size_t n, int d, const double* a, ptrdiff_t lda, const double* b, ptrdiff_t ldb, int root, double* out);
+typedef void (*LwtDotsF32)(size_t n, int d, const float* a, ptrdiff_t lda, const float* b, ptrdiff_t ldb, int root, float* out);
+typedef void (*LwtCrossF64)(size_t n, const double* a, ptrdiff_t lda, const double* b, ptrdiff_t ldb, double* out, ptrdiff_t ldo);
+typedef void (*LwtCrossF32)(size_t n, const float* a, ptrdiff_t lda, const float* b, ptrdiff_t ldb, float* out, ptrdiff_t ldo);
+typedef void (*LwtTileF64)(int kc, const double* a, const double* b, double* ab);
+typedef void (*LwtTileF32)(int kc, const float* a, const float* b, float* ab);
+
+/*
+ * Columns of the GEMM register tile computed by the tile kernels. Its rows fill 64 bytes
+ * (8 doubles or 16 floats): one AVX-512 register, two AVX2 or four SSE2 registers.
+ */
+#define LWT_SIMD_TILE_COLS 12
+
+/*
+ * Level in use, -1 until the first dispatch. Pool workers dispatch concurrently, so it
+ * is atomic; every thread detects the same level, so relaxed ordering is enough.
+ */
+atomic_int lwt_simd_current_level = -1;
+
+#ifdef LWT_SIMD_X86
+
+#define LWT_SIMD_ADD_OP(x, y) ((x) + (y))
+#define LWT_SIMD_SUB_OP(x, y) ((x) - (y))
+#define LWT_SIMD_MUL_OP(x, y) ((x) * (y))
+#define LWT_SIMD_DIV_OP(x, y) ((x) / (y))
+#define LWT_SIMD_MAX_OP(x, y) ((x) > (y) ? (x) : (y))
+#define LWT_SIMD_MIN_OP(x, y) ((x) < (y) ? (x) : (y))
+
+/*
+ * out[i] = a[i] op b[i], two vectors per iteration, scalar tail.
+ */
+#define LWT_SIMD_DEFINE_BINARY(name, isa, T, V, W, load, store, vop, sop)       \
+__attribute__((target(isa)))                                                      \
+void name(size_t n, T* out, const T* a, const T* b) {                             \
+    size_t i = 0;                                                                 \
+    for(; i + 2 * W <= n; i += 2 * W) {                                           \
+        V x0 = load(a + i), x1 = load(a + i + W);                                 \
+        V y0 = load(b + i), y1 = load(b + i + W);                                 \
+        store(out + i, vop(x0, y0));                                              \
+        store(out + i + W, vop(x1, y1));                                          \
+    }                                                                             \
+    for(; i + W <= n; i += W)                                                     \
+        store(out + i, vop(load(a + i), load(b + i)));                            \
+    for(; i < n; i ++)                                                            \
+        out[i] = sop(a[i], b[i]);                                                 \
+}
+
+/*
+ * out[i] = a[i] op s, two vectors per iteration, scalar tail.
+ */
+#define LWT_SIMD_DEFINE_SCALAR(name, isa, T, V, W, load, store, set1, vop, sop)  \
+__attribute__((target(isa)))                                                      \
+void name(size_t n, T* out, const T* a, T s) {                                    \
+    V vs = set1(s);                                                               \
+    size_t i = 0;                                                                 \
+    for(; i + 2 * W <= n; i += 2 * W) {                                           \
+        V x0 = load(a + i), x1 = load(a + i + W);                                 \
+        store(out + i, vop(x0, vs));                                              \
+        store(out + i + W, vop(x1, vs));                                          \
+    }                                                                             \
+    for(; i + W <= n; i += W)                                                     \
+        store(out + i, vop(load(a + i), vs));                                     \
+    for(; i < n; i ++)                                                            \
+        out[i] = sop(a[i], s);                                                    \
+}
+
+/*
+ * sum(a[i] * b[i]) with four independent accumulators to hide the add latency.
+ */
+#define LWT_SIMD_DEFINE_DOT(name, isa, T, V, W, load, store, zero, madd)         \
+__attribute__((target(isa)))                                                      \
+T name(size_t n, const T* a, const T* b) {                                        \
+    V s0 = zero(), s1 = zero(), s2 = zero(), s3 = zero();                         \
+    size_t i = 0;                                                                 \
+    for(; i + 4 * W <= n; i += 4 * W) {                                           \
+        s0 = madd(load(a + i), load(b + i), s0);                                  \
+        s1 = madd(load(a + i + W), load(b + i + W), s1);                          \
+        s2 = madd(load(a + i + 2 * W), load(b + i + 2 * W), s2);                  \
+        s3 = madd(load(a + i + 3 * W), load(b + i + 3 * W), s3);                  \
+    }                                                                             \
+    for(; i + W <= n; i += W)                                                     \
+        s0 = madd(load(a + i), load(b + i), s0);                                  \
+    T lanes[W];                                                                   \
+    store(lanes, s0 + s1 + (s2 + s3));                                            \
+    T result = 0;                                                                 \
+    for(int k = 0; k < W; k ++)                                                   \
+        result += lanes[k];                                                       \
+    for(; i < n; i ++)                                                            \
+        result += a[i] * b[i];                                                    \
+    return result;                                                                \
+}
+
+/*
+ * Folds a[0..n) with an associative operation, four vector accumulators wide.
+ * The lanes are combined in a fixed order, so the result only depends on n.
+ */
+#define LWT_SIMD_DEFINE_REDUCE(name, isa, T, V, W, load, store, set1, vop, sop, identity) \
+__attribute__((target(isa)))                                                      \
+T name(size_t n, const T* a) {                                                    \
+    V s0 = set1(identity), s1 = s0, s2 = s0, s3 = s0;                             \
+    size_t i = 0;                                                                 \
+    for(; i + 4 * W <= n; i += 4 * W) {                                           \
+        s0 = vop(s0, load(a + i));                                                \
+        s1 = vop(s1, load(a + i + W));                                            \
+        s2 = vop(s2, load(a + i + 2 * W));                                        \
+        s3 = vop(s3, load(a + i + 3 * W));                                        \
+    }                                                                             \
+    for(; i + W <= n; i += W)                                                     \
+        s0 = vop(s0, load(a + i));                                                \
+    T lanes[W];                                                                   \
+    store(lanes, vop(vop(s0, s1), vop(s2, s3)));                                  \
+    T result = identity;                                                          \
+    for(int k = 0; k < W; k ++)                                                   \
+        result = sop(result, lanes[k]);                                           \
+    for(; i < n; i ++)                                                            \
+        result = sop(result, a[i]);                                               \
+    return result;                                                                \
+}
+
+/*
+ * y[i] += s[0] * a[i] + s[1] * a[lda + i] + s[2] * a[2 * lda + i] + s[3] * a[3 * lda + i]:
+ * four unit-stride columns scaled and added to y, which is read and written once.
+ */
+#define LWT_SIMD_DEFINE_AXPY4(name, isa, T, V, W, load, store, set1, madd)       \
+__attribute__((target(isa)))                                                      \
+void name(size_t n, T* y, const T* a, ptrdiff_t lda, const T* s) {                \
+    const T* a1 = a + lda;                                                        \
+    const T* a2 = a1 + lda;                                                       \
+    const T* a3 = a2 + lda;                                                       \
+    V s0 = set1(s[0]), s1 = set1(s[1]), s2 = set1(s[2]), s3 = set1(s[3]);         \
+    size_t i = 0;                                                                 \
+    for(; i + W <= n; i += W) {                                                   \
+        V acc = madd(load(a + i), s0, load(y + i));                               \
+        acc = madd(load(a1 + i), s1, acc);                                        \
+        acc = madd(load(a2 + i), s2, acc);                                        \
+        store(y + i, madd(load(a3 + i), s3, acc));                                \
+    }                                                                             \
+    for(; i < n; i ++)                                                            \
+        y[i] = y[i] + a[i] * s[0] + a1[i] * s[1] + a2[i] * s[2] + a3[i] * s[3];   \
+}
+
+/*
+ * out[r] = sum(a[r * lda + i] * x[i]) for four unit-stride rows, each x vector loaded once.
+ */
+#define LWT_SIMD_DEFINE_DOT4(name, isa, T, V, W, load, store, zero, madd)        \
+__attribute__((target(isa)))                                                      \
+void name(size_t n, const T* a, ptrdiff_t lda, const T* x, T* out) {              \
+    const T* rows[4] = { a, a + lda, a + 2 * lda, a + 3 * lda };                  \
+    V s0 = zero(), s1 = zero(), s2 = zero(), s3 = zero();                         \
+    size_t i = 0;                                                                 \
+    for(; i + W <= n; i += W) {                                                   \
+        V xi = load(x + i);                                                       \
+        s0 = madd(load(rows[0] + i), xi, s0);                                     \
+        s1 = madd(load(rows[1] + i), xi, s1);                                     \
+        s2 = madd(load(rows[2] + i), xi, s2);                                     \
+        s3 = madd(load(rows[3] + i), xi, s3);                                     \
+    }                                                                             \
+    T lanes[4][W];                                                                \
+    store(lanes[0], s0);                                                          \
+    store(lanes[1], s1);                                                          \
+    store(lanes[2], s2);                                                          \
+    store(lanes[3], s3);                                                          \
+    for(int r = 0; r < 4; r ++) {                                                 \
+        T result = 0;                                                             \
+        for(int k = 0; k < W; k ++)                                               \
+            result += lanes[r][k];                                                \
+        for(size_t j = i; j < n; j ++)                                            \
+            result += rows[r][j] * x[j];                                          \
+        out[r] = result;                                                          \
+    }                                                                             \
+}
+
+/*
+ * out[i] = sum(a[c * lda + i] * b[c * ldb + i]) over c < d, square-rooted when `root` is set:
+ * the dot products (or norms) of n d-vectors stored component row by component row.
+ */
+#define LWT_SIMD_DEFINE_DOTS(name, isa, T, V, W, load, store, zero, madd, vsqrt) \
+__attribute__((target(isa)))                                                      \
+void name(size_t n, int d, const T* a, ptrdiff_t lda, const T* b, ptrdiff_t ldb, int root, T* out) { \
+    size_t i = 0;                                                                 \
+    for(; i + W <= n; i += W) {                                                   \
+        V acc = zero();                                                           \
+        for(int c = 0; c < d; c ++)                                               \
+            acc = madd(load(a + c * lda + i), load(b + c * ldb + i), acc);        \
+        store(out + i, root ? vsqrt(acc) : acc);                                  \
+    }                                                                             \
+    for(; i < n; i ++) {                                                          \
+        T acc = 0;                                                                \
+        for(int c = 0; c < d; c ++)                                               \
+            acc += a[c * lda + i] * b[c * ldb + i];                               \
+        out[i] = root ? (T) sqrt(acc) : acc;                                      \
+    }                                                                             \
+}
+
+/*
+ * Cross products of n 3-vectors stored component row by component row. Every
+ * component of a vector is loaded before its result is stored, so out may be a or b.
+ */
+#define LWT_SIMD_DEFINE_CROSS(name, isa, T, V, W, load, store, vmul, vsub)       \
+__attribute__((target(isa)))                                                      \
+void name(size_t n, const T* a, ptrdiff_t lda, const T* b, ptrdiff_t ldb, T* out, ptrdiff_t ldo) { \
+    size_t i = 0;                                                                 \
+    for(; i + W <= n; i += W) {                                                   \
+        V ax = load(a + i), ay = load(a + lda + i), az = load(a + 2 * lda + i);   \
+        V bx = load(b + i), by = load(b + ldb + i), bz = load(b + 2 * ldb + i);   \
+        store(out + i, vsub(vmul(ay, bz), vmul(az, by)));                         \
+        store(out + ldo + i, vsub(vmul(az, bx), vmul(ax, bz)));                   \
+        store(out + 2 * ldo + i, vsub(vmul(ax, by), vmul(ay, bx)));               \
+    }                                                                             \
+    for(; i < n; i ++) {                                                          \
+        T ax = a[i], ay = a[lda + i], az = a[2 * lda + i];                        \
+        T bx = b[i], by = b[ldb + i], bz = b[2 * ldb + i];                        \
+        out[i] = ay * bz - az * by;                                               \
+        out[ldo + i] = az * bx - ax * bz;                                         \
+        out[2 * ldo + i] = ax * by - ay * bx;                                     \
+    }                                                                             \
+}
+
+/*
+ * GEMM register tile: ab = A * B from a packed A micro-panel (kc groups of 64 bytes) and
+ * a packed B micro-panel (kc groups of LWT_SIMD_TILE_COLS), stored column by column. The
+ * columns are swept in passes of COLS, each keeping its VECS x COLS accumulators in
+ * registers and broadcasting one element of B per column.
+ */
+#define LWT_SIMD_DEFINE_TILE(name, isa, T, V, W, load, store, set1, zero, madd, COLS)  \
+__attribute__((target(isa)))                                                      \
+void name(int kc, const T* restrict a, const T* restrict b, T* restrict ab) {      \
+    enum { ROWS = 64 / sizeof(T), VECS = ROWS / W };                              \
+    for(int j0 = 0; j0 < LWT_SIMD_TILE_COLS; j0 += COLS) {                        \
+        V acc[VECS * COLS];                                                       \
+        _Pragma("GCC unroll 16")                                                  \
+        for(int i = 0; i < VECS * COLS; i ++)                                     \
+            acc[i] = zero();                                                      \
+        const T* ap = a;                                                          \
+        const T* bp = b + j0;                                                     \
+        for(int p = 0; p < kc; p ++) {                                            \
+            V x[VECS];                                                            \
+            _Pragma("GCC unroll 4")                                               \
+            for(int v = 0; v < VECS; v ++)                                        \
+                x[v] = load(ap + v * W);                                          \
+            _Pragma("GCC unroll 12")                                              \
+            for(int c = 0; c < COLS; c ++) {                                      \
+                V y = set1(bp[c]);                                                \
+                _Pragma("GCC unroll 4")                                           \
+                for(int v = 0; v < VECS; v ++)                                    \
+                    acc[c * VECS + v] = madd(x[v], y, acc[c * VECS + v]);         \
+            }                                                                     \
+            ap += ROWS;                                                           \
+            bp += LWT_SIMD_TILE_COLS;                                             \
+        }                                                                         \
+        _Pragma("GCC unroll 12")                                                  \
+        for(int c = 0; c < COLS; c ++) {                                          \
+            _Pragma("GCC unroll 4")                                               \
+            for(int v = 0; v < VECS; v ++)                                        \
+                store(ab + (j0 + c) * ROWS + v * W, acc[c * VECS + v]);           \
+        }                                                                         \
+    }                                                                             \
+}
+
+#define LWT_SSE2_MADD_PD(x, y, acc) _mm_add_pd(_mm_mul_pd(x, y), acc)
+#define LWT_SSE2_MADD_PS(x, y, acc) _mm_add_ps(_mm_mul_ps(x, y), acc)
+
+/*
+ * Binary and tensor-scalar kernels of one operation, in double and float.
+ */
+#define LWT_SIMD_DEFINE_OP(op, suffix, isa, VD, VF, WD, WF, PD, PS, sop)                                                      \
+LWT_SIMD_DEFINE_BINARY(lwt_simd_##op##_f64_##suffix, isa, double, VD, WD, PD##loadu_pd, PD##storeu_pd, PD##op##_pd, sop)           \
+LWT_SIMD_DEFINE_BINARY(lwt_simd_##op##_f32_##suffix, isa, float, VF, WF, PS##loadu_ps, PS##storeu_ps, PS##op##_ps, sop)            \
+LWT_SIMD_DEFINE_SCALAR(lwt_simd_##op##s_f64_##suffix, isa, double, VD, WD, PD##loadu_pd, PD##storeu_pd, PD##set1_pd, PD##op##_pd, sop) \
+LWT_SIMD_DEFINE_SCALAR(lwt_simd_##op##s_f32_##suffix, isa, float, VF, WF, PS##loadu_ps, PS##storeu_ps, PS##set1_ps, PS##op##_ps, sop)
+
+/*
+ * Reductions of one associative operation, in double and float.
+ */
+#define LWT_SIMD_DEFINE_FOLD(op, suffix, isa, VD, VF, WD, WF, PD, PS, sop, identity)                                         \
+LWT_SIMD_DEFINE_REDUCE(lwt_simd_fold_##op##_f64_##suffix, isa, double, VD, WD, PD##loadu_pd, PD##storeu_pd, PD##set1_pd, PD##op##_pd, sop, identity) \
+LWT_SIMD_DEFINE_REDUCE(lwt_simd_fold_##op##_f32_##suffix, isa, float, VF, WF, PS##loadu_ps, PS##storeu_ps, PS##set1_ps, PS##op##_ps, sop, identity)
+
+#define LWT_SIMD_DEFINE_ISA(suffix, isa, VD, VF, WD, WF, PD, PS, madd_pd, madd_ps, cols)                     \
+LWT_SIMD_DEFINE_OP(add, suffix, isa, VD, VF, WD, WF, PD, PS, LWT_SIMD_ADD_OP)                                  \
+LWT_SIMD_DEFINE_OP(sub, suffix, isa, VD, VF, WD, WF, PD, PS, LWT_SIMD_SUB_OP)                                  \
+LWT_SIMD_DEFINE_OP(mul, suffix, isa, VD, VF, WD, WF, PD, PS, LWT_SIMD_MUL_OP)                                  \
+LWT_SIMD_DEFINE_OP(div, suffix, isa, VD, VF, WD, WF, PD, PS, LWT_SIMD_DIV_OP)                                  \
+LWT_SIMD_DEFINE_OP(max, suffix, isa, VD, VF, WD, WF, PD, PS, LWT_SIMD_MAX_OP)                                  \
+LWT_SIMD_DEFINE_OP(min, suffix, isa, VD, VF, WD, WF, PD, PS, LWT_SIMD_MIN_OP)                                  \
+LWT_SIMD_DEFINE_FOLD(add, suffix, isa, VD, VF, WD, WF, PD, PS, LWT_SIMD_ADD_OP, 0.0)                           \
+LWT_SIMD_DEFINE_FOLD(mul, suffix, isa, VD, VF, WD, WF, PD, PS, LWT_SIMD_MUL_OP, 1.0)                           \
+LWT_SIMD_DEFINE_FOLD(max, suffix, isa, VD, VF, WD, WF, PD, PS, LWT_SIMD_MAX_OP, -INFINITY)                     \
+LWT_SIMD_DEFINE_FOLD(min, suffix, isa, VD, VF, WD, WF, PD, PS, LWT_SIMD_MIN_OP, INFINITY)                      \
+LWT_SIMD_DEFINE_DOT(lwt_simd_dot_f64_##suffix, isa, double, VD, WD, PD##loadu_pd, PD##storeu_pd, PD##setzero_pd, madd_pd) \
+LWT_SIMD_DEFINE_DOT(lwt_simd_dot_f32_##suffix, isa, float, VF, WF, PS##loadu_ps, PS##storeu_ps, PS##setzero_ps, madd_ps) \
+LWT_SIMD_DEFINE_AXPY4(lwt_simd_axpy4_f64_##suffix, isa, double, VD, WD, PD##loadu_pd, PD##storeu_pd, PD##set1_pd, madd_pd) \
+LWT_SIMD_DEFINE_AXPY4(lwt_simd_axpy4_f32_##suffix, isa, float, VF, WF, PS##loadu_ps, PS##storeu_ps, PS##set1_ps, madd_ps) \
+LWT_SIMD_DEFINE_DOT4(lwt_simd_dot4_f64_##suffix, isa, double, VD, WD, PD##loadu_pd, PD##storeu_pd, PD##setzero_pd, madd_pd) \
+LWT_SIMD_DEFINE_DOT4(lwt_simd_dot4_f32_##suffix, isa, float, VF, WF, PS##loadu_ps, PS##storeu_ps, PS##setzero_ps, madd_ps) \
+LWT_SIMD_DEFINE_DOTS(lwt_simd_dots_f64_##suffix, isa, double, VD, WD, PD##loadu_pd, PD##storeu_pd, PD##setzero_pd, madd_pd, PD##sqrt_pd) \
+LWT_SIMD_DEFINE_DOTS(lwt_simd_dots_f32_##suffix, isa, float, VF, WF, PS##loadu_ps, PS##storeu_ps, PS##setzero_ps, madd_ps, PS##sqrt_ps) \
+LWT_SIMD_DEFINE_CROSS(lwt_simd_cross_f64_##suffix, isa, double, VD, WD, PD##loadu_pd, PD##storeu_pd, PD##mul_pd, PD##sub_pd) \
+LWT_SIMD_DEFINE_CROSS(lwt_simd_cross_f32_##suffix, isa, float, VF, WF, PS##loadu_ps, PS##storeu_ps, PS##mul_ps, PS##sub_ps) \
+LWT_SIMD_DEFINE_TILE(lwt_simd_tile_f64_##suffix, isa, double, VD, WD, PD##loadu_pd, PD##storeu_pd, PD##set1_pd, PD##setzero_pd, madd_pd, cols) \
+LWT_SIMD_DEFINE_TILE(lwt_simd_tile_f32_##suffix, isa, float, VF, WF, PS##loadu_ps, PS##storeu_ps, PS##set1_ps, PS##setzero_ps, madd_ps, cols)
+
+LWT_SIMD_DEFINE_ISA(sse2, "sse2", __m128d, __m128, 2, 4, _mm_, _mm_, LWT_SSE2_MADD_PD, LWT_SSE2_MADD_PS, 3)
+LWT_SIMD_DEFINE_ISA(avx2, "avx2,fma", __m256d, __m256, 4, 8, _mm256_, _mm256_, _mm256_fmadd_pd, _mm256_fmadd_ps, 6)
+LWT_SIMD_DEFINE_ISA(avx512, "avx512f", __m512d, __m512, 8, 16, _mm512_, _mm512_, _mm512_fmadd_pd, _mm512_fmadd_ps, 12)
+
+#define LWT_SIMD_ROW(prefix, suffix, type, isa) { prefix##add##suffix##_##type##_##isa, prefix##sub##suffix##_##type##_##isa, \
+    prefix##mul##suffix##_##type##_##isa, prefix##div##suffix##_##type##_##isa, prefix##max##suffix##_##type##_##isa, prefix##min##suffix##_##type##_##isa }
+
+#define LWT_SIMD_FOLD_ROW(type, isa) { lwt_simd_fold_add_##type##_##isa, NULL, lwt_simd_fold_mul_##type##_##isa, NULL, \
+    lwt_simd_fold_max_##type##_##isa, lwt_simd_fold_min_##type##_##isa }
+
+#define LWT_SIMD_TABLE(prefix, suffix, type) \
+    { NULL }, LWT_SIMD_ROW(prefix, suffix, type, sse2), LWT_SIMD_ROW(prefix, suffix, type, avx2), LWT_SIMD_ROW(prefix, suffix, type, avx512)
+
+LwtBinaryF64 lwt_simd_binary_f64[LWT_SIMD_LEVELS][LWT_SIMD_OPS] = { LWT_SIMD_TABLE(lwt_simd_, , f64) };
+LwtBinaryF32 lwt_simd_binary_f32[LWT_SIMD_LEVELS][LWT_SIMD_OPS] = { LWT_SIMD_TABLE(lwt_simd_, , f32) };
+LwtScalarF64 lwt_simd_scalar_f64[LWT_SIMD_LEVELS][LWT_SIMD_OPS] = { LWT_SIMD_TABLE(lwt_simd_, s, f64) };
+LwtScalarF32 lwt_simd_scalar_f32[LWT_SIMD_LEVELS][LWT_SIMD_OPS] = { LWT_SIMD_TABLE(lwt_simd_, s, f32) };
+LwtReduceF64 lwt_simd_reduce_f64[LWT_SIMD_LEVELS][LWT_SIMD_OPS] = {
+    { NULL }, LWT_SIMD_FOLD_ROW(f64, sse2), LWT_SIMD_FOLD_ROW(f64, avx2), LWT_SIMD_FOLD_ROW(f64, avx512) };
+LwtReduceF32 lwt_simd_reduce_f32[LWT_SIMD_LEVELS][LWT_SIMD_OPS] = {
+    { NULL }, LWT_SIMD_FOLD_ROW(f32, sse2), LWT_SIMD_FOLD_ROW(f32, avx2), LWT_SIMD_FOLD_ROW(f32, avx512) };
+LwtDotF64 lwt_simd_dot_f64[LWT_SIMD_LEVELS] = { NULL, lwt_simd_dot_f64_sse2, lwt_simd_dot_f64_avx2, lwt_simd_dot_f64_avx512 };
+LwtDotF32 lwt_simd_dot_f32[LWT_SIMD_LEVELS] = { NULL, lwt_simd_dot_f32_sse2, lwt_simd_dot_f32_avx2, lwt_simd_dot_f32_avx512 };
+LwtAxpy4F64 lwt_simd_axpy4_f64[LWT_SIMD_LEVELS] = { NULL, lwt_simd_axpy4_f64_sse2, lwt_simd_axpy4_f64_avx2, lwt_simd_axpy4_f64_avx512 };
+LwtAxpy4F32 lwt_simd_axpy4_f32[LWT_SIMD_LEVELS] = { NULL, lwt_simd_axpy4_f32_sse2, lwt_simd_axpy4_f32_avx2, lwt_simd_axpy4_f32_avx512 };
+LwtDot4F64 lwt_simd_dot4_f64[LWT_SIMD_LEVELS] = { NULL, lwt_simd_dot4_f64_sse2, lwt_simd_dot4_f64_avx2, lwt_simd_dot4_f64_avx512 };
+LwtDot4F32 lwt_simd_dot4_f32[LWT_SIMD_LEVELS] = { NULL, lwt_simd_dot4_f32_sse2, lwt_simd_dot4_f32_avx2, lwt_simd_dot4_f32_avx512 };
+LwtDotsF64 lwt_simd_dots_f64[LWT_SIMD_LEVELS] = { NULL, lwt_simd_dots_f64_sse2, lwt_simd_dots_f64_avx2, lwt_simd_dots_f64_avx512 };
+LwtDotsF32 lwt_simd_dots_f32[LWT_SIMD_LEVELS] = { NULL, lwt_simd_dots_f32_sse2, lwt_simd_dots_f32_avx2, lwt_simd_dots_f32_avx512 };
+LwtCrossF64 lwt_simd_cross_f64[LWT_SIMD_LEVELS] = { NULL, lwt_simd_cross_f64_sse2, lwt_simd_cross_f64_avx2, lwt_simd_cross_f64_avx512 };
+LwtCrossF32 lwt_simd_cross_f32[LWT_SIMD_LEVELS] = { NULL, lwt_simd_cross_f32_sse2, lwt_simd_cross_f32_avx2, lwt_simd_cross_f32_avx512 };
+LwtTileF64 lwt_simd_tile_f64[LWT_SIMD_LEVELS] = { NULL, lwt_simd_tile_f64_sse2, lwt_simd_tile_f64_avx2, lwt_simd_tile_f64_avx512 };
+LwtTileF32 lwt_simd_tile_f32[LWT_SIMD_LEVELS] = { NULL, lwt_simd_tile_f32_sse2, lwt_simd_tile_f32_avx2, lwt_simd_tile_f32_avx512 };
+
+#else
+
+LwtBinaryF64 lwt_simd_binary_f64[LWT_SIMD_LEVELS][LWT_SIMD_OPS];
+LwtBinaryF32 lwt_simd_binary_f32[LWT_SIMD_LEVELS][LWT_SIMD_OPS];
+LwtScalarF64 lwt_simd_scalar_f64[LWT_SIMD_LEVELS][LWT_SIMD_OPS];
+LwtScalarF32 lwt_simd_scalar_f32[LWT_SIMD_LEVELS][LWT_SIMD_OPS];
+LwtReduceF64 lwt_simd_reduce_f64[LWT_SIMD_LEVELS][LWT_SIMD_OPS];
+LwtReduceF32 lwt_simd_reduce_f32[LWT_SIMD_LEVELS][LWT_SIMD_OPS];
+LwtDotF64 lwt_simd_dot_f64[LWT_SIMD_LEVELS];
+LwtDotF32 lwt_simd_dot_f32[LWT_SIMD_LEVELS];
+LwtAxpy4F64 lwt_simd_axpy4_f64[LWT_SIMD_LEVELS];
+LwtAxpy4F32 lwt_simd_axpy4_f32[LWT_SIMD_LEVELS];
+LwtDot4F64 lwt_simd_dot4_f64[LWT_SIMD_LEVELS];
+LwtDot4F32 lwt_simd_dot4_f32[LWT_SIMD_LEVELS];
+LwtDotsF64 lwt_simd_dots_f64[LWT_SIMD_LEVELS];
+LwtDotsF32 lwt_simd_dots_f32[LWT_SIMD_LEVELS];
+LwtCrossF64 lwt_simd_cross_f64[LWT_SIMD_LEVELS];
+LwtCrossF32 lwt_simd_cross_f32[LWT_SIMD_LEVELS];
+LwtTileF64 lwt_simd_tile_f64[LWT_SIMD_LEVELS];
+LwtTileF32 lwt_simd_tile_f32[LWT_SIMD_LEVELS];
+
+#endif
+
+/**
+ * Detects the best instruction set supported by the CPU and the operating system.
+ *
+ * @return One of LWT_SIMD_SCALAR, LWT_SIMD_SSE2, LWT_SIMD_AVX2 or LWT_SIMD_AVX512.
+ */
+int lwt_simd_detect(void) {
+
+#ifdef LWT_SIMD_X86
+    __builtin_cpu_init();
+
+    if(__builtin_cpu_supports("avx512f"))
+        return LWT_SIMD_AVX512;
+    if(__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma"))
+        return LWT_SIMD_AVX2;
+    if(__builtin_cpu_supports("sse2"))
+        return LWT_SIMD_SSE2;
+#endif
+
+    return LWT_SIMD_SCALAR;
+}
+
+/**
+ * Returns the instruction set level used by the element-wise kernels.
+ *
+ * @return The level, detected on the first call.
+ */
+int lwt_simd_level(void) {
+
+    int level = atomic_load_explicit(&lwt_simd_current_level, memory_order_relaxed);
+
+    if(level < 0) {
+        level = lwt_simd_detect();
+        atomic_store_explicit(&lwt_simd_current_level, level, memory_order_relaxed);
+    }
+
+    return level;
+}
+
+/**
+ * Forces the instruction set level used by the element-wise kernels.
+ *
+ * @param level A level up to the detected one; higher values are clamped.
+ *
+ * Note: Meant for benchmarking and testing the fallbacks.
+ */
+void lwt_simd_set_level(int level) {
+
+    int detected = lwt_simd_detect();
+    atomic_store_explicit(&lwt_simd_current_level, level < detected ? (level < 0 ? 0 : level) : detected, memory_order_relaxed);
+}
\ No newline at end of file
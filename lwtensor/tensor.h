@@ -29,181 +29,1746 @@
 #include <math.h>
 #include <string.h>
 #include <stdarg.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "alloc.h"
+#include "simd.h"
+#include "thread.h"
 
 #ifndef ttype
 #define ttype double
 #endif
 
-struct Tensor {
-    int* shape;
-    ttype* components;
-    unsigned int rank;
-};
+/*
+ * Maximum rank supported by the inline stride storage of a Tensor.
+ */
+#ifndef LWT_MAX_RANK
+#define LWT_MAX_RANK 8
+#endif
+
+/*
+ * Maximum number of operands walked together by a TensorIterator.
+ */
+#ifndef LWT_MAX_OPERANDS
+#define LWT_MAX_OPERANDS 8
+#endif
+
+/**
+ * Element types of a Tensor.
+ *
+ * Arithmetic runs on tensors of the compile-time `ttype` (TENSOR_NATIVE, which is
+ * TENSOR_F64 or TENSOR_F32). The other types are storage formats: convert them with
+ * `tensor_cast` before computing, and back to store results at reduced size.
+ */
+typedef enum {
+    TENSOR_F64 = 0,
+    TENSOR_F32,
+    TENSOR_F16,
+    TENSOR_BF16,
+    TENSOR_I32,
+    TENSOR_I8,
+    TENSOR_U8,
+    TENSOR_DTYPES
+} TensorDType;
+
+/*
+ * Element type matching `ttype`.
+ */
+#define TENSOR_NATIVE (sizeof(ttype) == sizeof(float) ? TENSOR_F32 : TENSOR_F64)
+
+/**
+ * Returns the size in bytes of one element of a given type.
+ */
+size_t tensor_dtype_size(TensorDType dtype) {
+
+    static const unsigned char sizes[TENSOR_DTYPES] = { 8, 4, 2, 2, 4, 1, 1 };
+    return sizes[dtype];
+}
+
+/*
+ * strides[i] is the distance, in elements, between two consecutive indices of
+ * axis i. Tensors are laid out with the first index varying fastest, so a freshly
+ * created tensor has strides[0] = 1 and strides[i] = strides[i - 1] * shape[i - 1].
+ *
+ * A view shares the components of another tensor: `components` points at its
+ * first element inside the parent buffer and `strides` describe how to walk it.
+ * `flags` records which of `shape` and `components` the tensor owns.
+ *
+ * `components` points at elements of type `dtype`; it is only a `ttype` array when
+ * `dtype` is TENSOR_NATIVE. Strides are counted in elements of `dtype`.
+ */
+struct Tensor {
+    int* shape;
+    ptrdiff_t strides[LWT_MAX_RANK];
+    ttype* components;
+    unsigned int rank;
+    unsigned int flags;
+    TensorDType dtype;
+};
+
+typedef struct Tensor Tensor;
+
+/**
+ * Ownership flags of a Tensor.
+ */
+enum {
+    TENSOR_OWNS_SHAPE = 1,
+    TENSOR_OWNS_COMPONENTS = 2,
+    TENSOR_SHAPE_FROM_MALLOC = 4
+};
+
+/**
+ * Number of bytes allocated for the shape of a tensor of a given rank.
+ *
+ * @param rank The rank.
+ * @return     The size of the shape array (at least one entry, so rank-0 tensors get a valid pointer).
+ */
+size_t lwt_shape_bytes(unsigned int rank) {
+    return sizeof(int) * (rank > 0 ? rank : 1);
+}
+
+/**
+ * Allocates the shape array of a tensor from the arena attached to the calling thread, or from the heap.
+ *
+ * @param rank The rank of the tensor.
+ * @return     A pointer to `rank` ints.
+ */
+int* lwt_storage_alloc_shape(unsigned int rank) {
+
+    if(lwt_current_arena != NULL)
+        return (int*) tensor_arena_alloc(lwt_current_arena, lwt_shape_bytes(rank));
+
+    return (int*) lwt_malloc(lwt_shape_bytes(rank));
+}
+
+/**
+ * Allocates the storage of a tensor from the arena attached to the calling thread, or from the heap.
+ *
+ * @param bytes Size of the storage in bytes.
+ * @return      A pointer aligned to LWT_ALIGNMENT.
+ */
+ttype* lwt_storage_alloc_bytes(size_t bytes) {
+
+    if(lwt_current_arena != NULL)
+        return (ttype*) tensor_arena_alloc(lwt_current_arena, bytes);
+
+    return (ttype*) lwt_malloc_aligned(bytes);
+}
+
+/**
+ * Allocates the components of a tensor from the arena attached to the calling thread, or from the heap.
+ *
+ * @param length Number of components.
+ * @return       A pointer to `length` components aligned to LWT_ALIGNMENT.
+ *
+ * Note: Heap buffers go through the allocation callbacks and the size-class pool.
+ */
+ttype* lwt_storage_alloc_components(size_t length) {
+    return lwt_storage_alloc_bytes(sizeof(ttype) * length);
+}
+
+/**
+ * Returns the ownership flags of a tensor whose storage comes from `lwt_storage_alloc_*`.
+ *
+ * @return No flags while an arena is attached (the arena owns the storage), both ownership flags otherwise.
+ */
+unsigned int lwt_storage_flags(void) {
+    return lwt_current_arena != NULL ? 0 : TENSOR_OWNS_SHAPE | TENSOR_OWNS_COMPONENTS;
+}
+
+/**
+ * Status codes returned by the routines that can fail.
+ */
+typedef enum {
+    TENSOR_OK = 0,
+    TENSOR_ERROR_SHAPE,
+    TENSOR_ERROR_SINGULAR,
+    TENSOR_ERROR_ILL_CONDITIONED,
+    TENSOR_ERROR_LAYOUT,
+    TENSOR_ERROR_LIMIT,
+    TENSOR_ERROR_DTYPE,
+    TENSOR_ERROR_IO
+} TensorStatus;
+
+/**
+ * Copies the elements of a tensor into another one, broadcasting the source.
+ *
+ * @param out Destination tensor (or view).
+ * @param in  Source tensor (or view); its shape must broadcast to the shape of `out`.
+ * @return    TENSOR_OK, or TENSOR_ERROR_SHAPE if `in` does not broadcast to `out`.
+ *
+ * Note: Tensors of different element types are converted (see `tensor_cast_into`).
+ */
+TensorStatus copy_into(Tensor out, Tensor in);
+
+/**
+ * Frees the memory owned by a tensor (see the definition below).
+ */
+void destroy_tensor(Tensor tensor);
+
+/**
+ * Returns the empty tensor (rank 0, NULL shape and components) used to report failures.
+ *
+ * @return A tensor that owns nothing; `destroy_tensor` accepts it.
+ */
+Tensor lwt_empty_tensor(void) {
+
+    Tensor tensor;
+    tensor.rank = 0;
+    tensor.shape = NULL;
+    tensor.components = NULL;
+    tensor.flags = 0;
+    tensor.dtype = TENSOR_NATIVE;
+
+    return tensor;
+}
+
+/**
+ * Fills the strides of a tensor from its shape.
+ *
+ * @param tensor The tensor whose strides are computed; its rank must not exceed LWT_MAX_RANK.
+ */
+void compute_strides(Tensor* tensor) {
+
+    ptrdiff_t stride = 1;
+    for(unsigned int i = 0; i < tensor->rank; i ++) {
+        tensor->strides[i] = stride;
+        stride *= tensor->shape[i];
+    }
+}
+
+/**
+ * Returns a pointer to the element at a given offset from the first component of a tensor.
+ *
+ * @param tensor The tensor, of any element type.
+ * @param offset Offset in elements of `tensor.dtype`.
+ * @return       The address of the element, as a `ttype` pointer.
+ */
+ttype* lwt_element(Tensor tensor, ptrdiff_t offset) {
+    return (ttype*) ((char*) tensor.components + offset * (ptrdiff_t) tensor_dtype_size(tensor.dtype));
+}
+
+/**
+ * Converts a double to the float of its magnitude rounded towards odd.
+ *
+ * Note: Rounding a second time from this float (to half or bfloat16) gives the correctly
+ * rounded result of the double, which rounding twice to nearest does not.
+ */
+float lwt_float_round_odd(double value) {
+
+    float rounded = (float) value;
+
+    uint32_t bits;
+    memcpy(&bits, &rounded, sizeof(bits));
+
+    if((double) rounded != value && value == value && !(bits & 1)) {
+        bits += fabs((double) rounded) < fabs(value) ? 1 : -1;
+        memcpy(&rounded, &bits, sizeof(bits));
+    }
+
+    return rounded;
+}
+
+/**
+ * Converts a float to IEEE 754 half precision, rounding to nearest even.
+ */
+uint16_t lwt_float_to_half(float value) {
+
+    uint32_t bits;
+    memcpy(&bits, &value, sizeof(bits));
+
+    uint16_t sign = (uint16_t) ((bits >> 16) & 0x8000);
+    uint32_t exponent = (bits >> 23) & 0xff;
+    uint32_t mantissa = bits & 0x7fffff;
+
+    if(exponent == 0xff)
+        return sign | 0x7c00 | (mantissa ? 0x200 : 0);
+
+    int e = (int) exponent - 127 + 15;
+    if(e >= 31)
+        return sign | 0x7c00;
+
+    if(e <= 0) {
+
+        if(e < -10)
+            return sign;
+
+        // Subnormal: shift the significand (with its implicit bit) into place and round
+        mantissa |= 0x800000;
+        int shift = 14 - e;
+        uint32_t half = mantissa >> shift;
+        uint32_t rest = mantissa & ((1u << shift) - 1);
+        uint32_t tie = 1u << (shift - 1);
+
+        if(rest > tie || (rest == tie && (half & 1)))
+            half ++;
+
+        return sign | (uint16_t) half;
+    }
+
+    uint32_t half = ((uint32_t) e << 10) | (mantissa >> 13);
+    uint32_t rest = mantissa & 0x1fff;
+
+    // A carry out of the mantissa correctly bumps the exponent, up to infinity
+    if(rest > 0x1000 || (rest == 0x1000 && (half & 1)))
+        half ++;
+
+    return sign | (uint16_t) half;
+}
+
+/**
+ * Converts an IEEE 754 half precision value to float.
+ */
+float lwt_half_to_float(uint16_t value) {
+
+    uint32_t sign = (uint32_t) (value & 0x8000) << 16;
+    uint32_t exponent = (value >> 10) & 0x1f;
+    uint32_t mantissa = value & 0x3ff;
+    uint32_t bits;
+
+    if(exponent == 0x1f)
+        bits = sign | 0x7f800000 | (mantissa << 13);
+    else if(exponent != 0)
+        bits = sign | ((exponent + 127 - 15) << 23) | (mantissa << 13);
+    else if(mantissa == 0)
+        bits = sign;
+    else {
+
+        // Subnormal: normalize the significand
+        exponent = 127 - 15 + 1;
+        while(!(mantissa & 0x400)) {
+            mantissa <<= 1;
+            exponent --;
+        }
+        bits = sign | (exponent << 23) | ((mantissa & 0x3ff) << 13);
+    }
+
+    float result;
+    memcpy(&result, &bits, sizeof(result));
+
+    return result;
+}
+
+/**
+ * Converts a float to bfloat16 (its upper 16 bits), rounding to nearest even.
+ */
+uint16_t lwt_float_to_bfloat(float value) {
+
+    uint32_t bits;
+    memcpy(&bits, &value, sizeof(bits));
+
+    if((bits & 0x7fffffff) > 0x7f800000)
+        return (uint16_t) ((bits >> 16) | 0x40);
+
+    bits += 0x7fff + ((bits >> 16) & 1);
+    return (uint16_t) (bits >> 16);
+}
+
+/**
+ * Converts a bfloat16 value to float.
+ */
+float lwt_bfloat_to_float(uint16_t value) {
+
+    uint32_t bits = (uint32_t) value << 16;
+
+    float result;
+    memcpy(&result, &bits, sizeof(result));
+
+    return result;
+}
+
+/**
+ * Converts a double to an integer type, rounding to nearest and saturating.
+ *
+ * @param value The value; NaN converts to 0.
+ * @param low   Smallest representable value.
+ * @param high  Largest representable value.
+ */
+double lwt_saturate(double value, double low, double high) {
+
+    if(value != value)
+        return 0.0;
+
+    value = value < 0.0 ? ceil(value - 0.5) : floor(value + 0.5);
+    return value < low ? low : value > high ? high : value;
+}
+
+/**
+ * Reads one element of any type as a double.
+ *
+ * @param dtype The element type.
+ * @param data  First element of the array.
+ * @param index Index of the element, in elements of `dtype`.
+ * @return      The value, exactly (every element type fits a double).
+ */
+double lwt_dtype_load(TensorDType dtype, const void* data, ptrdiff_t index) {
+
+    switch(dtype) {
+        case TENSOR_F64: return ((const double*) data)[index];
+        case TENSOR_F32: return ((const float*) data)[index];
+        case TENSOR_F16: return lwt_half_to_float(((const uint16_t*) data)[index]);
+        case TENSOR_BF16: return lwt_bfloat_to_float(((const uint16_t*) data)[index]);
+        case TENSOR_I32: return ((const int32_t*) data)[index];
+        case TENSOR_I8: return ((const int8_t*) data)[index];
+        default: return ((const uint8_t*) data)[index];
+    }
+}
+
+/**
+ * Writes one element of any type from a double.
+ *
+ * @param dtype The element type.
+ * @param data  First element of the array.
+ * @param index Index of the element, in elements of `dtype`.
+ * @param value The value. Floating types round to nearest even; integer types round
+ *              to nearest (ties away from zero) and saturate.
+ */
+void lwt_dtype_store(TensorDType dtype, void* data, ptrdiff_t index, double value) {
+
+    switch(dtype) {
+        case TENSOR_F64: ((double*) data)[index] = value; break;
+        case TENSOR_F32: ((float*) data)[index] = (float) value; break;
+        case TENSOR_F16: ((uint16_t*) data)[index] = lwt_float_to_half(lwt_float_round_odd(value)); break;
+        case TENSOR_BF16: ((uint16_t*) data)[index] = lwt_float_to_bfloat(lwt_float_round_odd(value)); break;
+        case TENSOR_I32: ((int32_t*) data)[index] = (int32_t) lwt_saturate(value, INT32_MIN, INT32_MAX); break;
+        case TENSOR_I8: ((int8_t*) data)[index] = (int8_t) lwt_saturate(value, INT8_MIN, INT8_MAX); break;
+        default: ((uint8_t*) data)[index] = (uint8_t) lwt_saturate(value, 0, UINT8_MAX); break;
+    }
+}
+
+/**
+ * Creates a tensor of a given rank and shape.
+ *
+ * @param rank The number of dimensions (axes) of the tensor.
+ * @param ...  A variable number of integers specifying the size of each dimension.
+ * @return     A Tensor structure with allocated memory and components initialized to 0.0,
+ *             or the empty tensor if `rank` exceeds LWT_MAX_RANK.
+ */
+Tensor create_tensor(unsigned int rank, ...) {
+
+    if(rank > LWT_MAX_RANK)
+        return lwt_empty_tensor();
+
+    LWT_OP_ENTER("create_tensor");
+
+    Tensor tensor;
+
+    va_list args;
+    va_start(args, rank);
+
+    size_t length = 1;
+    int* shape = lwt_storage_alloc_shape(rank);
+
+    for(unsigned int i = 0; i < rank; i ++) {
+        int s = va_arg(args, int);
+        length *= s;
+        shape[i] = s;
+    }
+
+    va_end(args);
+
+    tensor.rank = rank;
+    tensor.shape = shape;
+    tensor.components = lwt_storage_alloc_components(length);
+    tensor.flags = lwt_storage_flags();
+    tensor.dtype = TENSOR_NATIVE;
+    compute_strides(&tensor);
+
+    for(size_t i = 0; i < length; i ++) 
+        tensor.components[i] = 0.0;
+
+    LWT_OP_LEAVE();
+    return tensor;
+}
+
+/**
+ * Creates a tensor using a pointer to the shape array.
+ *
+ * @param rank  The number of dimensions of the tensor.
+ * @param shape A pointer to an array of integers defining the size of each dimension.
+ * @return      A Tensor structure with allocated components initialized to 0.0, or the empty
+ *              tensor if `rank` exceeds LWT_MAX_RANK (`shape` is then freed).
+ *
+ * Note: The `shape` pointer is not copied; it is assigned directly. Be cautious with ownership and lifetime.
+ * The tensor takes ownership of `shape` even while an arena is attached.
+ */
+Tensor create_tensor_byptr(unsigned rank, int* shape) {
+
+    if(rank > LWT_MAX_RANK) {
+        free(shape);
+        return lwt_empty_tensor();
+    }
+
+    LWT_OP_ENTER("create_tensor");
+
+    Tensor tensor;
+
+    size_t length = 1;
+    for(unsigned int i = 0; i < rank; i ++) length *= shape[i];
+
+    tensor.rank = rank;
+    tensor.shape = shape;
+    tensor.components = lwt_storage_alloc_components(length);
+    tensor.flags = TENSOR_OWNS_SHAPE | TENSOR_SHAPE_FROM_MALLOC | (lwt_storage_flags() & TENSOR_OWNS_COMPONENTS);
+    tensor.dtype = TENSOR_NATIVE;
+    compute_strides(&tensor);
+
+    for(size_t i = 0; i < length; i ++) 
+        tensor.components[i] = 0.0;
+
+    LWT_OP_LEAVE();
+    return tensor;
+}
+
+/**
+ * Creates a deep copy of a given tensor.
+ *
+ * @param tensor The source Tensor (or view) to be copied.
+ * @return       A new contiguous Tensor structure with its own allocated shape and component arrays,
+ *               of the same element type as `tensor`.
+ */
+Tensor create_copy(Tensor tensor) {
+
+    LWT_OP_ENTER("create_copy");
+
+    Tensor tensor_copy;
+    tensor_copy.rank = tensor.rank;
+
+    size_t length = 1;
+    int* shape = lwt_storage_alloc_shape(tensor.rank);
+
+    for(unsigned int i = 0; i < tensor.rank; i ++) {
+        shape[i] = tensor.shape[i];
+        length *= tensor.shape[i];
+    }
+
+    tensor_copy.shape = shape;
+    tensor_copy.components = lwt_storage_alloc_bytes(tensor_dtype_size(tensor.dtype) * length);
+    tensor_copy.flags = lwt_storage_flags();
+    tensor_copy.dtype = tensor.dtype;
+    compute_strides(&tensor_copy);
+
+    copy_into(tensor_copy, tensor);
+
+    LWT_OP_LEAVE();
+    return tensor_copy;
+}
+
+/**
+ * Sets the value of a tensor element at a specified multi-dimensional index.
+ *
+ * @param tensor The tensor to be modified.
+ * @param value  The value to assign to the specified position.
+ * @param ...    A sequence of integers indicating the index in each dimension.
+ *
+ * Note: The offset is the dot product of the index with the tensor strides. No bounds checking is performed.
+ * Tensors of another type than `ttype` convert the value (see `lwt_dtype_store`).
+ */
+void set_value(Tensor tensor, ttype value, ...) {
+
+    va_list args;
+    va_start(args, value);
+
+    ptrdiff_t offset = 0;
+    for(unsigned int i = 0; i < tensor.rank; i ++)
+        offset += va_arg(args, int) * tensor.strides[i];
+
+    if(tensor.dtype == TENSOR_NATIVE)
+        tensor.components[offset] = value;
+    else
+        lwt_dtype_store(tensor.dtype, tensor.components, offset, value);
+
+    va_end(args);
+}
+
+/**
+ * Retrieves the value of a tensor element at a specified multi-dimensional index.
+ *
+ * @param tensor The tensor to read from.
+ * @param ...    A sequence of integers indicating the index in each dimension.
+ * @return       The value at the specified position.
+ *
+ * Note: The offset is the dot product of the index with the tensor strides. No bounds checking is performed.
+ * Tensors of another type than `ttype` convert the element.
+ */
+ttype get_value(Tensor tensor, ...) {
+
+    va_list args;
+    va_start(args, tensor);
+
+    ptrdiff_t offset = 0;
+    for(unsigned int i = 0; i < tensor.rank; i ++)
+        offset += va_arg(args, int) * tensor.strides[i];
+
+    ttype value = tensor.dtype == TENSOR_NATIVE ? tensor.components[offset] :
+        (ttype) lwt_dtype_load(tensor.dtype, tensor.components, offset);
+    va_end(args);
+
+    return value;
+}
+
+/**
+ * Returns a pointer to the element of a rank-1 tensor at index i.
+ *
+ * @param tensor The tensor.
+ * @param i      Index along axis 0.
+ * @return       A pointer to the element, valid for reading and writing.
+ */
+static inline ttype* tensor_at1(Tensor tensor, int i) {
+    return tensor.components + i * tensor.strides[0];
+}
+
+/**
+ * Returns a pointer to the element of a rank-2 tensor at index (i, j).
+ *
+ * @param tensor The tensor.
+ * @param i      Index along axis 0.
+ * @param j      Index along axis 1.
+ * @return       A pointer to the element, valid for reading and writing.
+ */
+static inline ttype* tensor_at2(Tensor tensor, int i, int j) {
+    return tensor.components + i * tensor.strides[0] + j * tensor.strides[1];
+}
+
+/**
+ * Returns a pointer to the element of a rank-3 tensor at index (i, j, k).
+ *
+ * @param tensor The tensor.
+ * @param i      Index along axis 0.
+ * @param j      Index along axis 1.
+ * @param k      Index along axis 2.
+ * @return       A pointer to the element, valid for reading and writing.
+ */
+static inline ttype* tensor_at3(Tensor tensor, int i, int j, int k) {
+    return tensor.components + i * tensor.strides[0] + j * tensor.strides[1] + k * tensor.strides[2];
+}
+
+/**
+ * Returns a pointer to the element of a tensor at a multi-dimensional index.
+ *
+ * @param tensor The tensor.
+ * @param index  An array of `rank` indices, one per axis.
+ * @return       A pointer to the element, valid for reading and writing.
+ */
+static inline ttype* tensor_at(Tensor tensor, const int* index) {
+
+    ptrdiff_t offset = 0;
+    for(unsigned int i = 0; i < tensor.rank; i ++)
+        offset += index[i] * tensor.strides[i];
+
+    return tensor.components + offset;
+}
+
+/**
+ * Calculates the total number of elements in a tensor.
+ *
+ * @param tensor The tensor whose length is to be computed.
+ * @return       The product of all dimensions (i.e., the number of components).
+ */
+size_t get_length(Tensor tensor) {
+
+    size_t length = 1;
+    for(unsigned int i = 0; i < tensor.rank; i ++) 
+        length *= tensor.shape[i];
+
+    return length;
+}
+
+/**
+ * Walks several tensors of the same shape together.
+ *
+ * The first axis is kept as the inner run handed to kernels (`shape[0]` elements,
+ * operand k advancing by `strides[0][k]`); the remaining axes are visited by
+ * `tensor_iterator_next`. Axes that are contiguous in every operand are merged
+ * first, so dense tensors are walked as a single run.
+ */
+typedef struct {
+    unsigned int rank;
+    unsigned int count;
+    int shape[LWT_MAX_RANK];
+    int index[LWT_MAX_RANK];
+    ptrdiff_t strides[LWT_MAX_RANK][LWT_MAX_OPERANDS];
+    ptrdiff_t offsets[LWT_MAX_OPERANDS];
+} TensorIterator;
+
+/**
+ * Initializes an iterator over operands that share the shape of the first one.
+ *
+ * @param it       The iterator to initialize.
+ * @param count    Number of operands (at most LWT_MAX_OPERANDS).
+ * @param operands Array of `count` tensors; the iteration shape is the shape of operands[0].
+ * @return         1 if there is at least one element to visit, 0 otherwise.
+ */
+int tensor_iterator_init(TensorIterator* it, unsigned int count, const Tensor* operands) {
+
+    it->count = count;
+    it->rank = 1;
+    it->shape[0] = 1;
+    it->index[0] = 0;
+
+    for(unsigned int k = 0; k < count; k ++) {
+        it->strides[0][k] = 1;
+        it->offsets[k] = 0;
+    }
+
+    int first = 1;
+    for(unsigned int axis = 0; axis < operands[0].rank; axis ++) {
+
+        int extent = operands[0].shape[axis];
+        if(extent == 0)
+            return 0;
+        if(extent == 1)
+            continue;
+
+        unsigned int last = it->rank - 1;
+
+        int mergeable = 1;
+        for(unsigned int k = 0; k < count && !first; k ++) {
+            if(operands[k].strides[axis] != it->strides[last][k] * it->shape[last])
+                mergeable = 0;
+        }
+
+        if(first || mergeable) {
+
+            if(first) {
+                for(unsigned int k = 0; k < count; k ++)
+                    it->strides[last][k] = operands[k].strides[axis];
+            }
+
+            it->shape[last] *= extent;
+            first = 0;
+            continue;
+        }
+
+        it->shape[it->rank] = extent;
+        it->index[it->rank] = 0;
+        for(unsigned int k = 0; k < count; k ++)
+            it->strides[it->rank][k] = operands[k].strides[axis];
+
+        it->rank ++;
+    }
+
+    return 1;
+}
+
+/**
+ * Advances an iterator to the next inner run.
+ *
+ * @param it The iterator.
+ * @return   1 while there are runs left, 0 once every element has been visited.
+ */
+int tensor_iterator_next(TensorIterator* it) {
+
+    for(unsigned int axis = 1; axis < it->rank; axis ++) {
+
+        if(++ it->index[axis] < it->shape[axis]) {
+            for(unsigned int k = 0; k < it->count; k ++)
+                it->offsets[k] += it->strides[axis][k];
+            return 1;
+        }
+
+        it->index[axis] = 0;
+        for(unsigned int k = 0; k < it->count; k ++)
+            it->offsets[k] -= it->strides[axis][k] * (it->shape[axis] - 1);
+    }
+
+    return 0;
+}
+
+/**
+ * Moves an iterator to the element at a given position of the iteration order.
+ *
+ * @param it       An initialized iterator.
+ * @param position Flat position, in [0, number of elements).
+ *
+ * Note: `index[0]` is set as well, so the current inner run has `shape[0] - index[0]`
+ * elements left. Used to split the iteration space between threads.
+ */
+void tensor_iterator_seek(TensorIterator* it, size_t position) {
+
+    for(unsigned int k = 0; k < it->count; k ++)
+        it->offsets[k] = 0;
+
+    for(unsigned int axis = 0; axis < it->rank; axis ++) {
+
+        int index = (int) (position % it->shape[axis]);
+        position /= it->shape[axis];
+
+        it->index[axis] = index;
+        for(unsigned int k = 0; k < it->count; k ++)
+            it->offsets[k] += index * it->strides[axis][k];
+    }
+}
+
+/**
+ * Runs a binary SIMD kernel on contiguous runs.
+ *
+ * @param op  One of LWT_SIMD_ADD, LWT_SIMD_SUB, LWT_SIMD_MUL or LWT_SIMD_DIV.
+ * @param n   Number of elements.
+ * @param out Output run.
+ * @param a   First operand run.
+ * @param b   Second operand run.
+ * @return    1 if a SIMD kernel handled the run, 0 if the caller has to loop.
+ */
+int lwt_simd_binary(int op, size_t n, ttype* out, const ttype* a, const ttype* b) {
+
+    int level = lwt_simd_level();
+    if(level == LWT_SIMD_SCALAR)
+        return 0;
+
+    if(sizeof(ttype) == sizeof(double))
+        lwt_simd_binary_f64[level][op](n, (double*) out, (const double*) a, (const double*) b);
+    else if(sizeof(ttype) == sizeof(float))
+        lwt_simd_binary_f32[level][op](n, (float*) out, (const float*) a, (const float*) b);
+    else
+        return 0;
+
+    return 1;
+}
+
+/**
+ * Runs a tensor-scalar SIMD kernel on contiguous runs.
+ *
+ * @param op  One of LWT_SIMD_ADD, LWT_SIMD_SUB, LWT_SIMD_MUL or LWT_SIMD_DIV.
+ * @param n   Number of elements.
+ * @param out Output run.
+ * @param a   Tensor operand run.
+ * @param s   Scalar operand.
+ * @return    1 if a SIMD kernel handled the run, 0 if the caller has to loop.
+ */
+int lwt_simd_scalar(int op, size_t n, ttype* out, const ttype* a, ttype s) {
+
+    int level = lwt_simd_level();
+    if(level == LWT_SIMD_SCALAR)
+        return 0;
+
+    if(sizeof(ttype) == sizeof(double))
+        lwt_simd_scalar_f64[level][op](n, (double*) out, (const double*) a, (double) s);
+    else if(sizeof(ttype) == sizeof(float))
+        lwt_simd_scalar_f32[level][op](n, (float*) out, (const float*) a, (float) s);
+    else
+        return 0;
+
+    return 1;
+}
+
+/**
+ * Accumulation modes of dot, norm and the sum-based reductions.
+ *
+ * TENSOR_SUM_PAIRWISE    SIMD multi-accumulator sums over LWT_SUM_BLOCK blocks, combined
+ *                        pairwise; error grows with log(n). The default, at full speed.
+ * TENSOR_SUM_COMPENSATED Neumaier (improved Kahan) summation in eight independent lanes;
+ *                        the error no longer grows with n.
+ * TENSOR_SUM_WIDE        Eight lanes accumulated in double, which widens float tensors.
+ *
+ * Every mode adds the same elements in the same order for a given shape, so results are
+ * reproducible across runs and thread counts.
+ */
+typedef enum {
+    TENSOR_SUM_PAIRWISE = 0,
+    TENSOR_SUM_COMPENSATED,
+    TENSOR_SUM_WIDE
+} TensorSumMode;
+
+/*
+ * Elements summed directly by the SIMD kernels before switching to pairwise combination.
+ */
+#ifndef LWT_SUM_BLOCK
+#define LWT_SUM_BLOCK 256
+#endif
+
+LWT_THREAD_LOCAL TensorSumMode lwt_sum_mode = TENSOR_SUM_PAIRWISE;
+
+/**
+ * Selects the accumulation mode used by the calling thread.
+ *
+ * @param mode The new mode.
+ * @return     The previous mode, so it can be restored.
+ *
+ * Note: The mode is captured when an operation starts, so the worker threads of a
+ * parallel operation follow the mode of the thread that started it.
+ */
+TensorSumMode lwt_set_sum_mode(TensorSumMode mode) {
+
+    TensorSumMode previous = lwt_sum_mode;
+    lwt_sum_mode = mode;
+
+    return previous;
+}
+
+/**
+ * Running sum carried in double with a Neumaier correction term.
+ */
+typedef struct {
+    double value;
+    double compensation;
+} TensorSum;
+
+/**
+ * Adds a value to a running sum.
+ *
+ * @param sum The running sum.
+ * @param x   The value to add.
+ */
+void lwt_sum_add(TensorSum* sum, double x) {
+
+    double t = sum->value + x;
+
+    if(fabs(sum->value) >= fabs(x))
+        sum->compensation += (sum->value - t) + x;
+    else
+        sum->compensation += (x - t) + sum->value;
+
+    sum->value = t;
+}
+
+/**
+ * Adds a running sum into another one.
+ *
+ * @param sum   The running sum receiving `other`.
+ * @param other The running sum to add.
+ */
+void lwt_sum_merge(TensorSum* sum, const TensorSum* other) {
+    lwt_sum_add(sum, other->value);
+    sum->compensation += other->compensation;
+}
+
+/**
+ * Returns the value of a running sum.
+ */
+ttype lwt_sum_result(const TensorSum* sum) {
+    return (ttype) (sum->value + sum->compensation);
+}
+
+/**
+ * Adds a value to a running sum kept in ttype with a separate Neumaier correction term.
+ *
+ * @param sum          The running sum.
+ * @param compensation Its correction term.
+ * @param x            The value to add.
+ */
+void lwt_sum_add_compensated(ttype* sum, ttype* compensation, ttype x) {
+
+    ttype t = *sum + x;
+
+    if(fabs(*sum) >= fabs(x))
+        *compensation += (*sum - t) + x;
+    else
+        *compensation += (x - t) + *sum;
+
+    *sum = t;
+}
+
+/**
+ * Sums one block of x[i] (or x[i] * y[i]) with the SIMD kernels when the block is contiguous.
+ *
+ * @param n  Number of elements.
+ * @param x  First run.
+ * @param sx Stride of `x`.
+ * @param y  Second run, or NULL to sum `x` alone.
+ * @param sy Stride of `y`.
+ * @return   The sum.
+ */
+ttype lwt_sum_block(size_t n, const ttype* x, ptrdiff_t sx, const ttype* y, ptrdiff_t sy) {
+
+    int level = lwt_simd_level();
+
+    if(level != LWT_SIMD_SCALAR && sx == 1 && (y == NULL || sy == 1)) {
+
+        if(sizeof(ttype) == sizeof(double)) {
+            if(y != NULL)
+                return (ttype) lwt_simd_dot_f64[level](n, (const double*) x, (const double*) y);
+            return (ttype) lwt_simd_reduce_f64[level][LWT_SIMD_ADD](n, (const double*) x);
+        }
+        if(sizeof(ttype) == sizeof(float)) {
+            if(y != NULL)
+                return (ttype) lwt_simd_dot_f32[level](n, (const float*) x, (const float*) y);
+            return (ttype) lwt_simd_reduce_f32[level][LWT_SIMD_ADD](n, (const float*) x);
+        }
+    }
+
+    ttype s0 = 0.0, s1 = 0.0, s2 = 0.0, s3 = 0.0;
+    size_t i = 0;
+
+    for(; i + 4 <= n; i += 4) {
+        s0 += y != NULL ? x[i * sx] * y[i * sy] : x[i * sx];
+        s1 += y != NULL ? x[(i + 1) * sx] * y[(i + 1) * sy] : x[(i + 1) * sx];
+        s2 += y != NULL ? x[(i + 2) * sx] * y[(i + 2) * sy] : x[(i + 2) * sx];
+        s3 += y != NULL ? x[(i + 3) * sx] * y[(i + 3) * sy] : x[(i + 3) * sx];
+    }
+    for(; i < n; i ++)
+        s0 += y != NULL ? x[i * sx] * y[i * sy] : x[i * sx];
+
+    return (s0 + s1) + (s2 + s3);
+}
+
+/**
+ * Sums x[i] (or x[i] * y[i]) by recursive halving down to LWT_SUM_BLOCK-sized blocks.
+ */
+ttype lwt_sum_pairwise(size_t n, const ttype* x, ptrdiff_t sx, const ttype* y, ptrdiff_t sy) {
+
+    if(n <= LWT_SUM_BLOCK)
+        return lwt_sum_block(n, x, sx, y, sy);
+
+    size_t half = (n / 2 + LWT_SUM_BLOCK - 1) / LWT_SUM_BLOCK * LWT_SUM_BLOCK;
+
+    return lwt_sum_pairwise(half, x, sx, y, sy) +
+        lwt_sum_pairwise(n - half, x + half * sx, sx, y != NULL ? y + half * sy : NULL, sy);
+}
+
+/**
+ * Adds x[i] (or x[i] * y[i]) over one run to a running sum, in a given accumulation mode.
+ *
+ * @param mode The accumulation mode.
+ * @param n    Number of elements.
+ * @param x    First run.
+ * @param sx   Stride of `x`.
+ * @param y    Second run, or NULL to sum `x` alone.
+ * @param sy   Stride of `y`.
+ * @param sum  The running sum.
+ */
+void lwt_sum_run(TensorSumMode mode, size_t n, const ttype* x, ptrdiff_t sx, const ttype* y, ptrdiff_t sy, TensorSum* sum) {
+
+    if(mode == TENSOR_SUM_PAIRWISE) {
+        lwt_sum_add(sum, lwt_sum_pairwise(n, x, sx, y, sy));
+        return;
+    }
+
+    if(mode == TENSOR_SUM_WIDE) {
+
+        double lanes[8] = { 0.0 };
+        size_t i = 0;
+
+        for(; i + 8 <= n; i += 8) {
+            for(int l = 0; l < 8; l ++)
+                lanes[l] += y != NULL ? (double) x[(i + l) * sx] * y[(i + l) * sy] : (double) x[(i + l) * sx];
+        }
+        for(; i < n; i ++)
+            lanes[0] += y != NULL ? (double) x[i * sx] * y[i * sy] : (double) x[i * sx];
+
+        for(int l = 0; l < 8; l ++)
+            lwt_sum_add(sum, lanes[l]);
+        return;
+    }
+
+    ttype lanes[8] = { 0.0 }, compensations[8] = { 0.0 };
+    size_t i = 0;
+
+    for(; i + 8 <= n; i += 8) {
+        for(int l = 0; l < 8; l ++)
+            lwt_sum_add_compensated(&lanes[l], &compensations[l], y != NULL ? x[(i + l) * sx] * y[(i + l) * sy] : x[(i + l) * sx]);
+    }
+    for(; i < n; i ++)
+        lwt_sum_add_compensated(&lanes[0], &compensations[0], y != NULL ? x[i * sx] * y[i * sy] : x[i * sx]);
+
+    for(int l = 0; l < 8; l ++) {
+        lwt_sum_add(sum, lanes[l]);
+        sum->compensation += compensations[l];
+    }
+}
+
+/**
+ * Element-wise kernel over one inner run: out[i] = f(lhs[i], rhs[i], scalar).
+ *
+ * Each pointer advances by its own stride; unary kernels ignore `rhs`.
+ */
+typedef void (*TensorKernel)(size_t n, ttype* out, ptrdiff_t so,
+    const ttype* lhs, ptrdiff_t sl, const ttype* rhs, ptrdiff_t sr, ttype scalar);
+
+/*
+ * `contiguous` is tried first when every stride is 1 and returns nonzero if it
+ * handled the run (e.g. a SIMD kernel); otherwise the scalar loops run.
+ */
+#define LWT_DEFINE_KERNEL(name, expression, contiguous)                                         \
+void name(size_t n, ttype* out, ptrdiff_t so,                                                   \
+    const ttype* lhs, ptrdiff_t sl, const ttype* rhs, ptrdiff_t sr, ttype scalar) {             \
+    (void) rhs; (void) sr; (void) scalar;                                                      \
+    if(so == 1 && sl == 1 && sr == 1) {                                                         \
+        if(contiguous)                                                                          \
+            return;                                                                             \
+        for(size_t i = 0; i < n; i ++) { ttype a = lhs[i]; ttype b = rhs[i]; (void) b;          \
+            out[i] = (expression); }                                                            \
+    }                                                                                           \
+    else {                                                                                      \
+        for(size_t i = 0; i < n; i ++) { ttype a = lhs[i * sl]; ttype b = rhs[i * sr]; (void) b; \
+            out[i * so] = (expression); }                                                       \
+    }                                                                                           \
+}
+
+LWT_DEFINE_KERNEL(lwt_kernel_copy, a, (out == lhs || memmove(out, lhs, sizeof(ttype) * n)))
+LWT_DEFINE_KERNEL(lwt_kernel_sum, a + b, lwt_simd_binary(LWT_SIMD_ADD, n, out, lhs, rhs))
+LWT_DEFINE_KERNEL(lwt_kernel_subtract, a - b, lwt_simd_binary(LWT_SIMD_SUB, n, out, lhs, rhs))
+LWT_DEFINE_KERNEL(lwt_kernel_divide, a / b, lwt_simd_binary(LWT_SIMD_DIV, n, out, lhs, rhs))
+LWT_DEFINE_KERNEL(lwt_kernel_hadamard, a * b, lwt_simd_binary(LWT_SIMD_MUL, n, out, lhs, rhs))
+LWT_DEFINE_KERNEL(lwt_kernel_sum_scalar, a + scalar, lwt_simd_scalar(LWT_SIMD_ADD, n, out, lhs, scalar))
+LWT_DEFINE_KERNEL(lwt_kernel_subtract_scalar, a - scalar, lwt_simd_scalar(LWT_SIMD_SUB, n, out, lhs, scalar))
+LWT_DEFINE_KERNEL(lwt_kernel_divide_scalar, a / scalar, lwt_simd_scalar(LWT_SIMD_DIV, n, out, lhs, scalar))
+LWT_DEFINE_KERNEL(lwt_kernel_product_scalar, a * scalar, lwt_simd_scalar(LWT_SIMD_MUL, n, out, lhs, scalar))
+
+/**
+ * Describes a tensor broadcast to the shape of another one, without allocating.
+ *
+ * Shapes are aligned on their trailing axes; missing leading axes and axes of
+ * extent 1 are expanded with a zero stride, so every index of `out` maps to a
+ * valid element of `tensor`.
+ *
+ * @param tensor  The tensor to broadcast.
+ * @param out     The tensor whose shape is the target shape.
+ * @param operand Receives a tensor sharing `out`'s shape array and `tensor`'s components.
+ * @return        TENSOR_OK, or TENSOR_ERROR_SHAPE if the shapes are not compatible.
+ *
+ * Note: The result borrows `out.shape` and owns nothing; it is only meant to be
+ * handed to a TensorIterator together with `out`.
+ */
+TensorStatus lwt_broadcast_operand(Tensor tensor, Tensor out, Tensor* operand) {
+
+    if(tensor.rank > out.rank)
+        return TENSOR_ERROR_SHAPE;
+
+    unsigned int shift = out.rank - tensor.rank;
+
+    *operand = tensor;
+    operand->rank = out.rank;
+    operand->shape = out.shape;
+    operand->flags = 0;
+
+    for(unsigned int axis = 0; axis < out.rank; axis ++) {
+
+        if(axis < shift) {
+            operand->strides[axis] = 0;
+            continue;
+        }
+
+        int extent = tensor.shape[axis - shift];
+        if(extent == out.shape[axis])
+            operand->strides[axis] = tensor.strides[axis - shift];
+        else if(extent == 1)
+            operand->strides[axis] = 0;
+        else
+            return TENSOR_ERROR_SHAPE;
+    }
+
+    return TENSOR_OK;
+}
+
+/**
+ * Computes the shape two tensors broadcast to.
+ *
+ * @param lhs   The first tensor.
+ * @param rhs   The second tensor.
+ * @param rank  Receives the rank of the result.
+ * @param shape Receives the shape of the result (LWT_MAX_RANK entries).
+ * @return      TENSOR_OK, or TENSOR_ERROR_SHAPE if two aligned extents differ and neither is 1.
+ */
+TensorStatus lwt_broadcast_shape(Tensor lhs, Tensor rhs, unsigned int* rank, int* shape) {
+
+    *rank = lhs.rank > rhs.rank ? lhs.rank : rhs.rank;
+    if(*rank > LWT_MAX_RANK)
+        return TENSOR_ERROR_SHAPE;
+
+    for(unsigned int axis = 0; axis < *rank; axis ++) {
+
+        int a = axis + lhs.rank >= *rank ? lhs.shape[axis + lhs.rank - *rank] : 1;
+        int b = axis + rhs.rank >= *rank ? rhs.shape[axis + rhs.rank - *rank] : 1;
+
+        if(a != b && a != 1 && b != 1)
+            return TENSOR_ERROR_SHAPE;
+
+        shape[axis] = a == 1 ? b : a;
+    }
+
+    return TENSOR_OK;
+}
+
+typedef struct {
+    TensorKernel kernel;
+    TensorIterator it;
+    Tensor out, lhs, rhs;
+    ttype scalar;
+} LwtApplyJob;
+
+void lwt_apply_task(void* context, size_t begin, size_t end, int thread) {
+
+    (void) thread;
+    LwtApplyJob* job = (LwtApplyJob*) context;
+    TensorIterator it = job->it;
+
+    while(begin < end) {
+
+        tensor_iterator_seek(&it, begin);
+
+        size_t n = it.shape[0] - it.index[0];
+        n = n < end - begin ? n : end - begin;
+
+        job->kernel(n,
+            job->out.components + it.offsets[0], it.strides[0][0],
+            job->lhs.components + it.offsets[1], it.strides[0][1],
+            job->rhs.components + it.offsets[2], it.strides[0][2], job->scalar);
+
+        begin += n;
+    }
+}
+
+/**
+ * Applies an element-wise kernel, broadcasting both operands to the shape of `out`.
+ *
+ * @param kernel The kernel to run on each inner run.
+ * @param out    Output tensor, also defines the iteration shape.
+ * @param lhs    First operand.
+ * @param rhs    Second operand (pass `lhs` again for unary kernels).
+ * @param scalar Scalar forwarded to the kernel.
+ * @return       TENSOR_OK, TENSOR_ERROR_SHAPE if an operand does not broadcast to `out`,
+ *               or TENSOR_ERROR_DTYPE if a tensor is not of type `ttype`.
+ *
+ * Note: Broadcast axes are walked with a zero stride, nothing is expanded in memory.
+ * Tensors of at least two LWT_PARALLEL_GRAIN chunks are split over the current thread pool.
+ */
+TensorStatus lwt_apply(TensorKernel kernel, Tensor out, Tensor lhs, Tensor rhs, ttype scalar) {
+
+    if(out.dtype != TENSOR_NATIVE || lhs.dtype != TENSOR_NATIVE || rhs.dtype != TENSOR_NATIVE)
+        return TENSOR_ERROR_DTYPE;
+
+    LwtApplyJob job = { kernel, { 0 }, out, lhs, rhs, scalar };
+
+    if(lwt_broadcast_operand(lhs, out, &job.lhs) != TENSOR_OK ||
+        lwt_broadcast_operand(rhs, out, &job.rhs) != TENSOR_OK)
+        return TENSOR_ERROR_SHAPE;
+
+    Tensor operands[3] = { out, job.lhs, job.rhs };
+
+    if(tensor_iterator_init(&job.it, 3, operands))
+        lwt_parallel_for(get_length(out), LWT_PARALLEL_GRAIN, lwt_apply_task, &job);
+
+    return TENSOR_OK;
+}
+
+/*
+ * Elements converted at a time by `tensor_cast_into`, through a buffer of doubles.
+ */
+#ifndef LWT_CAST_BLOCK
+#define LWT_CAST_BLOCK 256
+#endif
+
+/**
+ * Converts a strided run of elements of any type to doubles.
+ *
+ * @param dtype  Element type of the run.
+ * @param n      Number of elements.
+ * @param out    Receives `n` doubles.
+ * @param in     First element of the run.
+ * @param stride Stride of the run, in elements.
+ */
+void lwt_cast_load(TensorDType dtype, size_t n, double* out, const void* in, ptrdiff_t stride) {
+
+    switch(dtype) {
+        case TENSOR_F64: for(size_t i = 0; i < n; i ++) out[i] = ((const double*) in)[i * stride]; break;
+        case TENSOR_F32: for(size_t i = 0; i < n; i ++) out[i] = ((const float*) in)[i * stride]; break;
+        case TENSOR_I32: for(size_t i = 0; i < n; i ++) out[i] = ((const int32_t*) in)[i * stride]; break;
+        case TENSOR_I8: for(size_t i = 0; i < n; i ++) out[i] = ((const int8_t*) in)[i * stride]; break;
+        case TENSOR_U8: for(size_t i = 0; i < n; i ++) out[i] = ((const uint8_t*) in)[i * stride]; break;
+        default: for(size_t i = 0; i < n; i ++) out[i] = lwt_dtype_load(dtype, in, i * stride); break;
+    }
+}
+
+/**
+ * Converts doubles to a strided run of elements of any type.
+ *
+ * @param dtype  Element type of the run.
+ * @param n      Number of elements.
+ * @param out    First element of the run.
+ * @param stride Stride of the run, in elements.
+ * @param in     The `n` doubles to convert (see `lwt_dtype_store` for the rounding).
+ */
+void lwt_cast_store(TensorDType dtype, size_t n, void* out, ptrdiff_t stride, const double* in) {
+
+    switch(dtype) {
+        case TENSOR_F64: for(size_t i = 0; i < n; i ++) ((double*) out)[i * stride] = in[i]; break;
+        case TENSOR_F32: for(size_t i = 0; i < n; i ++) ((float*) out)[i * stride] = (float) in[i]; break;
+        default: for(size_t i = 0; i < n; i ++) lwt_dtype_store(dtype, out, i * stride, in[i]); break;
+    }
+}
+
+typedef struct {
+    TensorIterator it;
+    Tensor out, in;
+} LwtCastJob;
+
+void lwt_cast_task(void* context, size_t begin, size_t end, int thread) {
+
+    (void) thread;
+    LwtCastJob* job = (LwtCastJob*) context;
+    TensorIterator it = job->it;
+    size_t size = tensor_dtype_size(job->in.dtype);
+
+    while(begin < end) {
+
+        tensor_iterator_seek(&it, begin);
+
+        size_t n = it.shape[0] - it.index[0];
+        n = n < end - begin ? n : end - begin;
+
+        char* out = (char*) lwt_element(job->out, it.offsets[0]);
+        const char* in = (const char*) lwt_element(job->in, it.offsets[1]);
+        ptrdiff_t so = it.strides[0][0], si = it.strides[0][1];
+
+        if(job->out.dtype != job->in.dtype) {
+
+            double buffer[LWT_CAST_BLOCK];
+            for(size_t i = 0; i < n; i += LWT_CAST_BLOCK) {
+
+                size_t count = n - i < LWT_CAST_BLOCK ? n - i : LWT_CAST_BLOCK;
+                lwt_cast_load(job->in.dtype, count, buffer, in + i * si * (ptrdiff_t) size, si);
+                lwt_cast_store(job->out.dtype, count, out + i * so * (ptrdiff_t) tensor_dtype_size(job->out.dtype), so, buffer);
+            }
+        }
+        else if(so == 1 && si == 1)
+            memmove(out, in, n * size);
+        else {
+            for(size_t i = 0; i < n; i ++)
+                memcpy(out + i * so * (ptrdiff_t) size, in + i * si * (ptrdiff_t) size, size);
+        }
+
+        begin += n;
+    }
+}
+
+/**
+ * Converts the elements of a tensor into a preallocated tensor of any element type.
+ *
+ * @param out Destination tensor (or view), of any type.
+ * @param in  Source tensor (or view), of any type; its shape must broadcast to the shape of `out`.
+ * @return    TENSOR_OK, or TENSOR_ERROR_SHAPE if `in` does not broadcast to `out`.
+ *
+ * Note: Values go through a double, which holds every type exactly. Floating types round
+ * to nearest even and overflow to infinity; integer types round half away from zero and
+ * saturate, NaN becoming 0. Tensors of the same type are copied as raw elements.
+ */
+TensorStatus tensor_cast_into(Tensor out, Tensor in) {
+
+    LwtCastJob job;
+    job.out = out;
+
+    if(lwt_broadcast_operand(in, out, &job.in) != TENSOR_OK)
+        return TENSOR_ERROR_SHAPE;
+
+    Tensor operands[2] = { out, job.in };
+
+    if(tensor_iterator_init(&job.it, 2, operands))
+        lwt_parallel_for(get_length(out), LWT_PARALLEL_GRAIN, lwt_cast_task, &job);
+
+    return TENSOR_OK;
+}
+
+TensorStatus copy_into(Tensor out, Tensor in) {
+
+    if(out.dtype != TENSOR_NATIVE || in.dtype != TENSOR_NATIVE)
+        return tensor_cast_into(out, in);
+
+    return lwt_apply(lwt_kernel_copy, out, in, in, 0.0);
+}
+
+/**
+ * Checks whether a tensor is laid out densely with the first index varying fastest.
+ *
+ * @param tensor The tensor (or view) to check.
+ * @return       1 if the components are contiguous in canonical order, 0 otherwise.
+ */
+int tensor_is_contiguous(Tensor tensor) {
+
+    ptrdiff_t stride = 1;
+    for(unsigned int i = 0; i < tensor.rank; i ++) {
+
+        if(tensor.shape[i] != 1 && tensor.strides[i] != stride)
+            return 0;
+
+        stride *= tensor.shape[i];
+    }
+
+    return 1;
+}
+
+/**
+ * Creates a view header that shares the components of a tensor.
+ *
+ * @param tensor The parent tensor.
+ * @param rank   Rank of the view.
+ * @return       A view with an allocated (uninitialized) shape of `rank` entries.
+ */
+Tensor lwt_create_view(Tensor tensor, unsigned int rank) {
+
+    LWT_OP_ENTER("view");
+
+    Tensor view;
+    view.rank = rank;
+    view.shape = lwt_storage_alloc_shape(rank);
+    view.components = tensor.components;
+    view.flags = lwt_storage_flags() & TENSOR_OWNS_SHAPE;
+    view.dtype = tensor.dtype;
+
+    LWT_OP_LEAVE();
+    return view;
+}
+
+/**
+ * Creates a view of a range of indices along one axis.
+ *
+ * @param tensor The tensor to slice.
+ * @param axis   The axis to slice.
+ * @param start  First index of the range.
+ * @param stop   One past the last index of the range (before the first index for negative steps).
+ * @param step   Distance between selected indices (non-zero, may be negative).
+ * @return       A view sharing the components of `tensor`.
+ *
+ * Note: The view must be released with `destroy_tensor`, which leaves the parent components untouched.
+ */
+Tensor tensor_slice(Tensor tensor, unsigned int axis, int start, int stop, int step) {
+
+    Tensor view = lwt_create_view(tensor, tensor.rank);
+
+    for(unsigned int i = 0; i < tensor.rank; i ++) {
+        view.shape[i] = tensor.shape[i];
+        view.strides[i] = tensor.strides[i];
+    }
+
+    int extent = 0;
+    if(step > 0 && stop > start)
+        extent = (stop - start + step - 1) / step;
+    else if(step < 0 && start > stop)
+        extent = (start - stop - step - 1) / -step;
+
+    view.shape[axis] = extent;
+    view.strides[axis] = tensor.strides[axis] * step;
+    if(extent > 0)
+        view.components = lwt_element(tensor, start * tensor.strides[axis]);
+
+    return view;
+}
+
+/**
+ * Creates a view of one index along an axis, removing that axis.
+ *
+ * @param tensor The tensor to index.
+ * @param axis   The axis to fix.
+ * @param index  The index along `axis`.
+ * @return       A view of rank `tensor.rank - 1` sharing the components of `tensor`
+ *               (e.g. a row or a column of a matrix).
+ */
+Tensor tensor_select(Tensor tensor, unsigned int axis, int index) {
+
+    Tensor view = lwt_create_view(tensor, tensor.rank - 1);
+    view.components = lwt_element(tensor, index * tensor.strides[axis]);
+
+    for(unsigned int i = 0, j = 0; i < tensor.rank; i ++) {
+
+        if(i == axis)
+            continue;
+
+        view.shape[j] = tensor.shape[i];
+        view.strides[j] = tensor.strides[i];
+        j ++;
+    }
+
+    return view;
+}
+
+/**
+ * Creates a view with permuted axes.
+ *
+ * @param tensor The tensor to permute.
+ * @param axes   Array of `rank` entries: axis i of the view is axis axes[i] of `tensor`.
+ * @return       A view sharing the components of `tensor`.
+ */
+Tensor tensor_permute_view(Tensor tensor, const int* axes) {
 
-typedef struct Tensor Tensor;
+    Tensor view = lwt_create_view(tensor, tensor.rank);
+
+    for(unsigned int i = 0; i < tensor.rank; i ++) {
+        view.shape[i] = tensor.shape[axes[i]];
+        view.strides[i] = tensor.strides[axes[i]];
+    }
+
+    return view;
+}
 
 /**
- * Creates a tensor of a given rank and shape.
+ * Creates a transposed view that reverses the order of the axes.
  *
- * @param rank The number of dimensions (axes) of the tensor.
- * @param ...  A variable number of integers specifying the size of each dimension.
- * @return     A Tensor structure with allocated memory and components initialized to 0.0.
+ * @param tensor The tensor to transpose.
+ * @return       A view sharing the components of `tensor`; for a matrix, element (i, j) of the view is (j, i).
  */
-Tensor create_tensor(unsigned int rank, ...) {
+Tensor tensor_transpose_view(Tensor tensor) {
 
-    Tensor tensor;
+    Tensor view = lwt_create_view(tensor, tensor.rank);
+
+    for(unsigned int i = 0; i < tensor.rank; i ++) {
+        view.shape[i] = tensor.shape[tensor.rank - 1 - i];
+        view.strides[i] = tensor.strides[tensor.rank - 1 - i];
+    }
+
+    return view;
+}
+
+/**
+ * Creates a view with a different shape over the same elements.
+ *
+ * @param tensor The tensor to reshape.
+ * @param rank   The rank of the view.
+ * @param ...    A variable number of integers specifying the size of each dimension.
+ * @return       A view sharing the components of `tensor`. If the strides of `tensor`
+ *               cannot express the new shape without copying, the returned view has
+ *               NULL components; reshape `tensor_contiguous(tensor)` instead.
+ *
+ * Note: Elements are matched in canonical order (first index fastest). The total
+ * number of elements must not change; a shape of another length also gives a view
+ * with NULL components, and a rank above LWT_MAX_RANK gives the empty tensor.
+ */
+Tensor tensor_reshape_view(Tensor tensor, unsigned int rank, ...) {
+
+    if(rank > LWT_MAX_RANK)
+        return lwt_empty_tensor();
+
+    Tensor view = lwt_create_view(tensor, rank);
 
     va_list args;
     va_start(args, rank);
+    for(unsigned int i = 0; i < rank; i ++)
+        view.shape[i] = va_arg(args, int);
+    va_end(args);
 
-    size_t length = 1;
-    int* shape = (int*) malloc(sizeof(int) * rank);
+    if(get_length(view) != get_length(tensor)) {
+        view.components = NULL;
+        return view;
+    }
 
-    for(int i = 0; i < rank; i ++) {
-        int s = va_arg(args, int);
-        length *= s;
-        shape[i] = s;
+    if(get_length(tensor) == 0) {
+        compute_strides(&view);
+        return view;
     }
 
-    va_end(args);
+    // Axes of extent 1 carry no layout information, drop them from the source
+    int old_shape[LWT_MAX_RANK];
+    ptrdiff_t old_strides[LWT_MAX_RANK];
+    unsigned int old_rank = 0;
 
-    tensor.rank = rank;
-    tensor.shape = shape;
-    tensor.components = (ttype*) malloc(sizeof(ttype) * length);
+    for(unsigned int i = 0; i < tensor.rank; i ++) {
+        if(tensor.shape[i] != 1) {
+            old_shape[old_rank] = tensor.shape[i];
+            old_strides[old_rank] = tensor.strides[i];
+            old_rank ++;
+        }
+    }
 
-    for(size_t i = 0; i < length; i ++) 
-        tensor.components[i] = 0.0;
+    // Match groups of old and new axes with equal element counts; inside a group the
+    // old axes must be chained contiguously so the new axes can be strided over them
+    unsigned int old_axis = 0, new_axis = 0;
+    while(new_axis < rank) {
 
-    return tensor;
+        if(view.shape[new_axis] == 1 || old_axis == old_rank) {
+            view.strides[new_axis] = new_axis > 0 ? view.strides[new_axis - 1] * view.shape[new_axis - 1] : 1;
+            new_axis ++;
+            continue;
+        }
+
+        unsigned int old_first = old_axis, new_first = new_axis;
+        size_t old_count = old_shape[old_axis ++];
+        size_t new_count = view.shape[new_axis ++];
+
+        while(old_count != new_count) {
+            if(old_count < new_count)
+                old_count *= old_shape[old_axis ++];
+            else
+                new_count *= view.shape[new_axis ++];
+        }
+
+        for(unsigned int k = old_first; k + 1 < old_axis; k ++) {
+            if(old_strides[k + 1] != old_strides[k] * old_shape[k]) {
+                view.components = NULL;
+                return view;
+            }
+        }
+
+        ptrdiff_t stride = old_strides[old_first];
+        for(unsigned int k = new_first; k < new_axis; k ++) {
+            view.strides[k] = stride;
+            stride *= view.shape[k];
+        }
+    }
+
+    return view;
 }
 
 /**
- * Creates a tensor using a pointer to the shape array.
+ * Returns a contiguous version of a tensor, copying only when required.
  *
- * @param rank  The number of dimensions of the tensor.
- * @param shape A pointer to an array of integers defining the size of each dimension.
- * @return      A Tensor structure with allocated components initialized to 0.0.
+ * @param tensor The tensor (or view).
+ * @return       A view of `tensor` if it is already contiguous, otherwise a new contiguous copy.
  *
- * Note: The `shape` pointer is not copied; it is assigned directly. Be cautious with ownership and lifetime.
+ * Note: Release the result with `destroy_tensor` in both cases.
  */
-Tensor create_tensor_byptr(unsigned rank, int* shape) {
-
-    Tensor tensor;
-
-    size_t length = 1;
-    for(int i = 0; i < rank; i ++) length *= shape[i];
+Tensor tensor_contiguous(Tensor tensor) {
 
-    tensor.rank = rank;
-    tensor.shape = shape;
-    tensor.components = (ttype*) malloc(sizeof(ttype) * length);
+    if(!tensor_is_contiguous(tensor))
+        return create_copy(tensor);
 
-    for(size_t i = 0; i < length; i ++) 
-        tensor.components[i] = 0.0;
+    Tensor view = lwt_create_view(tensor, tensor.rank);
+    for(unsigned int i = 0; i < tensor.rank; i ++) {
+        view.shape[i] = tensor.shape[i];
+        view.strides[i] = tensor.strides[i];
+    }
 
-    return tensor;
+    return view;
 }
 
 /**
- * Creates a deep copy of a given tensor.
+ * Creates a contiguous tensor of a given shape, leaving the components uninitialized.
  *
- * @param tensor The source Tensor to be copied.
- * @return       A new Tensor structure with its own allocated shape and component arrays.
+ * @param rank  Number of dimensions.
+ * @param shape Extent of each dimension; the array is copied.
+ * @return      A new tensor owning its shape and components, or the empty tensor if `rank`
+ *              exceeds LWT_MAX_RANK.
  */
-Tensor create_copy(Tensor tensor) {
+Tensor lwt_create_shaped(unsigned int rank, const int* shape) {
 
-    Tensor tensor_copy;
-    tensor_copy.rank = tensor.rank;
+    if(rank > LWT_MAX_RANK)
+        return lwt_empty_tensor();
 
-    size_t length = 1;
-    int* shape = (int*) malloc(sizeof(int) * tensor.rank);
+    Tensor result;
+    result.rank = rank;
+    result.shape = lwt_storage_alloc_shape(rank);
 
-    for(int i = 0; i < tensor.rank; i ++) {
-        shape[i] = tensor.shape[i];
-        length *= tensor.shape[i];
-    }
+    for(unsigned int i = 0; i < rank; i ++)
+        result.shape[i] = shape[i];
 
-    tensor_copy.shape = shape;
-    tensor_copy.components = (ttype*) malloc(sizeof(ttype) * length);
+    result.components = lwt_storage_alloc_components(get_length(result));
+    result.flags = lwt_storage_flags();
+    result.dtype = TENSOR_NATIVE;
+    compute_strides(&result);
 
-    for(int i = 0; i < length; i ++)
-        tensor_copy.components[i] = tensor.components[i];
+    return result;
+}
 
-    return tensor_copy;
+/**
+ * Creates a contiguous tensor with the shape of another one, leaving the components uninitialized.
+ *
+ * @param tensor The tensor whose shape is copied.
+ * @return       A new tensor owning its shape and components.
+ *
+ * Note: Used by the allocating operations, which overwrite every component anyway.
+ */
+Tensor lwt_create_like(Tensor tensor) {
+    return lwt_create_shaped(tensor.rank, tensor.shape);
 }
 
 /**
- * Sets the value of a tensor element at a specified multi-dimensional index.
+ * Creates an uninitialized contiguous tensor with the broadcast shape of two tensors.
  *
- * @param tensor The tensor to be modified.
- * @param value  The value to assign to the specified position.
- * @param ...    A sequence of integers indicating the index in each dimension.
+ * @param lhs The first tensor.
+ * @param rhs The second tensor.
+ * @return    A new tensor, or the empty tensor if the shapes do not broadcast.
+ */
+Tensor lwt_create_broadcast(Tensor lhs, Tensor rhs) {
+
+    unsigned int rank;
+    int shape[LWT_MAX_RANK];
+
+    if(lwt_broadcast_shape(lhs, rhs, &rank, shape) != TENSOR_OK)
+        return lwt_empty_tensor();
+
+    return lwt_create_shaped(rank, shape);
+}
+
+/**
+ * Creates a tensor of a given element type, with components initialized to zero.
  *
- * Note: This function assumes row-major ordering and does not perform bounds checking.
+ * @param dtype The element type.
+ * @param rank  Number of dimensions.
+ * @param shape Extent of each dimension; the array is copied.
+ * @return      A new contiguous tensor owning its shape and components, or the empty tensor
+ *              if `rank` exceeds LWT_MAX_RANK.
  */
-void set_value(Tensor tensor, ttype value, ...) {
+Tensor create_tensor_dtype(TensorDType dtype, unsigned int rank, const int* shape) {
 
-    va_list args;
-    va_start(args, value);
+    if(rank > LWT_MAX_RANK)
+        return lwt_empty_tensor();
 
-    int index = 0;
-    for(int i = 0; i < tensor.rank; i ++) {
+    LWT_OP_ENTER("create_tensor");
 
-        int subIndex = va_arg(args, int);
-        for(int j = 0; j < i; j ++) {
-            subIndex *= tensor.shape[j];
-        }
+    Tensor tensor;
+    tensor.rank = rank;
+    tensor.shape = lwt_storage_alloc_shape(rank);
 
-        index += subIndex;
-    }
+    for(unsigned int i = 0; i < rank; i ++)
+        tensor.shape[i] = shape[i];
 
-    tensor.components[index] = value;
-    va_end(args);
+    size_t bytes = tensor_dtype_size(dtype) * get_length(tensor);
+
+    tensor.components = lwt_storage_alloc_bytes(bytes);
+    tensor.flags = lwt_storage_flags();
+    tensor.dtype = dtype;
+    compute_strides(&tensor);
+
+    memset(tensor.components, 0, bytes);
+
+    LWT_OP_LEAVE();
+    return tensor;
 }
 
 /**
- * Retrieves the value of a tensor element at a specified multi-dimensional index.
+ * Converts a tensor to another element type.
  *
- * @param tensor The tensor to read from.
- * @param ...    A sequence of integers indicating the index in each dimension.
- * @return       The value at the specified position.
+ * @param tensor The tensor (or view) to convert.
+ * @param dtype  The element type of the result.
+ * @return       A new contiguous tensor of type `dtype` holding the converted elements.
  *
- * Note: This function assumes row-major ordering and does not perform bounds checking.
+ * Example: `tensor_cast(activations, TENSOR_F16)` halves the storage of float activations;
+ * cast back to TENSOR_NATIVE to compute with them.
  */
-ttype get_value(Tensor tensor, ...) {
+Tensor tensor_cast(Tensor tensor, TensorDType dtype) {
 
-    va_list args;
-    va_start(args, tensor);
+    LWT_OP_ENTER("tensor_cast");
 
-    int index = 0;
-    for(int i = 0; i < tensor.rank; i ++) {
+    Tensor result;
+    result.rank = tensor.rank;
+    result.shape = lwt_storage_alloc_shape(tensor.rank);
 
-        int subIndex = va_arg(args, int);
-        for(int j = 0; j < i; j ++) {
-            subIndex *= tensor.shape[j];
-        }
+    for(unsigned int i = 0; i < tensor.rank; i ++)
+        result.shape[i] = tensor.shape[i];
 
-        index += subIndex;
-    }
+    result.components = lwt_storage_alloc_bytes(tensor_dtype_size(dtype) * get_length(result));
+    result.flags = lwt_storage_flags();
+    result.dtype = dtype;
+    compute_strides(&result);
 
-    ttype value = tensor.components[index];
-    va_end(args);
+    tensor_cast_into(result, tensor);
 
-    return value;
+    LWT_OP_LEAVE();
+    return result;
 }
 
 /**
- * Calculates the total number of elements in a tensor.
+ * Adds two tensors element-wise into a preallocated tensor.
  *
- * @param tensor The tensor whose length is to be computed.
- * @return       The product of all dimensions (i.e., the number of components).
+ * @param out Output tensor (or view) receiving `lhs[i] + rhs[i]`; it may be `lhs` or `rhs`.
+ * @param lhs The first operand tensor.
+ * @param rhs The second operand tensor.
+ * @return    TENSOR_OK, or TENSOR_ERROR_SHAPE if `lhs` or `rhs` does not broadcast to `out`.
+ *
+ * Note: Performs no allocation. `lhs` and `rhs` are broadcast to the shape of `out`.
  */
-size_t get_length(Tensor tensor) {
-
-    size_t length = 1;
-    for(int i = 0; i < tensor.rank; i ++) 
-        length *= tensor.shape[i];
+TensorStatus sum_into(Tensor out, Tensor lhs, Tensor rhs) {
+    return lwt_apply(lwt_kernel_sum, out, lhs, rhs, 0.0);
+}
 
-    return length;
+/**
+ * Adds two tensors element-wise in place, storing `lhs[i] + rhs[i]` in `lhs`.
+ *
+ * @param lhs The first operand tensor, overwritten with the result.
+ * @param rhs The second operand tensor, broadcast to the shape of `lhs`.
+ * @return    TENSOR_OK, or TENSOR_ERROR_SHAPE if `rhs` does not broadcast to `lhs`.
+ */
+TensorStatus sum_inplace(Tensor lhs, Tensor rhs) {
+    return lwt_apply(lwt_kernel_sum, lhs, lhs, rhs, 0.0);
 }
 
 /**
@@ -213,24 +1778,47 @@ size_t get_length(Tensor tensor) {
  * @param rhs The second operand tensor.
  * @return    A new tensor containing the element-wise sum of `lhs` and `rhs`.
  *
- * Note: Both tensors must have the same shape. No shape checking is performed.
+ * Note: The shapes are broadcast against each other (trailing axes aligned, extent-1
+ * axes expanded). If they are incompatible, or an operand is not of the native element
+ * type, the empty tensor is returned.
  */
 Tensor sum(Tensor lhs, Tensor rhs) {
 
-    size_t length = 1;
-    int* shape = (int*) malloc(sizeof(int) * lhs.rank);
+    LWT_OP_ENTER("sum");
 
-    for(int i = 0; i < lhs.rank; i ++) {
-        shape[i] = lhs.shape[i];
-        length *= lhs.shape[i];
+    Tensor tensor = lwt_create_broadcast(lhs, rhs);
+    if(tensor.shape != NULL && sum_into(tensor, lhs, rhs) != TENSOR_OK) {
+        destroy_tensor(tensor);
+        tensor = lwt_empty_tensor();
     }
 
-    Tensor tensor = create_tensor_byptr(lhs.rank, shape);
+    LWT_OP_LEAVE();
+    return tensor;
+}
 
-    for(int i = 0; i < length; i ++)
-        tensor.components[i] = lhs.components[i] + rhs.components[i];
+/**
+ * Adds a scalar to each element of a tensor into a preallocated tensor.
+ *
+ * @param out    Output tensor (or view) receiving `lhs[i] + scalar`; it may be `lhs`.
+ * @param lhs    The input tensor.
+ * @param scalar The scalar operand.
+ * @return       TENSOR_OK, or TENSOR_ERROR_SHAPE if `lhs` does not broadcast to `out`.
+ *
+ * Note: Performs no allocation. `lhs` is broadcast to the shape of `out`.
+ */
+TensorStatus sum_scalar_into(Tensor out, Tensor lhs, ttype scalar) {
+    return lwt_apply(lwt_kernel_sum_scalar, out, lhs, lhs, scalar);
+}
 
-    return tensor;
+/**
+ * Adds a scalar to each element of a tensor in place.
+ *
+ * @param lhs    The input tensor, overwritten with `lhs[i] + scalar`.
+ * @param scalar The scalar operand.
+ * @return       TENSOR_OK, or TENSOR_ERROR_DTYPE if `lhs` is not of the native element type.
+ */
+TensorStatus sum_scalar_inplace(Tensor lhs, ttype scalar) {
+    return lwt_apply(lwt_kernel_sum_scalar, lhs, lhs, lhs, scalar);
 }
 
 /**
@@ -238,24 +1826,46 @@ Tensor sum(Tensor lhs, Tensor rhs) {
  *
  * @param lhs    The input tensor.
  * @param scalar The scalar value to add.
- * @return       A new tensor where each element is `lhs[i] + scalar`.
+ * @return       A new tensor where each element is `lhs[i] + scalar`,
+ *               or the empty tensor if `lhs` is not of the native element type.
  */
 Tensor sum_scalar(Tensor lhs, ttype scalar) {
 
-    size_t length = 1;
-    int* shape = (int*) malloc(sizeof(int) * lhs.rank);
+    LWT_OP_ENTER("sum_scalar");
 
-    for(int i = 0; i < lhs.rank; i ++) {
-        shape[i] = lhs.shape[i];
-        length *= lhs.shape[i];
+    Tensor tensor = lwt_create_like(lhs);
+    if(sum_scalar_into(tensor, lhs, scalar) != TENSOR_OK) {
+        destroy_tensor(tensor);
+        tensor = lwt_empty_tensor();
     }
 
-    Tensor tensor = create_tensor_byptr(lhs.rank, shape);
+    LWT_OP_LEAVE();
+    return tensor;
+}
 
-    for(int i = 0; i < length; i ++)
-        tensor.components[i] = lhs.components[i] + scalar;
+/**
+ * Subtracts one tensor from another element-wise into a preallocated tensor.
+ *
+ * @param out Output tensor (or view) receiving `lhs[i] - rhs[i]`; it may be `lhs` or `rhs`.
+ * @param lhs The first operand tensor.
+ * @param rhs The second operand tensor.
+ * @return    TENSOR_OK, or TENSOR_ERROR_SHAPE if `lhs` or `rhs` does not broadcast to `out`.
+ *
+ * Note: Performs no allocation. `lhs` and `rhs` are broadcast to the shape of `out`.
+ */
+TensorStatus subtract_into(Tensor out, Tensor lhs, Tensor rhs) {
+    return lwt_apply(lwt_kernel_subtract, out, lhs, rhs, 0.0);
+}
 
-    return tensor;
+/**
+ * Subtracts one tensor from another element-wise in place, storing `lhs[i] - rhs[i]` in `lhs`.
+ *
+ * @param lhs The first operand tensor, overwritten with the result.
+ * @param rhs The second operand tensor, broadcast to the shape of `lhs`.
+ * @return    TENSOR_OK, or TENSOR_ERROR_SHAPE if `rhs` does not broadcast to `lhs`.
+ */
+TensorStatus subtract_inplace(Tensor lhs, Tensor rhs) {
+    return lwt_apply(lwt_kernel_subtract, lhs, lhs, rhs, 0.0);
 }
 
 /**
@@ -265,24 +1875,47 @@ Tensor sum_scalar(Tensor lhs, ttype scalar) {
  * @param rhs The subtrahend tensor.
  * @return    A new tensor containing the result of `lhs[i] - rhs[i]` for each element.
  *
- * Note: Both tensors must have the same shape. No shape checking is performed.
+ * Note: The shapes are broadcast against each other (trailing axes aligned, extent-1
+ * axes expanded). If they are incompatible, or an operand is not of the native element
+ * type, the empty tensor is returned.
  */
 Tensor subtract(Tensor lhs, Tensor rhs) {
 
-    size_t length = 1;
-    int* shape = (int*) malloc(sizeof(int) * lhs.rank);
+    LWT_OP_ENTER("subtract");
 
-    for(int i = 0; i < lhs.rank; i ++) {
-        shape[i] = lhs.shape[i];
-        length *= lhs.shape[i];
+    Tensor tensor = lwt_create_broadcast(lhs, rhs);
+    if(tensor.shape != NULL && subtract_into(tensor, lhs, rhs) != TENSOR_OK) {
+        destroy_tensor(tensor);
+        tensor = lwt_empty_tensor();
     }
 
-    Tensor tensor = create_tensor_byptr(lhs.rank, shape);
+    LWT_OP_LEAVE();
+    return tensor;
+}
 
-    for(int i = 0; i < length; i ++)
-        tensor.components[i] = lhs.components[i] - rhs.components[i];
+/**
+ * Subtracts a scalar from each element of a tensor into a preallocated tensor.
+ *
+ * @param out    Output tensor (or view) receiving `lhs[i] - scalar`; it may be `lhs`.
+ * @param lhs    The input tensor.
+ * @param scalar The scalar operand.
+ * @return       TENSOR_OK, or TENSOR_ERROR_SHAPE if `lhs` does not broadcast to `out`.
+ *
+ * Note: Performs no allocation. `lhs` is broadcast to the shape of `out`.
+ */
+TensorStatus subtract_scalar_into(Tensor out, Tensor lhs, ttype scalar) {
+    return lwt_apply(lwt_kernel_subtract_scalar, out, lhs, lhs, scalar);
+}
 
-    return tensor;
+/**
+ * Subtracts a scalar from each element of a tensor in place.
+ *
+ * @param lhs    The input tensor, overwritten with `lhs[i] - scalar`.
+ * @param scalar The scalar operand.
+ * @return       TENSOR_OK, or TENSOR_ERROR_DTYPE if `lhs` is not of the native element type.
+ */
+TensorStatus subtract_scalar_inplace(Tensor lhs, ttype scalar) {
+    return lwt_apply(lwt_kernel_subtract_scalar, lhs, lhs, lhs, scalar);
 }
 
 /**
@@ -290,24 +1923,46 @@ Tensor subtract(Tensor lhs, Tensor rhs) {
  *
  * @param lhs    The input tensor.
  * @param scalar The scalar value to subtract.
- * @return       A new tensor where each element is `lhs[i] - scalar`.
+ * @return       A new tensor where each element is `lhs[i] - scalar`,
+ *               or the empty tensor if `lhs` is not of the native element type.
  */
 Tensor subtract_scalar(Tensor lhs, ttype scalar) {
 
-    size_t length = 1;
-    int* shape = (int*) malloc(sizeof(int) * lhs.rank);
+    LWT_OP_ENTER("subtract_scalar");
 
-    for(int i = 0; i < lhs.rank; i ++) {
-        shape[i] = lhs.shape[i];
-        length *= lhs.shape[i];
+    Tensor tensor = lwt_create_like(lhs);
+    if(subtract_scalar_into(tensor, lhs, scalar) != TENSOR_OK) {
+        destroy_tensor(tensor);
+        tensor = lwt_empty_tensor();
     }
 
-    Tensor tensor = create_tensor_byptr(lhs.rank, shape);
+    LWT_OP_LEAVE();
+    return tensor;
+}
 
-    for(int i = 0; i < length; i ++)
-        tensor.components[i] = lhs.components[i] - scalar;
+/**
+ * Divides two tensors element-wise into a preallocated tensor.
+ *
+ * @param out Output tensor (or view) receiving `lhs[i] / rhs[i]`; it may be `lhs` or `rhs`.
+ * @param lhs The first operand tensor.
+ * @param rhs The second operand tensor.
+ * @return    TENSOR_OK, or TENSOR_ERROR_SHAPE if `lhs` or `rhs` does not broadcast to `out`.
+ *
+ * Note: Performs no allocation. `lhs` and `rhs` are broadcast to the shape of `out`.
+ */
+TensorStatus divide_into(Tensor out, Tensor lhs, Tensor rhs) {
+    return lwt_apply(lwt_kernel_divide, out, lhs, rhs, 0.0);
+}
 
-    return tensor;
+/**
+ * Divides two tensors element-wise in place, storing `lhs[i] / rhs[i]` in `lhs`.
+ *
+ * @param lhs The first operand tensor, overwritten with the result.
+ * @param rhs The second operand tensor, broadcast to the shape of `lhs`.
+ * @return    TENSOR_OK, or TENSOR_ERROR_SHAPE if `rhs` does not broadcast to `lhs`.
+ */
+TensorStatus divide_inplace(Tensor lhs, Tensor rhs) {
+    return lwt_apply(lwt_kernel_divide, lhs, lhs, rhs, 0.0);
 }
 
 /**
@@ -317,24 +1972,47 @@ Tensor subtract_scalar(Tensor lhs, ttype scalar) {
  * @param rhs The denominator tensor.
  * @return    A new tensor where each element is `lhs[i] / rhs[i]`.
  *
- * Note: Both tensors must have the same shape. No shape checking or division-by-zero handling is performed.
+ * Note: The shapes are broadcast against each other (trailing axes aligned, extent-1
+ * axes expanded). If they are incompatible, or an operand is not of the native element
+ * type, the empty tensor is returned. No division-by-zero handling is performed.
  */
 Tensor divide(Tensor lhs, Tensor rhs) {
 
-    size_t length = 1;
-    int* shape = (int*) malloc(sizeof(int) * lhs.rank);
+    LWT_OP_ENTER("divide");
 
-    for(int i = 0; i < lhs.rank; i ++) {
-        shape[i] = lhs.shape[i];
-        length *= lhs.shape[i];
+    Tensor tensor = lwt_create_broadcast(lhs, rhs);
+    if(tensor.shape != NULL && divide_into(tensor, lhs, rhs) != TENSOR_OK) {
+        destroy_tensor(tensor);
+        tensor = lwt_empty_tensor();
     }
 
-    Tensor tensor = create_tensor_byptr(lhs.rank, shape);
+    LWT_OP_LEAVE();
+    return tensor;
+}
 
-    for(int i = 0; i < length; i ++)
-        tensor.components[i] = lhs.components[i] / rhs.components[i];
+/**
+ * Divides each element of a tensor by a scalar into a preallocated tensor.
+ *
+ * @param out    Output tensor (or view) receiving `lhs[i] / scalar`; it may be `lhs`.
+ * @param lhs    The input tensor.
+ * @param scalar The scalar operand.
+ * @return       TENSOR_OK, or TENSOR_ERROR_SHAPE if `lhs` does not broadcast to `out`.
+ *
+ * Note: Performs no allocation. `lhs` is broadcast to the shape of `out`.
+ */
+TensorStatus divide_scalar_into(Tensor out, Tensor lhs, ttype scalar) {
+    return lwt_apply(lwt_kernel_divide_scalar, out, lhs, lhs, scalar);
+}
 
-    return tensor;
+/**
+ * Divides each element of a tensor by a scalar in place.
+ *
+ * @param lhs    The input tensor, overwritten with `lhs[i] / scalar`.
+ * @param scalar The scalar operand.
+ * @return       TENSOR_OK, or TENSOR_ERROR_DTYPE if `lhs` is not of the native element type.
+ */
+TensorStatus divide_scalar_inplace(Tensor lhs, ttype scalar) {
+    return lwt_apply(lwt_kernel_divide_scalar, lhs, lhs, lhs, scalar);
 }
 
 /**
@@ -342,26 +2020,48 @@ Tensor divide(Tensor lhs, Tensor rhs) {
  *
  * @param lhs    The input tensor.
  * @param scalar The scalar divisor.
- * @return       A new tensor where each element is `lhs[i] / scalar`.
+ * @return       A new tensor where each element is `lhs[i] / scalar`,
+ *               or the empty tensor if `lhs` is not of the native element type.
  *
  * Note: No division-by-zero check is performed.
  */
 Tensor divide_scalar(Tensor lhs, ttype scalar) {
 
-    size_t length = 1;
-    int* shape = (int*) malloc(sizeof(int) * lhs.rank);
+    LWT_OP_ENTER("divide_scalar");
 
-    for(int i = 0; i < lhs.rank; i ++) {
-        shape[i] = lhs.shape[i];
-        length *= lhs.shape[i];
+    Tensor tensor = lwt_create_like(lhs);
+    if(divide_scalar_into(tensor, lhs, scalar) != TENSOR_OK) {
+        destroy_tensor(tensor);
+        tensor = lwt_empty_tensor();
     }
 
-    Tensor tensor = create_tensor_byptr(lhs.rank, shape);
+    LWT_OP_LEAVE();
+    return tensor;
+}
 
-    for(int i = 0; i < length; i ++)
-        tensor.components[i] = lhs.components[i] / scalar;
+/**
+ * Performs the Hadamard (element-wise) product of two tensors into a preallocated tensor.
+ *
+ * @param out Output tensor (or view) receiving `lhs[i] * rhs[i]`; it may be `lhs` or `rhs`.
+ * @param lhs The first operand tensor.
+ * @param rhs The second operand tensor.
+ * @return    TENSOR_OK, or TENSOR_ERROR_SHAPE if `lhs` or `rhs` does not broadcast to `out`.
+ *
+ * Note: Performs no allocation. `lhs` and `rhs` are broadcast to the shape of `out`.
+ */
+TensorStatus hadamard_into(Tensor out, Tensor lhs, Tensor rhs) {
+    return lwt_apply(lwt_kernel_hadamard, out, lhs, rhs, 0.0);
+}
 
-    return tensor;
+/**
+ * Performs the Hadamard (element-wise) product of two tensors in place, storing `lhs[i] * rhs[i]` in `lhs`.
+ *
+ * @param lhs The first operand tensor, overwritten with the result.
+ * @param rhs The second operand tensor, broadcast to the shape of `lhs`.
+ * @return    TENSOR_OK, or TENSOR_ERROR_SHAPE if `rhs` does not broadcast to `lhs`.
+ */
+TensorStatus hadamard_inplace(Tensor lhs, Tensor rhs) {
+    return lwt_apply(lwt_kernel_hadamard, lhs, lhs, rhs, 0.0);
 }
 
 /**
@@ -371,24 +2071,58 @@ Tensor divide_scalar(Tensor lhs, ttype scalar) {
  * @param rhs The second operand tensor.
  * @return    A new tensor containing the result of `lhs[i] * rhs[i]` for each element.
  *
- * Note: Both tensors must have the same shape. No shape checking is performed.
+ * Note: The shapes are broadcast against each other (trailing axes aligned, extent-1
+ * axes expanded). If they are incompatible, or an operand is not of the native element
+ * type, the empty tensor is returned.
  */
 Tensor hadamard(Tensor lhs, Tensor rhs) {
-    
-    size_t length = 1;
-    int* shape = (int*) malloc(sizeof(int) * lhs.rank);
 
-    for(int i = 0; i < lhs.rank; i ++) {
-        shape[i] = lhs.shape[i];
-        length *= lhs.shape[i];
+    LWT_OP_ENTER("hadamard");
+
+    Tensor tensor = lwt_create_broadcast(lhs, rhs);
+    if(tensor.shape != NULL && hadamard_into(tensor, lhs, rhs) != TENSOR_OK) {
+        destroy_tensor(tensor);
+        tensor = lwt_empty_tensor();
     }
 
-    Tensor tensor = create_tensor_byptr(lhs.rank, shape);
+    LWT_OP_LEAVE();
+    return tensor;
+}
 
-    for(int i = 0; i < length; i ++)
-        tensor.components[i] = lhs.components[i] * rhs.components[i];
+typedef struct {
+    TensorIterator it;
+    Tensor lhs, rhs;
+    TensorSumMode mode;
+    TensorSum* partials;
+} LwtDotJob;
 
-    return tensor;
+void lwt_dot_task(void* context, size_t begin, size_t end, int thread) {
+
+    (void) thread;
+    LwtDotJob* job = (LwtDotJob*) context;
+    TensorIterator it = job->it;
+
+    for(size_t chunk = begin; chunk < end; chunk += LWT_PARALLEL_GRAIN) {
+
+        size_t stop = end - chunk < LWT_PARALLEL_GRAIN ? end : chunk + LWT_PARALLEL_GRAIN;
+        TensorSum sum = { 0.0, 0.0 };
+
+        for(size_t position = chunk; position < stop; ) {
+
+            tensor_iterator_seek(&it, position);
+
+            size_t n = it.shape[0] - it.index[0];
+            n = n < stop - position ? n : stop - position;
+
+            lwt_sum_run(job->mode, n,
+                job->lhs.components + it.offsets[0], it.strides[0][0],
+                job->rhs.components + it.offsets[1], it.strides[0][1], &sum);
+
+            position += n;
+        }
+
+        job->partials[chunk / LWT_PARALLEL_GRAIN] = sum;
+    }
 }
 
 /**
@@ -396,49 +2130,98 @@ Tensor hadamard(Tensor lhs, Tensor rhs) {
  *
  * @param lhs The first operand tensor.
  * @param rhs The second operand tensor.
- * @return    The sum of element-wise products of `lhs` and `rhs`.
+ * @return    The sum of element-wise products of `lhs` and `rhs` (0 for tensors without
+ *            elements), or NaN if the shapes differ or an operand is not of the native
+ *            element type.
  *
- * Note: This treats both tensors as flat arrays. Shapes must match.
+ * Note: This treats both tensors as flat arrays. Shapes must match. The products are
+ * accumulated in the mode set by `lwt_set_sum_mode`. Long tensors are summed in
+ * LWT_PARALLEL_GRAIN chunks whose partial sums are combined pairwise in a fixed order,
+ * so the result does not depend on the number of threads.
  */
 ttype dot(Tensor lhs, Tensor rhs) {
 
-    size_t length = 1;
-    int* shape = (int*) malloc(sizeof(int) * lhs.rank);
+    if(lhs.dtype != TENSOR_NATIVE || rhs.dtype != TENSOR_NATIVE || lhs.rank != rhs.rank)
+        return NAN;
+    for(unsigned int i = 0; i < lhs.rank; i ++) {
+        if(lhs.shape[i] != rhs.shape[i])
+            return NAN;
+    }
+
+    LwtDotJob job;
+    job.lhs = lhs;
+    job.rhs = rhs;
+    job.mode = lwt_sum_mode;
+
+    Tensor operands[2] = { lhs, rhs };
+    if(!tensor_iterator_init(&job.it, 2, operands))
+        return 0.0;
+
+    size_t length = get_length(lhs);
+    size_t chunks = (length + LWT_PARALLEL_GRAIN - 1) / LWT_PARALLEL_GRAIN;
 
-    for(int i = 0; i < lhs.rank; i ++) {
-        shape[i] = lhs.shape[i];
-        length *= lhs.shape[i];
+    TensorSum partial = { 0.0, 0.0 };
+    job.partials = chunks > 1 ? (TensorSum*) lwt_malloc(sizeof(TensorSum) * chunks) : &partial;
+
+    lwt_parallel_for(length, LWT_PARALLEL_GRAIN, lwt_dot_task, &job);
+
+    for(size_t step = 1; step < chunks; step *= 2) {
+        for(size_t i = 0; i + step < chunks; i += 2 * step)
+            lwt_sum_merge(&job.partials[i], &job.partials[i + step]);
     }
 
-    ttype sum = 0.0;
-    for(int i = 0; i < length; i ++)
-        sum += lhs.components[i] * rhs.components[i];
+    ttype sum = lwt_sum_result(&job.partials[0]);
+
+    if(chunks > 1)
+        lwt_free(job.partials, sizeof(TensorSum) * chunks);
 
     return sum;
 }
 
+/**
+ * Multiplies each element of a tensor by a scalar into a preallocated tensor.
+ *
+ * @param out    Output tensor (or view) receiving `lhs[i] * scalar`; it may be `lhs`.
+ * @param lhs    The input tensor.
+ * @param scalar The scalar operand.
+ * @return       TENSOR_OK, or TENSOR_ERROR_SHAPE if `lhs` does not broadcast to `out`.
+ *
+ * Note: Performs no allocation. `lhs` is broadcast to the shape of `out`.
+ */
+TensorStatus product_scalar_into(Tensor out, Tensor lhs, ttype scalar) {
+    return lwt_apply(lwt_kernel_product_scalar, out, lhs, lhs, scalar);
+}
+
+/**
+ * Multiplies each element of a tensor by a scalar in place.
+ *
+ * @param lhs    The input tensor, overwritten with `lhs[i] * scalar`.
+ * @param scalar The scalar operand.
+ * @return       TENSOR_OK, or TENSOR_ERROR_DTYPE if `lhs` is not of the native element type.
+ */
+TensorStatus product_scalar_inplace(Tensor lhs, ttype scalar) {
+    return lwt_apply(lwt_kernel_product_scalar, lhs, lhs, lhs, scalar);
+}
+
 /**
  * Multiplies each element of a tensor by a scalar.
  *
  * @param lhs    The input tensor.
  * @param scalar The scalar value to multiply.
- * @return       A new tensor with each element equal to `lhs[i] * scalar`.
+ * @return       A new tensor with each element equal to `lhs[i] * scalar`,
+ *               or the empty tensor if `lhs` is not of the native element type.
  */
 Tensor product_scalar(Tensor lhs, ttype scalar) {
 
-    size_t length = 1;
-    int* shape = (int*) malloc(sizeof(int) * lhs.rank);
+    LWT_OP_ENTER("product_scalar");
 
-    for(int i = 0; i < lhs.rank; i ++) {
-        shape[i] = lhs.shape[i];
-        length *= lhs.shape[i];
+    Tensor tensor = lwt_create_like(lhs);
+    if(product_scalar_into(tensor, lhs, scalar) != TENSOR_OK) {
+        destroy_tensor(tensor);
+        tensor = lwt_empty_tensor();
     }
 
-    Tensor tensor = create_tensor_byptr(lhs.rank, shape);
-
-    for(int i = 0; i < length; i ++)
-        tensor.components[i] = lhs.components[i] * scalar;
-
+    LWT_OP_LEAVE();
     return tensor;
 }
 
@@ -448,8 +2231,16 @@ Tensor product_scalar(Tensor lhs, ttype scalar) {
  * @param tensor The tensor to destroy.
  *
  * Note: Only use this on tensors created via `create_tensor`, `create_tensor_byptr`, or similar functions.
+ * Views only release their own shape; the components stay owned by the parent tensor.
+ * Tensors created from an arena are left alone; `tensor_arena_reset` reclaims them.
  */
 void destroy_tensor(Tensor tensor) {
-    free(tensor.shape);
-    free(tensor.components);
+
+    if(tensor.flags & TENSOR_OWNS_COMPONENTS)
+        lwt_free_aligned(tensor.components, tensor_dtype_size(tensor.dtype) * get_length(tensor));
+
+    if(tensor.flags & TENSOR_SHAPE_FROM_MALLOC)
+        free(tensor.shape);
+    else if(tensor.flags & TENSOR_OWNS_SHAPE)
+        lwt_free(tensor.shape, lwt_shape_bytes(tensor.rank));
 }
\ No newline at end of file
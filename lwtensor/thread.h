@@ -0,0 +1,410 @@
+/*
+  MIT License
+  
+  Copyright (c) 2025 Morcillo Sanz
+  
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+  
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+  
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  SOFTWARE.
+*/
+
+#pragma once
+
+#include <stdlib.h>
+#include <stddef.h>
+#include <stdatomic.h>
+
+#include "alloc.h"
+
+/*
+ * Work is spread over a persistent pool of POSIX threads. Define LWT_NO_THREADS
+ * (implied on MSVC) to run every parallel loop on the calling thread.
+ */
+#if defined(_MSC_VER) && !defined(LWT_NO_THREADS)
+#define LWT_NO_THREADS
+#endif
+
+#ifndef LWT_NO_THREADS
+#include <pthread.h>
+#if !defined(_WIN32)
+#include <unistd.h>
+#endif
+#endif
+
+/*
+ * Number of elements handed out at a time by the element-wise parallel loops.
+ * Tensors shorter than two grains are processed inline by the calling thread.
+ */
+#ifndef LWT_PARALLEL_GRAIN
+#define LWT_PARALLEL_GRAIN 32768
+#endif
+
+/*
+ * Upper bound on the number of threads of a pool.
+ */
+#ifndef LWT_MAX_THREADS
+#define LWT_MAX_THREADS 256
+#endif
+
+/**
+ * Body of a parallel loop.
+ *
+ * @param context Pointer forwarded from `lwt_parallel_for`.
+ * @param begin   First index of the range to process.
+ * @param end     One past the last index of the range.
+ * @param thread  Index of the executing thread, in [0, threads); the caller is thread 0.
+ */
+typedef void (*TensorTask)(void* context, size_t begin, size_t end, int thread);
+
+/**
+ * A persistent pool of worker threads.
+ *
+ * Workers sleep on a condition variable between jobs. Within a job, each thread
+ * (the submitting one included) claims `grain`-sized chunks from a shared atomic
+ * counter until none are left, so faster threads naturally take more chunks.
+ */
+typedef struct {
+    int threads;
+    atomic_size_t next;
+    size_t chunks;
+    size_t count;
+    size_t grain;
+    TensorTask task;
+    void* context;
+    const char* op;
+#ifndef LWT_NO_THREADS
+    pthread_t* workers;
+    int capacity;
+    pthread_mutex_t lock;
+    pthread_cond_t wake;
+    pthread_cond_t done;
+    pthread_mutex_t submit;
+    unsigned long generation;
+    int active;
+    int stop;
+    atomic_int joined;
+#endif
+} TensorThreadPool;
+
+/*
+ * Set while the calling thread runs a chunk, so nested parallel loops run inline.
+ */
+LWT_THREAD_LOCAL int lwt_in_parallel = 0;
+
+/*
+ * Pool attached to the calling thread with `lwt_pool_attach`, overriding the default one.
+ */
+LWT_THREAD_LOCAL TensorThreadPool* lwt_current_pool = NULL;
+
+/**
+ * Claims and runs chunks of the current job until none are left.
+ *
+ * @param pool   The pool.
+ * @param thread Index of the executing thread.
+ */
+void lwt_pool_work(TensorThreadPool* pool, int thread) {
+
+    const char* previous_op = lwt_current_op;
+    int previous_parallel = lwt_in_parallel;
+
+    lwt_current_op = pool->op;
+    lwt_in_parallel = 1;
+
+    for(;;) {
+
+        size_t chunk = atomic_fetch_add_explicit(&pool->next, 1, memory_order_relaxed);
+        if(chunk >= pool->chunks)
+            break;
+
+        size_t begin = chunk * pool->grain;
+        size_t end = pool->count - begin < pool->grain ? pool->count : begin + pool->grain;
+        pool->task(pool->context, begin, end, thread);
+    }
+
+    lwt_current_op = previous_op;
+    lwt_in_parallel = previous_parallel;
+}
+
+#ifndef LWT_NO_THREADS
+
+void* lwt_pool_worker(void* argument) {
+
+    TensorThreadPool* pool = (TensorThreadPool*) argument;
+    int thread = atomic_fetch_add(&pool->joined, 1) + 1;
+    unsigned long seen = 0;
+
+    pthread_mutex_lock(&pool->lock);
+    for(;;) {
+
+        while(!pool->stop && pool->generation == seen)
+            pthread_cond_wait(&pool->wake, &pool->lock);
+        if(pool->stop)
+            break;
+
+        seen = pool->generation;
+        pthread_mutex_unlock(&pool->lock);
+
+        lwt_pool_work(pool, thread);
+
+        pthread_mutex_lock(&pool->lock);
+        if(-- pool->active == 0)
+            pthread_cond_signal(&pool->done);
+    }
+    pthread_mutex_unlock(&pool->lock);
+
+    return NULL;
+}
+
+#endif
+
+/**
+ * Creates a pool of threads.
+ *
+ * @param threads Total number of threads taking part in a job, the submitting
+ *                thread included (so `threads - 1` workers are started). Values
+ *                below 1 use the number of online processors.
+ * @return        The new pool, or NULL if it could not be allocated.
+ *
+ * Note: A pool of one thread runs every job inline.
+ */
+TensorThreadPool* lwt_pool_create(int threads) {
+
+    if(threads < 1) {
+        threads = 1;
+#if !defined(LWT_NO_THREADS) && defined(_SC_NPROCESSORS_ONLN)
+        long online = sysconf(_SC_NPROCESSORS_ONLN);
+        threads = online > 0 ? (int) online : 1;
+#endif
+    }
+    threads = threads < LWT_MAX_THREADS ? threads : LWT_MAX_THREADS;
+
+    TensorThreadPool* pool = (TensorThreadPool*) lwt_malloc(sizeof(TensorThreadPool));
+    if(pool == NULL)
+        return NULL;
+
+    pool->threads = 1;
+    atomic_init(&pool->next, 0);
+    pool->chunks = 0;
+
+#ifndef LWT_NO_THREADS
+    pthread_mutex_init(&pool->lock, NULL);
+    pthread_cond_init(&pool->wake, NULL);
+    pthread_cond_init(&pool->done, NULL);
+    pthread_mutex_init(&pool->submit, NULL);
+    pool->generation = 0;
+    pool->active = 0;
+    pool->stop = 0;
+    atomic_init(&pool->joined, 0);
+
+    pool->capacity = threads - 1;
+    pool->workers = NULL;
+    if(pool->capacity > 0)
+        pool->workers = (pthread_t*) lwt_malloc(sizeof(pthread_t) * pool->capacity);
+
+    for(int i = 0; pool->workers != NULL && i < threads - 1; i ++) {
+        if(pthread_create(&pool->workers[i], NULL, lwt_pool_worker, pool) != 0)
+            break;
+        pool->threads ++;
+    }
+#else
+    (void) threads;
+#endif
+
+    return pool;
+}
+
+/**
+ * Stops the workers of a pool and releases it.
+ *
+ * @param pool The pool (may be NULL). No job may be running on it.
+ */
+void lwt_pool_destroy(TensorThreadPool* pool) {
+
+    if(pool == NULL)
+        return;
+
+#ifndef LWT_NO_THREADS
+    pthread_mutex_lock(&pool->lock);
+    pool->stop = 1;
+    pthread_cond_broadcast(&pool->wake);
+    pthread_mutex_unlock(&pool->lock);
+
+    for(int i = 0; i < pool->threads - 1; i ++)
+        pthread_join(pool->workers[i], NULL);
+
+    if(pool->workers != NULL)
+        lwt_free(pool->workers, sizeof(pthread_t) * pool->capacity);
+
+    pthread_mutex_destroy(&pool->lock);
+    pthread_cond_destroy(&pool->wake);
+    pthread_cond_destroy(&pool->done);
+    pthread_mutex_destroy(&pool->submit);
+#endif
+
+    lwt_free(pool, sizeof(TensorThreadPool));
+}
+
+/*
+ * Process-wide pool used when no pool is attached, created on first use.
+ */
+_Atomic(TensorThreadPool*) lwt_default_pool = NULL;
+atomic_int lwt_default_threads;
+
+#ifndef LWT_NO_THREADS
+pthread_mutex_t lwt_default_pool_lock = PTHREAD_MUTEX_INITIALIZER;
+#endif
+
+/**
+ * Sets the number of threads of the default pool.
+ *
+ * @param threads Number of threads, or 0 for one per online processor (the default,
+ *                unless the LWT_NUM_THREADS environment variable says otherwise).
+ *
+ * Note: The current default pool is torn down, so no operation may be running.
+ */
+void lwt_set_num_threads(int threads) {
+
+#ifndef LWT_NO_THREADS
+    pthread_mutex_lock(&lwt_default_pool_lock);
+#endif
+
+    atomic_store(&lwt_default_threads, threads > 0 ? threads : 0);
+    lwt_pool_destroy(atomic_exchange(&lwt_default_pool, NULL));
+
+#ifndef LWT_NO_THREADS
+    pthread_mutex_unlock(&lwt_default_pool_lock);
+#endif
+}
+
+/**
+ * Returns the pool used by the parallel operations of the calling thread.
+ *
+ * @return The attached pool, or the default pool (created on first use).
+ */
+TensorThreadPool* lwt_pool_current(void) {
+
+    if(lwt_current_pool != NULL)
+        return lwt_current_pool;
+
+    TensorThreadPool* pool = atomic_load_explicit(&lwt_default_pool, memory_order_acquire);
+    if(pool != NULL)
+        return pool;
+
+#ifndef LWT_NO_THREADS
+    pthread_mutex_lock(&lwt_default_pool_lock);
+#endif
+
+    pool = atomic_load(&lwt_default_pool);
+    if(pool == NULL) {
+
+        int threads = atomic_load(&lwt_default_threads);
+        const char* environment = getenv("LWT_NUM_THREADS");
+        if(threads == 0 && environment != NULL)
+            threads = atoi(environment);
+
+        pool = lwt_pool_create(threads);
+        atomic_store_explicit(&lwt_default_pool, pool, memory_order_release);
+    }
+
+#ifndef LWT_NO_THREADS
+    pthread_mutex_unlock(&lwt_default_pool_lock);
+#endif
+
+    return pool;
+}
+
+/**
+ * Makes a pool the one used by the parallel operations of the calling thread.
+ *
+ * @param pool The pool to attach, or NULL to go back to the default pool.
+ * @return     The previously attached pool (or NULL), so attachments can be nested.
+ *
+ * Note: Attaching `lwt_pool_create(1)` makes the following calls single-threaded.
+ */
+TensorThreadPool* lwt_pool_attach(TensorThreadPool* pool) {
+
+    TensorThreadPool* previous = lwt_current_pool;
+    lwt_current_pool = pool;
+
+    return previous;
+}
+
+/**
+ * Returns the number of threads a parallel loop started now would use.
+ *
+ * @return 1 inside a parallel loop or without threads, the pool size otherwise.
+ */
+int lwt_parallel_threads(void) {
+
+    if(lwt_in_parallel)
+        return 1;
+
+    TensorThreadPool* pool = lwt_pool_current();
+    return pool != NULL ? pool->threads : 1;
+}
+
+/**
+ * Runs `task` over [0, count) in chunks of `grain` indices spread over the threads of the current pool.
+ *
+ * @param count   Number of indices.
+ * @param grain   Chunk size; ranges handed to `task` start at multiples of it.
+ * @param task    Loop body.
+ * @param context Pointer forwarded to `task`.
+ *
+ * Note: Loops of fewer than two chunks, nested loops and single-thread pools run
+ * inline as a single `task(context, 0, count, 0)` call. Concurrent submissions to
+ * the same pool are serialized.
+ */
+void lwt_parallel_for(size_t count, size_t grain, TensorTask task, void* context) {
+
+    if(count == 0)
+        return;
+
+    grain = grain > 0 ? grain : 1;
+    TensorThreadPool* pool = lwt_in_parallel || count < 2 * grain ? NULL : lwt_pool_current();
+
+    if(pool == NULL || pool->threads == 1) {
+        task(context, 0, count, 0);
+        return;
+    }
+
+#ifndef LWT_NO_THREADS
+    pthread_mutex_lock(&pool->submit);
+
+    pthread_mutex_lock(&pool->lock);
+    pool->task = task;
+    pool->context = context;
+    pool->count = count;
+    pool->grain = grain;
+    pool->chunks = (count + grain - 1) / grain;
+    pool->op = lwt_current_op;
+    atomic_store_explicit(&pool->next, 0, memory_order_relaxed);
+    pool->active = pool->threads - 1;
+    pool->generation ++;
+    pthread_cond_broadcast(&pool->wake);
+    pthread_mutex_unlock(&pool->lock);
+
+    lwt_pool_work(pool, 0);
+
+    pthread_mutex_lock(&pool->lock);
+    while(pool->active > 0)
+        pthread_cond_wait(&pool->done, &pool->lock);
+    pthread_mutex_unlock(&pool->lock);
+
+    pthread_mutex_unlock(&pool->submit);
+#endif
+}
\ No newline at end of file
@@ -66,12 +66,7 @@ Vector create_vector_from(ttype vec[3]) {
  * @return    The magnitude of the vector.
  */
 ttype norm(Vector vec) {
-
-    ttype sum = 0.0;
-    for(int i = 0; i < vec.shape[0]; i ++)
-        sum += vec.components[i] * vec.components[i];
-
-    return sqrt(sum);
+    return sqrt(dot(vec, vec));
 }
 
 /**
@@ -82,12 +77,14 @@ ttype norm(Vector vec) {
  */
 Vector normalize(Vector vec) {
 
+    LWT_OP_ENTER("normalize");
+
     ttype modulo = norm(vec);
-    Vector vector = create_copy(vec);
+    Vector vector = lwt_create_like(vec);
 
-    for(int i = 0; i < vector.shape[0]; i ++)
-        vector.components[i] /= modulo;
+    divide_scalar_into(vector, vec, modulo);
 
+    LWT_OP_LEAVE();
     return vector;
 }
 
@@ -102,11 +99,348 @@ Vector normalize(Vector vec) {
  */
 Vector cross(Vector u, Vector v) {
 
+    LWT_OP_ENTER("cross");
+
     Vector vector = create_vector(u.shape[0]);
 
-    vector.components[0] = u.components[1] * v.components[2] - u.components[2] * v.components[1];
-    vector.components[1] = u.components[2] * v.components[0] - u.components[0] * v.components[2];
-    vector.components[2] = u.components[0] * v.components[1] - u.components[1] * v.components[0];
+    ttype u0 = *tensor_at1(u, 0), u1 = *tensor_at1(u, 1), u2 = *tensor_at1(u, 2);
+    ttype v0 = *tensor_at1(v, 0), v1 = *tensor_at1(v, 1), v2 = *tensor_at1(v, 2);
 
+    vector.components[0] = u1 * v2 - u2 * v1;
+    vector.components[1] = u2 * v0 - u0 * v2;
+    vector.components[2] = u0 * v1 - u1 * v0;
+
+    LWT_OP_LEAVE();
     return vector;
+}
+
+/*
+ * Batched vector operations over an (N, d) tensor of N d-vectors, one per index of
+ * axis 0. The default layout keeps each component contiguous (structure of arrays),
+ * which the SIMD kernels read directly; other layouts, such as interleaved (x, y, z)
+ * triples from a C-order array or the transposed view of a (d, N) tensor, are gathered
+ * block by block. Blocks are spread over the thread pool.
+ */
+#define LWT_BATCH_BLOCK 256
+
+#ifndef LWT_BATCH_GRAIN
+#define LWT_BATCH_GRAIN 16384
+#endif
+
+enum {
+    LWT_BATCH_CROSS = 0,
+    LWT_BATCH_DOT,
+    LWT_BATCH_NORM,
+    LWT_BATCH_NORMALIZE
+};
+
+/**
+ * Computes the dot products (or norms) of n vectors stored component row by component row,
+ * with the SIMD kernels when available.
+ *
+ * @param n    Number of vectors.
+ * @param d    Number of components.
+ * @param a    First component row of the left vectors; the next ones follow at `lda` elements.
+ * @param lda  Distance between component rows of a.
+ * @param b    First component row of the right vectors.
+ * @param ldb  Distance between component rows of b.
+ * @param root Nonzero to store square roots (norms when b is a).
+ * @param out  Receives the n results, contiguous.
+ */
+void lwt_batch_dots(size_t n, int d, const ttype* a, ptrdiff_t lda, const ttype* b, ptrdiff_t ldb, int root, ttype* out) {
+
+    int level = lwt_simd_level();
+
+    if(level != LWT_SIMD_SCALAR && sizeof(ttype) == sizeof(double)) {
+        lwt_simd_dots_f64[level](n, d, (const double*) a, lda, (const double*) b, ldb, root, (double*) out);
+        return;
+    }
+    if(level != LWT_SIMD_SCALAR && sizeof(ttype) == sizeof(float)) {
+        lwt_simd_dots_f32[level](n, d, (const float*) a, lda, (const float*) b, ldb, root, (float*) out);
+        return;
+    }
+
+    for(size_t i = 0; i < n; i ++) {
+        ttype acc = lwt_sum_block(d, a + i, lda, b + i, ldb);
+        out[i] = root ? sqrt(acc) : acc;
+    }
+}
+
+/**
+ * Computes the cross products of n 3-vectors stored component row by component row,
+ * with the SIMD kernels when available.
+ *
+ * @param n   Number of vectors.
+ * @param a   First component row of the left vectors.
+ * @param lda Distance between component rows of a.
+ * @param b   First component row of the right vectors.
+ * @param ldb Distance between component rows of b.
+ * @param out First component row of the results (may be a or b).
+ * @param ldo Distance between component rows of out.
+ */
+void lwt_batch_cross(size_t n, const ttype* a, ptrdiff_t lda, const ttype* b, ptrdiff_t ldb, ttype* out, ptrdiff_t ldo) {
+
+    int level = lwt_simd_level();
+
+    if(level != LWT_SIMD_SCALAR && sizeof(ttype) == sizeof(double)) {
+        lwt_simd_cross_f64[level](n, (const double*) a, lda, (const double*) b, ldb, (double*) out, ldo);
+        return;
+    }
+    if(level != LWT_SIMD_SCALAR && sizeof(ttype) == sizeof(float)) {
+        lwt_simd_cross_f32[level](n, (const float*) a, lda, (const float*) b, ldb, (float*) out, ldo);
+        return;
+    }
+
+    for(size_t i = 0; i < n; i ++) {
+        ttype ax = a[i], ay = a[lda + i], az = a[2 * lda + i];
+        ttype bx = b[i], by = b[ldb + i], bz = b[2 * ldb + i];
+        out[i] = ay * bz - az * by;
+        out[ldo + i] = az * bx - ax * bz;
+        out[2 * ldo + i] = ax * by - ay * bx;
+    }
+}
+
+/**
+ * Returns n vectors of a batch, starting at `first`, as unit-stride component rows.
+ *
+ * @param t      An (N, d) tensor, or an (N) vector for d = 1.
+ * @param first  Index of the first vector.
+ * @param n      Number of vectors (at most LWT_BATCH_BLOCK).
+ * @param buffer Room for d rows of LWT_BATCH_BLOCK elements.
+ * @param gather Nonzero to copy the vectors into `buffer` when they are not read in place.
+ * @param ld     Receives the distance between component rows.
+ * @return       A pointer into the tensor when axis 0 is unit-stride, `buffer` otherwise.
+ */
+ttype* lwt_batch_rows(Tensor t, size_t first, size_t n, ttype* buffer, int gather, ptrdiff_t* ld) {
+
+    int d = t.rank == 2 ? t.shape[1] : 1;
+    ptrdiff_t stride = t.rank == 2 ? t.strides[1] : 0;
+
+    if(t.strides[0] == 1) {
+        *ld = stride;
+        return t.components + first;
+    }
+
+    *ld = LWT_BATCH_BLOCK;
+
+    if(gather && d == 3 && stride == 1) {
+        /* Interleaved (x, y, z) triples, the common point-cloud layout. */
+        const ttype* src = t.components + first * t.strides[0];
+        for(size_t i = 0; i < n; i ++) {
+            buffer[i] = src[i * t.strides[0]];
+            buffer[LWT_BATCH_BLOCK + i] = src[i * t.strides[0] + 1];
+            buffer[2 * LWT_BATCH_BLOCK + i] = src[i * t.strides[0] + 2];
+        }
+    }
+    else if(gather) {
+        for(int c = 0; c < d; c ++) {
+            const ttype* src = t.components + first * t.strides[0] + c * stride;
+            for(size_t i = 0; i < n; i ++)
+                buffer[c * LWT_BATCH_BLOCK + i] = src[i * t.strides[0]];
+        }
+    }
+
+    return buffer;
+}
+
+/**
+ * Writes n vectors computed into a gather buffer back to a batch.
+ *
+ * @param t      The (N, d) tensor or (N) vector that `lwt_batch_rows` returned `buffer` for.
+ * @param first  Index of the first vector.
+ * @param n      Number of vectors.
+ * @param buffer The component rows, LWT_BATCH_BLOCK elements apart.
+ */
+void lwt_batch_scatter(Tensor t, size_t first, size_t n, const ttype* buffer) {
+
+    int d = t.rank == 2 ? t.shape[1] : 1;
+    ptrdiff_t stride = t.rank == 2 ? t.strides[1] : 0;
+
+    if(d == 3 && stride == 1) {
+        ttype* dst = t.components + first * t.strides[0];
+        for(size_t i = 0; i < n; i ++) {
+            dst[i * t.strides[0]] = buffer[i];
+            dst[i * t.strides[0] + 1] = buffer[LWT_BATCH_BLOCK + i];
+            dst[i * t.strides[0] + 2] = buffer[2 * LWT_BATCH_BLOCK + i];
+        }
+        return;
+    }
+
+    for(int c = 0; c < d; c ++) {
+        ttype* dst = t.components + first * t.strides[0] + c * stride;
+        for(size_t i = 0; i < n; i ++)
+            dst[i * t.strides[0]] = buffer[c * LWT_BATCH_BLOCK + i];
+    }
+}
+
+typedef struct {
+    int op, d;
+    Tensor out, u, v;
+    ttype** buffers;
+} LwtBatchVectorJob;
+
+void lwt_batch_vector_task(void* context, size_t begin, size_t end, int thread) {
+
+    LwtBatchVectorJob* job = (LwtBatchVectorJob*) context;
+    int d = job->d;
+    size_t rows = (size_t) 3 * d + 1;
+
+    if(job->buffers[thread] == NULL)
+        job->buffers[thread] = (ttype*) lwt_malloc_aligned(sizeof(ttype) * rows * LWT_BATCH_BLOCK);
+
+    ttype* u_buffer = job->buffers[thread];
+    ttype* v_buffer = u_buffer + (size_t) d * LWT_BATCH_BLOCK;
+    ttype* out_buffer = v_buffer + (size_t) d * LWT_BATCH_BLOCK;
+    ttype* scale = out_buffer + (size_t) d * LWT_BATCH_BLOCK;
+
+    for(size_t first = begin; first < end; first += LWT_BATCH_BLOCK) {
+
+        size_t n = end - first < LWT_BATCH_BLOCK ? end - first : LWT_BATCH_BLOCK;
+        ptrdiff_t lu, lv, lo;
+
+        ttype* u = lwt_batch_rows(job->u, first, n, u_buffer, 1, &lu);
+        ttype* out = lwt_batch_rows(job->out, first, n, out_buffer, 0, &lo);
+
+        switch(job->op) {
+
+            case LWT_BATCH_CROSS: {
+                ttype* v = lwt_batch_rows(job->v, first, n, v_buffer, 1, &lv);
+                lwt_batch_cross(n, u, lu, v, lv, out, lo);
+                break;
+            }
+
+            case LWT_BATCH_DOT: {
+                ttype* v = lwt_batch_rows(job->v, first, n, v_buffer, 1, &lv);
+                lwt_batch_dots(n, d, u, lu, v, lv, 0, out);
+                break;
+            }
+
+            case LWT_BATCH_NORM:
+                lwt_batch_dots(n, d, u, lu, u, lu, 1, out);
+                break;
+
+            default:
+                /* Zero-length vectors get a zero scale instead of 0 / 0. */
+                lwt_batch_dots(n, d, u, lu, u, lu, 1, scale);
+                for(size_t i = 0; i < n; i ++)
+                    scale[i] = scale[i] > 0.0 ? 1.0 / scale[i] : 0.0;
+
+                for(int c = 0; c < d; c ++) {
+                    if(!lwt_simd_binary(LWT_SIMD_MUL, n, out + c * lo, u + c * lu, scale)) {
+                        for(size_t i = 0; i < n; i ++)
+                            out[c * lo + i] = u[c * lu + i] * scale[i];
+                    }
+                }
+                break;
+        }
+
+        if(out == out_buffer)
+            lwt_batch_scatter(job->out, first, n, out_buffer);
+    }
+}
+
+/*
+ * Checks the operands of a batched operation and runs it over the pool.
+ */
+TensorStatus lwt_batch_vector_run(int op, Tensor out, Tensor u, Tensor v) {
+
+    int inputs = op == LWT_BATCH_CROSS || op == LWT_BATCH_DOT ? 2 : 1;
+    unsigned int out_rank = op == LWT_BATCH_CROSS || op == LWT_BATCH_NORMALIZE ? 2 : 1;
+
+    if(out.dtype != TENSOR_NATIVE || u.dtype != TENSOR_NATIVE || (inputs == 2 && v.dtype != TENSOR_NATIVE))
+        return TENSOR_ERROR_DTYPE;
+    if(u.rank != 2 || out.rank != out_rank || out.shape[0] != u.shape[0])
+        return TENSOR_ERROR_SHAPE;
+    if(inputs == 2 && (v.rank != 2 || v.shape[0] != u.shape[0] || v.shape[1] != u.shape[1]))
+        return TENSOR_ERROR_SHAPE;
+    if(out_rank == 2 && out.shape[1] != u.shape[1])
+        return TENSOR_ERROR_SHAPE;
+    if(op == LWT_BATCH_CROSS && u.shape[1] != 3)
+        return TENSOR_ERROR_SHAPE;
+
+    ttype* buffers[LWT_MAX_THREADS] = { NULL };
+
+    LwtBatchVectorJob job;
+    job.op = op;
+    job.d = u.shape[1];
+    job.out = out;
+    job.u = u;
+    job.v = inputs == 2 ? v : u;
+    job.buffers = buffers;
+
+    lwt_parallel_for((size_t) u.shape[0], LWT_BATCH_GRAIN, lwt_batch_vector_task, &job);
+
+    size_t size = sizeof(ttype) * ((size_t) 3 * job.d + 1) * LWT_BATCH_BLOCK;
+    for(int t = 0; t < LWT_MAX_THREADS; t ++)
+        lwt_free_aligned(buffers[t], size);
+
+    return TENSOR_OK;
+}
+
+/**
+ * Computes the cross products of N pairs of 3D vectors in one pass.
+ *
+ * @param out Receives the N x 3 cross products (may be u or v).
+ * @param u   N x 3 left vectors.
+ * @param v   N x 3 right vectors.
+ * @return    TENSOR_OK, TENSOR_ERROR_SHAPE or TENSOR_ERROR_DTYPE.
+ */
+TensorStatus batched_cross_into(Tensor out, Tensor u, Tensor v) {
+
+    LWT_OP_ENTER("batched_cross");
+    TensorStatus status = lwt_batch_vector_run(LWT_BATCH_CROSS, out, u, v);
+    LWT_OP_LEAVE();
+
+    return status;
+}
+
+/**
+ * Computes the dot products of N pairs of d-vectors in one pass.
+ *
+ * @param out Receives the N dot products.
+ * @param u   N x d left vectors.
+ * @param v   N x d right vectors.
+ * @return    TENSOR_OK, TENSOR_ERROR_SHAPE or TENSOR_ERROR_DTYPE.
+ */
+TensorStatus batched_dot_into(Vector out, Tensor u, Tensor v) {
+
+    LWT_OP_ENTER("batched_dot");
+    TensorStatus status = lwt_batch_vector_run(LWT_BATCH_DOT, out, u, v);
+    LWT_OP_LEAVE();
+
+    return status;
+}
+
+/**
+ * Computes the Euclidean norms of N d-vectors in one pass.
+ *
+ * @param out     Receives the N norms.
+ * @param vectors N x d vectors.
+ * @return        TENSOR_OK, TENSOR_ERROR_SHAPE or TENSOR_ERROR_DTYPE.
+ */
+TensorStatus batched_norm_into(Vector out, Tensor vectors) {
+
+    LWT_OP_ENTER("batched_norm");
+    TensorStatus status = lwt_batch_vector_run(LWT_BATCH_NORM, out, vectors, vectors);
+    LWT_OP_LEAVE();
+
+    return status;
+}
+
+/**
+ * Normalizes N d-vectors in one pass.
+ *
+ * @param out     Receives the N x d unit vectors (may be `vectors`, to normalize in place).
+ * @param vectors N x d vectors.
+ * @return        TENSOR_OK, TENSOR_ERROR_SHAPE or TENSOR_ERROR_DTYPE.
+ *
+ * Note: Zero-length vectors stay zero instead of becoming NaNs.
+ */
+TensorStatus batched_normalize_into(Tensor out, Tensor vectors) {
+
+    LWT_OP_ENTER("batched_normalize");
+    TensorStatus status = lwt_batch_vector_run(LWT_BATCH_NORMALIZE, out, vectors, vectors);
+    LWT_OP_LEAVE();
+
+    return status;
 }
\ No newline at end of file
@@ -0,0 +1,105 @@
+#include <stdio.h>
+#include <time.h>
+
+#include "../lwtensor/matrix.h"
+
+/* Number of right-hand sides solved at once. */
+#define RHS 16
+
+double seconds() {
+    struct timespec ts;
+    timespec_get(&ts, TIME_UTC);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+void fill_random(Matrix matrix) {
+    size_t length = get_length(matrix);
+    for(size_t i = 0; i < length; i ++)
+        matrix.components[i] = (ttype) rand() / RAND_MAX - 0.5;
+}
+
+/* A well-conditioned symmetric positive definite matrix: M * M^T + n * I. */
+Matrix random_spd(int n) {
+
+    Matrix m = create_matrix(n, n);
+    Matrix a = create_matrix(n, n);
+    fill_random(m);
+
+    matmul_into(a, m, tensor_transpose_view(m), 1.0, 0.0);
+    for(int i = 0; i < n; i ++)
+        a.components[i + (size_t) i * n] += n;
+
+    destroy_tensor(m);
+    return a;
+}
+
+/* Largest absolute entry of A * X - B. */
+ttype residual(Matrix a, Matrix x, Matrix b) {
+
+    Matrix r = create_copy(b);
+    matmul_into(r, a, x, 1.0, -1.0);
+
+    ttype error = 0.0;
+    for(size_t i = 0; i < get_length(r); i ++) {
+        ttype value = fabs(r.components[i]);
+        error = value > error ? value : error;
+    }
+
+    destroy_tensor(r);
+    return error;
+}
+
+int main(int argc, char** argv) {
+
+    int sizes[] = { 128, 256, 512, 1024, 2048 };
+    int count = sizeof(sizes) / sizeof(sizes[0]);
+
+    if(argc > 1) {
+        count = argc - 1 < count ? argc - 1 : count;
+        for(int i = 0; i < count; i ++)
+            sizes[i] = atoi(argv[i + 1]);
+    }
+
+    printf("%8s %14s %14s %12s %12s %12s\n", "n", "cholesky ms", "inverse ms", "speedup", "chol resid", "inv resid");
+
+    for(int i = 0; i < count; i ++) {
+
+        int n = sizes[i];
+
+        Matrix a = random_spd(n);
+        Matrix b = create_matrix(n, RHS);
+        Matrix x = create_matrix(n, RHS);
+        Matrix l = create_matrix(n, n);
+        fill_random(b);
+
+        int repetitions = n <= 256 ? 10 : 1;
+
+        /* cholesky_into + cholesky_solve_into */
+        double start = seconds();
+        for(int r = 0; r < repetitions; r ++) {
+            cholesky_into(l, a);
+            cholesky_solve_into(x, l, b);
+        }
+        double fast = (seconds() - start) / repetitions * 1e3;
+        ttype fast_error = residual(a, x, b);
+
+        /* inverse() followed by a product with B */
+        start = seconds();
+        for(int r = 0; r < repetitions; r ++) {
+            Matrix inv = inverse(a);
+            matmul_into(x, inv, b, 1.0, 0.0);
+            destroy_tensor(inv);
+        }
+        double slow = (seconds() - start) / repetitions * 1e3;
+        ttype slow_error = residual(a, x, b);
+
+        printf("%8d %14.2f %14.2f %11.1fx %12.3e %12.3e\n", n, fast, slow, slow / fast, (double) fast_error, (double) slow_error);
+
+        destroy_tensor(a);
+        destroy_tensor(b);
+        destroy_tensor(x);
+        destroy_tensor(l);
+    }
+
+    return 0;
+}
\ No newline at end of file
@@ -0,0 +1,92 @@
+#include <stdio.h>
+#include <time.h>
+
+#include "../lwtensor/matrix.h"
+
+/* Largest size at which the reference triple loop is still timed. */
+#define REFERENCE_LIMIT 512
+
+double seconds() {
+    struct timespec ts;
+    timespec_get(&ts, TIME_UTC);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+/* The previous matmul(): a triple loop through the variadic accessors. */
+void reference_matmul(Matrix result, Matrix lhs, Matrix rhs) {
+
+    for(int r = 0; r < lhs.shape[0]; r ++) {
+        for(int c = 0; c < rhs.shape[1]; c ++) {
+
+            ttype mir = 0.0;
+            for(int k = 0; k < lhs.shape[1]; k ++)
+                mir += get_value(lhs, r, k) * get_value(rhs, k, c);
+
+            set_value(result, mir, r, c);
+        }
+    }
+}
+
+void fill_random(Matrix matrix) {
+    size_t length = get_length(matrix);
+    for(size_t i = 0; i < length; i ++)
+        matrix.components[i] = (ttype) rand() / RAND_MAX - 0.5;
+}
+
+int main(int argc, char** argv) {
+
+    int sizes[] = { 128, 256, 512, 1024, 2048 };
+    int count = sizeof(sizes) / sizeof(sizes[0]);
+
+    if(argc > 1) {
+        count = argc - 1 < count ? argc - 1 : count;
+        for(int i = 0; i < count; i ++)
+            sizes[i] = atoi(argv[i + 1]);
+    }
+
+    printf("%8s %16s %16s %12s\n", "n", "matmul GFLOP/s", "naive GFLOP/s", "max error");
+
+    for(int i = 0; i < count; i ++) {
+
+        int n = sizes[i];
+        double flops = 2.0 * n * n * n;
+
+        Matrix a = create_matrix(n, n);
+        Matrix b = create_matrix(n, n);
+        Matrix c = create_matrix(n, n);
+        fill_random(a);
+        fill_random(b);
+
+        int repetitions = n <= 256 ? 10 : 1;
+        double start = seconds();
+        for(int r = 0; r < repetitions; r ++)
+            matmul_into(c, a, b, 1.0, 0.0);
+        double fast = flops * repetitions / (seconds() - start) * 1e-9;
+
+        if(n <= REFERENCE_LIMIT) {
+
+            Matrix reference = create_matrix(n, n);
+
+            start = seconds();
+            reference_matmul(reference, a, b);
+            double naive = flops / (seconds() - start) * 1e-9;
+
+            ttype error = 0.0;
+            for(size_t j = 0; j < get_length(c); j ++) {
+                ttype difference = fabs(c.components[j] - reference.components[j]);
+                error = difference > error ? difference : error;
+            }
+
+            printf("%8d %16.2f %16.2f %12.3e\n", n, fast, naive, (double) error);
+            destroy_tensor(reference);
+        }
+        else
+            printf("%8d %16.2f %16s %12s\n", n, fast, "-", "-");
+
+        destroy_tensor(a);
+        destroy_tensor(b);
+        destroy_tensor(c);
+    }
+
+    return 0;
+}
\ No newline at end of file
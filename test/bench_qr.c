@@ -0,0 +1,81 @@
+#include <stdio.h>
+#include <time.h>
+
+#include "../lwtensor/matrix.h"
+
+/* Columns of the tall, skinny matrices. */
+#define COLUMNS 256
+
+/* Largest row count at which the unblocked factorization is still timed. */
+#define REFERENCE_LIMIT 65536
+
+double seconds() {
+    struct timespec ts;
+    timespec_get(&ts, TIME_UTC);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+void fill_random(Matrix matrix) {
+    srand(1);
+    size_t length = get_length(matrix);
+    for(size_t i = 0; i < length; i ++)
+        matrix.components[i] = (ttype) rand() / RAND_MAX - 0.5;
+}
+
+int main(int argc, char** argv) {
+
+    int sizes[] = { 4096, 16384, 65536, 262144 };
+    int count = sizeof(sizes) / sizeof(sizes[0]);
+
+    if(argc > 1) {
+        count = argc - 1 < count ? argc - 1 : count;
+        for(int i = 0; i < count; i ++)
+            sizes[i] = atoi(argv[i + 1]);
+    }
+
+    printf("%8s %8s %14s %14s %12s\n", "m", "n", "qr GFLOP/s", "naive GFLOP/s", "R diff");
+
+    for(int i = 0; i < count; i ++) {
+
+        int m = sizes[i], n = COLUMNS;
+        double flops = 2.0 * m * n * n - 2.0 / 3.0 * n * n * n;
+
+        Matrix a = create_matrix(m, n);
+        ttype* tau = (ttype*) malloc(sizeof(ttype) * n);
+        ttype* diagonal = (ttype*) malloc(sizeof(ttype) * n);
+        fill_random(a);
+
+        /* Blocked factorization, in place */
+        double start = seconds();
+        qr_decompose(a, &a, tau, NULL);
+        double fast = flops / (seconds() - start) * 1e-9;
+
+        for(int j = 0; j < n; j ++)
+            diagonal[j] = a.components[j + (size_t) j * m];
+
+        if(m <= REFERENCE_LIMIT) {
+
+            /* One reflector at a time */
+            fill_random(a);
+            start = seconds();
+            lwt_qr_factor(m, n, a.components, m, tau);
+            double naive = flops / (seconds() - start) * 1e-9;
+
+            ttype error = 0.0;
+            for(int j = 0; j < n; j ++) {
+                ttype difference = fabs(a.components[j + (size_t) j * m] - diagonal[j]) / fabs(diagonal[j]);
+                error = difference > error ? difference : error;
+            }
+
+            printf("%8d %8d %14.2f %14.2f %12.3e\n", m, n, fast, naive, (double) error);
+        }
+        else
+            printf("%8d %8d %14.2f %14s %12s\n", m, n, fast, "-", "-");
+
+        destroy_tensor(a);
+        free(tau);
+        free(diagonal);
+    }
+
+    return 0;
+}
\ No newline at end of file
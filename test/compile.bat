@@ -1 +1,4 @@
-gcc -std=c11 test.c -o test.exe
\ No newline at end of file
+gcc -std=c11 -pthread test.c -o test.exe
+gcc -std=c11 -O2 -pthread bench_matmul.c -o bench_matmul.exe
+gcc -std=c11 -O2 -pthread bench_cholesky.c -o bench_cholesky.exe
+gcc -std=c11 -O2 -pthread bench_qr.c -o bench_qr.exe
\ No newline at end of file
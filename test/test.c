@@ -1,6 +1,1640 @@
 #include <stdio.h>
 
 #include "../lwtensor/matrix.h"
+#include "../lwtensor/expr.h"
+#include "../lwtensor/reduce.h"
+#include "../lwtensor/quant.h"
+#include "../lwtensor/npy.h"
+#include "../lwtensor/geometry.h"
+
+int failures = 0;
+
+/* Prints the error of a check, which fails above the tolerance. */
+void check(const char* name, ttype error, ttype tolerance) {
+
+    int ok = error <= tolerance;
+    failures += !ok;
+
+    printf("%-44s %12.3e  %s\n", name, (double) error, ok ? "ok" : "FAILED");
+}
+
+/* Tolerance of the residual checks, a fixed multiple of the machine epsilon of `ttype`. */
+ttype tolerance() {
+    return 1e4 * (sizeof(ttype) == sizeof(float) ? FLT_EPSILON : DBL_EPSILON);
+}
+
+void fill_random(Tensor tensor) {
+    size_t length = get_length(tensor);
+    for(size_t i = 0; i < length; i ++)
+        tensor.components[i] = (ttype) rand() / RAND_MAX - 0.5;
+}
+
+/* Random entries plus `shift` on the diagonal, which keeps square matrices well conditioned. */
+Matrix random_matrix(int rows, int cols, ttype shift) {
+
+    Matrix matrix = create_matrix(rows, cols);
+    fill_random(matrix);
+
+    for(int i = 0; i < rows && i < cols; i ++)
+        *tensor_at2(matrix, i, i) += shift;
+
+    return matrix;
+}
+
+/* Largest absolute element of a contiguous tensor. */
+ttype max_abs(Tensor tensor) {
+
+    ttype largest = 0.0;
+    for(size_t i = 0; i < get_length(tensor); i ++) {
+        ttype value = fabs(tensor.components[i]);
+        largest = value > largest ? value : largest;
+    }
+
+    return largest;
+}
+
+/* Largest absolute difference between two tensors (or views) of the same shape. */
+ttype max_difference(Tensor a, Tensor b) {
+
+    Tensor difference = subtract(a, b);
+    ttype error = max_abs(difference);
+
+    destroy_tensor(difference);
+    return error;
+}
+
+/* Computes alpha * lhs * rhs + beta * out one dot product at a time, accumulating in double. */
+void reference_matmul(Matrix out, Matrix lhs, Matrix rhs, ttype alpha, ttype beta) {
+
+    for(int i = 0; i < out.shape[0]; i ++) {
+        for(int j = 0; j < out.shape[1]; j ++) {
+
+            double sum = 0.0;
+            for(int p = 0; p < lhs.shape[1]; p ++)
+                sum += (double) *tensor_at2(lhs, i, p) * *tensor_at2(rhs, p, j);
+
+            *tensor_at2(out, i, j) = (ttype) (alpha * sum + beta * *tensor_at2(out, i, j));
+        }
+    }
+}
+
+/* Counting allocation callbacks around the defaults. */
+size_t counted_bytes = 0;
+
+void* counting_alloc(void* context, size_t size) {
+    counted_bytes += size;
+    return lwt_default_alloc(context, size);
+}
+
+void counting_free(void* context, void* ptr, size_t size) {
+    counted_bytes -= size;
+    lwt_default_free(context, ptr, size);
+}
+
+void* counting_aligned_alloc(void* context, size_t size, size_t alignment) {
+    counted_bytes += size;
+    return lwt_default_aligned_alloc(context, size, alignment);
+}
+
+/* Largest absolute element of A * X - B. */
+ttype residual(Matrix a, Matrix x, Matrix b) {
+
+    Matrix r = create_copy(b);
+    matmul_into(r, a, x, 1.0, -1.0);
+
+    ttype error = max_abs(r);
+
+    destroy_tensor(r);
+    return error;
+}
+
+void test_accessors() {
+
+    Tensor t = create_tensor(3, 2, 3, 4);
+    ttype error = t.strides[0] != 1 || t.strides[1] != 2 || t.strides[2] != 6;
+
+    /* Every accessor reaches the element set_value wrote, at the canonical offset. */
+    for(int k = 0; k < 4; k ++) {
+        for(int j = 0; j < 3; j ++) {
+            for(int i = 0; i < 2; i ++) {
+
+                int index[LWT_MAX_RANK] = { i, j, k };
+                set_value(t, 100 * i + 10 * j + k, i, j, k);
+
+                error += tensor_at3(t, i, j, k) != t.components + i + 2 * j + 6 * k;
+                error += tensor_at(t, index) != tensor_at3(t, i, j, k);
+                error += get_value(t, i, j, k) != 100 * i + 10 * j + k;
+            }
+        }
+    }
+    check("strides and element accessors", error, 0.0);
+
+    Tensor deep = create_tensor(LWT_MAX_RANK + 1, 1, 1, 1, 1, 1, 1, 1, 1, 1);
+    check("create_tensor rank above LWT_MAX_RANK", deep.components != NULL || deep.rank != 0, 0.0);
+
+    destroy_tensor(t);
+    destroy_tensor(deep);
+}
+
+void test_views() {
+
+    Tensor t = create_tensor(3, 5, 6, 7);
+    fill_random(t);
+
+    /* Every element of a view is the parent element at the mapped index. */
+    Tensor forward = tensor_slice(t, 1, 1, 6, 2);
+    Tensor backward = tensor_slice(t, 2, 6, -1, -3);
+    Tensor row = tensor_select(t, 0, 4);
+    int axes[3] = { 2, 0, 1 };
+    Tensor permuted = tensor_permute_view(t, axes);
+
+    ttype error = forward.shape[1] != 3 || backward.shape[2] != 3;
+    for(int k = 0; k < 7; k ++) {
+        for(int j = 0; j < 6; j ++) {
+            for(int i = 0; i < 5; i ++) {
+
+                ttype value = *tensor_at3(t, i, j, k);
+
+                if(j % 2 == 1)
+                    error += *tensor_at3(forward, i, j / 2, k) != value;
+                if(k % 3 == 0)
+                    error += *tensor_at3(backward, i, j, 2 - k / 3) != value;
+                if(i == 4)
+                    error += *tensor_at2(row, j, k) != value;
+
+                error += *tensor_at3(permuted, k, i, j) != value;
+            }
+        }
+    }
+    check("tensor_slice / select / permute_view", error, 0.0);
+
+    /* A reshape merges axes that are chained in memory and refuses the others. */
+    Tensor merged = tensor_reshape_view(t, 2, 30, 7);
+    Tensor refused = tensor_reshape_view(permuted, 1, 210);
+    Tensor copy = tensor_contiguous(permuted);
+    Tensor flat = tensor_reshape_view(copy, 1, 210);
+
+    error = merged.components != t.components || refused.components != NULL;
+    for(int k = 0; k < 7; k ++) {
+        for(int j = 0; j < 6; j ++) {
+            for(int i = 0; i < 5; i ++) {
+                error += *tensor_at2(merged, i + 5 * j, k) != *tensor_at3(t, i, j, k);
+                error += *tensor_at1(flat, k + 7 * i + 35 * j) != *tensor_at3(t, i, j, k);
+            }
+        }
+    }
+    check("tensor_reshape_view / tensor_contiguous", error, 0.0);
+
+    destroy_tensor(t);
+    destroy_tensor(forward);
+    destroy_tensor(backward);
+    destroy_tensor(row);
+    destroy_tensor(permuted);
+    destroy_tensor(merged);
+    destroy_tensor(refused);
+    destroy_tensor(copy);
+    destroy_tensor(flat);
+}
+
+void test_iterator() {
+
+    /* Rank-4 views whose axes cannot be merged: a strided slice and a permutation. */
+    Tensor base = create_tensor(4, 3, 8, 5, 6);
+    Tensor other = create_tensor(4, 6, 5, 4, 3);
+    Tensor out = create_tensor(4, 3, 4, 5, 6);
+    fill_random(base);
+    fill_random(other);
+
+    int axes[4] = { 3, 2, 1, 0 };
+    Tensor a = tensor_slice(base, 1, 0, 8, 2);
+    Tensor b = tensor_permute_view(other, axes);
+
+    /* Each run starts at the offsets of its multi-index, in every operand. */
+    Tensor operands[3] = { out, a, b };
+    TensorIterator it;
+    ttype error = !tensor_iterator_init(&it, 3, operands) || it.rank < 3;
+    size_t runs = 0;
+
+    for(int more = 1; more; more = tensor_iterator_next(&it)) {
+        for(unsigned int k = 0; k < 3; k ++) {
+
+            ptrdiff_t offset = 0;
+            for(unsigned int axis = 1; axis < it.rank; axis ++)
+                offset += it.index[axis] * it.strides[axis][k];
+
+            error += it.offsets[k] != offset;
+        }
+        runs ++;
+    }
+    error += runs * it.shape[0] != get_length(out);
+    check("tensor_iterator_next offsets", error, 0.0);
+
+    error = sum_into(out, a, b) != TENSOR_OK;
+    for(int l = 0; l < 6; l ++) {
+        for(int k = 0; k < 5; k ++) {
+            for(int j = 0; j < 4; j ++) {
+                for(int i = 0; i < 3; i ++) {
+                    int index[LWT_MAX_RANK] = { i, j, k, l };
+                    error += fabs(*tensor_at(out, index) - (*tensor_at(a, index) + *tensor_at(b, index)));
+                }
+            }
+        }
+    }
+    check("sum_into over rank-4 views", error, tolerance());
+
+    /* Reductions walk the view run by run, reading the offsets after every step. */
+    Tensor reduced = tensor_reduce(b, (1u << 0) | (1u << 2), TENSOR_REDUCE_SUM, 1);
+    error = reduced.components == NULL;
+    for(int l = 0; l < 6 && reduced.components != NULL; l ++) {
+        for(int j = 0; j < 4; j ++) {
+
+            ttype expected = 0.0;
+            for(int k = 0; k < 5; k ++) {
+                for(int i = 0; i < 3; i ++) {
+                    int index[LWT_MAX_RANK] = { i, j, k, l };
+                    expected += *tensor_at(b, index);
+                }
+            }
+
+            int index[LWT_MAX_RANK] = { 0, j, 0, l };
+            error = fmax(error, fabs(*tensor_at(reduced, index) - expected));
+        }
+    }
+    check("tensor_reduce over a rank-4 view", error, tolerance());
+    destroy_tensor(reduced);
+
+    destroy_tensor(a);
+    destroy_tensor(b);
+    destroy_tensor(base);
+    destroy_tensor(other);
+    destroy_tensor(out);
+}
+
+void test_elementwise() {
+
+    Matrix a = random_matrix(37, 23, 0.0);
+    Matrix b = random_matrix(37, 23, 0.0);
+    Matrix out = create_matrix(37, 23);
+    Matrix inplace = create_copy(a);
+
+    /* Strided operands: the transpose of a 23 x 37 matrix. */
+    Matrix c_storage = random_matrix(23, 37, 0.0);
+    Matrix c = tensor_transpose_view(c_storage);
+
+    TensorStatus status = sum_into(out, a, c);
+    status |= subtract_inplace(inplace, b);
+    status |= hadamard_inplace(inplace, c);
+    status |= divide_scalar_inplace(inplace, 4.0);
+
+    ttype error = status != TENSOR_OK;
+    for(int j = 0; j < 23; j ++) {
+        for(int i = 0; i < 37; i ++) {
+
+            ttype x = *tensor_at2(a, i, j), y = *tensor_at2(b, i, j), z = *tensor_at2(c, i, j);
+
+            error += fabs(*tensor_at2(out, i, j) - (x + z));
+            error += fabs(*tensor_at2(inplace, i, j) - (x - y) * z / 4.0);
+        }
+    }
+    check("sum_into / *_inplace", error, tolerance());
+
+    /* The strided view as output. */
+    status = product_scalar_into(c, a, 3.0);
+    error = status != TENSOR_OK;
+    for(int j = 0; j < 23; j ++) {
+        for(int i = 0; i < 37; i ++)
+            error += fabs(*tensor_at2(c, i, j) - 3.0 * *tensor_at2(a, i, j));
+    }
+    check("product_scalar_into a strided view", error, tolerance());
+
+    Matrix wrong = create_matrix(37, 22);
+    check("sum_into shape mismatch", sum_into(out, a, wrong) != TENSOR_ERROR_SHAPE, 0.0);
+
+    /* The allocating forms release their result and return the empty tensor on failure. */
+    int shape[2] = { 37, 23 };
+    Tensor half = create_tensor_dtype(TENSOR_F16, 2, shape);
+    Vector v = create_vector(23);
+    Matrix a_t = tensor_transpose_view(a);
+    size_t live = lwt_alloc_stats().live_bytes;
+
+    Tensor failed[12] = { sum(a, half), subtract(half, a), divide(a, half), hadamard(half, b),
+        sum_scalar(half, 1.0), subtract_scalar(half, 1.0), divide_scalar(half, 2.0), product_scalar(half, 2.0),
+        tensor_reduce(half, 1u, TENSOR_REDUCE_SUM, 0), matmul(half, a_t),
+        matmul(a, wrong), transform(v, half) };
+
+    error = lwt_alloc_stats().live_bytes != live;
+    for(int i = 0; i < 12; i ++)
+        error += failed[i].components != NULL || failed[i].shape != NULL;
+    check("allocating ops on invalid operands", error, 0.0);
+
+    /* dot over a strided view, and its NaN on invalid operands. */
+    double expected = 0.0;
+    for(int j = 0; j < 23; j ++) {
+        for(int i = 0; i < 37; i ++)
+            expected += (double) *tensor_at2(a, i, j) * *tensor_at2(c, i, j);
+    }
+    error = fabs(dot(a, c) - expected);
+    error += !isnan(dot(a, half)) + !isnan(dot(half, a)) + !isnan(dot(a, wrong));
+    check("dot of a strided view / invalid operands", error, tolerance());
+    destroy_tensor(half);
+    destroy_tensor(v);
+    destroy_tensor(a_t);
+
+    destroy_tensor(a);
+    destroy_tensor(b);
+    destroy_tensor(out);
+    destroy_tensor(inplace);
+    destroy_tensor(c_storage);
+    destroy_tensor(c);
+    destroy_tensor(wrong);
+}
+
+void test_broadcast() {
+
+    Tensor a = create_tensor(3, 4, 5, 6);
+    Tensor row = create_tensor(2, 1, 6);
+    Tensor column = create_tensor(3, 4, 1, 1);
+    Tensor out = create_tensor(3, 4, 5, 6);
+    fill_random(a);
+    fill_random(row);
+    fill_random(column);
+
+    /* Leading axes and extent-1 axes are expanded on both sides of each op. */
+    TensorStatus status = subtract_into(out, a, row);
+    status |= divide_inplace(out, column);
+    Tensor outer = hadamard(column, row);
+
+    ttype error = status != TENSOR_OK || outer.rank != 3 || outer.shape[1] != 1 || outer.shape[2] != 6;
+    for(int k = 0; k < 6; k ++) {
+        for(int j = 0; j < 5; j ++) {
+            for(int i = 0; i < 4; i ++) {
+
+                ttype r = *tensor_at2(row, 0, k), c = *tensor_at3(column, i, 0, 0);
+
+                error += fabs(*tensor_at3(out, i, j, k) - (*tensor_at3(a, i, j, k) - r) / c);
+                if(j == 0)
+                    error += fabs(*tensor_at3(outer, i, 0, k) - c * r);
+            }
+        }
+    }
+    check("broadcast _into / _inplace / allocating", error, tolerance());
+
+    /* The output itself is never broadcast. */
+    Tensor small = create_tensor(3, 4, 1, 6);
+    check("broadcast into a smaller output", sum_into(small, a, row) != TENSOR_ERROR_SHAPE, 0.0);
+
+    destroy_tensor(a);
+    destroy_tensor(row);
+    destroy_tensor(column);
+    destroy_tensor(out);
+    destroy_tensor(outer);
+    destroy_tensor(small);
+}
+
+void test_reduce() {
+
+    /* A permuted, hence non-contiguous, 6 x 5 x 7 view. */
+    Tensor base = create_tensor(3, 7, 6, 5);
+    fill_random(base);
+    int axes[3] = { 1, 2, 0 };
+    Tensor t = tensor_permute_view(base, axes);
+    int extents[3] = { 6, 5, 7 };
+
+    const char* names[8] = { "sum", "mean", "prod", "max", "min", "argmax", "argmin", "var" };
+    char label[64];
+
+    for(int op = TENSOR_REDUCE_SUM; op <= TENSOR_REDUCE_VAR; op ++) {
+
+        ttype error = 0.0;
+        for(unsigned int mask = 1; mask < 8; mask ++) {
+
+            Tensor r = tensor_reduce(t, mask, (TensorReduceOp) op, 1);
+            error += r.components == NULL;
+
+            int low[3], high[3], kept[3];
+            for(kept[2] = 0; kept[2] < r.shape[2]; kept[2] ++) {
+                for(kept[1] = 0; kept[1] < r.shape[1]; kept[1] ++) {
+                    for(kept[0] = 0; kept[0] < r.shape[0]; kept[0] ++) {
+
+                        for(int axis = 0; axis < 3; axis ++) {
+                            low[axis] = mask & (1u << axis) ? 0 : kept[axis];
+                            high[axis] = mask & (1u << axis) ? extents[axis] : kept[axis] + 1;
+                        }
+
+                        double total = 0.0, product = 1.0, squares = 0.0, high_value = -HUGE_VAL, low_value = HUGE_VAL;
+                        int count = 0, argmax = 0, argmin = 0;
+
+                        for(int pass = 0; pass < 2; pass ++) {
+                            for(int k = low[2]; k < high[2]; k ++) {
+                                for(int j = low[1]; j < high[1]; j ++) {
+                                    for(int i = low[0]; i < high[0]; i ++) {
+
+                                        double value = *tensor_at3(t, i, j, k);
+                                        if(pass == 1) {
+                                            squares += (value - total / count) * (value - total / count);
+                                            continue;
+                                        }
+
+                                        /* Position over the reduced axes, the first one varying fastest. */
+                                        int index[3] = { i, j, k }, position = 0, stride = 1;
+                                        for(int axis = 0; axis < 3; axis ++) {
+                                            if(mask & (1u << axis)) {
+                                                position += index[axis] * stride;
+                                                stride *= extents[axis];
+                                            }
+                                        }
+
+                                        if(value > high_value) { high_value = value; argmax = position; }
+                                        if(value < low_value) { low_value = value; argmin = position; }
+                                        total += value;
+                                        product *= value;
+                                        count ++;
+                                    }
+                                }
+                            }
+                        }
+
+                        double expected[8] = { total, total / count, product, high_value, low_value, argmax, argmin, squares / count };
+                        double got = *tensor_at3(r, kept[0], kept[1], kept[2]);
+                        double scale = op == TENSOR_REDUCE_PROD ? fabs(expected[op]) + 1e-30 : 1.0 + fabs(expected[op]);
+                        error = fmax(error, fabs(got - expected[op]) / scale);
+                    }
+                }
+            }
+
+            destroy_tensor(r);
+        }
+
+        snprintf(label, sizeof(label), "tensor_reduce %s, every mask", names[op]);
+        check(label, error, tolerance());
+    }
+
+    /* Dropping the reduced axes gives the same values. */
+    Tensor kept = tensor_reduce(t, 1u << 1, TENSOR_REDUCE_SUM, 1);
+    Tensor dropped = tensor_reduce(t, 1u << 1, TENSOR_REDUCE_SUM, 0);
+    Tensor reshaped = tensor_reshape_view(kept, 2, 6, 7);
+    check("tensor_reduce keepdims = 0", dropped.rank != 2 ? 1.0 : max_difference(dropped, reshaped), 0.0);
+
+    destroy_tensor(kept);
+    destroy_tensor(dropped);
+    destroy_tensor(reshaped);
+    destroy_tensor(t);
+    destroy_tensor(base);
+}
+
+void test_sum_modes() {
+
+    /* Large values cancelling pairwise up to a small remainder: an ill-conditioned sum. */
+    Tensor x = create_tensor(1, 100003);
+    Tensor ones = create_tensor(1, 100003);
+    fill_random(x);
+    for(int i = 0; i + 1 < 100003; i += 2)
+        x.components[i + 1] = -1e6 * x.components[i] + x.components[i + 1];
+    for(int i = 0; i < 100003; i += 2)
+        x.components[i] *= 1e6;
+    for(int i = 0; i < 100003; i ++)
+        ones.components[i] = 1.0;
+
+    /* Reference with a compensated long double sum. */
+    long double exact = 0.0, compensation = 0.0;
+    ttype magnitude = 0.0;
+    for(int i = 0; i < 100003; i ++) {
+        long double y = (long double) x.components[i] - compensation;
+        long double t = exact + y;
+        compensation = (t - exact) - y;
+        exact = t;
+        magnitude += fabs(x.components[i]);
+    }
+
+    const char* names[3] = { "pairwise", "compensated", "wide" };
+    char label[64];
+
+    for(int mode = TENSOR_SUM_PAIRWISE; mode <= TENSOR_SUM_WIDE; mode ++) {
+
+        TensorSumMode previous = lwt_set_sum_mode((TensorSumMode) mode);
+        Tensor total = tensor_reduce(x, TENSOR_AXES_ALL, TENSOR_REDUCE_SUM, 0);
+        ttype product = dot(x, ones);
+        lwt_set_sum_mode(previous);
+
+        /* Pairwise summation is bounded by the sum of magnitudes, the other modes by the result. */
+        ttype scale = mode == TENSOR_SUM_PAIRWISE ? magnitude : fabs((ttype) exact);
+        ttype error = fmax(fabs(total.components[0] - (ttype) exact), fabs(product - (ttype) exact)) / scale;
+
+        snprintf(label, sizeof(label), "sum mode %s", names[mode]);
+        check(label, error, tolerance());
+
+        destroy_tensor(total);
+    }
+
+    destroy_tensor(x);
+    destroy_tensor(ones);
+}
+
+void test_cast() {
+
+    /* A strided view with values covering the ranges of the integer types. */
+    Matrix storage = random_matrix(17, 33, 0.0);
+    for(int i = 0; i < 17 * 33; i ++)
+        storage.components[i] *= 600.0;
+    Matrix x = tensor_transpose_view(storage);
+
+    const char* names[TENSOR_DTYPES] = { "F64", "F32", "F16", "BF16", "I32", "I8", "U8" };
+    double roundoff[4] = { DBL_EPSILON / 2, FLT_EPSILON / 2, 1.0 / 2048, 1.0 / 256 };
+    double low[3] = { -2147483648.0, -128.0, 0.0 }, high[3] = { 2147483647.0, 127.0, 255.0 };
+    char label[64];
+
+    for(int dtype = TENSOR_F64; dtype < TENSOR_DTYPES; dtype ++) {
+
+        Tensor narrow = tensor_cast(x, (TensorDType) dtype);
+        Tensor back = tensor_cast(narrow, TENSOR_NATIVE);
+        double unit = fmax(roundoff[dtype < TENSOR_I32 ? dtype : 0], roundoff[TENSOR_NATIVE]);
+
+        ttype error = narrow.dtype != (TensorDType) dtype || back.shape[0] != 33 ? INFINITY : 0.0;
+        for(int j = 0; j < 17 && !isinf(error); j ++) {
+            for(int i = 0; i < 33; i ++) {
+
+                double value = *tensor_at2(x, i, j), got = *tensor_at2(back, i, j);
+
+                /* Floating types round to nearest (error in units of roundoff), integer types round
+                   half away from zero and saturate. */
+                if(dtype <= TENSOR_BF16)
+                    error = fmax(error, fabs(got - value) / fmax(fabs(value), DBL_MIN) / unit);
+                else
+                    error = fmax(error, fabs(got - fmin(fmax(round(value), low[dtype - TENSOR_I32]), high[dtype - TENSOR_I32])));
+            }
+        }
+
+        snprintf(label, sizeof(label), "tensor_cast %s round trip", names[dtype]);
+        check(label, error, dtype <= TENSOR_BF16 ? 1.0 : 0.0);
+
+        destroy_tensor(narrow);
+        destroy_tensor(back);
+    }
+
+    /* Overflow to infinity, saturation and NaN. */
+    Tensor special = create_tensor(1, 3);
+    special.components[0] = 70000.0;
+    special.components[1] = -1000.0;
+    special.components[2] = NAN;
+
+    Tensor half = tensor_cast(special, TENSOR_F16);
+    Tensor small = tensor_cast(special, TENSOR_I8);
+    Tensor half_back = tensor_cast(half, TENSOR_NATIVE);
+    Tensor small_back = tensor_cast(small, TENSOR_NATIVE);
+
+    ttype error = !isinf(half_back.components[0]) || !isnan(half_back.components[2]);
+    error += small_back.components[0] != 127.0 || small_back.components[1] != -128.0 || small_back.components[2] != 0.0;
+    check("tensor_cast overflow / saturation / NaN", error, 0.0);
+
+    destroy_tensor(special);
+    destroy_tensor(half);
+    destroy_tensor(small);
+    destroy_tensor(half_back);
+    destroy_tensor(small_back);
+    destroy_tensor(x);
+    destroy_tensor(storage);
+}
+
+void test_quantize() {
+
+    Matrix a = random_matrix(40, 30, 0.0);
+
+    /* Rounding to the nearest level errs by at most half a step. */
+    QuantizedTensor symmetric = quantize(a, TENSOR_I8, -1);
+    Tensor restored = dequantize(symmetric);
+    check("quantize i8 error / scale", max_difference(a, restored) / symmetric.scales[0], 0.5 + tolerance());
+
+    QuantizedTensor asymmetric = quantize(a, TENSOR_U8, 1);
+    Tensor channels = dequantize(asymmetric);
+
+    ttype error = 0.0;
+    for(int c = 0; c < a.shape[1]; c ++) {
+        for(int r = 0; r < a.shape[0]; r ++) {
+            ttype value = fabs(*tensor_at2(a, r, c) - *tensor_at2(channels, r, c)) / asymmetric.scales[c];
+            error = value > error ? value : error;
+        }
+    }
+    check("quantize u8 per-column error / scale", error, 0.5 + tolerance());
+
+    /* The quantized product accumulates exactly, so it matches the product of the dequantized operands. */
+    Matrix x = random_matrix(37, 70, 0.0);
+    Matrix y = random_matrix(70, 29, 0.0);
+    QuantizedTensor qx = quantize(x, TENSOR_U8, 0);
+    QuantizedTensor qy = quantize(y, TENSOR_I8, 1);
+    Tensor dx = dequantize(qx);
+    Tensor dy = dequantize(qy);
+    Matrix expected = create_matrix(37, 29);
+    Matrix product = create_matrix(37, 29);
+    reference_matmul(expected, dx, dy, 1.0, 0.0);
+
+    TensorStatus status = qmatmul_dequantize_into(product, qx, qy);
+    check("qmatmul_dequantize_into vs reference", status == TENSOR_OK ? max_difference(product, expected) : INFINITY, tolerance());
+
+    destroy_tensor(x);
+    destroy_tensor(y);
+    destroy_tensor(dx);
+    destroy_tensor(dy);
+    destroy_tensor(expected);
+    destroy_tensor(product);
+    destroy_quantized(qx);
+    destroy_quantized(qy);
+    destroy_tensor(a);
+    destroy_tensor(restored);
+    destroy_tensor(channels);
+    destroy_quantized(symmetric);
+    destroy_quantized(asymmetric);
+}
+
+void test_container() {
+
+    Matrix a = random_matrix(7, 5, 0.0);
+    Tensor view = tensor_transpose_view(a);
+    Tensor half = tensor_cast(a, TENSOR_F16);
+
+    const char* names[] = { "a", "view", "half" };
+    Tensor tensors[] = { a, view, half };
+    Tensor loaded;
+
+    /* The round trips are exact: the elements are stored as they are. */
+    TensorStatus status = tensor_save("test_roundtrip.lwt", 3, names, tensors);
+    if(status == TENSOR_OK)
+        status = tensor_load("test_roundtrip.lwt", "a", &loaded);
+    check("tensor_save / tensor_load", status == TENSOR_OK ? max_difference(loaded, a) : INFINITY, 0.0);
+    if(status == TENSOR_OK)
+        destroy_tensor(loaded);
+
+    /* Mapped tensors keep their element type and read straight from the file. */
+    TensorFile file;
+    status = tensor_mmap_open("test_roundtrip.lwt", &file);
+    ttype error = INFINITY;
+    if(status == TENSOR_OK) {
+
+        Tensor mapped_view = tensor_mmap_get(&file, "view");
+        Tensor mapped_half = tensor_mmap_get(&file, "half");
+        Tensor widened = tensor_cast(mapped_half, TENSOR_NATIVE);
+        Tensor expected = tensor_cast(half, TENSOR_NATIVE);
+
+        error = max_difference(mapped_view, view) + max_difference(widened, expected);
+        error += mapped_half.dtype != TENSOR_F16 || tensor_mmap_get(&file, "missing").shape != NULL;
+
+        destroy_tensor(widened);
+        destroy_tensor(expected);
+        tensor_mmap_close(&file);
+    }
+    check("tensor_mmap_open / tensor_mmap_get", error, 0.0);
+
+    /* Missing names and files that are not containers are reported. */
+    FILE* stream = fopen("test_roundtrip.bad", "wb");
+    if(stream != NULL) {
+        fputs("not a tensor container", stream);
+        fclose(stream);
+    }
+    error = tensor_load("test_roundtrip.lwt", "missing", &loaded) != TENSOR_ERROR_SHAPE;
+    error += tensor_load("test_roundtrip.bad", NULL, &loaded) != TENSOR_ERROR_IO;
+    error += tensor_load("test_roundtrip.none", NULL, &loaded) != TENSOR_ERROR_IO;
+    check("tensor_load errors", error, 0.0);
+
+    remove("test_roundtrip.lwt");
+    remove("test_roundtrip.bad");
+
+    destroy_tensor(a);
+    destroy_tensor(view);
+    destroy_tensor(half);
+}
+
+void test_npy() {
+
+    Matrix a = random_matrix(7, 5, 0.0);
+    Tensor view = tensor_transpose_view(a);
+
+    const char* names[] = { "a", "view" };
+    Tensor tensors[] = { a, view };
+    Tensor loaded;
+
+    /* The round trips are exact: the elements are stored as they are. */
+    TensorStatus status = npy_save("test_roundtrip.npy", view);
+    if(status == TENSOR_OK)
+        status = npy_load("test_roundtrip.npy", NULL, &loaded);
+    check("npy_save / npy_load", status == TENSOR_OK ? max_difference(loaded, view) : INFINITY, 0.0);
+    if(status == TENSOR_OK)
+        destroy_tensor(loaded);
+
+    status = npz_save("test_roundtrip.npz", 2, names, tensors);
+    if(status == TENSOR_OK)
+        status = npy_load("test_roundtrip.npz", "view", &loaded);
+    check("npz_save / npy_load", status == TENSOR_OK ? max_difference(loaded, view) : INFINITY, 0.0);
+    if(status == TENSOR_OK)
+        destroy_tensor(loaded);
+
+    /* A C-order int32 array as numpy writes it: element (i, j) of a 2 x 3 array is 3 * i + j. */
+    char header[128 - 10 + 1];
+    snprintf(header, sizeof(header), "%-117s", "{'descr': '<i4', 'fortran_order': False, 'shape': (2, 3), }");
+    header[117] = '\n';
+
+    unsigned char preamble[10] = { 0x93, 'N', 'U', 'M', 'P', 'Y', 1, 0, 118, 0 };
+    int32_t values[6] = { 0, 1, 2, 3, 4, 5 };
+    FILE* stream = fopen("test_roundtrip.npy", "wb");
+    if(stream != NULL) {
+        fwrite(preamble, 1, sizeof(preamble), stream);
+        fwrite(header, 1, 118, stream);
+        fwrite(values, sizeof(int32_t), 6, stream);
+        fclose(stream);
+    }
+
+    ttype error = INFINITY;
+    if(npy_load("test_roundtrip.npy", NULL, &loaded) == TENSOR_OK) {
+
+        error = loaded.dtype != TENSOR_I32 || loaded.rank != 2 || loaded.shape[0] != 2 || loaded.shape[1] != 3;
+        for(int i = 0; i < 2 && error == 0.0; i ++) {
+            for(int j = 0; j < 3; j ++)
+                error += ((int32_t*) loaded.components)[i * loaded.strides[0] + j * loaded.strides[1]] != 3 * i + j;
+        }
+        destroy_tensor(loaded);
+    }
+    check("npy_load of a C-order int32 array", error, 0.0);
+
+    Tensor bfloat = tensor_cast(a, TENSOR_BF16);
+    check("npy_save of an unsupported dtype", npy_save("test_roundtrip.npy", bfloat) != TENSOR_ERROR_DTYPE, 0.0);
+    destroy_tensor(bfloat);
+
+    remove("test_roundtrip.npy");
+    remove("test_roundtrip.npz");
+
+    destroy_tensor(a);
+    destroy_tensor(view);
+}
+
+void test_arena() {
+
+    Matrix a = random_matrix(40, 30, 0.0);
+    Matrix b = random_matrix(40, 30, 0.0);
+    Matrix expected = hadamard(a, b);
+
+    TensorArena arena;
+    tensor_arena_init(&arena, 0);
+
+    size_t allocations = lwt_alloc_stats().allocations;
+    TensorArena* previous = tensor_arena_attach(&arena);
+
+    /* The second round reuses the block of the first one. */
+    ttype error = 0.0;
+    for(int round = 0; round < 2; round ++) {
+
+        Matrix product = hadamard(a, b);
+        Matrix copy = create_copy(product);
+
+        error += max_difference(copy, expected);
+        error += (uintptr_t) product.components % LWT_ALIGNMENT != 0 || product.flags != 0;
+
+        destroy_tensor(product);
+        destroy_tensor(copy);
+        tensor_arena_reset(&arena);
+    }
+
+    tensor_arena_attach(previous);
+    error += lwt_alloc_stats().allocations - allocations != 1;
+    check("arena tensors / heap allocations", error, 0.0);
+
+    tensor_arena_destroy(&arena);
+    destroy_tensor(a);
+    destroy_tensor(b);
+    destroy_tensor(expected);
+}
+
+void test_allocator() {
+
+    /* Every byte requested through the callbacks comes back with its size. */
+    lwt_set_allocator(counting_alloc, counting_free, counting_aligned_alloc, NULL);
+
+    Matrix a = random_matrix(50, 20, 0.0);
+    Matrix at = tensor_transpose_view(a);
+    Matrix b = matmul(a, at);
+    size_t requested = counted_bytes;
+
+    destroy_tensor(a);
+    destroy_tensor(at);
+    destroy_tensor(b);
+
+    check("allocator callbacks / sized frees", requested == 0 || counted_bytes != 0, 0.0);
+    lwt_set_allocator(NULL, NULL, NULL, NULL);
+
+    /* A freed buffer is handed out again for the next request of the same size. */
+    lwt_bufpool_enable(1);
+
+    TensorAllocStats before = lwt_alloc_stats();
+    destroy_tensor(create_matrix(123, 45));
+    destroy_tensor(create_matrix(123, 45));
+    TensorAllocStats after = lwt_alloc_stats();
+
+    check("buffer pool hit / live bytes", after.pool_hits - before.pool_hits < 1 || after.live_bytes != before.live_bytes, 0.0);
+
+    lwt_bufpool_trim();
+    lwt_bufpool_enable(0);
+    check("buffer pool trim", lwt_alloc_stats().pooled_bytes, 0.0);
+}
+
+void test_simd() {
+
+    /* Lengths with a tail after the last full vector of every instruction set. */
+    Tensor a = create_tensor(1, 1037);
+    Tensor b = create_tensor(1, 1037);
+    fill_random(a);
+    fill_random(b);
+
+    Matrix x = random_matrix(70, 90, 0.0);
+    Matrix y = random_matrix(90, 50, 0.0);
+
+    lwt_simd_set_level(LWT_SIMD_SCALAR);
+    Tensor expected[5] = { sum(a, b), subtract(a, b), hadamard(a, b), divide(a, b), product_scalar(a, 3.0) };
+    ttype expected_dot = dot(a, b);
+    Matrix expected_product = matmul(x, y);
+
+    char label[64];
+    for(int level = LWT_SIMD_SSE2; level <= lwt_simd_detect(); level ++) {
+
+        lwt_simd_set_level(level);
+
+        Tensor results[5] = { sum(a, b), subtract(a, b), hadamard(a, b), divide(a, b), product_scalar(a, 3.0) };
+        Matrix product = matmul(x, y);
+
+        ttype error = 0.0;
+        for(int r = 0; r < 5; r ++) {
+            error += max_difference(results[r], expected[r]);
+            destroy_tensor(results[r]);
+        }
+
+        snprintf(label, sizeof(label), "SIMD level %d element-wise ops", level);
+        check(label, error, 0.0);
+
+        snprintf(label, sizeof(label), "SIMD level %d dot / matmul", level);
+        check(label, fabs(dot(a, b) - expected_dot) + max_difference(product, expected_product), tolerance());
+
+        destroy_tensor(product);
+    }
+
+    lwt_simd_set_level(lwt_simd_detect());
+
+    for(int r = 0; r < 5; r ++)
+        destroy_tensor(expected[r]);
+    destroy_tensor(a);
+    destroy_tensor(b);
+    destroy_tensor(x);
+    destroy_tensor(y);
+    destroy_tensor(expected_product);
+}
+
+void test_expr() {
+
+    /* A permuted view, a tensor broadcast over the leading axis and one with an extent-1 axis. */
+    Tensor base = create_tensor(3, 7, 6, 5);
+    Tensor b = create_tensor(2, 5, 7);
+    Tensor c = create_tensor(3, 6, 1, 7);
+    Tensor out = create_tensor(3, 6, 5, 7);
+    fill_random(base);
+    fill_random(b);
+    fill_random(c);
+
+    int axes[3] = { 1, 2, 0 };
+    Tensor a = tensor_permute_view(base, axes);
+
+    /* (a * 2.5 + b - c) / (a + 3) */
+    TensorExpr e;
+    lwt_expr_init(&e);
+    int numerator = lwt_expr_sub(&e, lwt_expr_add(&e, lwt_expr_mul(&e, lwt_expr_tensor(&e, a), lwt_expr_scalar(&e, 2.5)),
+        lwt_expr_tensor(&e, b)), lwt_expr_tensor(&e, c));
+    lwt_expr_div(&e, numerator, lwt_expr_add(&e, lwt_expr_tensor(&e, a), lwt_expr_scalar(&e, 3.0)));
+
+    ttype error = lwt_expr_eval_into(&e, out) != TENSOR_OK;
+    for(int k = 0; k < 7; k ++) {
+        for(int j = 0; j < 5; j ++) {
+            for(int i = 0; i < 6; i ++) {
+                ttype x = *tensor_at3(a, i, j, k);
+                ttype expected = (x * 2.5 + *tensor_at2(b, j, k) - *tensor_at3(c, i, 0, k)) / (x + 3.0);
+                error = fmax(error, fabs(*tensor_at3(out, i, j, k) - expected));
+            }
+        }
+    }
+    check("lwt_expr_eval_into vs loop", error, tolerance());
+
+    Tensor evaluated = lwt_expr_eval(&e);
+    check("lwt_expr_eval vs _into", max_difference(evaluated, out), 0.0);
+
+    /* Shapes that do not broadcast are refused. */
+    TensorExpr bad;
+    lwt_expr_init(&bad);
+    lwt_expr_add(&bad, lwt_expr_tensor(&bad, base), lwt_expr_tensor(&bad, b));
+    check("lwt_expr shape mismatch", lwt_expr_eval_into(&bad, out) != TENSOR_ERROR_SHAPE, 0.0);
+
+    destroy_tensor(evaluated);
+    destroy_tensor(a);
+    destroy_tensor(base);
+    destroy_tensor(b);
+    destroy_tensor(c);
+    destroy_tensor(out);
+}
+
+void count_visits(void* context, size_t begin, size_t end, int thread) {
+
+    /* A thread index outside the pool counts as many visits. */
+    atomic_int* visits = (atomic_int*) context;
+    for(size_t i = begin; i < end; i ++)
+        atomic_fetch_add(&visits[i], 1 + 1000 * (thread < 0 || thread >= 4));
+}
+
+void test_threads() {
+
+    TensorThreadPool* pool = lwt_pool_create(4);
+    TensorThreadPool* serial = lwt_pool_create(1);
+    TensorThreadPool* previous = lwt_pool_attach(pool);
+
+    /* Every index is handed to exactly one thread of the pool. */
+    size_t count = 100003;
+    atomic_int* visits = calloc(count, sizeof(atomic_int));
+    lwt_parallel_for(count, 1000, count_visits, visits);
+
+    ttype error = 0.0;
+    for(size_t i = 0; i < count; i ++)
+        error += visits[i] != 1;
+    check("lwt_parallel_for covers each index once", error, 0.0);
+    free(visits);
+
+    /* Parallel element-wise ops and matmul match a single-thread pool bit for bit. */
+    Tensor a = create_tensor(2, 400, 300);
+    Tensor b = create_tensor(2, 400, 300);
+    Matrix x = random_matrix(150, 120, 0.0);
+    Matrix y = random_matrix(120, 130, 0.0);
+    fill_random(a);
+    fill_random(b);
+
+    Tensor parallel_sum = hadamard(a, b);
+    Matrix parallel_product = matmul(x, y);
+
+    lwt_pool_attach(serial);
+    Tensor serial_sum = hadamard(a, b);
+    Matrix serial_product = matmul(x, y);
+
+    check("4 threads vs 1 thread", max_difference(parallel_sum, serial_sum) + max_difference(parallel_product, serial_product), 0.0);
+
+    lwt_pool_attach(previous);
+    lwt_pool_destroy(pool);
+    lwt_pool_destroy(serial);
+
+    destroy_tensor(a);
+    destroy_tensor(b);
+    destroy_tensor(x);
+    destroy_tensor(y);
+    destroy_tensor(parallel_sum);
+    destroy_tensor(serial_sum);
+    destroy_tensor(parallel_product);
+    destroy_tensor(serial_product);
+}
+
+void test_gemm() {
+
+    /* Shapes around the small-product cutoff, the micro-tile and the KC / NC blocks. */
+    int shapes[][3] = { { 1, 1, 1 }, { 4, 4, 4 }, { 7, 5, 3 }, { 33, 17, 65 }, { 130, 270, 300 }, { 8, 2100, 300 }, { 300, 29, 513 } };
+    char label[64];
+
+    for(size_t s = 0; s < sizeof(shapes) / sizeof(shapes[0]); s ++) {
+
+        int m = shapes[s][0], n = shapes[s][1], k = shapes[s][2];
+
+        Matrix a = random_matrix(m, k, 0.0);
+        Matrix b = random_matrix(k, n, 0.0);
+        Matrix c = random_matrix(m, n, 0.0);
+        Matrix reference = create_copy(c);
+
+        TensorStatus status = matmul_into(c, a, b, 0.5, -2.0);
+        reference_matmul(reference, a, b, 0.5, -2.0);
+
+        snprintf(label, sizeof(label), "matmul_into %dx%dx%d", m, n, k);
+        check(label, status == TENSOR_OK ? max_difference(c, reference) : INFINITY, tolerance());
+
+        /* Transposed views reach the packing routines with unit row strides. */
+        Matrix at_storage = random_matrix(k, m, 0.0);
+        Matrix bt_storage = random_matrix(n, k, 0.0);
+        Matrix at = tensor_transpose_view(at_storage);
+        Matrix bt = tensor_transpose_view(bt_storage);
+
+        Matrix product = matmul(at, bt);
+        reference_matmul(reference, at, bt, 1.0, 0.0);
+
+        snprintf(label, sizeof(label), "matmul transposed %dx%dx%d", m, n, k);
+        check(label, max_difference(product, reference), tolerance());
+
+        destroy_tensor(a);
+        destroy_tensor(b);
+        destroy_tensor(c);
+        destroy_tensor(reference);
+        destroy_tensor(at_storage);
+        destroy_tensor(bt_storage);
+        destroy_tensor(at);
+        destroy_tensor(bt);
+        destroy_tensor(product);
+    }
+
+    Matrix a = create_matrix(3, 4);
+    Matrix c = create_matrix(3, 3);
+    check("matmul_into inner dimension mismatch", matmul_into(c, a, a, 1.0, 0.0) != TENSOR_ERROR_SHAPE, 0.0);
+
+    destroy_tensor(a);
+    destroy_tensor(c);
+}
+
+void test_split_k() {
+
+    /* A^T * B with a long inner dimension and a small result. */
+    Matrix a = random_matrix(5000, 32, 0.0);
+    Matrix b = random_matrix(5000, 24, 0.0);
+    Matrix expected = create_matrix(32, 24);
+    Matrix single = create_matrix(32, 24);
+    Matrix parallel = create_matrix(32, 24);
+    Matrix a_t = tensor_transpose_view(a);
+
+    reference_matmul(expected, a_t, b, 1.0, 0.0);
+
+    TensorThreadPool* pool = lwt_pool_create(1);
+    TensorThreadPool* previous = lwt_pool_attach(pool);
+    lwt_gemm_split_k(32, 24, 5000, 1.0, a.components, a.strides[1], a.strides[0],
+        b.components, b.strides[0], b.strides[1], 0.0, single.components, single.strides[0], single.strides[1]);
+    lwt_pool_destroy(pool);
+
+    pool = lwt_pool_create(4);
+    lwt_pool_attach(pool);
+    lwt_gemm_split_k(32, 24, 5000, 1.0, a.components, a.strides[1], a.strides[0],
+        b.components, b.strides[0], b.strides[1], 0.0, parallel.components, parallel.strides[0], parallel.strides[1]);
+    lwt_pool_attach(previous);
+    lwt_pool_destroy(pool);
+
+    check("lwt_gemm_split_k vs reference", max_difference(parallel, expected), tolerance());
+    check("lwt_gemm_split_k 4 threads vs 1 thread", max_difference(parallel, single), 0.0);
+
+    destroy_tensor(a_t);
+    destroy_tensor(a);
+    destroy_tensor(b);
+    destroy_tensor(expected);
+    destroy_tensor(single);
+    destroy_tensor(parallel);
+}
+
+/* Compares batched_matmul_into(out, lhs, rhs, alpha, beta) on rank-4 operands with a direct loop. */
+ttype batched_error(Tensor lhs, Tensor rhs, Tensor out, ttype alpha, ttype beta) {
+
+    Tensor previous = create_copy(out);
+    ttype error = batched_matmul_into(out, lhs, rhs, alpha, beta) != TENSOR_OK;
+
+    for(int b1 = 0; b1 < out.shape[1]; b1 ++) {
+        for(int b0 = 0; b0 < out.shape[0]; b0 ++) {
+            for(int j = 0; j < out.shape[3]; j ++) {
+                for(int i = 0; i < out.shape[2]; i ++) {
+
+                    double sum = 0.0;
+                    for(int p = 0; p < lhs.shape[3]; p ++) {
+                        int l[LWT_MAX_RANK] = { lhs.shape[0] == 1 ? 0 : b0, lhs.shape[1] == 1 ? 0 : b1, i, p };
+                        int r[LWT_MAX_RANK] = { rhs.shape[0] == 1 ? 0 : b0, rhs.shape[1] == 1 ? 0 : b1, p, j };
+                        sum += (double) *tensor_at(lhs, l) * *tensor_at(rhs, r);
+                    }
+
+                    int o[LWT_MAX_RANK] = { b0, b1, i, j };
+                    error = fmax(error, fabs(*tensor_at(out, o) - (alpha * sum + beta * *tensor_at(previous, o))));
+                }
+            }
+        }
+    }
+
+    destroy_tensor(previous);
+    return error;
+}
+
+void test_batched() {
+
+    /* Small matrices, batched along a unit-stride axis, with both operands broadcast. */
+    Tensor lhs = create_tensor(4, 13, 1, 5, 7);
+    Tensor rhs = create_tensor(4, 1, 3, 7, 6);
+    Tensor out = create_tensor(4, 13, 3, 5, 6);
+    fill_random(lhs);
+    fill_random(rhs);
+    fill_random(out);
+    check("batched_matmul_into small, broadcast", batched_error(lhs, rhs, out, 2.0, 0.5), tolerance());
+
+    /* Matrices large enough for the blocked GEMM. */
+    Tensor big_lhs = create_tensor(4, 2, 1, 70, 60);
+    Tensor big_rhs = create_tensor(4, 2, 1, 60, 50);
+    Tensor big_out = create_tensor(4, 2, 1, 70, 50);
+    fill_random(big_lhs);
+    fill_random(big_rhs);
+    check("batched_matmul_into large", batched_error(big_lhs, big_rhs, big_out, 1.0, 0.0), tolerance());
+
+    Tensor allocated = batched_matmul(lhs, rhs);
+    ttype error = allocated.rank != 4 || allocated.shape[0] != 13 || allocated.shape[1] != 3;
+    error += batched_matmul_into(out, lhs, big_rhs, 1.0, 0.0) != TENSOR_ERROR_SHAPE;
+    check("batched_matmul shape / mismatch", error, 0.0);
+
+    destroy_tensor(lhs);
+    destroy_tensor(rhs);
+    destroy_tensor(out);
+    destroy_tensor(big_lhs);
+    destroy_tensor(big_rhs);
+    destroy_tensor(big_out);
+    destroy_tensor(allocated);
+}
+
+void test_gemv() {
+
+    /* Both unit-stride orientations of A, each multiplied directly and transposed. */
+    Matrix a = random_matrix(301, 173, 0.0);
+    Matrix a_t = tensor_transpose_view(a);
+    Matrix matrices[2] = { a, a_t };
+
+    /* Strided input and output: every other element of longer vectors. */
+    Vector x_storage = create_vector(2 * 301);
+    Vector y_storage = create_vector(2 * 301);
+    fill_random(x_storage);
+    Vector x_full = tensor_slice(x_storage, 0, 0, 2 * 301, 2);
+    Vector y_full = tensor_slice(y_storage, 0, 1, 2 * 301, 2);
+
+    char label[64];
+    for(int m = 0; m < 2; m ++) {
+        for(int trans = 0; trans < 2; trans ++) {
+
+            Matrix A = matrices[m];
+            int rows = A.shape[trans], cols = A.shape[1 - trans];
+
+            Vector x = tensor_slice(x_full, 0, 0, cols, 1);
+            Vector y = tensor_slice(y_full, 0, 0, rows, 1);
+            fill_random(y_storage);
+            Vector previous = create_copy(y);
+
+            ttype error = gemv_into(y, A, x, 1.5, -0.5, trans) != TENSOR_OK;
+            for(int i = 0; i < rows; i ++) {
+
+                double sum = 0.0;
+                for(int j = 0; j < cols; j ++)
+                    sum += (double) (trans ? *tensor_at2(A, j, i) : *tensor_at2(A, i, j)) * *tensor_at1(x, j);
+
+                error = fmax(error, fabs(*tensor_at1(y, i) - (1.5 * sum - 0.5 * *tensor_at1(previous, i))));
+            }
+
+            snprintf(label, sizeof(label), "gemv_into %s%s, strided x / y", m ? "A^T view" : "A", trans ? " transposed" : "");
+            check(label, error, tolerance());
+
+            destroy_tensor(x);
+            destroy_tensor(y);
+            destroy_tensor(previous);
+        }
+    }
+
+    Vector wrong = create_vector(172);
+    check("gemv_into length mismatch", gemv_into(wrong, a, wrong, 1.0, 0.0, 0) != TENSOR_ERROR_SHAPE, 0.0);
+
+    destroy_tensor(wrong);
+    destroy_tensor(x_full);
+    destroy_tensor(y_full);
+    destroy_tensor(x_storage);
+    destroy_tensor(y_storage);
+    destroy_tensor(a_t);
+    destroy_tensor(a);
+}
+
+void test_geometry() {
+
+    /* Random, well conditioned 4x4, 3x3 and 2x2 matrices, loaded from Matrix values. */
+    Matrix ta = random_matrix(4, 4, 2.0), tb = random_matrix(4, 4, 2.0);
+    Matrix t3 = random_matrix(3, 3, 2.0), t2 = random_matrix(2, 2, 2.0);
+    Mat4 a = mat4_identity(), b = a, a_t = a, inverse4 = a;
+    Mat3 m3 = mat3_identity(), inverse3 = m3;
+    Mat2 m2 = mat2_identity(), inverse2 = m2;
+
+    Matrix ta_t = tensor_transpose_view(ta);
+    TensorStatus status = mat4_load(ta, &a) | mat4_load(tb, &b) | mat4_load(ta_t, &a_t) | mat3_load(t3, &m3) | mat2_load(t2, &m2);
+    status |= mat4_inverse(a, &inverse4) | mat3_inverse(m3, &inverse3) | mat2_inverse(m2, &inverse2);
+
+    /* Products against matmul, and the strided load against mat4_transpose. */
+    Matrix expected = matmul(ta, tb);
+    Matrix product = mat4_to_tensor(mat4_mul(a, b));
+    Mat4 transposed = mat4_transpose(a);
+
+    ttype error = status != TENSOR_OK ? INFINITY : max_difference(product, expected);
+    for(int i = 0; i < 16; i ++)
+        error += fabs(transposed.m[i] - a_t.m[i]);
+
+    Vec4 x = vec4(0.5, -1.0, 2.0, 0.25);
+    Vec4 y = mat4_mul_vec(a, x);
+    for(int i = 0; i < 4; i ++)
+        error += fabs(y.v[i] - (a.m[i] * 0.5 - a.m[i + 4] + a.m[i + 8] * 2.0 + a.m[i + 12] * 0.25));
+    check("Mat4 mul / mul_vec / load / transpose", error, tolerance());
+
+    /* Inverses and determinants against the general routines. */
+    Matrix identity4 = mat4_to_tensor(mat4_mul(a, inverse4));
+    Matrix identity3 = mat3_to_tensor(mat3_mul(m3, inverse3));
+    Matrix identity2 = mat2_to_tensor(mat2_mul(m2, inverse2));
+    Matrix eye4 = create_indentity(4), eye3 = create_indentity(3), eye2 = create_indentity(2);
+
+    error = max_difference(identity4, eye4) + max_difference(identity3, eye3) + max_difference(identity2, eye2);
+    error += fabs(mat4_determinant(a) - determinant(ta)) / fabs(determinant(ta));
+    error += fabs(mat3_determinant(m3) - determinant(t3)) / fabs(determinant(t3));
+    error += fabs(mat2_determinant(m2) - determinant(t2)) / fabs(determinant(t2));
+    check("Mat2-4 inverse / determinant", error, tolerance());
+
+    /* Vector identities: u x v is orthogonal to both and |u x v|^2 = |u|^2 |v|^2 - (u . v)^2. */
+    Vec3 u = vec3(1.0, 2.0, -0.5), v = vec3(-3.0, 0.5, 4.0);
+    Vec3 w = vec3_cross(u, v);
+    ttype uv = vec3_dot(u, v), lu = vec3_length(u), lv = vec3_length(v);
+    error = fabs(vec3_dot(w, u)) + fabs(vec3_dot(w, v));
+    error += fabs(vec3_dot(w, w) - (lu * lu * lv * lv - uv * uv)) / (lu * lu * lv * lv);
+    error += fabs(vec3_length(vec3_normalize(v)) - 1.0);
+    error += mat2_inverse((Mat2) { { 1.0, 2.0, 2.0, 4.0 } }, &inverse2) != TENSOR_ERROR_SINGULAR;
+    check("Vec3 cross / dot / normalize, singular Mat2", error, tolerance());
+
+    Matrix matrices[12] = { ta, tb, t3, t2, ta_t, expected, product, identity4, identity3, identity2, eye4, eye3 };
+    for(int i = 0; i < 12; i ++)
+        destroy_tensor(matrices[i]);
+    destroy_tensor(eye2);
+}
+
+void test_batched_vectors() {
+
+    /* N x 3 vectors, one operand stored the other way round, and a zero-length row. */
+    int n = 1037;
+    Tensor u = create_tensor(2, n, 3);
+    Tensor v_storage = create_tensor(2, 3, n);
+    fill_random(u);
+    fill_random(v_storage);
+    Tensor v = tensor_transpose_view(v_storage);
+    for(int c = 0; c < 3; c ++)
+        *tensor_at2(u, 5, c) = 0.0;
+
+    Tensor cross = create_tensor(2, n, 3);
+    Tensor normalized = create_copy(u);
+    Vector dots = create_vector(n), norms = create_vector(n);
+
+    TensorStatus status = batched_cross_into(cross, u, v) | batched_dot_into(dots, u, v);
+    status |= batched_norm_into(norms, u) | batched_normalize_into(normalized, normalized);
+
+    ttype error = status != TENSOR_OK;
+    for(int i = 0; i < n; i ++) {
+
+        ttype a[3], b[3];
+        for(int c = 0; c < 3; c ++) {
+            a[c] = *tensor_at2(u, i, c);
+            b[c] = *tensor_at2(v, i, c);
+        }
+
+        ttype expected_cross[3] = { a[1] * b[2] - a[2] * b[1], a[2] * b[0] - a[0] * b[2], a[0] * b[1] - a[1] * b[0] };
+        ttype length = sqrt(a[0] * a[0] + a[1] * a[1] + a[2] * a[2]);
+
+        error = fmax(error, fabs(*tensor_at1(dots, i) - (a[0] * b[0] + a[1] * b[1] + a[2] * b[2])));
+        error = fmax(error, fabs(*tensor_at1(norms, i) - length));
+        for(int c = 0; c < 3; c ++) {
+            error = fmax(error, fabs(*tensor_at2(cross, i, c) - expected_cross[c]));
+            error = fmax(error, fabs(*tensor_at2(normalized, i, c) - (length > 0.0 ? a[c] / length : 0.0)));
+        }
+    }
+    check("batched cross / dot / norm / normalize", error, tolerance());
+
+    Tensor wrong = create_tensor(2, n, 4);
+    check("batched_cross_into of 4D vectors", batched_cross_into(wrong, wrong, wrong) != TENSOR_ERROR_SHAPE, 0.0);
+
+    destroy_tensor(u);
+    destroy_tensor(v);
+    destroy_tensor(v_storage);
+    destroy_tensor(cross);
+    destroy_tensor(normalized);
+    destroy_tensor(dots);
+    destroy_tensor(norms);
+    destroy_tensor(wrong);
+}
+
+void test_lu() {
+
+    int n = 150;
+    Matrix a = random_matrix(n, n, 0.0);
+    Matrix lu = create_matrix(n, n);
+    int* piv = (int*) malloc(sizeof(int) * n);
+
+    /* P * A = L * U, with the interchanges applied to a copy of A in order. */
+    TensorStatus status = lu_decompose(a, &lu, piv);
+
+    Matrix l = create_indentity(n);
+    Matrix u = create_matrix(n, n);
+    for(int c = 0; c < n; c ++) {
+        for(int r = 0; r < n; r ++)
+            *tensor_at2(r > c ? l : u, r, c) = *tensor_at2(lu, r, c);
+    }
+
+    Matrix pa = create_copy(a);
+    for(int k = 0; k < n; k ++) {
+        for(int c = 0; c < n; c ++) {
+            ttype swap = *tensor_at2(pa, k, c);
+            *tensor_at2(pa, k, c) = *tensor_at2(pa, piv[k], c);
+            *tensor_at2(pa, piv[k], c) = swap;
+        }
+    }
+
+    check("lu_decompose L * U - P * A", status == TENSOR_OK ? residual(l, u, pa) : INFINITY, tolerance());
+
+    /* det(L * U) is the product of the diagonal of U; swapping two rows flips its sign.
+       The off-diagonal factors are scaled down to keep the product well conditioned. */
+    ttype expected = 1.0;
+    for(int c = 0; c < n; c ++) {
+        for(int r = 0; r < n; r ++)
+            *tensor_at2(r > c ? l : u, r, c) /= r != c ? n : 1;
+    }
+    for(int i = 0; i < n; i ++) {
+        *tensor_at2(u, i, i) = 0.9 + 0.2 * rand() / RAND_MAX;
+        expected *= *tensor_at2(u, i, i);
+    }
+
+    Matrix product = matmul(l, u);
+    check("determinant of L * U", fabs(determinant(product) / expected - 1.0), tolerance());
+
+    for(int c = 0; c < n; c ++) {
+        ttype swap = *tensor_at2(product, 3, c);
+        *tensor_at2(product, 3, c) = *tensor_at2(product, 100, c);
+        *tensor_at2(product, 100, c) = swap;
+    }
+    check("determinant after a row swap", fabs(determinant(product) / -expected - 1.0), tolerance());
+
+    /* A zero column makes the matrix exactly singular. */
+    for(int r = 0; r < n; r ++)
+        *tensor_at2(a, r, 70) = 0.0;
+    check("lu_decompose singular status", lu_decompose(a, &lu, piv) != TENSOR_ERROR_SINGULAR, 0.0);
+    check("determinant of a singular matrix", fabs(determinant(a)), 0.0);
+
+    destroy_tensor(a);
+    destroy_tensor(lu);
+    destroy_tensor(l);
+    destroy_tensor(u);
+    destroy_tensor(pa);
+    destroy_tensor(product);
+    free(piv);
+}
+
+void test_inverse() {
+
+    int n = 130;
+    Matrix a = random_matrix(n, n, 4.0);
+    Matrix inv = create_matrix(n, n);
+    Matrix workspace = create_matrix(n, n);
+    Matrix identity = create_indentity(n);
+
+    TensorStatus status = inverse_into(inv, a, workspace);
+    check("inverse_into A * A^-1 - I", status == TENSOR_OK ? residual(a, inv, identity) : INFINITY, tolerance());
+
+    /* In place, from a transposed view: (A^T)^-1 = (A^-1)^T. */
+    Matrix at = tensor_transpose_view(a);
+    Matrix in_place = create_copy(at);
+    status = inverse_into(in_place, in_place, workspace);
+
+    Matrix inv_t = tensor_transpose_view(inv);
+    check("inverse_into in place of A^T", status == TENSOR_OK ? max_difference(in_place, inv_t) : INFINITY, tolerance());
+
+    Matrix singular = create_matrix(n, n);
+    check("inverse_into singular status", inverse_into(inv, singular, workspace) != TENSOR_ERROR_SINGULAR, 0.0);
+
+    /* Operands of another element type are refused before anything is written. */
+    int shape[2] = { n, n };
+    Tensor half = create_tensor_dtype(TENSOR_F16, 2, shape);
+    int piv[130];
+    ttype before = inv.components[0];
+    Tensor refused = inverse(half);
+
+    ttype error = inverse_into(inv, half, workspace) != TENSOR_ERROR_DTYPE;
+    error += inverse_into(half, a, workspace) != TENSOR_ERROR_DTYPE;
+    error += lu_decompose(half, &workspace, piv) != TENSOR_ERROR_DTYPE;
+    error += lu_decompose(a, &half, piv) != TENSOR_ERROR_DTYPE;
+    error += !isnan(determinant(half)) + (refused.components != NULL) + (inv.components[0] != before);
+    check("LU / inverse reject a non-native dtype", error, 0.0);
+    destroy_tensor(half);
+
+    destroy_tensor(a);
+    destroy_tensor(inv);
+    destroy_tensor(workspace);
+    destroy_tensor(identity);
+    destroy_tensor(at);
+    destroy_tensor(in_place);
+    destroy_tensor(inv_t);
+    destroy_tensor(singular);
+}
+
+/* Largest absolute element of Q^T * Q - I. */
+ttype orthogonality(Matrix q) {
+
+    Matrix qt = tensor_transpose_view(q);
+    Matrix qtq = create_indentity(q.shape[1]);
+    matmul_into(qtq, qt, q, 1.0, -1.0);
+
+    ttype error = max_abs(qtq);
+
+    destroy_tensor(qt);
+    destroy_tensor(qtq);
+    return error;
+}
+
+void test_qr(const char* name, int m, int n, int pivoting) {
+
+    int k = m < n ? m : n;
+    char label[64];
+
+    Matrix a = random_matrix(m, n, 0.0);
+    if(pivoting) {
+        for(int r = 0; r < m; r ++)
+            *tensor_at2(a, r, n - 1) = *tensor_at2(a, r, 0) + *tensor_at2(a, r, 1);
+    }
+
+    Matrix qr = create_matrix(m, n);
+    ttype* tau = (ttype*) malloc(sizeof(ttype) * k);
+    int* perm = (int*) malloc(sizeof(int) * n);
+
+    TensorStatus status = qr_decompose(a, &qr, tau, pivoting ? perm : NULL);
+
+    /* A * P, column j being column perm[j] of A */
+    Matrix ap = create_matrix(m, n);
+    for(int c = 0; c < n; c ++) {
+        for(int r = 0; r < m; r ++)
+            *tensor_at2(ap, r, c) = *tensor_at2(a, r, pivoting ? perm[c] : c);
+    }
+
+    for(int full = 0; full < 2; full ++) {
+
+        Matrix q = create_matrix(m, full ? m : k);
+        Matrix r = create_matrix(full ? m : k, n);
+
+        if(status == TENSOR_OK)
+            status = qr_form_q(q, qr, tau);
+        if(status == TENSOR_OK)
+            status = qr_form_r(r, qr);
+
+        snprintf(label, sizeof(label), "%s %s Q * R - A", name, full ? "full" : "economy");
+        check(label, status == TENSOR_OK ? residual(q, r, ap) : INFINITY, tolerance());
+
+        snprintf(label, sizeof(label), "%s %s Q^T * Q - I", name, full ? "full" : "economy");
+        check(label, status == TENSOR_OK ? orthogonality(q) : INFINITY, tolerance());
+
+        destroy_tensor(q);
+        destroy_tensor(r);
+    }
+
+    if(pivoting) {
+
+        /* |R[i][i]| is non-increasing and reveals the rank deficiency. */
+        ttype increase = 0.0;
+        for(int i = 1; i < k; i ++) {
+            ttype step = fabs(*tensor_at2(qr, i, i)) - fabs(*tensor_at2(qr, i - 1, i - 1));
+            increase = step > increase ? step : increase;
+        }
+
+        snprintf(label, sizeof(label), "%s diagonal increase", name);
+        check(label, increase, 0.0);
+
+        snprintf(label, sizeof(label), "%s |R[k-1][k-1]| / |R[0][0]|", name);
+        check(label, fabs(*tensor_at2(qr, k - 1, k - 1)) / fabs(*tensor_at2(qr, 0, 0)), tolerance());
+    }
+
+    destroy_tensor(a);
+    destroy_tensor(qr);
+    destroy_tensor(ap);
+    free(tau);
+    free(perm);
+}
+
+void test_qr_scaling(const char* name, ttype scale, int pivoting) {
+
+    /* A * scale factors as Q * (R * scale): near the overflow or underflow threshold the
+       squares of the elements are not representable, but the norms are. */
+    Matrix a = random_matrix(90, 40, 0.0);
+    Matrix scaled = product_scalar(a, scale);
+    Matrix qr = create_matrix(90, 40), qr_scaled = create_matrix(90, 40);
+    Matrix q = create_matrix(90, 40), q_scaled = create_matrix(90, 40);
+    ttype tau[40], tau_scaled[40];
+    int perm[40], perm_scaled[40];
+
+    TensorStatus status = qr_decompose(a, &qr, tau, pivoting ? perm : NULL);
+    status |= qr_decompose(scaled, &qr_scaled, tau_scaled, pivoting ? perm_scaled : NULL);
+    status |= qr_form_q(q, qr, tau) | qr_form_q(q_scaled, qr_scaled, tau_scaled);
+
+    ttype error = status != TENSOR_OK ? INFINITY : max_difference(q_scaled, q);
+    for(int c = 0; c < 40 && status == TENSOR_OK; c ++) {
+        error += pivoting && perm[c] != perm_scaled[c];
+        for(int r = 0; r <= c; r ++)
+            error = fmax(error, fabs(*tensor_at2(qr_scaled, r, c) / scale - *tensor_at2(qr, r, c)) / fabs(*tensor_at2(qr, 0, 0)));
+    }
+
+    check(name, error, tolerance());
+
+    destroy_tensor(a);
+    destroy_tensor(scaled);
+    destroy_tensor(qr);
+    destroy_tensor(qr_scaled);
+    destroy_tensor(q);
+    destroy_tensor(q_scaled);
+}
+
+void test_solve() {
+
+    Matrix a = random_matrix(50, 50, 4.0);
+    Matrix b = random_matrix(50, 3, 0.0);
+    Matrix x = create_matrix(50, 3);
+    Matrix workspace = create_matrix(50, 50);
+
+    TensorStatus status = solve_into(x, a, b, workspace);
+    check("solve A * X - B", status == TENSOR_OK ? residual(a, x, b) : INFINITY, tolerance());
+
+    destroy_tensor(a);
+    destroy_tensor(b);
+    destroy_tensor(x);
+    destroy_tensor(workspace);
+}
+
+void test_cholesky() {
+
+    /* Symmetric positive definite, large enough for the blocked path: M * M^T + n * I. */
+    int n = 300;
+    Matrix m = random_matrix(n, n, 0.0);
+    Matrix mt = tensor_transpose_view(m);
+    Matrix spd = create_indentity(n);
+    matmul_into(spd, m, mt, 1.0, n);
+
+    Matrix l = create_matrix(n, n);
+    Matrix lt = tensor_transpose_view(l);
+    Matrix product = create_copy(spd);
+
+    TensorStatus status = cholesky_into(l, spd);
+    matmul_into(product, l, lt, 1.0, -1.0);
+
+    ttype error = status != TENSOR_OK ? INFINITY : max_abs(product) / max_abs(spd);
+    for(int c = 1; c < n; c ++) {
+        for(int r = 0; r < c; r ++)
+            error += fabs(*tensor_at2(l, r, c));
+    }
+    check("cholesky_into L * L^T - A", error, tolerance());
+
+    /* Several right-hand sides, then one vector solved in place. */
+    Matrix rhs = random_matrix(n, 4, 0.0);
+    Matrix y = create_matrix(n, 4);
+    Vector b = create_vector(n);
+    fill_random(b);
+    Vector x = create_copy(b);
+    Matrix b_column = tensor_reshape_view(b, 2, n, 1), x_column = tensor_reshape_view(x, 2, n, 1);
+
+    status = cholesky_solve_into(y, l, rhs);
+    check("cholesky_solve A * X - B", status == TENSOR_OK ? residual(spd, y, rhs) : INFINITY, tolerance());
+    status = cholesky_solve_into(x, l, x);
+    check("cholesky_solve vector in place", status == TENSOR_OK ? residual(spd, x_column, b_column) : INFINITY, tolerance());
+
+    /* Indefinite input is reported. */
+    Matrix indefinite = create_indentity(n);
+    *tensor_at2(indefinite, n - 1, n - 1) = -1.0;
+    check("cholesky_into indefinite status", cholesky_into(l, indefinite) != TENSOR_ERROR_SINGULAR, 0.0);
+
+    Matrix matrices[12] = { m, mt, spd, l, lt, product, rhs, y, b, x, b_column, x_column };
+    for(int i = 0; i < 12; i ++)
+        destroy_tensor(matrices[i]);
+    destroy_tensor(indefinite);
+}
+
+void test_lstsq() {
+
+    /* Overdetermined: the residual is orthogonal to the columns of A. */
+    Matrix a = random_matrix(80, 30, 0.0);
+    Matrix b = random_matrix(80, 2, 0.0);
+    Matrix x = lstsq(a, b);
+
+    Matrix at = tensor_transpose_view(a);
+    Matrix r = create_copy(b);
+    Matrix normal = create_matrix(30, 2);
+    matmul_into(r, a, x, 1.0, -1.0);
+    matmul_into(normal, at, r, 1.0, 0.0);
+    check("lstsq A^T * (A * X - B)", max_abs(normal), tolerance());
+
+    /* Underdetermined: X solves the system and is the minimum-norm solution A^T * (A * A^T)^-1 * B. */
+    Matrix wide = random_matrix(20, 50, 0.0);
+    Matrix c = random_matrix(20, 2, 0.0);
+    Matrix z = lstsq(wide, c);
+    check("lstsq underdetermined A * X - B", residual(wide, z, c), tolerance());
+
+    Matrix wide_t = tensor_transpose_view(wide);
+    Matrix gram = create_matrix(20, 20);
+    Matrix reference = create_matrix(50, 2);
+    matmul_into(gram, wide, wide_t, 1.0, 0.0);
+    Tensor y = solve(gram, c);
+    matmul_into(reference, wide_t, y, 1.0, 0.0);
+    check("lstsq minimum norm", max_difference(z, reference), tolerance());
+
+    destroy_tensor(a);
+    destroy_tensor(at);
+    destroy_tensor(b);
+    destroy_tensor(x);
+    destroy_tensor(r);
+    destroy_tensor(normal);
+    destroy_tensor(wide);
+    destroy_tensor(wide_t);
+    destroy_tensor(c);
+    destroy_tensor(z);
+    destroy_tensor(gram);
+    destroy_tensor(reference);
+    destroy_tensor(y);
+}
 
 int main() {
 
@@ -31,5 +1665,44 @@ int main() {
     destroy_tensor(matrix2);
     destroy_tensor(inv);
 
-    return 0;
+    printf("\n");
+
+    test_accessors();
+    test_views();
+    test_iterator();
+    test_elementwise();
+    test_broadcast();
+    test_reduce();
+    test_sum_modes();
+    test_cast();
+    test_quantize();
+    test_container();
+    test_npy();
+    test_arena();
+    test_allocator();
+    test_simd();
+    test_expr();
+    test_threads();
+    test_gemm();
+    test_split_k();
+    test_batched();
+    test_gemv();
+    test_geometry();
+    test_batched_vectors();
+    test_lu();
+    test_inverse();
+    test_solve();
+    test_cholesky();
+    test_lstsq();
+    test_qr("qr 70x40", 70, 40, 0);
+    test_qr("qr 40x70", 40, 70, 0);
+    test_qr("qr 300x150", 300, 150, 0);
+    test_qr("qr pivoted 60x30", 60, 30, 1);
+    test_qr_scaling("qr of A * huge", sizeof(ttype) == sizeof(float) ? 1e25 : 1e160, 0);
+    test_qr_scaling("qr of A * tiny", sizeof(ttype) == sizeof(float) ? 1e-25 : 1e-170, 0);
+    test_qr_scaling("qr pivoted of A * huge", sizeof(ttype) == sizeof(float) ? 1e25 : 1e160, 1);
+    test_qr_scaling("qr pivoted of A * tiny", sizeof(ttype) == sizeof(float) ? 1e-25 : 1e-170, 1);
+
+    printf("\n%d failed\n", failures);
+    return failures != 0;
 }
\ No newline at end of file